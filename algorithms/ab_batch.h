@@ -0,0 +1,362 @@
+#pragma once
+// Пакетный режим A/B: попарное сравнение групп общего набора данных
+// по критериям Стьюдента (объединенная дисперсия и Уэлч) и Фишера.
+//
+// Формат набора данных: строки "группа значение [значение ...]".
+// Формат манифеста: строки "группа_A группа_B".
+// Строки, начинающиеся с '#', и пустые строки игнорируются.
+// Набор данных и манифест могут быть сжаты gzip или zstd (compressed_input.h).
+// Результаты записываются в TSV, с параметром --format - в JSON Lines или
+// CSV (result_writer.h).
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/math/distributions/fisher_f.hpp>
+#include <boost/math/distributions/students_t.hpp>
+
+#include "compressed_input.h"
+#include "fast_reader.h"
+#include "moments.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+
+// Группа набора данных и ее накопленные моменты
+struct GroupMoments {
+   std::string name;
+   SampleMoments moments;
+};
+
+// Все группы набора данных; моменты каждой группы считаются один раз
+struct AbBatchDataset {
+   std::vector<GroupMoments> groups;
+   std::unordered_map<std::string, size_t> index;
+};
+
+// Результат сравнения одной пары групп
+struct AbPairResult {
+   size_t a = 0;
+   size_t b = 0;
+   double F = 0.0, F_df1 = 0.0, F_df2 = 0.0, F_p = 0.0;
+   double t_pooled = 0.0, df_pooled = 0.0, p_pooled = 0.0;
+   double t_welch = 0.0, df_welch = 0.0, p_welch = 0.0;
+};
+
+// Следующее слово строки [p, end) до пробельного символа; p сдвигается за него
+inline bool ab_next_word(const char*& p, const char* end, std::string& word) {
+   while (p < end && text_is_space(*p)) p++;
+   const char* begin = p;
+   while (p < end && !text_is_space(*p)) p++;
+   word.assign(begin, p);
+   return p > begin;
+}
+
+// Чтение набора данных с одновременным накоплением моментов по группам
+inline bool read_group_dataset(const std::string& filename, AbBatchDataset& dataset) {
+   STAT_PROFILE_SCOPE("read_group_dataset");
+   dataset.groups.clear();
+   dataset.index.clear();
+
+   // Значения после имени группы разбираются общим разбором строк
+   // (fast_reader.h): до первого нечислового значения
+   TextReadOptions options;
+   bool separator[256];
+   text_separator_table(options, separator);
+   TextColumns parsed;
+
+   std::string name;
+   auto add_line = [&](const char* begin, const char* end) {
+      if (begin == end || *begin == '#') return;
+
+      const char* p = begin;
+      if (!ab_next_word(p, end, name)) return;
+
+      auto it = dataset.index.find(name);
+      if (it == dataset.index.end()) {
+         it = dataset.index.emplace(name, dataset.groups.size()).first;
+         dataset.groups.emplace_back();
+         dataset.groups.back().name = name;
+      }
+
+      SampleMoments& moments = dataset.groups[it->second].moments;
+      parsed.values.clear();
+      parsed.row_end.clear();
+      parsed.row_stopped.clear();
+      parsed.directives.clear();
+      text_parse_line(p, end, 0, options, separator, parsed);
+      for (double value : parsed.values) {
+         moments.add(value);
+      }
+   };
+
+   // Чтение и распаковка идут в отдельном потоке, строки разбираются здесь
+   bool opened = read_input_lines(filename, [&](const char* begin, const char* end) {
+      while (begin < end) {
+         const char* eol = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+         if (eol == nullptr) eol = end;
+         add_line(begin, eol);
+         begin = eol + 1;
+      }
+   });
+   if (!opened) {
+      std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+      return false;
+   }
+
+   if (dataset.groups.empty()) {
+      std::cerr << "Ошибка: набор данных " << filename << " не содержит групп" << std::endl;
+      return false;
+   }
+   return true;
+}
+
+// Чтение манифеста пар; пары с неизвестными группами пропускаются.
+// Манифест, как и набор данных, может быть сжат (read_input_lines).
+inline bool read_pair_manifest(const std::string& filename, const AbBatchDataset& dataset,
+   std::vector<AbPairResult>& pairs) {
+   STAT_PROFILE_SCOPE("read_pair_manifest");
+   pairs.clear();
+
+   std::string name_a, name_b;
+   int line_num = 0;
+   auto add_line = [&](const char* begin, const char* end) {
+      line_num++;
+      if (begin == end || *begin == '#') return;
+
+      const char* p = begin;
+      if (!ab_next_word(p, end, name_a) || !ab_next_word(p, end, name_b)) {
+         std::cerr << "Предупреждение: некорректная строка манифеста " << line_num << std::endl;
+         return;
+      }
+
+      auto it_a = dataset.index.find(name_a);
+      auto it_b = dataset.index.find(name_b);
+      if (it_a == dataset.index.end() || it_b == dataset.index.end()) {
+         std::cerr << "Предупреждение: неизвестная группа в строке манифеста " << line_num << std::endl;
+         return;
+      }
+
+      AbPairResult pair;
+      pair.a = it_a->second;
+      pair.b = it_b->second;
+      pairs.push_back(pair);
+   };
+
+   bool opened = read_input_lines(filename, [&](const char* begin, const char* end) {
+      while (begin < end) {
+         const char* eol = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+         if (eol == nullptr) eol = end;
+         add_line(begin, eol);
+         begin = eol + 1;
+      }
+   });
+   if (!opened) {
+      std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+      return false;
+   }
+   return true;
+}
+
+// Вычисление F- и t-статистик с двусторонними p-значениями по моментам групп
+inline void compare_groups(const SampleMoments& a, const SampleMoments& b, AbPairResult& result) {
+   using namespace boost::math;
+   const double nan = std::numeric_limits<double>::quiet_NaN();
+
+   result.F = result.F_df1 = result.F_df2 = result.F_p = nan;
+   result.t_pooled = result.df_pooled = result.p_pooled = nan;
+   result.t_welch = result.df_welch = result.p_welch = nan;
+
+   if (a.count < 2 || b.count < 2) return;
+
+   double n1 = static_cast<double>(a.count);
+   double n2 = static_cast<double>(b.count);
+   double var1 = a.variance();
+   double var2 = b.variance();
+
+   // F-критерий (двусторонний)
+   result.F_df1 = n1 - 1;
+   result.F_df2 = n2 - 1;
+   if (var2 > 0) {
+      result.F = var1 / var2;
+      fisher_f_distribution<> fd(result.F_df1, result.F_df2);
+      double lower = cdf(fd, result.F);
+      double upper = cdf(complement(fd, result.F));
+      result.F_p = std::min(1.0, 2.0 * std::min(lower, upper));
+   }
+
+   // Точный критерий Стьюдента (объединенная дисперсия)
+   result.df_pooled = n1 + n2 - 2;
+   double pooledVariance = ((n1 - 1) * var1 + (n2 - 1) * var2) / result.df_pooled;
+   if (pooledVariance > 0) {
+      result.t_pooled = (a.mean - b.mean) / std::sqrt(pooledVariance * (1.0 / n1 + 1.0 / n2));
+      students_t_distribution<> td(result.df_pooled);
+      result.p_pooled = 2.0 * cdf(complement(td, std::fabs(result.t_pooled)));
+   }
+
+   // Критерий Уэлча (неравные дисперсии)
+   double se1 = var1 / n1;
+   double se2 = var2 / n2;
+   if (se1 + se2 > 0) {
+      result.t_welch = (a.mean - b.mean) / std::sqrt(se1 + se2);
+      result.df_welch = (se1 + se2) * (se1 + se2) /
+         (se1 * se1 / (n1 - 1) + se2 * se2 / (n2 - 1));
+      students_t_distribution<> td(result.df_welch);
+      result.p_welch = 2.0 * cdf(complement(td, std::fabs(result.t_welch)));
+   }
+}
+
+// Запись результата пары в таблице кэша (ResultTable<10>) и обратно
+inline std::array<double, 10> ab_pair_record(const AbPairResult& r) {
+   return { r.F, r.F_df1, r.F_df2, r.F_p, r.t_pooled, r.df_pooled, r.p_pooled,
+      r.t_welch, r.df_welch, r.p_welch };
+}
+
+inline void ab_pair_from_record(const std::array<double, 10>& record, AbPairResult& r) {
+   r.F = record[0]; r.F_df1 = record[1]; r.F_df2 = record[2]; r.F_p = record[3];
+   r.t_pooled = record[4]; r.df_pooled = record[5]; r.p_pooled = record[6];
+   r.t_welch = record[7]; r.df_welch = record[8]; r.p_welch = record[9];
+}
+
+// Ключ пары в кэше: результат зависит только от объема, среднего и суммы
+// квадратов отклонений двух групп
+inline std::uint64_t ab_pair_key(Xxh64 hash, const SampleMoments& a, const SampleMoments& b) {
+   for (const SampleMoments* m : { &a, &b }) {
+      std::uint64_t count = m->count;
+      hash.update(&count, sizeof(count));
+      hash.update(&m->mean, sizeof(m->mean));
+      hash.update(&m->m2, sizeof(m->m2));
+   }
+   return hash.digest();
+}
+
+// Запись результатов в компактном столбцовом виде (TSV с заголовком)
+inline bool write_ab_batch_results(const std::string& filename, const AbBatchDataset& dataset,
+   const std::vector<AbPairResult>& pairs) {
+   // Буфер объявлен раньше потока, чтобы пережить его закрытие
+   std::vector<char> buffer(1 << 20);
+   std::ofstream outfile;
+   outfile.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+   outfile.open(filename);
+   if (!outfile.is_open()) {
+      std::cerr << "ОШИБКА: Не удалось создать выходной файл: " << filename << std::endl;
+      return false;
+   }
+
+   outfile.precision(10);
+   outfile << "group_a\tgroup_b\tn_a\tn_b\tmean_a\tmean_b\tvar_a\tvar_b"
+      << "\tF\tF_df1\tF_df2\tF_p"
+      << "\tt_pooled\tdf_pooled\tp_pooled"
+      << "\tt_welch\tdf_welch\tp_welch\n";
+
+   for (const AbPairResult& r : pairs) {
+      const SampleMoments& a = dataset.groups[r.a].moments;
+      const SampleMoments& b = dataset.groups[r.b].moments;
+      outfile << dataset.groups[r.a].name << '\t' << dataset.groups[r.b].name
+         << '\t' << a.count << '\t' << b.count
+         << '\t' << a.mean << '\t' << b.mean << '\t' << a.variance() << '\t' << b.variance()
+         << '\t' << r.F << '\t' << r.F_df1 << '\t' << r.F_df2 << '\t' << r.F_p
+         << '\t' << r.t_pooled << '\t' << r.df_pooled << '\t' << r.p_pooled
+         << '\t' << r.t_welch << '\t' << r.df_welch << '\t' << r.p_welch << '\n';
+   }
+
+   outfile.close();
+   return true;
+}
+
+// Запись результатов в формате JSON Lines или CSV (result_writer.h)
+inline bool write_ab_batch_records(const std::string& filename, const AbBatchDataset& dataset,
+   const std::vector<AbPairResult>& pairs, const ResultOptions& options) {
+   ResultWriter writer;
+   if (!writer.open(filename, options, "ab_batch", { "group_a", "group_b", "n_a", "n_b",
+      "mean_a", "mean_b", "var_a", "var_b", "f", "f_df1", "f_df2", "f_p",
+      "t_pooled", "df_pooled", "p_pooled", "t_welch", "df_welch", "p_welch" })) {
+      std::cerr << "ОШИБКА: Не удалось создать выходной файл: " << filename << std::endl;
+      return false;
+   }
+
+   for (const AbPairResult& r : pairs) {
+      const SampleMoments& a = dataset.groups[r.a].moments;
+      const SampleMoments& b = dataset.groups[r.b].moments;
+      writer.write(dataset.groups[r.a].name, dataset.groups[r.b].name, a.count, b.count,
+         a.mean, b.mean, a.variance(), b.variance(), r.F, r.F_df1, r.F_df2, r.F_p,
+         r.t_pooled, r.df_pooled, r.p_pooled, r.t_welch, r.df_welch, r.p_welch);
+   }
+
+   if (!writer.close()) {
+      std::cerr << "ОШИБКА: Ошибка записи в файл: " << filename << std::endl;
+      return false;
+   }
+   return true;
+}
+
+// Полный пакетный прогон: чтение данных и манифеста, параллельный расчет, запись.
+// С кэшем (--cache) результаты пар хранятся в таблице ab_pair по моментам
+// своих двух групп: после изменения данных или манифеста пересчитываются
+// только пары с новыми или изменившимися группами.
+inline bool run_ab_batch(const std::string& dataset_filename, const std::string& manifest_filename,
+   const std::string& output_filename, const ResultOptions& options = ResultOptions(),
+   const ResultCacheOptions& cache = ResultCacheOptions()) {
+   AbBatchDataset dataset;
+   if (!read_group_dataset(dataset_filename, dataset)) return false;
+
+   std::vector<AbPairResult> pairs;
+   if (!read_pair_manifest(manifest_filename, dataset, pairs)) return false;
+
+   std::cout << "Прочитано групп: " << dataset.groups.size() << std::endl;
+   std::cout << "Пар для сравнения: " << pairs.size() << std::endl;
+
+   // Пары, которых нет в кэше
+   ResultTable<10> table(cache, "ab_pair");
+   std::vector<std::uint64_t> keys;
+   std::vector<size_t> missing;
+   if (table.enabled()) {
+      STAT_PROFILE_SCOPE("ab_pair_lookup");
+      Xxh64 prefix = table.key_hash();
+      keys.resize(pairs.size());
+      std::array<double, 10> record;
+      for (size_t i = 0; i < pairs.size(); ++i) {
+         keys[i] = ab_pair_key(prefix, dataset.groups[pairs[i].a].moments, dataset.groups[pairs[i].b].moments);
+         if (table.find(keys[i], record)) ab_pair_from_record(record, pairs[i]);
+         else missing.push_back(i);
+      }
+      std::cout << "Пар из кэша: " << pairs.size() - missing.size() << ", пересчитано: " << missing.size() << std::endl;
+   }
+   else {
+      missing.resize(pairs.size());
+      std::iota(missing.begin(), missing.end(), size_t(0));
+   }
+
+   STAT_PROFILE_COUNT("ab_pairs", missing.size());
+   parallel_for(missing.size(), 256, [&](size_t begin, size_t end) {
+      STAT_PROFILE_SCOPE("compare_groups_chunk");
+      for (size_t j = begin; j < end; ++j) {
+         AbPairResult& pair = pairs[missing[j]];
+         compare_groups(dataset.groups[pair.a].moments, dataset.groups[pair.b].moments, pair);
+      }
+   });
+
+   if (table.enabled()) {
+      for (size_t i : missing) table.insert(keys[i], ab_pair_record(pairs[i]));
+      table.save();
+   }
+
+   STAT_PROFILE_SCOPE("write_results");
+   bool written = options.structured()
+      ? write_ab_batch_records(output_filename, dataset, pairs, options)
+      : write_ab_batch_results(output_filename, dataset, pairs);
+   if (!written) return false;
+
+   std::cout << "Результаты пакетного сравнения сохранены в файл: " << output_filename << std::endl;
+   return true;
+}
@@ -0,0 +1,151 @@
+#pragma once
+// Арена для временных данных одного анализа.
+//
+// Временные массивы анализа (симплексы Нелдера-Мида, обращаемые и
+// перемножаемые матрицы, массивы рангов) берутся из арены потока: память
+// выделяется сдвигом указателя в текущем блоке, освобождение отдельных
+// массивов ничего не делает, вся память арены возвращается сразу при выходе
+// из внешней области ArenaScope.
+//
+//   ArenaScope arena_scope;                    // в начале обработки задания
+//   std::pmr::vector<double> v(n, arena_resource());
+//
+// Блоки, выделенные за время задания, при сбросе объединяются в один, так
+// что следующее задание того же размера не обращается к куче вовсе. Арена у
+// каждого потока своя, блокировок нет. Вне ArenaScope arena_resource()
+// возвращает обычную кучу (new/delete).
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+class Arena : public std::pmr::memory_resource {
+public:
+   // Больше этого размера после сброса не сохраняется
+   static constexpr size_t max_retained_bytes = size_t(64) << 20;
+
+   explicit Arena(size_t initial_bytes = size_t(64) << 10) : next_size_(initial_bytes) {}
+   ~Arena() override { release(); }
+
+   Arena(const Arena&) = delete;
+   Arena& operator=(const Arena&) = delete;
+
+   // Освобождает все выделенное; блоки объединяются в один
+   void reset() {
+      if (blocks_.size() > 1) {
+         size_t total = 0;
+         for (const Block& block : blocks_) total += block.size;
+         release();
+         add_block(std::min(total, max_retained_bytes));
+      }
+      else if (!blocks_.empty() && blocks_.front().size > max_retained_bytes) {
+         release();
+         add_block(max_retained_bytes);
+      }
+      if (!blocks_.empty()) {
+         current_ = 0;
+         offset_ = 0;
+      }
+   }
+
+   // Байт выделено с последнего сброса (с учетом выравнивания)
+   size_t used() const {
+      size_t bytes = offset_;
+      for (size_t i = 0; i < current_; i++) bytes += blocks_[i].size;
+      return bytes;
+   }
+
+   size_t capacity() const {
+      size_t bytes = 0;
+      for (const Block& block : blocks_) bytes += block.size;
+      return bytes;
+   }
+
+protected:
+   void* do_allocate(size_t bytes, size_t alignment) override {
+      if (bytes == 0) bytes = 1;
+      for (;;) {
+         if (current_ < blocks_.size()) {
+            Block& block = blocks_[current_];
+            std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.data);
+            std::uintptr_t begin = (base + offset_ + alignment - 1) & ~std::uintptr_t(alignment - 1);
+            if (begin + bytes <= base + block.size) {
+               offset_ = begin + bytes - base;
+               return reinterpret_cast<void*>(begin);
+            }
+            // Следующий уже выделенный блок (после сброса без объединения)
+            if (current_ + 1 < blocks_.size() && blocks_[current_ + 1].size >= bytes + alignment) {
+               current_++;
+               offset_ = 0;
+               continue;
+            }
+         }
+         // Новый блок вдвое больше предыдущего, но не меньше запроса
+         size_t size = std::max(next_size_, bytes + alignment);
+         next_size_ = std::max(next_size_, size) * 2;
+         add_block(size);
+         current_ = blocks_.size() - 1;
+         offset_ = 0;
+      }
+   }
+
+   void do_deallocate(void*, size_t, size_t) override {}
+
+   bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+   }
+
+private:
+   struct Block {
+      char* data;
+      size_t size;
+   };
+
+   void add_block(size_t size) {
+      blocks_.push_back({ static_cast<char*>(::operator new(size)), size });
+   }
+
+   void release() {
+      for (Block& block : blocks_) ::operator delete(block.data);
+      blocks_.clear();
+      current_ = 0;
+      offset_ = 0;
+   }
+
+   std::vector<Block> blocks_;
+   size_t current_ = 0;
+   size_t offset_ = 0;
+   size_t next_size_;
+};
+
+inline Arena& thread_arena() {
+   thread_local Arena arena;
+   return arena;
+}
+
+inline int& arena_scope_depth() {
+   thread_local int depth = 0;
+   return depth;
+}
+
+// Область задания: при выходе из внешней области арена потока сбрасывается.
+// Вложенные области (в том числе задачи пула, выполняемые потоком во время
+// ожидания) память не освобождают.
+class ArenaScope {
+public:
+   ArenaScope() { arena_scope_depth()++; }
+   ~ArenaScope() {
+      if (--arena_scope_depth() == 0) thread_arena().reset();
+   }
+
+   ArenaScope(const ArenaScope&) = delete;
+   ArenaScope& operator=(const ArenaScope&) = delete;
+};
+
+// Ресурс для временных массивов: арена потока внутри ArenaScope, иначе куча
+inline std::pmr::memory_resource* arena_resource() {
+   if (arena_scope_depth() > 0) return &thread_arena();
+   return std::pmr::new_delete_resource();
+}
@@ -0,0 +1,237 @@
+#pragma once
+// Автоматическое дифференцирование вперед второго порядка.
+//
+// Jet<N> хранит значение функции N переменных, ее градиент и матрицу
+// вторых производных. Функция, написанная шаблоном по типу числа,
+//
+//   template <class T> T loglik(const T* p) { ... log(p[1]) ... }
+//
+// при T = double дает значение, а при T = Jet<N> за тот же один проход по
+// данным - точные градиент и гессиан (без численного дифференцирования).
+// Для своих элементарных функций (например, log(1 - Ф(z))) достаточно
+// вызвать jet_chain со значением функции и двумя ее производными.
+//
+// newton_maximize уточняет максимум такой функции методом Ньютона,
+// observed_covariance - обратная матрица наблюдаемой информации (-гессиана)
+// в точке максимума, асимптотическая ковариационная матрица оценок.
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include "matrix.h"
+
+template <size_t N>
+struct Jet {
+   double v = 0.0;                          // значение
+   std::array<double, N> g{};               // градиент
+   std::array<std::array<double, N>, N> h{}; // гессиан (симметричный)
+
+   Jet() = default;
+   Jet(double value) : v(value) {}
+
+   // Независимая переменная номер index
+   static Jet variable(double value, size_t index) {
+      Jet x(value);
+      x.g[index] = 1.0;
+      return x;
+   }
+
+   Jet& operator+=(const Jet& b) {
+      v += b.v;
+      for (size_t i = 0; i < N; i++) {
+         g[i] += b.g[i];
+         for (size_t j = 0; j < N; j++) h[i][j] += b.h[i][j];
+      }
+      return *this;
+   }
+   Jet& operator-=(const Jet& b) { return *this += -b; }
+   Jet& operator*=(const Jet& b) { return *this = *this * b; }
+   Jet& operator/=(const Jet& b) { return *this = *this / b; }
+
+   Jet operator-() const {
+      Jet r;
+      r.v = -v;
+      for (size_t i = 0; i < N; i++) {
+         r.g[i] = -g[i];
+         for (size_t j = 0; j < N; j++) r.h[i][j] = -h[i][j];
+      }
+      return r;
+   }
+};
+
+// f(x) по значению f и производным df, d2f в точке x.v
+template <size_t N>
+Jet<N> jet_chain(const Jet<N>& x, double f, double df, double d2f) {
+   Jet<N> r;
+   r.v = f;
+   for (size_t i = 0; i < N; i++) {
+      r.g[i] = df * x.g[i];
+      for (size_t j = 0; j < N; j++) r.h[i][j] = df * x.h[i][j] + d2f * x.g[i] * x.g[j];
+   }
+   return r;
+}
+
+template <size_t N>
+Jet<N> operator+(Jet<N> a, const Jet<N>& b) { return a += b; }
+template <size_t N>
+Jet<N> operator-(Jet<N> a, const Jet<N>& b) { return a -= b; }
+
+template <size_t N>
+Jet<N> operator*(const Jet<N>& a, const Jet<N>& b) {
+   Jet<N> r;
+   r.v = a.v * b.v;
+   for (size_t i = 0; i < N; i++) {
+      r.g[i] = a.g[i] * b.v + a.v * b.g[i];
+      for (size_t j = 0; j < N; j++) {
+         r.h[i][j] = a.h[i][j] * b.v + a.v * b.h[i][j] + a.g[i] * b.g[j] + b.g[i] * a.g[j];
+      }
+   }
+   return r;
+}
+
+template <size_t N>
+Jet<N> operator/(const Jet<N>& a, const Jet<N>& b) {
+   double inv = 1.0 / b.v;
+   return a * jet_chain(b, inv, -inv * inv, 2.0 * inv * inv * inv);
+}
+
+// Операции с обычными числами
+template <size_t N>
+Jet<N> operator+(Jet<N> a, double b) { a.v += b; return a; }
+template <size_t N>
+Jet<N> operator+(double a, Jet<N> b) { b.v += a; return b; }
+template <size_t N>
+Jet<N> operator-(Jet<N> a, double b) { a.v -= b; return a; }
+template <size_t N>
+Jet<N> operator-(double a, const Jet<N>& b) { return -b + a; }
+template <size_t N>
+Jet<N> operator*(const Jet<N>& a, double b) { return jet_chain(a, a.v * b, b, 0.0); }
+template <size_t N>
+Jet<N> operator*(double a, const Jet<N>& b) { return b * a; }
+template <size_t N>
+Jet<N> operator/(const Jet<N>& a, double b) { return a * (1.0 / b); }
+template <size_t N>
+Jet<N> operator/(double a, const Jet<N>& b) { return Jet<N>(a) / b; }
+
+// Элементарные функции
+template <size_t N>
+Jet<N> exp(const Jet<N>& x) {
+   double e = std::exp(x.v);
+   return jet_chain(x, e, e, e);
+}
+
+template <size_t N>
+Jet<N> log(const Jet<N>& x) {
+   double inv = 1.0 / x.v;
+   return jet_chain(x, std::log(x.v), inv, -inv * inv);
+}
+
+template <size_t N>
+Jet<N> sqrt(const Jet<N>& x) {
+   double s = std::sqrt(x.v);
+   return jet_chain(x, s, 0.5 / s, -0.25 / (s * x.v));
+}
+
+template <size_t N>
+Jet<N> pow(const Jet<N>& x, double p) {
+   double f = std::pow(x.v, p);
+   return jet_chain(x, f, p * f / x.v, p * (p - 1.0) * f / (x.v * x.v));
+}
+
+// x^y = exp(y log x) для переменного показателя
+template <size_t N>
+Jet<N> pow(const Jet<N>& x, const Jet<N>& y) {
+   return exp(y * log(x));
+}
+
+// Значение числа (для double - само число)
+inline double jet_value(double x) { return x; }
+template <size_t N>
+double jet_value(const Jet<N>& x) { return x.v; }
+
+// Ковариационная матрица оценок: (-H)^-1; false - информация вырождена
+template <size_t N>
+bool observed_covariance(const Jet<N>& loglik, Matrix<N, N>& cov) {
+   Matrix<N, N> info;
+   for (size_t i = 0; i < N; i++) {
+      for (size_t j = 0; j < N; j++) info(i, j) = -loglik.h[i][j];
+   }
+   return inverse(info, cov);
+}
+
+// f(const Jet<N>* p) -> Jet<N> в точке x: значение, градиент и гессиан
+template <size_t N, class F>
+Jet<N> jet_evaluate(const std::array<double, N>& x, F& f) {
+   std::array<Jet<N>, N> p;
+   for (size_t i = 0; i < N; i++) p[i] = Jet<N>::variable(x[i], i);
+   return f(p.data());
+}
+
+struct NewtonResult {
+   int iterations = 0;
+   bool converged = false;  // шаг меньше tolerance
+   double value = 0.0;      // функция в найденной точке
+   double gradient_norm = 0.0;
+};
+
+// Уточнение максимума f методом Ньютона из точки x (обычно найденной
+// Нелдером-Мидом). f(const Jet<N>* p) -> Jet<N>; каждая итерация - один
+// проход по данным. Шаг дробится, пока функция не возрастет; если гессиан
+// не отрицательно определен, делается шаг по градиенту.
+template <size_t N, class F>
+NewtonResult newton_maximize(std::array<double, N>& x, F f, int max_iter = 50, double tolerance = 1e-10) {
+   auto evaluate = [&f](const std::array<double, N>& point) { return jet_evaluate(point, f); };
+
+   NewtonResult result;
+   Jet<N> current = evaluate(x);
+   while (result.iterations < max_iter && std::isfinite(current.v)) {
+      result.iterations++;
+
+      Matrix<N, N> minus_h;
+      Matrix<N, 1> gradient;
+      for (size_t i = 0; i < N; i++) {
+         gradient(i, 0) = current.g[i];
+         for (size_t j = 0; j < N; j++) minus_h(i, j) = -current.h[i][j];
+      }
+      Matrix<N, 1> newton_step;
+      std::array<double, N> step;
+      double ascent = 0.0;
+      bool newton = solve(minus_h, gradient, newton_step);
+      if (newton) {
+         for (size_t i = 0; i < N; i++) {
+            step[i] = newton_step(i, 0);
+            ascent += step[i] * current.g[i];
+         }
+      }
+      if (!newton || !(ascent > 0.0)) step = current.g;
+
+      double scale = 1.0;
+      bool accepted = false;
+      std::array<double, N> trial;
+      for (int halving = 0; halving < 40 && !accepted; halving++, scale *= 0.5) {
+         for (size_t i = 0; i < N; i++) trial[i] = x[i] + scale * step[i];
+         Jet<N> next = evaluate(trial);
+         if (std::isfinite(next.v) && next.v >= current.v) {
+            current = next;
+            accepted = true;
+         }
+      }
+      if (!accepted) break;
+
+      double change = 0.0;
+      for (size_t i = 0; i < N; i++) {
+         change = std::fmax(change, std::fabs(trial[i] - x[i]) / std::fmax(1.0, std::fabs(x[i])));
+      }
+      x = trial;
+      if (change < tolerance) {
+         result.converged = true;
+         break;
+      }
+   }
+
+   result.value = current.v;
+   double norm = 0.0;
+   for (size_t i = 0; i < N; i++) norm += current.g[i] * current.g[i];
+   result.gradient_norm = std::sqrt(norm);
+   return result;
+}
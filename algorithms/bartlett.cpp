@@ -5,8 +5,16 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <cstdint>
 #include <boost/math/distributions/chi_squared.hpp>
 
+#include "columnar.h"
+#include "fast_reader.h"
+#include "moments.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+
 using namespace std;
 using namespace boost::math;
 
@@ -18,12 +26,74 @@ struct BartlettConfig {
    vector<int> sizes;
    double alpha = 0.05;
    string output_filename = "bartlett_results.txt";
+   bool raw_samples = false; // дисперсии вычислены по исходным наблюдениям блоков [SAMPLE]
 };
 
-// Функция для чтения всех данных из файла
+// Дисперсии и объемы групп по моментам выборок
+void fill_variances_from_moments(const vector<SampleMoments>& moments, BartlettConfig& config) {
+   // Пустые выборки пропускаются, как в kruskal_w.cpp
+   for (const SampleMoments& group : moments) {
+       if (group.count == 0) continue;
+       config.variances.push_back(group.variance());
+       config.sizes.push_back(static_cast<int>(group.count));
+   }
+   config.raw_samples = true;
+}
+
+// Дисперсии и объемы групп по исходным наблюдениям за один параллельный проход
+void fill_variances_from_samples(const vector<double>& values, const vector<uint32_t>& groups,
+   size_t group_count, BartlettConfig& config) {
+   fill_variances_from_moments(compute_group_moments(values.data(), groups.data(),
+       values.size(), group_count), config);
+}
+
+// Двоичный столбцовый файл (columnar.h): моменты берутся из файла, если они
+// там сохранены, иначе считаются прямо по отображенным столбцам
+bool read_config_from_columnar(const string& filename, BartlettConfig& config) {
+   ColumnarFile file;
+   if (!file.open(filename)) {
+       cout << "Ошибка: некорректный двоичный файл данных " << filename << endl;
+       return false;
+   }
+
+   config.variances.clear();
+   config.sizes.clear();
+   config.alpha = 0.05; // значение по умолчанию
+   config.output_filename = "bartlett_results.txt"; // значение по умолчанию
+
+   vector<SampleMoments> moments;
+   if (file.has_moments()) {
+       for (size_t g = 0; g < file.groups(); g++) moments.push_back(file.group_moments(g));
+   }
+   else if (file.group().empty()) {
+       moments.push_back(compute_moments(file.values().data, file.rows()));
+   }
+   else {
+       moments = compute_group_moments(file.values().data, file.group().data, file.rows(), file.groups());
+   }
+   fill_variances_from_moments(moments, config);
+
+   if (config.variances.empty()) {
+       cout << "Ошибка: файл не содержит данных о дисперсиях" << endl;
+       return false;
+   }
+   cout << "Прочитано " << config.variances.size() << " выборок из файла " << filename << endl;
+   cout << "Дисперсии вычислены по " << file.rows() << " исходным наблюдениям" << endl;
+   cout << "Уровень значимости alpha: " << config.alpha << endl;
+   cout << "Выходной файл: " << config.output_filename << endl;
+   return true;
+}
+
+// Функция для чтения всех данных из файла.
+// Секции [PARAMETERS], [DATA] и [SAMPLE] разбираются как в kruskal_w.cpp;
+// отличие одно: числа до первой [SAMPLE] - пары "дисперсия объем", а не
+// первая выборка
 bool read_config_from_file(const string& filename, BartlettConfig& config) {
-   ifstream infile(filename);
-   if (!infile.is_open()) {
+   STAT_PROFILE_SCOPE("read_data");
+   if (is_columnar_file(filename)) return read_config_from_columnar(filename, config);
+
+   TextColumns columns;
+   if (!read_text_columns(filename, columns)) {
        cout << "Ошибка: не удалось открыть файл " << filename << endl;
        return false;
    }
@@ -33,93 +103,109 @@ bool read_config_from_file(const string& filename, BartlettConfig& config) {
    config.alpha = 0.05; // значение по умолчанию
    config.output_filename = "bartlett_results.txt"; // значение по умолчанию
 
-   string line;
-   int line_num = 0;
-   bool reading_data = false;
-   bool reading_params = false;
-
-   while (getline(infile, line)) {
-       line_num++;
+   config.raw_samples = false;
 
-       // Удаление начальных и конечных пробелов
-       line.erase(0, line.find_first_not_of(" \t"));
-       line.erase(line.find_last_not_of(" \t") + 1);
+   bool reading_params = false;
+   bool reading_sample = false;
+
+   // Исходные наблюдения в столбцовом виде: значение и номер его группы
+   vector<double> raw_values;
+   vector<uint32_t> raw_groups;
+   size_t group_count = 0;
+   // Строка последней метки [SAMPLE] и число прочитанных в ней значений
+   size_t sample_line = 0;
+   size_t sample_size = 0;
+
+   // Выборка [SAMPLE] без значений не входит в расчет
+   auto close_sample = [&]() {
+       if (reading_sample && sample_size == 0) {
+           cout << "Предупреждение: пустая выборка [SAMPLE] в строке " << sample_line << " пропущена" << endl;
+       }
+       reading_sample = false;
+   };
+
+   // Строки данных между директивами
+   size_t next_row = 0;
+   auto take_rows = [&](size_t until) {
+       if (next_row >= until) return;
+       // В секции параметров числовые строки не используются
+       if (reading_params) {
+           next_row = until;
+           return;
+       }
 
-       // Пропускаем пустые строки
-       if (line.empty()) {
-           continue;
+       // После метки [SAMPLE] строки - исходные наблюдения текущей выборки
+       if (reading_sample) {
+           size_t count = columns.row(until) - columns.row(next_row);
+           if (count > 0 && sample_size == 0) group_count++;
+           sample_size += count;
+           raw_values.insert(raw_values.end(), columns.row(next_row), columns.row(until));
+           raw_groups.resize(raw_values.size(), static_cast<uint32_t>(group_count - 1));
+           next_row = until;
+           return;
        }
 
-       // Пропускаем комментарии
-       if (line[0] == '#') {
-           continue;
+       // Иначе строка данных - пара "дисперсия объем"
+       for (; next_row < until; ++next_row) {
+           if (columns.row_size(next_row) >= 2) {
+               config.variances.push_back(columns.row(next_row)[0]);
+               config.sizes.push_back(static_cast<int>(columns.row(next_row)[1]));
+           }
        }
+   };
+
+   for (const TextDirective& directive : columns.directives) {
+       take_rows(directive.row);
+       const string& line = directive.text;
 
-       // Проверяем секции файла
+       // Проверяем секции файла. Как и в kruskal_w.cpp, [PARAMETERS] и [DATA]
+       // не закрывают выборку: строки после [DATA] дополняют текущую [SAMPLE]
        if (line == "[PARAMETERS]") {
            reading_params = true;
-           reading_data = false;
            continue;
        }
        else if (line == "[DATA]") {
-           reading_data = true;
            reading_params = false;
            continue;
        }
-
-       // Чтение параметров
-       if (reading_params) {
-           istringstream iss(line);
-           string key;
-           if (iss >> key) {
-               if (key == "alpha" || key == "ALPHA") {
-                   if (!(iss >> config.alpha)) {
-                       cout << "Предупреждение: некорректное значение alpha в строке " << line_num << endl;
-                   }
-               }
-               else if (key == "output" || key == "OUTPUT") {
-                   string filename;
-                   if (iss >> filename) {
-                       config.output_filename = filename;
-                   }
-               }
-           }
+       else if (line == "[SAMPLE]") {
+           // Начало новой выборки исходных наблюдений (формат kruskal_w.cpp)
+           close_sample();
+           config.raw_samples = true;
+           reading_params = false;
+           reading_sample = true;
+           sample_line = directive.line;
+           sample_size = 0;
+           continue;
        }
 
-       // Чтение данных
-       else if (reading_data || (!reading_params && !reading_data)) {
-           // По умолчанию читаем как данные, если нет явных секций
-           istringstream iss(line);
-           double variance;
-           int size;
-
-           if (iss >> variance >> size) {
-               config.variances.push_back(variance);
-               config.sizes.push_back(size);
+       // Чтение параметров (в секции параметров и среди данных)
+       istringstream iss(line);
+       string key;
+       if (iss >> key) {
+           if (key == "alpha" || key == "ALPHA") {
+               if (!(iss >> config.alpha)) {
+                   cout << "Предупреждение: некорректное значение alpha в строке " << directive.line << endl;
+               }
            }
-           else {
-               // Пробуем прочитать как параметр, если не удалось как данные
-               iss.clear();
-               iss.str(line);
-               string key;
-               if (iss >> key) {
-                   if (key == "alpha" || key == "ALPHA") {
-                       if (!(iss >> config.alpha)) {
-                           cout << "Предупреждение: некорректное значение alpha в строке " << line_num << endl;
-                       }
-                   }
-                   else if (key == "output" || key == "OUTPUT") {
-                       string filename;
-                       if (iss >> filename) {
-                           config.output_filename = filename;
-                       }
-                   }
+           else if (key == "output" || key == "OUTPUT") {
+               string filename;
+               if (iss >> filename) {
+                   config.output_filename = filename;
                }
            }
        }
    }
+   take_rows(columns.rows());
+   close_sample();
 
-   infile.close();
+   if (config.raw_samples) {
+       if (!config.variances.empty()) {
+           cout << "Ошибка: файл содержит и пары \"дисперсия объем\", и выборки [SAMPLE]" << endl;
+           return false;
+       }
+       fill_variances_from_samples(raw_values, raw_groups, group_count, config);
+   }
 
    if (config.variances.empty()) {
        cout << "Ошибка: файл не содержит данных о дисперсиях" << endl;
@@ -127,6 +213,9 @@ bool read_config_from_file(const string& filename, BartlettConfig& config) {
    }
 
    cout << "Прочитано " << config.variances.size() << " выборок из файла " << filename << endl;
+   if (config.raw_samples) {
+       cout << "Дисперсии вычислены по " << raw_values.size() << " исходным наблюдениям" << endl;
+   }
    cout << "Уровень значимости alpha: " << config.alpha << endl;
    cout << "Выходной файл: " << config.output_filename << endl;
 
@@ -134,70 +223,105 @@ bool read_config_from_file(const string& filename, BartlettConfig& config) {
 }
 
 
-void write_results_to_file(const BartlettConfig& config,
+bool write_results_to_file(const BartlettConfig& config,
    double s2_pooled,
    double c,
    double chi2_stat,
    int df,
    double chi2_critical,
    bool hypothesis_accepted) {
+   STAT_PROFILE_SCOPE("write_report");
 
    ofstream outfile(config.output_filename);
    if (!outfile.is_open()) {
        cout << "Ошибка: не удалось создать файл " << config.output_filename << endl;
-       return;
+       return false;
    }
 
    outfile << fixed << setprecision(6);
 
-   outfile << "=== РЕЗУЛЬТАТЫ КРИТЕРИЯ БАРТЛЕТА ===" << endl << endl;
+   outfile << "=== РЕЗУЛЬТАТЫ КРИТЕРИЯ БАРТЛЕТА ===" << '\n' << '\n';
 
    // Исходные данные
-   outfile << "ИСХОДНЫЕ ДАННЫЕ:" << endl;
-   outfile << "Входной файл: bartlett_input.txt" << endl;
-   outfile << "Уровень значимости (alpha): " << config.alpha << endl << endl;
+   outfile << "ИСХОДНЫЕ ДАННЫЕ:" << '\n';
+   outfile << "Входной файл: bartlett_input.txt" << '\n';
+   outfile << "Уровень значимости (alpha): " << config.alpha << '\n';
+   if (config.raw_samples) {
+       outfile << "Дисперсии вычислены по исходным наблюдениям блоков [SAMPLE]" << '\n';
+   }
+   outfile << '\n';
 
-   outfile << setw(5) << "№" << setw(15) << "Дисперсия" << setw(10) << "Объем" << endl;
-   outfile << string(35, '-') << endl;
+   outfile << setw(5) << "№" << setw(15) << "Дисперсия" << setw(10) << "Объем" << '\n';
+   outfile << string(35, '-') << '\n';
 
    for (size_t i = 0; i < config.variances.size(); i++) {
        outfile << setw(5) << i + 1
            << setw(15) << config.variances[i]
-           << setw(10) << config.sizes[i] << endl;
+           << setw(10) << config.sizes[i] << '\n';
    }
-   outfile << endl;
+   outfile << '\n';
 
    // Результаты вычислений
-   outfile << "РЕЗУЛЬТАТЫ ВЫЧИСЛЕНИЙ:" << endl;
-   outfile << "Количество выборок (m): " << config.variances.size() << endl;
-   outfile << "Объединенная дисперсия (s^2): " << s2_pooled << endl;
-   outfile << "Коэффициент c: " << c << endl;
-   outfile << "Статистика хи-квадрат: " << chi2_stat << endl;
-   outfile << "Степени свободы (df): " << df << endl;
-   outfile << "Критическое значение хи-квадрат: " << chi2_critical << endl << endl;
+   outfile << "РЕЗУЛЬТАТЫ ВЫЧИСЛЕНИЙ:" << '\n';
+   outfile << "Количество выборок (m): " << config.variances.size() << '\n';
+   outfile << "Объединенная дисперсия (s^2): " << s2_pooled << '\n';
+   outfile << "Коэффициент c: " << c << '\n';
+   outfile << "Статистика хи-квадрат: " << chi2_stat << '\n';
+   outfile << "Степени свободы (df): " << df << '\n';
+   outfile << "Критическое значение хи-квадрат: " << chi2_critical << '\n' << '\n';
 
    // Вывод о гипотезе
-   outfile << "ВЫВОД:" << endl;
+   outfile << "ВЫВОД:" << '\n';
    if (hypothesis_accepted) {
-       outfile << "Нулевая гипотеза об однородности дисперсий ПРИНЯТА." << endl;
-       outfile << "(χ² = " << chi2_stat << " <= " << chi2_critical << ")" << endl;
-       outfile << "Все дисперсии можно считать статистически одинаковыми." << endl;
+       outfile << "Нулевая гипотеза об однородности дисперсий ПРИНЯТА." << '\n';
+       outfile << "(χ² = " << chi2_stat << " <= " << chi2_critical << ")" << '\n';
+       outfile << "Все дисперсии можно считать статистически одинаковыми." << '\n';
    }
    else {
-       outfile << "Нулевая гипотеза об однородности дисперсий ОТВЕРГНУТА." << endl;
-       outfile << "(χ² = " << chi2_stat << " > " << chi2_critical << ")" << endl;
-       outfile << "Дисперсии статистически различаются." << endl;
+       outfile << "Нулевая гипотеза об однородности дисперсий ОТВЕРГНУТА." << '\n';
+       outfile << "(χ² = " << chi2_stat << " > " << chi2_critical << ")" << '\n';
+       outfile << "Дисперсии статистически различаются." << '\n';
    }
 
-   outfile << endl << "======================================" << endl;
-   outfile << "Критерий Бартлета выполнен успешно." << endl;
+   outfile << '\n' << "======================================" << '\n';
+   outfile << "Критерий Бартлета выполнен успешно." << '\n';
 
    outfile.close();
    cout << "Результаты сохранены в файл: " << config.output_filename << endl;
+   return true;
 }
 
 
-bool bartlett_test(const BartlettConfig& config) {
+// Итоги критерия одной записью для --format jsonl|csv (result_writer.h)
+bool write_results_records(const BartlettConfig& config, const ResultOptions& options,
+   double s2_pooled,
+   double c,
+   double chi2_stat,
+   int df,
+   double chi2_critical,
+   bool hypothesis_accepted) {
+   STAT_PROFILE_SCOPE("write_report");
+
+   ResultWriter writer;
+   if (!writer.open(config.output_filename, options, "bartlett", { "samples", "raw_samples", "alpha",
+       "pooled_variance", "c", "chi2", "df", "critical", "accepted" })) {
+       cout << "Ошибка: не удалось создать файл " << config.output_filename << endl;
+       return false;
+   }
+   writer.write(config.variances.size(), config.raw_samples, config.alpha,
+       s2_pooled, c, chi2_stat, df, chi2_critical, hypothesis_accepted);
+   if (!writer.close()) {
+       cout << "Ошибка записи в файл " << config.output_filename << endl;
+       return false;
+   }
+   cout << "Результаты сохранены в файл: " << config.output_filename << endl;
+   return true;
+}
+
+
+// true - результаты записаны в config.output_filename
+bool bartlett_test(const BartlettConfig& config, const ResultOptions& options) {
+   STAT_PROFILE_SCOPE("bartlett_test");
 
    int m = config.variances.size();
 
@@ -273,10 +397,12 @@ bool bartlett_test(const BartlettConfig& config) {
    }
 
    // Запись в файл
-   write_results_to_file(config, s2_pooled, c, chi2_stat, df,
+   if (options.structured()) {
+       return write_results_records(config, options, s2_pooled, c, chi2_stat, df,
+           chi2_critical, hypothesis_accepted);
+   }
+   return write_results_to_file(config, s2_pooled, c, chi2_stat, df,
        chi2_critical, hypothesis_accepted);
-
-   return hypothesis_accepted;
 }
 
 /**
@@ -289,36 +415,56 @@ void create_example_config_file() {
        return;
    }
 
-   outfile << "# Пример файла конфигурации для критерия Бартлета" << endl;
-   outfile << "# Все параметры можно указывать в любом порядке" << endl;
-   outfile << "# Пустые строки и строки, начинающиеся с #, игнорируются" << endl;
-   outfile << endl;
-
-   outfile << "# Параметры теста (необязательные, значения по умолчанию указаны)" << endl;
-   outfile << "alpha 0.05           # уровень значимости (по умолчанию 0.05)" << endl;
-   outfile << "output results.txt   # имя выходного файла (по умолчанию bartlett_results.txt)" << endl;
-   outfile << endl;
-
-   outfile << "# Данные: дисперсия и объем выборки (обязательные)" << endl;
-   outfile << "# Каждая строка - отдельная выборка" << endl;
-   outfile << "# Данные из контрольного вопроса 5 (квадраты СКО: 0.15, 0.17, 0.21, 0.25, 0.27)" << endl;
-   outfile << endl;
-
-   outfile << "0.0225 10" << endl;
-   outfile << "0.0289 12" << endl;
-   outfile << "0.0441 15" << endl;
-   outfile << "0.0625 9" << endl;
-   outfile << "0.0729 11" << endl;
+   outfile << "# Пример файла конфигурации для критерия Бартлета" << '\n';
+   outfile << "# Все параметры можно указывать в любом порядке" << '\n';
+   outfile << "# Пустые строки и строки, начинающиеся с #, игнорируются" << '\n';
+   outfile << '\n';
+
+   outfile << "# Параметры теста (необязательные, значения по умолчанию указаны)" << '\n';
+   outfile << "alpha 0.05           # уровень значимости (по умолчанию 0.05)" << '\n';
+   outfile << "output results.txt   # имя выходного файла (по умолчанию bartlett_results.txt)" << '\n';
+   outfile << '\n';
+
+   outfile << "# Данные: дисперсия и объем выборки (обязательные)" << '\n';
+   outfile << "# Каждая строка - отдельная выборка" << '\n';
+   outfile << "# Вместо дисперсий можно задать исходные наблюдения: каждая выборка" << '\n';
+   outfile << "# начинается с метки [SAMPLE], как в файлах критерия Краскела-Уоллиса" << '\n';
+   outfile << "# Данные из контрольного вопроса 5 (квадраты СКО: 0.15, 0.17, 0.21, 0.25, 0.27)" << '\n';
+   outfile << '\n';
+
+   outfile << "0.0225 10" << '\n';
+   outfile << "0.0289 12" << '\n';
+   outfile << "0.0441 15" << '\n';
+   outfile << "0.0625 9" << '\n';
+   outfile << "0.0729 11" << '\n';
 
    outfile.close();
    cout << "Создан примерный файл конфигурации: example_config.txt" << endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
    setlocale(LC_ALL, "rus");
    // Имя входного файла
    string input_filename = "bartlett_input.txt";
 
+   // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+   ResultCacheOptions cache_options;
+   if (!take_cache_options(argc, argv, cache_options)) return 1;
+
+   // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+   ResultOptions result_options;
+   if (!take_result_options(argc, argv, result_options)) return 1;
+
+   // Другой входной файл (текстовый или двоичный): --input <файл>
+   if (argc > 2 && string(argv[1]) == "--input") input_filename = argv[2];
+
+   // Тот же файл с теми же параметрами - результат из кэша
+   ResultCache cache(cache_options, "bartlett");
+   cache.add_file(input_filename);
+   cache.add_arguments(argc, argv);
+   cache.add("format", static_cast<int>(result_options.format));
+   if (cache.replay()) return 0;
+
    cout << "Программа для вычисления критерия Бартлета" << endl;
    cout << "==========================================" << endl;
 
@@ -353,10 +499,11 @@ int main() {
    if (!read_config_from_file(input_filename, config)) {
        return 1;
    }
+   config.output_filename = result_output_filename(config.output_filename, result_options);
 
    // Выполнение критерия Бартлета
    cout << endl;
-   bartlett_test(config);
+   if (bartlett_test(config, result_options)) cache.store({ config.output_filename });
 
    return 0;
 }
@@ -0,0 +1,74 @@
+#pragma once
+// Чтение цензурированной выборки: значения и признаки цензурирования
+// (0 - отказ, иначе цензурировано справа).
+//
+// Текстовый файл - строки "значение,цензурирование" (разделители - пробелы,
+// запятая, точка с запятой; сжатые файлы читаются через compressed_input.h),
+// двоичный .scol - столбцы value и censor (columnar.h) без разбора текста.
+//
+// Строка из одного числа не несет признака цензурирования: программы ММП
+// (normal, weibul) и stat_convert ее пропускают, программы МНК (mnk,
+// lsq_weibull) с plain_failures = true считают ее отказом. Правило строк
+// задано одной функцией censored_rows.
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "columnar.h"
+#include "fast_reader.h"
+#include "profiler.h"
+
+// Значения и признаки цензурирования из разобранных строк текста
+inline void censored_rows(const TextColumns& columns, std::vector<double>& values,
+   std::vector<int>& censored, bool plain_failures = false) {
+   values.reserve(values.size() + columns.rows());
+   censored.reserve(censored.size() + columns.rows());
+   for (size_t r = 0; r < columns.rows(); ++r) {
+      const double* row = columns.row(r);
+      if (columns.row_size(r) >= 2) {
+         values.push_back(row[0]);
+         censored.push_back(static_cast<int>(row[1]));
+      }
+      else if (plain_failures) {
+         values.push_back(row[0]);
+         censored.push_back(0);
+      }
+   }
+}
+
+// false - файл не открывается или двоичный файл некорректен (сообщение
+// выводится в cout)
+inline bool read_censored_data(const std::string& filename, std::vector<double>& values,
+   std::vector<int>& censored, bool plain_failures = false) {
+   STAT_PROFILE_SCOPE("read_data");
+   values.clear();
+   censored.clear();
+
+   // Двоичный столбцовый файл (columnar.h): столбцы берутся без разбора текста
+   if (is_columnar_file(filename)) {
+      ColumnarFile file;
+      if (!file.open(filename)) {
+         std::cout << "Некорректный двоичный файл данных: " << filename << std::endl;
+         return false;
+      }
+      ColumnSpan<double> column = file.values();
+      ColumnSpan<std::uint8_t> censor = file.censor();
+      values.assign(column.begin(), column.end());
+      if (censor.empty()) censored.assign(values.size(), 0);
+      else censored.assign(censor.begin(), censor.end());
+      return true;
+   }
+
+   TextReadOptions options;
+   options.separators = ",;";
+   TextColumns columns;
+
+   if (!read_text_columns(filename, columns, options)) {
+      std::cout << "Не удалось открыть файл: " << filename << std::endl;
+      return false;
+   }
+
+   censored_rows(columns, values, censored, plain_failures);
+   return true;
+}
@@ -0,0 +1,318 @@
+#pragma once
+// Двоичный столбцовый формат входных данных (.scol).
+//
+// Текстовый файл один раз преобразуется утилитой stat_convert, после чего
+// любая программа отображает двоичный файл в память и работает с его
+// столбцами напрямую, без разбора текста.
+//
+// Структура файла (порядок байтов - little-endian):
+//   ColumnarHeader                      64 байта
+//   ColumnarEntry[column_count]         каталог столбцов
+//   данные столбцов, каждый выровнен на 64 байта
+//
+// Столбцы:
+//   "value"   double   [rows]          наблюдения
+//   "censor"  uint8    [rows]          признак цензурирования (необязательный)
+//   "group"   uint32   [rows]          номер выборки (необязательный, иначе 0)
+//   "order"   uint32   [rows]          индексы строк по возрастанию value (необязательный)
+//   "moments" double   [groups * 7]    count, mean, M2, M3, M4, min, max по выборкам (необязательный)
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "fast_reader.h"
+#include "moments.h"
+#include "parallel_sort.h"
+#include "profiler.h"
+
+const char columnar_magic[8] = { 'S', 'T', 'A', 'T', 'C', 'O', 'L', '1' };
+const std::uint32_t columnar_version = 1;
+const std::uint32_t columnar_byte_order = 0x01020304;
+
+enum ColumnType : std::uint32_t {
+   ColumnFloat64 = 1,
+   ColumnUInt8 = 2,
+   ColumnUInt32 = 3
+};
+
+struct ColumnarHeader {
+   char magic[8];
+   std::uint32_t version;
+   std::uint32_t column_count;
+   std::uint64_t row_count;
+   std::uint32_t group_count;
+   std::uint32_t byte_order;
+   char source[32]; // имя исходного текстового формата
+};
+
+struct ColumnarEntry {
+   char name[16];
+   std::uint32_t type;
+   std::uint32_t reserved;
+   std::uint64_t offset; // от начала файла
+   std::uint64_t count;  // число элементов
+};
+
+static_assert(sizeof(ColumnarHeader) == 64, "ColumnarHeader must be 64 bytes");
+static_assert(sizeof(ColumnarEntry) == 40, "ColumnarEntry must be 40 bytes");
+
+// Непрерывный участок отображенного файла
+template <class T>
+struct ColumnSpan {
+   const T* data = nullptr;
+   size_t size = 0;
+
+   bool empty() const { return size == 0; }
+   const T* begin() const { return data; }
+   const T* end() const { return data + size; }
+   const T& operator[](size_t i) const { return data[i]; }
+};
+
+// Проверка сигнатуры в начале файла
+inline bool is_columnar_file(const std::string& filename) {
+   std::ifstream file(filename, std::ios::binary);
+   char magic[sizeof(columnar_magic)] = {};
+   return file.read(magic, sizeof(magic)) && std::memcmp(magic, columnar_magic, sizeof(magic)) == 0;
+}
+
+//############# Чтение ############################
+
+class ColumnarFile {
+public:
+   // Отображает файл в память и проверяет каталог столбцов
+   bool open(const std::string& filename) {
+      STAT_PROFILE_SCOPE("columnar_open");
+      if (!file_.open(filename)) return false;
+      if (file_.size() < sizeof(ColumnarHeader)) return fail();
+
+      std::memcpy(&header_, file_.data(), sizeof(header_));
+      if (std::memcmp(header_.magic, columnar_magic, sizeof(columnar_magic)) != 0 ||
+         header_.version != columnar_version || header_.byte_order != columnar_byte_order) {
+         return fail();
+      }
+
+      size_t directory_end = sizeof(ColumnarHeader) + size_t(header_.column_count) * sizeof(ColumnarEntry);
+      if (directory_end > file_.size()) return fail();
+      entries_.resize(header_.column_count);
+      std::memcpy(entries_.data(), file_.data() + sizeof(ColumnarHeader), entries_.size() * sizeof(ColumnarEntry));
+
+      for (const ColumnarEntry& entry : entries_) {
+         size_t width = type_width(entry.type);
+         if (width == 0 || entry.offset % 64 != 0 || entry.offset > file_.size() ||
+            entry.count > (file_.size() - entry.offset) / width) {
+            return fail();
+         }
+      }
+
+      values_ = column<double>("value", ColumnFloat64);
+      censor_ = column<std::uint8_t>("censor", ColumnUInt8);
+      group_ = column<std::uint32_t>("group", ColumnUInt32);
+      order_ = column<std::uint32_t>("order", ColumnUInt32);
+      moments_ = column<double>("moments", ColumnFloat64);
+
+      if (values_.size != header_.row_count ||
+         (!censor_.empty() && censor_.size != header_.row_count) ||
+         (!group_.empty() && group_.size != header_.row_count) ||
+         (!order_.empty() && order_.size != header_.row_count) ||
+         (!moments_.empty() && moments_.size != size_t(header_.group_count) * 7)) {
+         return fail();
+      }
+
+      // Номера выборок и индексы строк используются как индексы массивов
+      for (std::uint32_t g : group_) {
+         if (g >= header_.group_count) return fail();
+      }
+      for (std::uint32_t i : order_) {
+         if (i >= header_.row_count) return fail();
+      }
+      return true;
+   }
+
+   size_t rows() const { return static_cast<size_t>(header_.row_count); }
+   size_t groups() const { return header_.group_count; }
+   std::string source() const {
+      return std::string(header_.source, std::find(header_.source, header_.source + sizeof(header_.source), '\0'));
+   }
+
+   ColumnSpan<double> values() const { return values_; }
+   ColumnSpan<std::uint8_t> censor() const { return censor_; }
+   ColumnSpan<std::uint32_t> group() const { return group_; }
+   ColumnSpan<std::uint32_t> order() const { return order_; }
+
+   bool has_moments() const { return !moments_.empty(); }
+   SampleMoments group_moments(size_t g) const {
+      SampleMoments m;
+      const double* p = moments_.data + g * 7;
+      m.count = static_cast<size_t>(p[0]);
+      m.mean = p[1];
+      m.m2 = p[2];
+      m.m3 = p[3];
+      m.m4 = p[4];
+      m.min = p[5];
+      m.max = p[6];
+      return m;
+   }
+
+   // Номер выборки строки (0, если столбца "group" нет)
+   std::uint32_t group_of(size_t row) const { return group_.empty() ? 0 : group_[row]; }
+
+private:
+   static size_t type_width(std::uint32_t type) {
+      switch (type) {
+      case ColumnFloat64: return 8;
+      case ColumnUInt8: return 1;
+      case ColumnUInt32: return 4;
+      default: return 0;
+      }
+   }
+
+   template <class T>
+   ColumnSpan<T> column(const char* name, std::uint32_t type) const {
+      ColumnSpan<T> span;
+      for (const ColumnarEntry& entry : entries_) {
+         if (entry.type == type && std::strncmp(entry.name, name, sizeof(entry.name)) == 0) {
+            span.data = reinterpret_cast<const T*>(file_.data() + entry.offset);
+            span.size = static_cast<size_t>(entry.count);
+            break;
+         }
+      }
+      return span;
+   }
+
+   bool fail() {
+      file_.close();
+      return false;
+   }
+
+   MappedFile file_;
+   ColumnarHeader header_ = {};
+   std::vector<ColumnarEntry> entries_;
+   ColumnSpan<double> values_;
+   ColumnSpan<std::uint8_t> censor_;
+   ColumnSpan<std::uint32_t> group_;
+   ColumnSpan<std::uint32_t> order_;
+   ColumnSpan<double> moments_;
+};
+
+//############# Запись ############################
+
+struct ColumnarData {
+   std::vector<double> values;
+   std::vector<std::uint8_t> censor;  // пустой - столбец не записывается
+   std::vector<std::uint32_t> group;  // пустой - все строки в выборке 0
+   size_t group_count = 1;
+   std::string source;
+   bool with_order = false;
+   bool with_moments = false;
+};
+
+inline bool write_columnar_file(const std::string& filename, const ColumnarData& data) {
+   STAT_PROFILE_SCOPE("write_columnar_file");
+   struct Pending {
+      const char* name;
+      std::uint32_t type;
+      const void* bytes;
+      size_t count;
+      size_t width;
+   };
+
+   size_t rows = data.values.size();
+   if (rows > UINT32_MAX) return false; // индексы строк хранятся в uint32
+   std::vector<std::uint32_t> order;
+   std::vector<double> moments;
+   std::vector<Pending> columns;
+
+   columns.push_back({ "value", ColumnFloat64, data.values.data(), rows, 8 });
+   if (!data.censor.empty()) {
+      columns.push_back({ "censor", ColumnUInt8, data.censor.data(), data.censor.size(), 1 });
+   }
+   if (!data.group.empty()) {
+      columns.push_back({ "group", ColumnUInt32, data.group.data(), data.group.size(), 4 });
+   }
+   if (data.with_order) {
+      STAT_PROFILE_COUNT("sort_size", rows);
+      order.resize(rows);
+      parallel_sort_indices(data.values.data(), rows, order.data());
+      columns.push_back({ "order", ColumnUInt32, order.data(), rows, 4 });
+   }
+   if (data.with_moments) {
+      std::vector<std::uint32_t> single;
+      const std::uint32_t* groups = data.group.data();
+      if (data.group.empty()) {
+         single.assign(rows, 0);
+         groups = single.data();
+      }
+      std::vector<SampleMoments> per_group = compute_group_moments(data.values.data(), groups, rows, data.group_count);
+      for (const SampleMoments& m : per_group) {
+         double packed[7] = { static_cast<double>(m.count), m.mean, m.m2, m.m3, m.m4, m.min, m.max };
+         moments.insert(moments.end(), packed, packed + 7);
+      }
+      columns.push_back({ "moments", ColumnFloat64, moments.data(), moments.size(), 8 });
+   }
+
+   ColumnarHeader header = {};
+   std::memcpy(header.magic, columnar_magic, sizeof(columnar_magic));
+   header.version = columnar_version;
+   header.column_count = static_cast<std::uint32_t>(columns.size());
+   header.row_count = rows;
+   header.group_count = static_cast<std::uint32_t>(data.group_count);
+   header.byte_order = columnar_byte_order;
+   std::memcpy(header.source, data.source.data(), std::min(data.source.size(), sizeof(header.source) - 1));
+
+   auto align = [](std::uint64_t offset) { return (offset + 63) / 64 * 64; };
+
+   std::vector<ColumnarEntry> entries(columns.size());
+   std::uint64_t offset = align(sizeof(ColumnarHeader) + entries.size() * sizeof(ColumnarEntry));
+   for (size_t i = 0; i < columns.size(); i++) {
+      ColumnarEntry& entry = entries[i];
+      std::memset(&entry, 0, sizeof(entry));
+      std::memcpy(entry.name, columns[i].name, std::min(std::strlen(columns[i].name), sizeof(entry.name) - 1));
+      entry.type = columns[i].type;
+      entry.offset = offset;
+      entry.count = columns[i].count;
+      offset = align(offset + columns[i].count * columns[i].width);
+   }
+
+   std::ofstream out(filename, std::ios::binary);
+   if (!out.is_open()) return false;
+
+   const char padding[64] = {};
+   std::uint64_t written = 0;
+   auto put = [&](const void* bytes, std::uint64_t size) {
+      out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+      written += size;
+   };
+   auto pad_to = [&](std::uint64_t target) { put(padding, target - written); };
+
+   put(&header, sizeof(header));
+   put(entries.data(), entries.size() * sizeof(ColumnarEntry));
+   for (size_t i = 0; i < columns.size(); i++) {
+      pad_to(entries[i].offset);
+      put(columns[i].bytes, columns[i].count * columns[i].width);
+   }
+   pad_to(offset);
+
+   return static_cast<bool>(out);
+}
+
+// Значения, разложенные по выборкам (для программ, работающих с vector<vector<double>>)
+inline std::vector<std::vector<double>> columnar_groups(const ColumnarFile& file) {
+   std::vector<std::vector<double>> groups(std::max<size_t>(1, file.groups()));
+   ColumnSpan<double> values = file.values();
+   if (file.group().empty()) {
+      groups[0].assign(values.begin(), values.end());
+      return groups;
+   }
+
+   std::vector<size_t> sizes(groups.size(), 0);
+   for (std::uint32_t g : file.group()) sizes[g]++;
+   for (size_t g = 0; g < groups.size(); g++) groups[g].reserve(sizes[g]);
+   for (size_t i = 0; i < values.size; i++) {
+      groups[file.group()[i]].push_back(values[i]);
+   }
+   return groups;
+}
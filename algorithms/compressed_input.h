@@ -0,0 +1,340 @@
+#pragma once
+// Последовательное чтение входных файлов, в том числе сжатых gzip и zstd.
+//
+// Формат определяется по сигнатуре в начале файла, а не по расширению.
+// Распаковка выполняется в отдельном потоке одновременно с разбором:
+// поток PipelinedInput заполняет блоки, вызывающий поток получает их
+// по порядку через очередь ограниченной длины.
+//
+// Поддержка сжатия подключается при сборке:
+//   STAT_WITH_ZLIB - gzip (.gz), библиотека zlib (-lz)
+//   STAT_WITH_ZSTD - zstd (.zst), библиотека libzstd (-lzstd)
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "profiler.h"
+
+#ifdef STAT_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef STAT_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+enum class InputCompression { None, Gzip, Zstd };
+
+// Сжатие файла по сигнатуре: 1F 8B - gzip, 28 B5 2F FD - zstd
+inline InputCompression detect_input_compression(const std::string& filename) {
+   std::FILE* file = std::fopen(filename.c_str(), "rb");
+   if (file == nullptr) return InputCompression::None;
+   unsigned char magic[4] = {};
+   size_t got = std::fread(magic, 1, sizeof(magic), file);
+   std::fclose(file);
+
+   if (got >= 2 && magic[0] == 0x1F && magic[1] == 0x8B) return InputCompression::Gzip;
+   if (got == 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) {
+      return InputCompression::Zstd;
+   }
+   return InputCompression::None;
+}
+
+inline bool input_compression_supported(InputCompression compression) {
+   switch (compression) {
+   case InputCompression::None: return true;
+#ifdef STAT_WITH_ZLIB
+   case InputCompression::Gzip: return true;
+#endif
+#ifdef STAT_WITH_ZSTD
+   case InputCompression::Zstd: return true;
+#endif
+   default: return false;
+   }
+}
+
+// Сообщение для сжатого файла, который программа не умеет читать
+inline std::string input_compression_unsupported_message(InputCompression compression) {
+   if (compression == InputCompression::Gzip) {
+      return "файл сжат gzip, программа собрана без поддержки gzip (STAT_WITH_ZLIB)";
+   }
+   return "файл сжат zstd, программа собрана без поддержки zstd (STAT_WITH_ZSTD)";
+}
+
+// Источник байтов файла: обычного или сжатого
+class InputSource {
+public:
+   InputSource() = default;
+   ~InputSource() { close(); }
+
+   InputSource(const InputSource&) = delete;
+   InputSource& operator=(const InputSource&) = delete;
+
+   // Если файл просто не удалось открыть, error остается пустым:
+   // об этом сообщает вызывающая программа, как и раньше
+   bool open(const std::string& filename, std::string& error) {
+      close();
+      compression_ = detect_input_compression(filename);
+      if (!input_compression_supported(compression_)) {
+         error = input_compression_unsupported_message(compression_);
+         return false;
+      }
+
+#ifdef STAT_WITH_ZLIB
+      if (compression_ == InputCompression::Gzip) {
+         gz_ = gzopen(filename.c_str(), "rb");
+         if (gz_ == nullptr) return false;
+         gzbuffer(gz_, 1u << 17);
+         return true;
+      }
+#endif
+
+      file_ = std::fopen(filename.c_str(), "rb");
+      if (file_ == nullptr) return false;
+
+#ifdef STAT_WITH_ZSTD
+      if (compression_ == InputCompression::Zstd) {
+         zstd_ = ZSTD_createDStream();
+         if (zstd_ == nullptr) {
+            error = "не удалось создать распаковщик zstd";
+            return false;
+         }
+         ZSTD_initDStream(zstd_);
+         zstd_input_.resize(ZSTD_DStreamInSize());
+         zstd_in_ = { zstd_input_.data(), 0, 0 };
+         zstd_frame_left_ = 0;
+      }
+#endif
+      return true;
+   }
+
+   // Читает до capacity байтов; 0 - конец данных или ошибка (error не пуст)
+   size_t read(char* buffer, size_t capacity, std::string& error) {
+#ifdef STAT_WITH_ZLIB
+      if (compression_ == InputCompression::Gzip) {
+         size_t total = 0;
+         while (total < capacity) {
+            int got = gzread(gz_, buffer + total, static_cast<unsigned>(capacity - total));
+            if (got <= 0) {
+               int code = Z_OK;
+               const char* message = gzerror(gz_, &code);
+               if (got < 0 || (code != Z_OK && code != Z_STREAM_END)) error = message;
+               break;
+            }
+            total += static_cast<size_t>(got);
+         }
+         return total;
+      }
+#endif
+#ifdef STAT_WITH_ZSTD
+      if (compression_ == InputCompression::Zstd) {
+         ZSTD_outBuffer out = { buffer, capacity, 0 };
+         while (out.pos < out.size) {
+            if (zstd_in_.pos == zstd_in_.size) {
+               size_t got = std::fread(zstd_input_.data(), 1, zstd_input_.size(), file_);
+               if (got == 0) {
+                  // Файл закончился внутри кадра - данные обрезаны
+                  if (zstd_frame_left_ != 0) error = "неожиданный конец сжатых данных";
+                  break;
+               }
+               zstd_in_ = { zstd_input_.data(), got, 0 };
+            }
+            size_t result = ZSTD_decompressStream(zstd_, &out, &zstd_in_);
+            if (ZSTD_isError(result)) {
+               error = ZSTD_getErrorName(result);
+               break;
+            }
+            zstd_frame_left_ = result;
+         }
+         return out.pos;
+      }
+#endif
+      size_t got = std::fread(buffer, 1, capacity, file_);
+      if (got < capacity && std::ferror(file_)) error = "ошибка чтения файла";
+      return got;
+   }
+
+   void close() {
+#ifdef STAT_WITH_ZLIB
+      if (gz_ != nullptr) gzclose(gz_);
+      gz_ = nullptr;
+#endif
+#ifdef STAT_WITH_ZSTD
+      if (zstd_ != nullptr) ZSTD_freeDStream(zstd_);
+      zstd_ = nullptr;
+#endif
+      if (file_ != nullptr) std::fclose(file_);
+      file_ = nullptr;
+   }
+
+private:
+   InputCompression compression_ = InputCompression::None;
+   std::FILE* file_ = nullptr;
+#ifdef STAT_WITH_ZLIB
+   gzFile gz_ = nullptr;
+#endif
+#ifdef STAT_WITH_ZSTD
+   ZSTD_DStream* zstd_ = nullptr;
+   std::vector<char> zstd_input_;
+   ZSTD_inBuffer zstd_in_ = { nullptr, 0, 0 };
+   size_t zstd_frame_left_ = 0; // ненулевое значение - текущий кадр не завершен
+#endif
+};
+
+// Чтение файла блоками в отдельном потоке. Пока вызывающий поток
+// разбирает блок, следующие блоки уже читаются и распаковываются.
+class PipelinedInput {
+public:
+   explicit PipelinedInput(size_t block_size = size_t(4) << 20, size_t depth = 4)
+      : block_size_(block_size), depth_(depth) {}
+   ~PipelinedInput() { close(); }
+
+   PipelinedInput(const PipelinedInput&) = delete;
+   PipelinedInput& operator=(const PipelinedInput&) = delete;
+
+   bool open(const std::string& filename) {
+      close();
+      error_.clear();
+      if (!source_.open(filename, error_)) return false;
+      finished_ = false;
+      stopping_ = false;
+      thread_ = std::thread([this]() { produce(); });
+      return true;
+   }
+
+   // Следующий блок по порядку; false - данные закончились (или ошибка, см. error).
+   // Блок действителен до следующего вызова next().
+   bool next(const char*& data, size_t& size) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (current_.size > 0) free_.push_back(std::move(current_));
+      current_ = Block();
+      changed_.wait(lock, [this]() { return !ready_.empty() || finished_; });
+      if (ready_.empty()) return false;
+
+      current_ = std::move(ready_.front());
+      ready_.pop_front();
+      changed_.notify_all();
+      data = current_.data.data();
+      size = current_.size;
+      return true;
+   }
+
+   bool failed() const { return !error_.empty(); }
+   const std::string& error() const { return error_; }
+
+   void close() {
+      if (thread_.joinable()) {
+         {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+         }
+         changed_.notify_all();
+         thread_.join();
+      }
+      source_.close();
+      ready_.clear();
+      current_ = Block();
+   }
+
+private:
+   struct Block {
+      std::vector<char> data;
+      size_t size = 0;
+   };
+
+   void produce() {
+      for (;;) {
+         Block block;
+         {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this]() { return stopping_ || ready_.size() < depth_; });
+            if (stopping_) return;
+            if (!free_.empty()) {
+               block = std::move(free_.back());
+               free_.pop_back();
+            }
+         }
+
+         if (block.data.size() < block_size_) block.data.resize(block_size_);
+         std::string error;
+         {
+            STAT_PROFILE_SCOPE("read_block");
+            block.size = source_.read(block.data.data(), block_size_, error);
+         }
+
+         std::lock_guard<std::mutex> lock(mutex_);
+         if (block.size > 0) ready_.push_back(std::move(block));
+         if (block.size == 0 || !error.empty()) {
+            error_ = error;
+            finished_ = true;
+         }
+         changed_.notify_all();
+         if (finished_) return;
+      }
+   }
+
+   size_t block_size_;
+   size_t depth_;
+   InputSource source_;
+   std::thread thread_;
+   std::mutex mutex_;
+   std::condition_variable changed_;
+   std::deque<Block> ready_;
+   std::vector<Block> free_;
+   Block current_;
+   bool finished_ = false;
+   bool stopping_ = false;
+   std::string error_;
+};
+
+// Чтение файла участками из целых строк: consumer(begin, end) вызывается
+// по порядку, каждый участок заканчивается символом '\n' (кроме последнего).
+// Строка, разрезанная границей блока, собирается в отдельном буфере.
+template <class Consumer>
+bool read_input_lines(const std::string& filename, Consumer consumer) {
+   STAT_PROFILE_SCOPE("read_input_lines");
+   PipelinedInput input;
+   if (!input.open(filename)) {
+      if (input.failed()) std::cerr << "Ошибка чтения файла " << filename << ": " << input.error() << std::endl;
+      return false;
+   }
+
+   std::vector<char> carry;
+   const char* data;
+   size_t size;
+   while (input.next(data, size)) {
+      STAT_PROFILE_COUNT("read_bytes", size);
+      const char* end = data + size;
+      const char* first_newline = static_cast<const char*>(std::memchr(data, '\n', size));
+      if (first_newline == nullptr) {
+         carry.insert(carry.end(), data, end);
+         continue;
+      }
+
+      const char* body = data;
+      if (!carry.empty()) {
+         carry.insert(carry.end(), data, first_newline + 1);
+         consumer(static_cast<const char*>(carry.data()), static_cast<const char*>(carry.data() + carry.size()));
+         carry.clear();
+         body = first_newline + 1;
+      }
+
+      const char* last_newline = end;
+      while (last_newline[-1] != '\n') last_newline--;
+      if (body < last_newline) consumer(body, last_newline);
+      carry.assign(last_newline, end);
+   }
+
+   if (input.failed()) {
+      std::cerr << "Ошибка чтения файла " << filename << ": " << input.error() << std::endl;
+      return false;
+   }
+   if (!carry.empty()) consumer(static_cast<const char*>(carry.data()), static_cast<const char*>(carry.data() + carry.size()));
+   return true;
+}
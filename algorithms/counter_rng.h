@@ -0,0 +1,79 @@
+#pragma once
+// Счетчиковый генератор псевдослучайных чисел Philox4x32-10
+// (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 2011).
+// Последовательность определяется парой (seed, номер потока), поэтому
+// каждому ресэмплу можно выдать свой независимый поток, и результат
+// не зависит от числа рабочих потоков и порядка их выполнения.
+#include <cstdint>
+
+class CounterRng {
+public:
+   CounterRng(std::uint64_t seed, std::uint64_t stream)
+      : key0_(static_cast<std::uint32_t>(seed)), key1_(static_cast<std::uint32_t>(seed >> 32)),
+        stream0_(static_cast<std::uint32_t>(stream)), stream1_(static_cast<std::uint32_t>(stream >> 32)) {}
+
+   // Следующее 32-битное значение
+   std::uint32_t next_u32() {
+      if (available_ == 0) {
+         generate_block();
+         available_ = 4;
+      }
+      return block_[4 - available_--];
+   }
+
+   // Равномерное целое из [0, bound), без смещения (метод Лемира)
+   std::uint32_t uniform(std::uint32_t bound) {
+      std::uint64_t m = static_cast<std::uint64_t>(next_u32()) * bound;
+      std::uint32_t low = static_cast<std::uint32_t>(m);
+      if (low < bound) {
+         std::uint32_t threshold = static_cast<std::uint32_t>(-bound) % bound;
+         while (low < threshold) {
+            m = static_cast<std::uint64_t>(next_u32()) * bound;
+            low = static_cast<std::uint32_t>(m);
+         }
+      }
+      return static_cast<std::uint32_t>(m >> 32);
+   }
+
+   // Равномерное вещественное из [0, 1) с 53 значащими битами
+   double uniform01() {
+      std::uint64_t hi = next_u32() >> 5;
+      std::uint64_t lo = next_u32() >> 6;
+      return (hi * 67108864.0 + lo) * (1.0 / 9007199254740992.0);
+   }
+
+private:
+   static void mulhilo(std::uint32_t a, std::uint32_t b, std::uint32_t& hi, std::uint32_t& lo) {
+      std::uint64_t product = static_cast<std::uint64_t>(a) * b;
+      hi = static_cast<std::uint32_t>(product >> 32);
+      lo = static_cast<std::uint32_t>(product);
+   }
+
+   void generate_block() {
+      std::uint32_t c0 = block_counter_, c1 = block_counter_high_, c2 = stream0_, c3 = stream1_;
+      std::uint32_t k0 = key0_, k1 = key1_;
+      for (int round = 0; round < 10; round++) {
+         std::uint32_t hi0, lo0, hi1, lo1;
+         mulhilo(0xD2511F53u, c0, hi0, lo0);
+         mulhilo(0xCD9E8D57u, c2, hi1, lo1);
+         c0 = hi1 ^ c1 ^ k0;
+         c1 = lo1;
+         c2 = hi0 ^ c3 ^ k1;
+         c3 = lo0;
+         k0 += 0x9E3779B9u;
+         k1 += 0xBB67AE85u;
+      }
+      block_[0] = c0;
+      block_[1] = c1;
+      block_[2] = c2;
+      block_[3] = c3;
+      if (++block_counter_ == 0) block_counter_high_++;
+   }
+
+   std::uint32_t key0_, key1_;
+   std::uint32_t stream0_, stream1_;
+   std::uint32_t block_counter_ = 0;
+   std::uint32_t block_counter_high_ = 0;
+   std::uint32_t block_[4] = { 0, 0, 0, 0 };
+   int available_ = 0;
+};
@@ -0,0 +1,288 @@
+#pragma once
+// Чтение выбранных столбцов из CSV/TSV-файлов с заголовком.
+//
+// Первая непустая строка файла - заголовок с именами столбцов, по нему же
+// определяется разделитель: табуляция, иначе ',' или ';' (что встречается
+// чаще). Из строк данных преобразуются только запрошенные поля; остальные
+// пропускаются без разбора чисел, а поля правее последнего нужного не
+// просматриваются вовсе. Пустые и нечисловые значения (NA и т.п.)
+// считаются пропусками. При разделителе ';' или табуляции допускается
+// десятичная запятая. Поля в кавычках поддерживаются, перевод строки
+// внутри кавычек - нет.
+//
+// Все выбранные столбцы заполняются за один проход: файл разбирается
+// параллельно участками из целых строк, сжатый файл (compressed_input.h) -
+// по мере распаковки.
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "compressed_input.h"
+#include "fast_reader.h"
+#include "parallel.h"
+#include "profiler.h"
+
+struct CsvSelection {
+   std::vector<std::string> names;           // выбранные столбцы в порядке запроса
+   std::vector<std::vector<double>> columns; // значения выбранных столбцов
+   std::vector<size_t> missing;              // число пропусков в каждом столбце
+   size_t rows = 0;                          // строк данных
+   char delimiter = ',';
+};
+
+// Конец поля, начинающегося в p (позиция разделителя или конец строки)
+inline const char* csv_field_end(const char* p, const char* end, char delimiter) {
+   if (p < end && *p == '"') {
+      for (p++; p < end; p++) {
+         if (*p != '"') continue;
+         if (p + 1 < end && p[1] == '"') {
+            p++;
+            continue;
+         }
+         p++;
+         break;
+      }
+   }
+   if (p >= end) return end;
+   const char* found = static_cast<const char*>(std::memchr(p, delimiter, end - p));
+   return found != nullptr ? found : end;
+}
+
+// Содержимое поля без пробелов и кавычек по краям
+inline void csv_trim_field(const char*& begin, const char*& end) {
+   while (begin < end && text_is_space(*begin)) begin++;
+   while (end > begin && text_is_space(end[-1])) end--;
+   if (end - begin >= 2 && *begin == '"' && end[-1] == '"') {
+      begin++;
+      end--;
+      while (begin < end && text_is_space(*begin)) begin++;
+      while (end > begin && text_is_space(end[-1])) end--;
+   }
+}
+
+// Числовое значение поля; false - пропуск или нечисловое значение
+inline bool csv_parse_value(const char* begin, const char* end, char delimiter, double& value) {
+   csv_trim_field(begin, end);
+   if (begin == end) return false;
+
+   if (delimiter != ',' && std::memchr(begin, ',', end - begin) != nullptr) {
+      char buffer[64];
+      size_t length = static_cast<size_t>(end - begin);
+      if (length >= sizeof(buffer)) return false;
+      std::memcpy(buffer, begin, length);
+      std::replace(buffer, buffer + length, ',', '.');
+      return text_parse_number(buffer, buffer + length, value) == buffer + length;
+   }
+   return text_parse_number(begin, end, value) == end;
+}
+
+// Частичный результат участка файла
+struct CsvPart {
+   std::vector<std::vector<double>> columns;
+   std::vector<size_t> missing;
+   size_t rows = 0;
+};
+
+// Разбор участка из целых строк. field_slot[f] - номер выбранного столбца
+// для поля f или -1; поля после field_slot.size() не просматриваются.
+inline void csv_parse_range(const char* begin, const char* end, char delimiter,
+   const std::vector<int>& field_slot, CsvPart& part) {
+   const size_t last_field = field_slot.size();
+   const char* p = begin;
+   while (p < end) {
+      const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      if (eol == nullptr) eol = end;
+      const char* line = p;
+      const char* line_end = eol;
+      p = eol + 1;
+      if (line_end > line && line_end[-1] == '\r') line_end--;
+
+      const char* first = line;
+      while (first < line_end && text_is_space(*first)) first++;
+      if (first == line_end) continue;
+      part.rows++;
+
+      const char* field = line;
+      size_t f = 0;
+      while (f < last_field) {
+         const char* field_end = csv_field_end(field, line_end, delimiter);
+         int slot = field_slot[f++];
+         if (slot >= 0) {
+            double value;
+            if (csv_parse_value(field, field_end, delimiter, value)) part.columns[slot].push_back(value);
+            else part.missing[slot]++;
+         }
+         if (field_end == line_end) break;
+         field = field_end + 1;
+      }
+      // Строка короче заголовка: недостающие поля - пропуски
+      for (; f < last_field; f++) {
+         if (field_slot[f] >= 0) part.missing[field_slot[f]]++;
+      }
+   }
+}
+
+// Разбор заголовка: разделитель и номера полей выбранных столбцов
+inline bool csv_parse_header(const char* begin, const char* end, CsvSelection& selection,
+   std::vector<int>& field_slot) {
+   if (end - begin >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) begin += 3; // метка UTF-8
+   if (end > begin && end[-1] == '\r') end--;
+
+   if (std::memchr(begin, '\t', end - begin) != nullptr) {
+      selection.delimiter = '\t';
+   }
+   else {
+      selection.delimiter = std::count(begin, end, ';') > std::count(begin, end, ',') ? ';' : ',';
+   }
+
+   std::vector<std::string> header;
+   const char* field = begin;
+   for (;;) {
+      const char* field_end = csv_field_end(field, end, selection.delimiter);
+      const char* name_begin = field;
+      const char* name_end = field_end;
+      csv_trim_field(name_begin, name_end);
+      header.emplace_back(name_begin, name_end);
+      if (field_end == end) break;
+      field = field_end + 1;
+   }
+
+   field_slot.clear();
+   for (size_t slot = 0; slot < selection.names.size(); slot++) {
+      auto it = std::find(header.begin(), header.end(), selection.names[slot]);
+      if (it == header.end()) {
+         std::cerr << "Ошибка: столбец \"" << selection.names[slot] << "\" не найден в заголовке файла" << std::endl;
+         return false;
+      }
+      size_t index = static_cast<size_t>(it - header.begin());
+      if (field_slot.size() <= index) field_slot.resize(index + 1, -1);
+      if (field_slot[index] >= 0) {
+         std::cerr << "Ошибка: столбец \"" << selection.names[slot] << "\" указан дважды" << std::endl;
+         return false;
+      }
+      field_slot[index] = static_cast<int>(slot);
+   }
+   return true;
+}
+
+// Начало первой непустой строки участка или nullptr
+inline const char* csv_first_line(const char* begin, const char* end, const char*& line_end) {
+   const char* p = begin;
+   while (p < end) {
+      const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      if (eol == nullptr) eol = end;
+      const char* first = p;
+      while (first < eol && text_is_space(*first)) first++;
+      if (first < eol) {
+         line_end = eol;
+         return p;
+      }
+      p = eol + 1;
+   }
+   return nullptr;
+}
+
+// Добавление частичного результата участка
+inline void csv_append_part(CsvSelection& selection, CsvPart& part) {
+   for (size_t slot = 0; slot < selection.columns.size(); slot++) {
+      selection.columns[slot].insert(selection.columns[slot].end(),
+         part.columns[slot].begin(), part.columns[slot].end());
+      selection.missing[slot] += part.missing[slot];
+   }
+   selection.rows += part.rows;
+}
+
+// Чтение столбцов names из файла. Сообщения об ошибках выводятся в cerr.
+inline bool read_csv_columns(const std::string& filename, const std::vector<std::string>& names,
+   CsvSelection& selection) {
+   STAT_PROFILE_SCOPE("read_csv_columns");
+   selection = CsvSelection();
+   selection.names = names;
+   selection.columns.resize(names.size());
+   selection.missing.assign(names.size(), 0);
+
+   std::vector<int> field_slot;
+   auto empty_part = [&]() {
+      CsvPart part;
+      part.columns.resize(names.size());
+      part.missing.assign(names.size(), 0);
+      return part;
+   };
+
+   if (detect_input_compression(filename) != InputCompression::None) {
+      bool header_found = false;
+      bool header_valid = true;
+      CsvPart part = empty_part();
+      bool opened = read_input_lines(filename, [&](const char* begin, const char* end) {
+         if (!header_valid) return;
+         if (!header_found) {
+            const char* line_end = nullptr;
+            const char* line = csv_first_line(begin, end, line_end);
+            if (line == nullptr) return;
+            header_found = true;
+            header_valid = csv_parse_header(line, line_end, selection, field_slot);
+            if (!header_valid) return;
+            begin = std::min(end, line_end + 1);
+         }
+         csv_parse_range(begin, end, selection.delimiter, field_slot, part);
+      });
+      if (!opened) {
+         std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+         return false;
+      }
+      if (!header_found) {
+         std::cerr << "Ошибка: файл " << filename << " не содержит заголовка" << std::endl;
+         return false;
+      }
+      if (!header_valid) return false;
+      csv_append_part(selection, part);
+      return true;
+   }
+
+   MappedFile file(filename);
+   if (!file.is_open()) {
+      std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+      return false;
+   }
+
+   const char* data = file.data();
+   const char* data_end = data + file.size();
+   STAT_PROFILE_COUNT("read_bytes", file.size());
+   const char* header_end = nullptr;
+   const char* header = csv_first_line(data, data_end, header_end);
+   if (header == nullptr) {
+      std::cerr << "Ошибка: файл " << filename << " не содержит заголовка" << std::endl;
+      return false;
+   }
+   if (!csv_parse_header(header, header_end, selection, field_slot)) return false;
+
+   const char* body = std::min(data_end, header_end + 1);
+   std::vector<size_t> bounds = text_part_bounds(body, static_cast<size_t>(data_end - body));
+   size_t parts = bounds.size() - 1;
+   std::vector<CsvPart> partial(parts, empty_part());
+   parallel_for(parts, 1, [&](size_t first, size_t last) {
+      for (size_t p = first; p < last; p++) {
+         STAT_PROFILE_SCOPE("parse_csv_part");
+         csv_parse_range(body + bounds[p], body + bounds[p + 1], selection.delimiter, field_slot, partial[p]);
+      }
+   });
+
+   for (CsvPart& part : partial) csv_append_part(selection, part);
+   return true;
+}
+
+// Имя выходного файла для столбца: "result.txt" + "A" -> "result_A.txt"
+inline std::string csv_output_filename(const std::string& base, const std::string& column) {
+   std::string suffix = column;
+   for (char& c : suffix) {
+      bool keep = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         c == '-' || (static_cast<unsigned char>(c) >= 0x80);
+      if (!keep) c = '_';
+   }
+   size_t dot = base.find_last_of('.');
+   if (dot == std::string::npos) return base + "_" + suffix;
+   return base.substr(0, dot) + "_" + suffix + base.substr(dot);
+}
@@ -0,0 +1,341 @@
+#pragma once
+// Быстрое чтение текстовых файлов данных, общее для всех утилит.
+//
+// Файл отображается в память, делится на участки по границам строк,
+// участки разбираются параллельно (числа - через std::from_chars),
+// результаты склеиваются по порядку в непрерывные столбцы.
+//
+// Каждая непустая строка файла становится либо строкой данных (начинается
+// с числа; читаются все числа до первого нечислового значения, как циклом
+// iss >> value), либо директивой (остальные строки: [DATA], [SAMPLE],
+// "alpha 0.05", "Sample1:" и т.п.). Директивы хранят свое положение среди
+// строк данных, поэтому форматы с секциями разбираются так же, как раньше.
+//
+// Сжатые файлы (gzip, zstd; см. compressed_input.h) не отображаются в память,
+// а распаковываются в отдельном потоке и разбираются по мере поступления блоков.
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "compressed_input.h"
+#include "parallel.h"
+#include "profiler.h"
+
+// Файл, отображенный в память только для чтения
+class MappedFile {
+public:
+   MappedFile() = default;
+   explicit MappedFile(const std::string& filename) { open(filename); }
+   ~MappedFile() { close(); }
+
+   MappedFile(const MappedFile&) = delete;
+   MappedFile& operator=(const MappedFile&) = delete;
+
+   bool open(const std::string& filename) {
+      close();
+#ifdef _WIN32
+      file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (file_ == INVALID_HANDLE_VALUE) return false;
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(file_, &size)) {
+         close();
+         return false;
+      }
+      size_ = static_cast<size_t>(size.QuadPart);
+      if (size_ > 0) {
+         mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+         if (mapping_ == nullptr) {
+            close();
+            return false;
+         }
+         data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+         if (data_ == nullptr) {
+            close();
+            return false;
+         }
+      }
+#else
+      int fd = ::open(filename.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      if (fstat(fd, &st) != 0) {
+         ::close(fd);
+         return false;
+      }
+      size_ = static_cast<size_t>(st.st_size);
+      if (size_ > 0) {
+         void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (mapped == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+         }
+         madvise(mapped, size_, MADV_WILLNEED);
+         data_ = static_cast<const char*>(mapped);
+      }
+      ::close(fd);
+#endif
+      open_ = true;
+      return true;
+   }
+
+   void close() {
+#ifdef _WIN32
+      if (data_ != nullptr) UnmapViewOfFile(data_);
+      if (mapping_ != nullptr) CloseHandle(mapping_);
+      if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+      mapping_ = nullptr;
+      file_ = INVALID_HANDLE_VALUE;
+#else
+      if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+#endif
+      data_ = nullptr;
+      size_ = 0;
+      open_ = false;
+   }
+
+   bool is_open() const { return open_; }
+   const char* data() const { return data_; }
+   size_t size() const { return size_; }
+
+private:
+   const char* data_ = nullptr;
+   size_t size_ = 0;
+   bool open_ = false;
+#ifdef _WIN32
+   HANDLE file_ = INVALID_HANDLE_VALUE;
+   HANDLE mapping_ = nullptr;
+#endif
+};
+
+struct TextReadOptions {
+   bool skip_comments = true;   // пропускать строки, начинающиеся с '#'
+   const char* separators = ""; // разделители чисел помимо пробельных символов, например ","
+   bool track_lines = false;    // запоминать номер строки файла для каждой строки данных
+};
+
+// Нечисловая строка файла
+struct TextDirective {
+   std::string text; // без начальных и конечных пробелов
+   size_t line = 0;  // номер строки файла, с 1
+   size_t row = 0;   // число строк данных перед директивой
+};
+
+// Результат разбора: числа всех строк данных подряд и разметка строк
+struct TextColumns {
+   std::vector<double> values;
+   std::vector<size_t> row_end;             // конец строки данных r в values
+   std::vector<unsigned char> row_stopped;  // после чисел строки есть нечисловой хвост
+   std::vector<size_t> row_line;            // номер строки файла (при track_lines)
+   std::vector<TextDirective> directives;
+
+   size_t rows() const { return row_end.size(); }
+   size_t row_begin(size_t r) const { return r == 0 ? 0 : row_end[r - 1]; }
+   size_t row_size(size_t r) const { return row_end[r] - row_begin(r); }
+   const double* row(size_t r) const { return values.data() + row_begin(r); } // r == rows() - конец данных
+};
+
+inline bool text_is_space(char c) {
+   return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+// Разбор числа в позиции p; возвращает указатель за числом или nullptr.
+// Как и operator>>, не принимает слова (inf, nan) и допускает один знак
+// ('+' или '-', но не "+-").
+inline const char* text_parse_number(const char* p, const char* end, double& value) {
+   const char* first = p;
+   const char* digits = first;
+   if (first < end && *first == '+') digits = ++first;
+   else if (first < end && *first == '-') digits = first + 1;
+   if (digits == end || !((*digits >= '0' && *digits <= '9') || *digits == '.')) return nullptr;
+   auto result = std::from_chars(first, end, value);
+   if (result.ec != std::errc()) return nullptr;
+   return result.ptr;
+}
+
+// Разбор одной строки (без символа перевода строки)
+inline void text_parse_line(const char* begin, const char* end, size_t line,
+   const TextReadOptions& options, const bool* separator, TextColumns& out) {
+   while (begin < end && text_is_space(*begin)) begin++;
+   while (end > begin && text_is_space(end[-1])) end--;
+   if (begin == end) return;
+   if (options.skip_comments && *begin == '#') return;
+
+   size_t count = 0;
+   bool stopped = false;
+   const char* p = begin;
+   while (p < end) {
+      double value;
+      const char* next = text_parse_number(p, end, value);
+      if (next == nullptr) {
+         stopped = true;
+         break;
+      }
+      out.values.push_back(value);
+      count++;
+      p = next;
+      while (p < end && separator[static_cast<unsigned char>(*p)]) p++;
+   }
+
+   if (count == 0) {
+      TextDirective directive;
+      directive.text.assign(begin, end);
+      directive.line = line;
+      directive.row = out.row_end.size();
+      out.directives.push_back(std::move(directive));
+      return;
+   }
+
+   out.row_end.push_back(out.values.size());
+   out.row_stopped.push_back(stopped ? 1 : 0);
+   if (options.track_lines) out.row_line.push_back(line);
+}
+
+// Разбор участка [begin, end), начинающегося с начала строки.
+// Номера строк локальные (с 1); возвращает число строк участка.
+inline size_t text_parse_range(const char* begin, const char* end,
+   const TextReadOptions& options, const bool* separator, TextColumns& out) {
+   size_t line = 0;
+   const char* p = begin;
+   while (p < end) {
+      const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      if (eol == nullptr) eol = end;
+      text_parse_line(p, eol, ++line, options, separator, out);
+      p = eol + 1;
+   }
+   return line;
+}
+
+// Границы участков для параллельного разбора: участки не меньше 1 МБ,
+// каждая граница сдвигается к началу следующей строки
+inline std::vector<size_t> text_part_bounds(const char* data, size_t size) {
+   const size_t min_part = size_t(1) << 20;
+   size_t parts = std::max<size_t>(1, std::min<size_t>(hardware_threads(), size / min_part));
+   std::vector<size_t> bounds(parts + 1, size);
+   bounds[0] = 0;
+   for (size_t p = 1; p < parts; p++) {
+      size_t b = std::max(bounds[p - 1], size / parts * p);
+      while (b < size && b > 0 && data[b - 1] != '\n') b++;
+      bounds[p] = b;
+   }
+   return bounds;
+}
+
+// Разбор сжатого файла по мере распаковки. Участки разбираются прямо
+// в columns; локальные номера строк участка сдвигаются на число уже
+// прочитанных строк.
+inline bool read_compressed_text_columns(const std::string& filename, TextColumns& columns,
+   const TextReadOptions& options, const bool* separator) {
+   size_t line_offset = 0;
+   return read_input_lines(filename, [&](const char* begin, const char* end) {
+      size_t first_row = columns.row_line.size();
+      size_t first_directive = columns.directives.size();
+      size_t shift = line_offset;
+      line_offset += text_parse_range(begin, end, options, separator, columns);
+      for (size_t r = first_row; r < columns.row_line.size(); r++) columns.row_line[r] += shift;
+      for (size_t d = first_directive; d < columns.directives.size(); d++) columns.directives[d].line += shift;
+   });
+}
+
+// Таблица разделителей: пробельные символы и options.separators
+inline void text_separator_table(const TextReadOptions& options, bool* separator) {
+   std::fill(separator, separator + 256, false);
+   for (const char* s = " \t\r\n\v\f"; *s; s++) separator[static_cast<unsigned char>(*s)] = true;
+   for (const char* s = options.separators; *s; s++) separator[static_cast<unsigned char>(*s)] = true;
+}
+
+// Разбор текста в памяти (участки - параллельно), результат дописывается в
+// пустой columns. data должен начинаться с начала строки.
+inline void parse_text_buffer(const char* data, size_t size, TextColumns& columns,
+   const TextReadOptions& options, const bool* separator) {
+   STAT_PROFILE_COUNT("read_bytes", size);
+   std::vector<size_t> bounds = text_part_bounds(data, size);
+   size_t parts = bounds.size() - 1;
+
+   if (parts == 1) {
+      text_parse_range(data, data + size, options, separator, columns);
+      return;
+   }
+
+   std::vector<TextColumns> partial(parts);
+   std::vector<size_t> lines(parts, 0);
+   parallel_for(parts, 1, [&](size_t first, size_t last) {
+      for (size_t p = first; p < last; p++) {
+         STAT_PROFILE_SCOPE("parse_text_part");
+         lines[p] = text_parse_range(data + bounds[p], data + bounds[p + 1], options, separator, partial[p]);
+      }
+   });
+
+   // Склейка участков по порядку со сдвигом индексов и номеров строк
+   STAT_PROFILE_SCOPE("merge_text_parts");
+   size_t total_values = 0, total_rows = 0;
+   for (const TextColumns& part : partial) {
+      total_values += part.values.size();
+      total_rows += part.rows();
+   }
+   columns.values.reserve(total_values);
+   columns.row_end.reserve(total_rows);
+   columns.row_stopped.reserve(total_rows);
+   if (options.track_lines) columns.row_line.reserve(total_rows);
+
+   size_t line_offset = 0;
+   for (size_t p = 0; p < parts; p++) {
+      TextColumns& part = partial[p];
+      size_t value_offset = columns.values.size();
+      size_t row_offset = columns.rows();
+
+      columns.values.insert(columns.values.end(), part.values.begin(), part.values.end());
+      for (size_t end : part.row_end) columns.row_end.push_back(end + value_offset);
+      columns.row_stopped.insert(columns.row_stopped.end(), part.row_stopped.begin(), part.row_stopped.end());
+      for (size_t line : part.row_line) columns.row_line.push_back(line + line_offset);
+      for (TextDirective& directive : part.directives) {
+         directive.line += line_offset;
+         directive.row += row_offset;
+         columns.directives.push_back(std::move(directive));
+      }
+
+      line_offset += lines[p];
+      std::vector<double>().swap(part.values);
+   }
+}
+
+// Чтение и разбор всего файла. Возвращает false, если файл не удалось открыть.
+inline bool read_text_columns(const std::string& filename, TextColumns& columns,
+   const TextReadOptions& options = TextReadOptions()) {
+   STAT_PROFILE_SCOPE("read_text_columns");
+   columns = TextColumns();
+
+   bool separator[256];
+   text_separator_table(options, separator);
+
+   if (detect_input_compression(filename) != InputCompression::None) {
+      return read_compressed_text_columns(filename, columns, options, separator);
+   }
+
+   MappedFile file(filename);
+   if (!file.is_open()) return false;
+
+   parse_text_buffer(file.data(), file.size(), columns, options, separator);
+   return true;
+}
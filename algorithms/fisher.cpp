@@ -17,6 +17,16 @@
 #include <boost/math/distributions/non_central_f.hpp>
 #include <boost/math/distributions/binomial.hpp>
 
+#include "ab_batch.h"
+#include "columnar.h"
+#include "fast_reader.h"
+#include "moments.h"
+#include "parallel_sort.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+#include "stream_moments.h"
+
 using namespace std;
 using namespace boost::math;
 
@@ -44,6 +54,7 @@ double t_cdf(double x, double f) {
 }
 
 double t_ppf(double p, double f) {
+   STAT_PROFILE_SCOPE("t_ppf");
    if (p <= 0 || p >= 1) return 0;
    students_t_distribution<> d(f);
    return quantile(d, p);
@@ -61,6 +72,7 @@ double f_cdf(double x, double f1, double f2) {
 }
 
 double f_ppf(double p, double f1, double f2) {
+   STAT_PROFILE_SCOPE("f_ppf");
    if (p <= 0 || p >= 1) return 0;
    fisher_f_distribution<> d(f1, f2);
    return quantile(d, p);
@@ -73,89 +85,84 @@ double f_pdf(double x, double f1, double f2) {
 
 // Функция для чтения данных из файла для двух выборок
 pair<vector<double>, vector<double>> readTwoSamplesFromFile(const string& filename) {
+   STAT_PROFILE_SCOPE("read_data");
    vector<double> sample1, sample2;
-   ifstream file(filename);
 
-   if (!file.is_open()) {
+   // Двоичный столбцовый файл (columnar.h): выборки 0 и 1 столбца group
+   if (is_columnar_file(filename)) {
+       ColumnarFile file;
+       if (!file.open(filename)) {
+           cerr << "Некорректный двоичный файл данных: " << filename << endl;
+           return make_pair(sample1, sample2);
+       }
+       vector<vector<double>> groups = columnar_groups(file);
+       if (groups.size() > 0) sample1.swap(groups[0]);
+       if (groups.size() > 1) sample2.swap(groups[1]);
+       return make_pair(sample1, sample2);
+   }
+
+   TextReadOptions options;
+   options.skip_comments = false;
+   TextColumns columns;
+
+   if (!read_text_columns(filename, columns, options)) {
        cerr << "Ошибка открытия файла: " << filename << endl;
        return make_pair(sample1, sample2);
    }
 
-   string line;
+   // Из каждой строки данных берется первое число; метки выборок
+   // и нечисловые строки хранятся как директивы между строками данных
    int currentSample = 1;
+   size_t next = 0;
+   auto takeRows = [&](size_t until) {
+       vector<double>& sample = (currentSample == 1) ? sample1 : sample2;
+       for (; next < until; ++next) {
+           sample.push_back(columns.row(next)[0]);
+       }
+   };
 
-   while (getline(file, line)) {
-       if (line.empty()) continue;
-
-       if (line == "Sample1:") {
+   for (const TextDirective& directive : columns.directives) {
+       takeRows(directive.row);
+       if (directive.text == "Sample1:") {
            currentSample = 1;
-           continue;
        }
-       else if (line == "Sample2:") {
+       else if (directive.text == "Sample2:") {
            currentSample = 2;
-           continue;
        }
-
-       double value;
-       try {
-           value = stod(line);
-           if (currentSample == 1) {
-               sample1.push_back(value);
-           }
-           else {
-               sample2.push_back(value);
-           }
-       }
-       catch (const exception& e) {
-           cerr << "Ошибка преобразования числа: " << line << endl;
+       else {
+           cerr << "Ошибка преобразования числа: " << directive.text << endl;
        }
    }
+   takeRows(columns.rows());
 
-   file.close();
    return make_pair(sample1, sample2);
 }
 
-// Функция для вычисления выборочного среднего
-double calculateMean(const vector<double>& data) {
-   if (data.empty()) return 0.0;
-   double sum = 0.0;
-   for (double value : data) {
-       sum += value;
-   }
-   return sum / data.size();
-}
-
-// Функция для вычисления выборочной дисперсии
-double calculateVariance(const vector<double>& data, double mean) {
-   if (data.size() <= 1) return 0.0;
-
-   double sumSquares = 0.0;
-   for (double value : data) {
-       sumSquares += (value - mean) * (value - mean);
-   }
-   return sumSquares / (data.size() - 1);
-}
-
-// Функция для вычисления стандартного отклонения
-double calculateStdDev(const vector<double>& data, double mean) {
-   return sqrt(calculateVariance(data, mean));
-}
+// Итоги критерия для машиночитаемого вывода (result_writer.h)
+struct FisherStudentSummary {
+   size_t n1 = 0, n2 = 0;
+   double mean1 = NAN, mean2 = NAN, var1 = NAN, var2 = NAN;
+   double F = NAN, F_critical = NAN;
+   int F_df1 = 0, F_df2 = 0;
+   bool equalVariances = false;
+   const char* test = "";   // "pooled" или "welch"
+   double t = NAN, df = NAN, t_critical = NAN;
+   bool meansEqual = false;
+};
 
 // Функция для проверки равенства дисперсий (F-критерий)
-bool checkEqualVariances(const vector<double>& sample1, const vector<double>& sample2,
-   double alpha, ofstream& outputFile) {
-   int n1 = sample1.size();
-   int n2 = sample2.size();
+bool checkEqualVariances(const SampleMoments& moments1, const SampleMoments& moments2,
+   double alpha, ostream& outputFile, FisherStudentSummary& summary) {
+   int n1 = moments1.count;
+   int n2 = moments2.count;
 
    if (n1 < 2 || n2 < 2) {
-       outputFile << "ОШИБКА: Для проверки равенства дисперсий нужны выборки объемом >= 2" << endl;
+       outputFile << "ОШИБКА: Для проверки равенства дисперсий нужны выборки объемом >= 2" << '\n';
        return false;
    }
 
-   double mean1 = calculateMean(sample1);
-   double mean2 = calculateMean(sample2);
-   double var1 = calculateVariance(sample1, mean1);
-   double var2 = calculateVariance(sample2, mean2);
+   double var1 = moments1.variance();
+   double var2 = moments2.variance();
 
    // Вычисляем F-статистику (большая дисперсия в числителе)
    double F_statistic;
@@ -175,37 +182,44 @@ bool checkEqualVariances(const vector<double>& sample1, const vector<double>& sa
    // Критическое значение F-распределения
    double F_critical = f_ppf(1 - alpha / 2, f1, f2); // Двусторонний критерий
 
-   outputFile << "ПРОВЕРКА РАВЕНСТВА ДИСПЕРСИЙ (F-критерий):" << endl;
-   outputFile << "Дисперсия выборки 1: " << var1 << " (n1 = " << n1 << ", f1 = " << f1 << ")" << endl;
-   outputFile << "Дисперсия выборки 2: " << var2 << " (n2 = " << n2 << ", f2 = " << f2 << ")" << endl;
-   outputFile << "F-статистика: " << F_statistic << endl;
-   outputFile << "Критическое значение F(" << alpha / 2 << "; " << f1 << ", " << f2 << "): " << F_critical << endl;
+   outputFile << "ПРОВЕРКА РАВЕНСТВА ДИСПЕРСИЙ (F-критерий):" << '\n';
+   outputFile << "Дисперсия выборки 1: " << var1 << " (n1 = " << n1 << ", f1 = " << f1 << ")" << '\n';
+   outputFile << "Дисперсия выборки 2: " << var2 << " (n2 = " << n2 << ", f2 = " << f2 << ")" << '\n';
+   outputFile << "F-статистика: " << F_statistic << '\n';
+   outputFile << "Критическое значение F(" << alpha / 2 << "; " << f1 << ", " << f2 << "): " << F_critical << '\n';
 
    bool variancesEqual = (F_statistic <= F_critical);
+   summary.var1 = var1;
+   summary.var2 = var2;
+   summary.F = F_statistic;
+   summary.F_df1 = f1;
+   summary.F_df2 = f2;
+   summary.F_critical = F_critical;
+   summary.equalVariances = variancesEqual;
 
    if (variancesEqual) {
-       outputFile << "ВЫВОД: Дисперсии СТАТИСТИЧЕСКИ НЕ РАЗЛИЧАЮТСЯ (принимаем H₀)" << endl;
-       outputFile << "Гипотеза о равенстве дисперсий принимается на уровне значимости " << alpha << endl;
+       outputFile << "ВЫВОД: Дисперсии СТАТИСТИЧЕСКИ НЕ РАЗЛИЧАЮТСЯ (принимаем H₀)" << '\n';
+       outputFile << "Гипотеза о равенстве дисперсий принимается на уровне значимости " << alpha << '\n';
    }
    else {
-       outputFile << "ВЫВОД: Дисперсии СТАТИСТИЧЕСКИ РАЗЛИЧАЮТСЯ (отвергаем H₀)" << endl;
-       outputFile << "Гипотеза о равенстве дисперсий отвергается на уровне значимости " << alpha << endl;
+       outputFile << "ВЫВОД: Дисперсии СТАТИСТИЧЕСКИ РАЗЛИЧАЮТСЯ (отвергаем H₀)" << '\n';
+       outputFile << "Гипотеза о равенстве дисперсий отвергается на уровне значимости " << alpha << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 
    return variancesEqual;
 }
 
 // Точный критерий Стьюдента для равных дисперсий (формула 3.5)
-void performExactTTest(const vector<double>& sample1, const vector<double>& sample2,
-   double alpha, ofstream& outputFile) {
-   int n1 = sample1.size();
-   int n2 = sample2.size();
+void performExactTTest(const SampleMoments& moments1, const SampleMoments& moments2,
+   double alpha, ostream& outputFile, FisherStudentSummary& summary) {
+   int n1 = moments1.count;
+   int n2 = moments2.count;
 
-   double mean1 = calculateMean(sample1);
-   double mean2 = calculateMean(sample2);
-   double var1 = calculateVariance(sample1, mean1);
-   double var2 = calculateVariance(sample2, mean2);
+   double mean1 = moments1.mean;
+   double mean2 = moments2.mean;
+   double var1 = moments1.variance();
+   double var2 = moments2.variance();
 
    // Объединенная дисперсия (формула 3.6)
    double pooledVariance = ((n1 - 1) * var1 + (n2 - 1) * var2) / (n1 + n2 - 2);
@@ -218,36 +232,41 @@ void performExactTTest(const vector<double>& sample1, const vector<double>& samp
    // Критическое значение
    double t_critical = t_ppf(1 - alpha / 2, degreesOfFreedom); // Двусторонний критерий
 
-   outputFile << "ТОЧНЫЙ КРИТЕРИЙ СТЬЮДЕНТА (равные дисперсии):" << endl;
-   outputFile << "Среднее выборки 1: " << mean1 << endl;
-   outputFile << "Среднее выборки 2: " << mean2 << endl;
-   outputFile << "Разность средних: " << mean1 - mean2 << endl;
-   outputFile << "Объединенная дисперсия: " << pooledVariance << endl;
-   outputFile << "t-статистика: " << t_statistic << endl;
-   outputFile << "Степени свободы: f = " << degreesOfFreedom << endl;
-   outputFile << "Критическое значение t(" << alpha / 2 << "; " << degreesOfFreedom << "): " << t_critical << endl;
+   outputFile << "ТОЧНЫЙ КРИТЕРИЙ СТЬЮДЕНТА (равные дисперсии):" << '\n';
+   outputFile << "Среднее выборки 1: " << mean1 << '\n';
+   outputFile << "Среднее выборки 2: " << mean2 << '\n';
+   outputFile << "Разность средних: " << mean1 - mean2 << '\n';
+   outputFile << "Объединенная дисперсия: " << pooledVariance << '\n';
+   outputFile << "t-статистика: " << t_statistic << '\n';
+   outputFile << "Степени свободы: f = " << degreesOfFreedom << '\n';
+   outputFile << "Критическое значение t(" << alpha / 2 << "; " << degreesOfFreedom << "): " << t_critical << '\n';
+
+   summary.t = t_statistic;
+   summary.df = degreesOfFreedom;
+   summary.t_critical = t_critical;
+   summary.meansEqual = abs(t_statistic) <= t_critical;
 
    if (abs(t_statistic) <= t_critical) {
-       outputFile << "ВЫВОД: Средние значения СТАТИСТИЧЕСКИ НЕ РАЗЛИЧАЮТСЯ" << endl;
-       outputFile << "Гипотеза о равенстве средних принимается на уровне значимости " << alpha << endl;
+       outputFile << "ВЫВОД: Средние значения СТАТИСТИЧЕСКИ НЕ РАЗЛИЧАЮТСЯ" << '\n';
+       outputFile << "Гипотеза о равенстве средних принимается на уровне значимости " << alpha << '\n';
    }
    else {
-       outputFile << "ВЫВОД: Средние значения СТАТИСТИЧЕСКИ РАЗЛИЧАЮТСЯ" << endl;
-       outputFile << "Гипотеза о равенстве средних отвергается на уровне значимости " << alpha << endl;
+       outputFile << "ВЫВОД: Средние значения СТАТИСТИЧЕСКИ РАЗЛИЧАЮТСЯ" << '\n';
+       outputFile << "Гипотеза о равенстве средних отвергается на уровне значимости " << alpha << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 }
 
 // Приближенный критерий Стьюдента для неравных дисперсий (формула 3.7)
-void performApproximateTTest(const vector<double>& sample1, const vector<double>& sample2,
-   double alpha, ofstream& outputFile) {
-   int n1 = sample1.size();
-   int n2 = sample2.size();
+void performApproximateTTest(const SampleMoments& moments1, const SampleMoments& moments2,
+   double alpha, ostream& outputFile, FisherStudentSummary& summary) {
+   int n1 = moments1.count;
+   int n2 = moments2.count;
 
-   double mean1 = calculateMean(sample1);
-   double mean2 = calculateMean(sample2);
-   double var1 = calculateVariance(sample1, mean1);
-   double var2 = calculateVariance(sample2, mean2);
+   double mean1 = moments1.mean;
+   double mean2 = moments2.mean;
+   double var1 = moments1.variance();
+   double var2 = moments2.variance();
 
    // t-статистика для неравных дисперсий (формула 3.7)
    double t_statistic = (mean1 - mean2) / sqrt(var1 / n1 + var2 / n2);
@@ -259,116 +278,198 @@ void performApproximateTTest(const vector<double>& sample1, const vector<double>
    // Критическое значение
    double t_critical = t_ppf(1 - alpha / 2, degreesOfFreedom); // Двусторонний критерий
 
-   outputFile << "ПРИБЛИЖЕННЫЙ КРИТЕРИЙ СТЬЮДЕНТА (неравные дисперсии):" << endl;
-   outputFile << "Среднее выборки 1: " << mean1 << endl;
-   outputFile << "Среднее выборки 2: " << mean2 << endl;
-   outputFile << "Разность средних: " << mean1 - mean2 << endl;
-   outputFile << "Дисперсия выборки 1: " << var1 << endl;
-   outputFile << "Дисперсия выборки 2: " << var2 << endl;
-   outputFile << "t-статистика: " << t_statistic << endl;
-   outputFile << "Степени свободы (по Уэлчу): f = " << degreesOfFreedom << endl;
-   outputFile << "Критическое значение t(" << alpha / 2 << "; " << degreesOfFreedom << "): " << t_critical << endl;
+   outputFile << "ПРИБЛИЖЕННЫЙ КРИТЕРИЙ СТЬЮДЕНТА (неравные дисперсии):" << '\n';
+   outputFile << "Среднее выборки 1: " << mean1 << '\n';
+   outputFile << "Среднее выборки 2: " << mean2 << '\n';
+   outputFile << "Разность средних: " << mean1 - mean2 << '\n';
+   outputFile << "Дисперсия выборки 1: " << var1 << '\n';
+   outputFile << "Дисперсия выборки 2: " << var2 << '\n';
+   outputFile << "t-статистика: " << t_statistic << '\n';
+   outputFile << "Степени свободы (по Уэлчу): f = " << degreesOfFreedom << '\n';
+   outputFile << "Критическое значение t(" << alpha / 2 << "; " << degreesOfFreedom << "): " << t_critical << '\n';
+
+   summary.t = t_statistic;
+   summary.df = degreesOfFreedom;
+   summary.t_critical = t_critical;
+   summary.meansEqual = abs(t_statistic) <= t_critical;
 
    if (abs(t_statistic) <= t_critical) {
-       outputFile << "ВЫВОД: Средние значения СТАТИСТИЧЕСКИ НЕ РАЗЛИЧАЮТСЯ" << endl;
-       outputFile << "Гипотеза о равенстве средних принимается на уровне значимости " << alpha << endl;
+       outputFile << "ВЫВОД: Средние значения СТАТИСТИЧЕСКИ НЕ РАЗЛИЧАЮТСЯ" << '\n';
+       outputFile << "Гипотеза о равенстве средних принимается на уровне значимости " << alpha << '\n';
    }
    else {
-       outputFile << "ВЫВОД: Средние значения СТАТИСТИЧЕСКИ РАЗЛИЧАЮТСЯ" << endl;
-       outputFile << "Гипотеза о равенстве средних отвергается на уровне значимости " << alpha << endl;
+       outputFile << "ВЫВОД: Средние значения СТАТИСТИЧЕСКИ РАЗЛИЧАЮТСЯ" << '\n';
+       outputFile << "Гипотеза о равенстве средних отвергается на уровне значимости " << alpha << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 }
 
 // Основная функция для применения критерия Фишера-Стьюдента
-void performFisherStudentTest(const vector<double>& sample1, const vector<double>& sample2,
-   double alpha, ofstream& outputFile) {
-   int n1 = sample1.size();
-   int n2 = sample2.size();
-
-   outputFile << "==================================================" << endl;
-   outputFile << "   КРИТЕРИЙ ФИШЕРА-СТЬЮДЕНТА ДЛЯ ДВУХ ВЫБОРОК" << endl;
-   outputFile << "==================================================" << endl;
-   outputFile << endl;
-
-   outputFile << "ОСНОВНЫЕ ПАРАМЕТРЫ:" << endl;
-   outputFile << "Объем выборки 1: n1 = " << n1 << endl;
-   outputFile << "Объем выборки 2: n2 = " << n2 << endl;
-   outputFile << "Уровень значимости: alpha = " << alpha << endl;
-   outputFile << "Двусторонний критерий" << endl;
-   outputFile << endl;
+void performFisherStudentTest(const SampleMoments& moments1, const SampleMoments& moments2,
+   double alpha, ostream& outputFile, FisherStudentSummary& summary) {
+   STAT_PROFILE_SCOPE("fisher_student_test");
+   int n1 = moments1.count;
+   int n2 = moments2.count;
+   summary.n1 = moments1.count;
+   summary.n2 = moments2.count;
+   summary.mean1 = moments1.mean;
+   summary.mean2 = moments2.mean;
+
+   outputFile << "==================================================" << '\n';
+   outputFile << "   КРИТЕРИЙ ФИШЕРА-СТЬЮДЕНТА ДЛЯ ДВУХ ВЫБОРОК" << '\n';
+   outputFile << "==================================================" << '\n';
+   outputFile << '\n';
+
+   outputFile << "ОСНОВНЫЕ ПАРАМЕТРЫ:" << '\n';
+   outputFile << "Объем выборки 1: n1 = " << n1 << '\n';
+   outputFile << "Объем выборки 2: n2 = " << n2 << '\n';
+   outputFile << "Уровень значимости: alpha = " << alpha << '\n';
+   outputFile << "Двусторонний критерий" << '\n';
+   outputFile << '\n';
 
    // Шаг 1: Проверка равенства дисперсий
-   bool variancesEqual = checkEqualVariances(sample1, sample2, alpha, outputFile);
+   bool variancesEqual = checkEqualVariances(moments1, moments2, alpha, outputFile, summary);
 
    // Шаг 2: Проверка равенства средних
-   outputFile << "ПРОВЕРКА РАВЕНСТВА СРЕДНИХ:" << endl;
+   outputFile << "ПРОВЕРКА РАВЕНСТВА СРЕДНИХ:" << '\n';
    if (variancesEqual) {
-       outputFile << "Используется ТОЧНЫЙ критерий Стьюдента (дисперсии равны)" << endl;
-       performExactTTest(sample1, sample2, alpha, outputFile);
+       outputFile << "Используется ТОЧНЫЙ критерий Стьюдента (дисперсии равны)" << '\n';
+       summary.test = "pooled";
+       performExactTTest(moments1, moments2, alpha, outputFile, summary);
    }
    else {
-       outputFile << "Используется ПРИБЛИЖЕННЫЙ критерий Стьюдента (дисперсии различны)" << endl;
-       performApproximateTTest(sample1, sample2, alpha, outputFile);
+       outputFile << "Используется ПРИБЛИЖЕННЫЙ критерий Стьюдента (дисперсии различны)" << '\n';
+       summary.test = "welch";
+       performApproximateTTest(moments1, moments2, alpha, outputFile, summary);
    }
+}
 
-   // Детальная информация о выборках
-   outputFile << "ДЕТАЛЬНАЯ ИНФОРМАЦИЯ О ВЫБОРКАХ:" << endl;
+// Детальная информация о выборках
+void writeSortedSamples(const vector<double>& sample1, const vector<double>& sample2,
+   ofstream& outputFile) {
+   STAT_PROFILE_SCOPE("write_sorted_samples");
+   STAT_PROFILE_COUNT("sort_size", sample1.size() + sample2.size());
+   outputFile << "ДЕТАЛЬНАЯ ИНФОРМАЦИЯ О ВЫБОРКАХ:" << '\n';
 
    vector<double> sorted1 = sample1;
    vector<double> sorted2 = sample2;
-   sort(sorted1.begin(), sorted1.end());
-   sort(sorted2.begin(), sorted2.end());
+   parallel_sort(sorted1);
+   parallel_sort(sorted2);
 
-   outputFile << "Выборка 1 (отсортированная):" << endl;
+   outputFile << "Выборка 1 (отсортированная):" << '\n';
    for (size_t i = 0; i < sorted1.size(); ++i) {
-       outputFile << "  x1[" << setw(2) << i + 1 << "] = " << setw(10) << sorted1[i] << endl;
+       outputFile << "  x1[" << setw(2) << i + 1 << "] = " << setw(10) << sorted1[i] << '\n';
    }
 
-   outputFile << "Выборка 2 (отсортированная):" << endl;
+   outputFile << "Выборка 2 (отсортированная):" << '\n';
    for (size_t i = 0; i < sorted2.size(); ++i) {
-       outputFile << "  x2[" << setw(2) << i + 1 << "] = " << setw(10) << sorted2[i] << endl;
+       outputFile << "  x2[" << setw(2) << i + 1 << "] = " << setw(10) << sorted2[i] << '\n';
    }
 
-   outputFile << endl;
-   outputFile << "==================================================" << endl;
-   outputFile << "СТАТИСТИЧЕСКИЕ ХАРАКТЕРИСТИКИ:" << endl;
-   outputFile << "Выборка 1: среднее = " << calculateMean(sample1)
-       << ", ст. отклонение = " << calculateStdDev(sample1, calculateMean(sample1)) << endl;
-   outputFile << "Выборка 2: среднее = " << calculateMean(sample2)
-       << ", ст. отклонение = " << calculateStdDev(sample2, calculateMean(sample2)) << endl;
-   outputFile << "Коэффициент вариации 1: " << calculateStdDev(sample1, calculateMean(sample1)) / calculateMean(sample1) << endl;
-   outputFile << "Коэффициент вариации 2: " << calculateStdDev(sample2, calculateMean(sample2)) / calculateMean(sample2) << endl;
-   outputFile << "==================================================" << endl;
+   outputFile << '\n';
+}
+
+// Итоговые характеристики выборок
+void writeSampleCharacteristics(const SampleMoments& moments1, const SampleMoments& moments2,
+   ofstream& outputFile) {
+   outputFile << "==================================================" << '\n';
+   outputFile << "СТАТИСТИЧЕСКИЕ ХАРАКТЕРИСТИКИ:" << '\n';
+   outputFile << "Выборка 1: среднее = " << moments1.mean
+       << ", ст. отклонение = " << moments1.stddev() << '\n';
+   outputFile << "Выборка 2: среднее = " << moments2.mean
+       << ", ст. отклонение = " << moments2.stddev() << '\n';
+   outputFile << "Коэффициент вариации 1: " << moments1.stddev() / moments1.mean << '\n';
+   outputFile << "Коэффициент вариации 2: " << moments2.stddev() / moments2.mean << '\n';
+   outputFile << "==================================================" << '\n';
+}
+
+void performFisherStudentTest(const vector<double>& sample1, const vector<double>& sample2,
+   double alpha, ofstream& outputFile, FisherStudentSummary& summary) {
+   // Описательные статистики выборок (один проход по каждой выборке)
+   SampleMoments moments1 = compute_moments(sample1);
+   SampleMoments moments2 = compute_moments(sample2);
+
+   performFisherStudentTest(moments1, moments2, alpha, outputFile, summary);
+   writeSortedSamples(sample1, sample2, outputFile);
+   writeSampleCharacteristics(moments1, moments2, outputFile);
+}
+
+// Запись итогов критерия в формате JSON Lines или CSV
+bool writeFisherStudentRecord(const string& filename, const ResultOptions& options,
+   double alpha, const FisherStudentSummary& s) {
+   ResultWriter writer;
+   if (!writer.open(filename, options, "fisher_student", { "n1", "n2", "mean1", "mean2", "var1", "var2",
+       "alpha", "f", "f_df1", "f_df2", "f_critical", "equal_variances",
+       "test", "t", "df", "t_critical", "equal_means" })) {
+       cerr << "ОШИБКА: Не удалось создать выходной файл: " << filename << endl;
+       return false;
+   }
+   writer.write(s.n1, s.n2, s.mean1, s.mean2, s.var1, s.var2,
+       alpha, s.F, s.F_df1, s.F_df2, s.F_critical, s.equalVariances,
+       s.test, s.t, s.df, s.t_critical, s.meansEqual);
+   if (!writer.close()) {
+       cerr << "ОШИБКА: Ошибка записи в файл: " << filename << endl;
+       return false;
+   }
+   return true;
 }
 
 // Функция для создания тестового файла с данными
 void createTestDataFile() {
    ofstream testFile("fisher_input_data.txt");
    if (testFile.is_open()) {
-       testFile << "Sample1:" << endl;
-       testFile << "220" << endl;
-       testFile << "223" << endl;
-       testFile << "234" << endl;
-       testFile << "245" << endl;
-       testFile << "257" << endl;
-       testFile << endl;
-       testFile << "Sample2:" << endl;
-       testFile << "234" << endl;
-       testFile << "246" << endl;
-       testFile << "259" << endl;
-       testFile << "262" << endl;
-       testFile << "278" << endl;
-       testFile << "280" << endl;
-       testFile << "285" << endl;
-       testFile << "290" << endl;
+       testFile << "Sample1:" << '\n';
+       testFile << "220" << '\n';
+       testFile << "223" << '\n';
+       testFile << "234" << '\n';
+       testFile << "245" << '\n';
+       testFile << "257" << '\n';
+       testFile << '\n';
+       testFile << "Sample2:" << '\n';
+       testFile << "234" << '\n';
+       testFile << "246" << '\n';
+       testFile << "259" << '\n';
+       testFile << "262" << '\n';
+       testFile << "278" << '\n';
+       testFile << "280" << '\n';
+       testFile << "285" << '\n';
+       testFile << "290" << '\n';
        testFile.close();
        cout << "Создан тестовый файл fisher_input_data.txt с примером данных" << endl;
    }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
    setlocale(LC_ALL, "rus");
+
+   // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+   ResultCacheOptions cacheOptions;
+   if (!take_cache_options(argc, argv, cacheOptions)) return 1;
+
+   // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+   ResultOptions resultOptions;
+   if (!take_result_options(argc, argv, resultOptions)) return 1;
+
+   // Пакетный режим A/B: F.exe --batch <данные> <манифест пар> [выходной файл]
+   //                        [--format jsonl|csv] [--async-output]
+   if (argc > 1 && string(argv[1]) == "--batch") {
+       if (argc < 4) {
+           cerr << "Использование: " << argv[0] << " --batch <файл данных> <манифест пар> [выходной файл]"
+               << " [--format jsonl|csv] [--async-output]" << endl;
+           return 1;
+       }
+       string batchOutputFilename = (argc > 4) ? argv[4] : result_output_filename("ab_batch_results.tsv", resultOptions);
+       ResultCache cache(cacheOptions, "ab_batch");
+       cache.add_file(argv[2]);
+       cache.add_file(argv[3]);
+       cache.add("format", static_cast<int>(resultOptions.format));
+       cache.add_arguments(argc, argv);
+       if (cache.replay()) return 0;
+       if (!run_ab_batch(argv[2], argv[3], batchOutputFilename, resultOptions, cacheOptions)) return 1;
+       cache.store({ batchOutputFilename });
+       return 0;
+   }
+
    // Параметры критерия
    double alpha = 0.05; // Уровень значимости
 
@@ -376,6 +477,59 @@ int main() {
    string inputFilename = "fisher_input_data.txt";
    string outputFilename = "fisher_test_result.txt";
 
+   // Потоковый режим для файлов, не помещающихся в память:
+   // F.exe --stream <входной файл> [выходной файл]
+   if (argc > 1 && string(argv[1]) == "--stream") {
+       if (argc < 3) {
+           cerr << "Использование: " << argv[0] << " --stream <входной файл> [выходной файл]" << endl;
+           return 1;
+       }
+       outputFilename = (argc > 3) ? argv[3] : result_output_filename(outputFilename, resultOptions);
+
+       SampleMoments moments1, moments2;
+       cout << "Потоковое чтение данных из файла: " << argv[2] << endl;
+       if (!stream_two_samples_from_file(argv[2], moments1, moments2)) {
+           return 1;
+       }
+       if (moments1.count == 0 || moments2.count == 0) {
+           cerr << "ОШИБКА: Не удалось прочитать данные из файла или одна из выборок пуста" << endl;
+           return 1;
+       }
+
+       FisherStudentSummary summary;
+       if (resultOptions.structured()) {
+           ostream discard(nullptr);
+           performFisherStudentTest(moments1, moments2, alpha, discard, summary);
+           if (!writeFisherStudentRecord(outputFilename, resultOptions, alpha, summary)) return 1;
+       }
+       else {
+           ofstream outputFile(outputFilename);
+           if (!outputFile.is_open()) {
+               cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputFilename << endl;
+               return 1;
+           }
+           performFisherStudentTest(moments1, moments2, alpha, outputFile, summary);
+           writeSampleCharacteristics(moments1, moments2, outputFile);
+           outputFile.close();
+       }
+
+       cout << "Прочитано " << moments1.count << " значений в выборке 1" << endl;
+       cout << "Прочитано " << moments2.count << " значений в выборке 2" << endl;
+       cout << "Результаты сохранены в файл: " << outputFilename << endl;
+       return 0;
+   }
+
+   // Другой входной файл (текстовый или двоичный): --input <файл>
+   if (argc > 2 && string(argv[1]) == "--input") inputFilename = argv[2];
+
+   // Тот же файл с теми же параметрами - результат из кэша
+   ResultCache cache(cacheOptions, "fisher");
+   cache.add_file(inputFilename);
+   cache.add("alpha", alpha);
+   cache.add("format", static_cast<int>(resultOptions.format));
+   cache.add_arguments(argc, argv);
+   if (cache.replay()) return 0;
+
    cout << "ПРОГРАММА ДЛЯ СРАВНЕНИЯ ДВУХ ВЫБОРОК" << endl;
    cout << "Метод: критерий Фишера-Стьюдента" << endl;
    cout << "=============================================" << endl;
@@ -402,19 +556,29 @@ int main() {
    cout << "Прочитано " << sample1.size() << " значений в выборке 1" << endl;
    cout << "Прочитано " << sample2.size() << " значений в выборке 2" << endl;
 
-   // Создание выходного файла
-   ofstream outputFile(outputFilename);
-
-   if (!outputFile.is_open()) {
-       cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputFilename << endl;
-       return 1;
+   // Применение критерия Фишера-Стьюдента
+   FisherStudentSummary summary;
+   if (resultOptions.structured()) {
+       outputFilename = result_output_filename(outputFilename, resultOptions);
+       cout << "Применение критерия Фишера-Стьюдента..." << endl;
+       ostream discard(nullptr);
+       performFisherStudentTest(compute_moments(sample1), compute_moments(sample2), alpha, discard, summary);
+       if (!writeFisherStudentRecord(outputFilename, resultOptions, alpha, summary)) return 1;
    }
+   else {
+       // Создание выходного файла
+       ofstream outputFile(outputFilename);
 
-   // Применение критерия Фишера-Стьюдента
-   cout << "Применение критерия Фишера-Стьюдента..." << endl;
-   performFisherStudentTest(sample1, sample2, alpha, outputFile);
+       if (!outputFile.is_open()) {
+           cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputFilename << endl;
+           return 1;
+       }
+
+       cout << "Применение критерия Фишера-Стьюдента..." << endl;
+       performFisherStudentTest(sample1, sample2, alpha, outputFile, summary);
 
-   outputFile.close();
+       outputFile.close();
+   }
 
    cout << endl;
    cout << "УСПЕШНО: Критерий Фишера-Стьюдента применен." << endl;
@@ -425,5 +589,6 @@ int main() {
    cout << "  - Объем выборки 1: n1 = " << sample1.size() << endl;
    cout << "  - Объем выборки 2: n2 = " << sample2.size() << endl;
 
+   cache.store({ outputFilename });
    return 0;
 }
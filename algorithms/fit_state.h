@@ -0,0 +1,204 @@
+#pragma once
+// Состояние оценки для инкрементального пересчета (--state <файл>).
+//
+// Партии растут в течение дня: новые отказы и приостановки дописываются в
+// конец текстового файла данных. Файл состояния хранит уже прочитанные
+// наблюдения по возрастанию (с признаками цензурирования), накопители по
+// нецензурированным наблюдениям, найденные параметры и границу прочитанной
+// части файла данных. При следующем запуске разбирается только дописанный
+// хвост, новые наблюдения сортируются и сливаются с сохраненными, а
+// оптимум уточняется методом Ньютона из прежнего.
+//
+//   FitState state;
+//   load_fit_state(state_file, state);            // нет файла - пустое состояние
+//   if (update_fit_state(input, "normal_mle", state, appended)) { ... state.values ... }
+//   state.params = ...; state.fitted = true;
+//   save_fit_state(state_file, state);
+//
+// Если файл данных изменен не дописыванием (стал короче, изменился любой
+// байт перед границей: проверяется XXH64 всей прочитанной части) или
+// состояние записано другим методом, оно сбрасывается и файл читается
+// заново. Проверка - один проход хэша по файлу, без разбора текста. Двоичные (.scol) и сжатые файлы не дописываются:
+// для них update_fit_state возвращает false.
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "censored_data.h"
+#include "columnar.h"
+#include "compressed_input.h"
+#include "fast_reader.h"
+#include "moments.h"
+#include "parallel_sort.h"
+#include "profiler.h"
+#include "xxhash.h"
+
+const char fit_state_magic[8] = { 'S', 'T', 'A', 'T', 'F', 'I', 'T', '2' };
+
+struct FitState {
+   std::string method;               // метод, записавший состояние
+   std::uint64_t consumed = 0;       // байт файла данных разобрано
+   std::uint64_t check = 0;          // XXH64 байтов [0, consumed)
+   bool fitted = false;              // params - оптимум для текущих данных до дописывания
+   std::array<double, 2> params{};
+   SampleMoments failures;           // моменты нецензурированных наблюдений
+   std::vector<double> values;       // все наблюдения по возрастанию
+   std::vector<std::uint8_t> censored;
+
+   void reset(const std::string& new_method) {
+      *this = FitState();
+      method = new_method;
+   }
+};
+
+inline bool save_fit_state(const std::string& filename, const FitState& state) {
+   STAT_PROFILE_SCOPE("save_fit_state");
+   // Запись во временный файл и замена: прерванная запись не портит состояние
+   std::string temporary = filename + ".tmp";
+   {
+      std::ofstream out(temporary, std::ios::binary);
+      if (!out.is_open()) return false;
+      auto put = [&out](const void* bytes, size_t size) { out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size)); };
+      std::uint64_t method_size = state.method.size();
+      std::uint64_t count = state.values.size();
+      std::uint8_t fitted = state.fitted ? 1 : 0;
+      const SampleMoments& m = state.failures;
+      std::uint64_t failures = m.count;
+      double moments[6] = { m.mean, m.m2, m.m3, m.m4, m.min, m.max };
+
+      put(fit_state_magic, sizeof(fit_state_magic));
+      put(&method_size, sizeof(method_size));
+      put(state.method.data(), state.method.size());
+      put(&state.consumed, sizeof(state.consumed));
+      put(&state.check, sizeof(state.check));
+      put(&fitted, sizeof(fitted));
+      put(state.params.data(), sizeof(state.params));
+      put(&failures, sizeof(failures));
+      put(moments, sizeof(moments));
+      put(&count, sizeof(count));
+      put(state.values.data(), count * sizeof(double));
+      put(state.censored.data(), count);
+      if (!out) return false;
+   }
+   std::remove(filename.c_str());
+   return std::rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+// false - файла нет или он поврежден (state не изменяется)
+inline bool load_fit_state(const std::string& filename, FitState& state) {
+   STAT_PROFILE_SCOPE("load_fit_state");
+   std::ifstream in(filename, std::ios::binary);
+   if (!in.is_open()) return false;
+   auto get = [&in](void* bytes, size_t size) { in.read(static_cast<char*>(bytes), static_cast<std::streamsize>(size)); return static_cast<bool>(in); };
+
+   char magic[8];
+   std::uint64_t method_size = 0;
+   if (!get(magic, sizeof(magic)) || !std::equal(magic, magic + 8, fit_state_magic)) return false;
+   if (!get(&method_size, sizeof(method_size)) || method_size > 256) return false;
+
+   FitState loaded;
+   loaded.method.resize(method_size);
+   std::uint8_t fitted = 0;
+   std::uint64_t failures = 0, count = 0;
+   double moments[6];
+   if (!get(&loaded.method[0], method_size) || !get(&loaded.consumed, sizeof(loaded.consumed)) ||
+      !get(&loaded.check, sizeof(loaded.check)) || !get(&fitted, sizeof(fitted)) ||
+      !get(loaded.params.data(), sizeof(loaded.params)) || !get(&failures, sizeof(failures)) ||
+      !get(moments, sizeof(moments)) || !get(&count, sizeof(count))) {
+      return false;
+   }
+   loaded.fitted = fitted != 0;
+   loaded.failures.count = failures;
+   loaded.failures.mean = moments[0];
+   loaded.failures.m2 = moments[1];
+   loaded.failures.m3 = moments[2];
+   loaded.failures.m4 = moments[3];
+   loaded.failures.min = moments[4];
+   loaded.failures.max = moments[5];
+   loaded.values.resize(count);
+   loaded.censored.resize(count);
+   if (!get(loaded.values.data(), count * sizeof(double)) || !get(loaded.censored.data(), count)) return false;
+
+   state = std::move(loaded);
+   return true;
+}
+
+// Дочитывает в state наблюдения, дописанные в текстовый файл input после
+// state.consumed (формат "значение,цензурирование", как у read_censored_data).
+// appended - число новых наблюдений. Разбираются только целые строки:
+// последняя строка без перевода строки может дописываться в этот момент и
+// остается до следующего запуска. false - файл не открывается или не
+// текстовый: тогда его нужно читать целиком обычным образом.
+inline bool update_fit_state(const std::string& input, const std::string& method, FitState& state, size_t& appended) {
+   STAT_PROFILE_SCOPE("update_fit_state");
+   appended = 0;
+   if (is_columnar_file(input) || detect_input_compression(input) != InputCompression::None) return false;
+   MappedFile file(input);
+   if (!file.is_open()) return false;
+
+   const char* data = file.data();
+   std::uint64_t size = file.size();
+   // Хэш прочитанной части продолжается по новым строкам: один проход по файлу
+   Xxh64 check;
+   if (state.method != method || size < state.consumed) {
+      state.reset(method);
+   }
+   else {
+      check.update(data, state.consumed);
+      if (check.digest() != state.check) {
+         state.reset(method);
+         check = Xxh64();
+      }
+   }
+   std::uint64_t end = size;
+   while (end > state.consumed && data[end - 1] != '\n') end--;
+
+   TextReadOptions options;
+   options.separators = ",;";
+   bool separator[256];
+   text_separator_table(options, separator);
+   TextColumns columns;
+   parse_text_buffer(data + state.consumed, end - state.consumed, columns, options, separator);
+
+   std::vector<double> values;
+   std::vector<int> flags;
+   censored_rows(columns, values, flags);
+   std::vector<std::uint8_t> censored(flags.size());
+   for (size_t i = 0; i < flags.size(); ++i) {
+      censored[i] = static_cast<std::uint8_t>(flags[i]);
+      if (flags[i] == 0) state.failures.add(values[i]);
+   }
+   appended = values.size();
+
+   // Новые наблюдения сортируются и сливаются с сохраненными (при равных
+   // значениях сохраненные раньше)
+   if (appended > 0) {
+      std::vector<std::uint32_t> order(appended);
+      parallel_sort_indices(values.data(), appended, order.data());
+      size_t old_count = state.values.size();
+      std::vector<double> merged_values(old_count + appended);
+      std::vector<std::uint8_t> merged_censored(old_count + appended);
+      size_t i = 0, j = 0;
+      for (size_t k = 0; k < merged_values.size(); k++) {
+         if (j == appended || (i < old_count && !(values[order[j]] < state.values[i]))) {
+            merged_values[k] = state.values[i];
+            merged_censored[k] = state.censored[i++];
+         }
+         else {
+            merged_values[k] = values[order[j]];
+            merged_censored[k] = censored[order[j++]];
+         }
+      }
+      state.values.swap(merged_values);
+      state.censored.swap(merged_censored);
+   }
+
+   check.update(data + state.consumed, end - state.consumed);
+   state.consumed = end;
+   state.check = check.digest();
+   return true;
+}
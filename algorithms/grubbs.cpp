@@ -17,6 +17,15 @@
 #include <boost/math/distributions/non_central_f.hpp>
 #include <boost/math/distributions/binomial.hpp>
 
+#include "columnar.h"
+#include "csv_reader.h"
+#include "fast_reader.h"
+#include "moments.h"
+#include "parallel_sort.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+
 using namespace std;
 using namespace boost::math;
 
@@ -44,6 +53,7 @@ double t_cdf(double x, double f) {
 }
 
 double t_ppf(double p, double f) {
+   STAT_PROFILE_SCOPE("t_ppf");
    if (p <= 0 || p >= 1) return 0;
    students_t_distribution<> d(f);
    return quantile(d, p);
@@ -56,52 +66,49 @@ double t_pdf(double x, double f) {
 
 // Функция для чтения данных из файла
 vector<double> readDataFromFile(const string& filename) {
+   STAT_PROFILE_SCOPE("read_data");
    vector<double> data;
-   ifstream file(filename);
 
-   if (!file.is_open()) {
-       cerr << "Ошибка открытия файла: " << filename << endl;
+   // Двоичный столбцовый файл (columnar.h)
+   if (is_columnar_file(filename)) {
+       ColumnarFile file;
+       if (!file.open(filename)) {
+           cerr << "Некорректный двоичный файл данных: " << filename << endl;
+           return data;
+       }
+       data.assign(file.values().begin(), file.values().end());
        return data;
    }
 
-   double value;
-   while (file >> value) {
-       data.push_back(value);
-   }
-
-   file.close();
-   return data;
-}
+   TextReadOptions options;
+   options.skip_comments = false;
+   TextColumns columns;
 
-// Функция для вычисления выборочного среднего
-double calculateMean(const vector<double>& data) {
-   double sum = 0.0;
-   for (double value : data) {
-       sum += value;
+   if (!read_text_columns(filename, columns, options)) {
+       cerr << "Ошибка открытия файла: " << filename << endl;
+       return data;
    }
-   return sum / data.size();
-}
-
-// Функция для вычисления выборочного стандартного отклонения
-double calculateStdDev(const vector<double>& data, double mean) {
-   if (data.size() <= 1) return 0.0;
 
-   double sumSquares = 0.0;
-   for (double value : data) {
-       sumSquares += (value - mean) * (value - mean);
+   // Числа читаются подряд до первого нечислового значения в файле
+   size_t rows = columns.rows();
+   if (!columns.directives.empty()) rows = min(rows, columns.directives.front().row);
+   size_t count = 0;
+   for (size_t r = 0; r < rows; ++r) {
+       count = columns.row_end[r];
+       if (columns.row_stopped[r]) break;
    }
-   return sqrt(sumSquares / (data.size() - 1));
+   columns.values.resize(count);
+   data.swap(columns.values);
+   return data;
 }
 
 // Функция для вычисления статистики Граббса
-double calculateGrubbsStatistic(const vector<double>& data, double mean, double stdDev, bool testMax) {
+double calculateGrubbsStatistic(const SampleMoments& moments, bool testMax) {
    if (testMax) {
-       double maxVal = *max_element(data.begin(), data.end());
-       return abs(maxVal - mean) / stdDev;
+       return abs(moments.max - moments.mean) / moments.stddev();
    }
    else {
-       double minVal = *min_element(data.begin(), data.end());
-       return abs(minVal - mean) / stdDev;
+       return abs(moments.min - moments.mean) / moments.stddev();
    }
 }
 
@@ -116,19 +123,44 @@ double calculateGrubbsCriticalValue(int n, double alpha, bool twoSided) {
    return numerator / denominator;
 }
 
-// Функция для проверки нормальности данных (упрощенная версия)
-bool checkNormality(const vector<double>& data, double mean, double stdDev, ofstream& outputFile) {
+// Итоги критерия для машиночитаемого вывода (result_writer.h)
+struct GrubbsSummary {
+   SampleMoments moments;
+   double grubbsMin = NAN;
+   double grubbsMax = NAN;
+   double criticalValue = NAN; // не определено при n < 3
+   bool minOutlier = false;
+   bool maxOutlier = false;
+};
+
+GrubbsSummary summarizeGrubbsTest(const vector<double>& data, double alpha, bool twoSided) {
+   STAT_PROFILE_SCOPE("grubbs_test");
+   GrubbsSummary summary;
+   summary.moments = compute_moments(data);
    int n = data.size();
+   if (n < 3) return summary;
+
+   summary.grubbsMax = calculateGrubbsStatistic(summary.moments, true);
+   summary.grubbsMin = calculateGrubbsStatistic(summary.moments, false);
+   summary.criticalValue = calculateGrubbsCriticalValue(n, alpha, twoSided);
+   summary.maxOutlier = summary.grubbsMax > summary.criticalValue;
+   summary.minOutlier = summary.grubbsMin > summary.criticalValue;
+   return summary;
+}
+
+// Функция для проверки нормальности данных (упрощенная версия)
+bool checkNormality(const SampleMoments& moments, ofstream& outputFile) {
+   int n = moments.count;
    if (n < 8) {
-       outputFile << "Предупреждение: объем выборки слишком мал для надежной проверки нормальности" << endl;
+       outputFile << "Предупреждение: объем выборки слишком мал для надежной проверки нормальности" << '\n';
        return true; // Принимаем нормальность для малых выборок
    }
 
    // Простая проверка на основе коэффициента вариации
-   double coefficientOfVariation = stdDev / mean;
+   double coefficientOfVariation = moments.stddev() / moments.mean;
    if (coefficientOfVariation > 0.5) {
        outputFile << "Предупреждение: высокий коэффициент вариации (" << coefficientOfVariation
-           << ") может указывать на ненормальность данных" << endl;
+           << ") может указывать на ненормальность данных" << '\n';
    }
 
    return true;
@@ -137,88 +169,92 @@ bool checkNormality(const vector<double>& data, double mean, double stdDev, ofst
 // Основная функция для применения критерия Граббса
 void applyGrubbsTest(const vector<double>& data, double alpha, bool twoSided,
    ofstream& outputFile) {
+   STAT_PROFILE_SCOPE("write_report");
    int n = data.size();
 
    if (n < 3) {
-       outputFile << "ОШИБКА: Объем выборки слишком мал для применения критерия Граббса (n < 3)" << endl;
-       outputFile << "Минимальный требуемый объем выборки: 3 наблюдения" << endl;
+       outputFile << "ОШИБКА: Объем выборки слишком мал для применения критерия Граббса (n < 3)" << '\n';
+       outputFile << "Минимальный требуемый объем выборки: 3 наблюдения" << '\n';
        return;
    }
 
    if (n > 50) {
-       outputFile << "обычно не проводят, поскольку они не оказывают заметного влияния на точность оценок" << endl;
+       outputFile << "обычно не проводят, поскольку они не оказывают заметного влияния на точность оценок" << '\n';
    }
 
-   // Вычисляем выборочные характеристики
-   double mean = calculateMean(data);
-   double stdDev = calculateStdDev(data, mean);
-
-   outputFile << "==================================================" << endl;
-   outputFile << "         КРИТЕРИЙ ГРАББСА ДЛЯ ВЫБРОСОВ" << endl;
-   outputFile << "==================================================" << endl;
-   outputFile << endl;
-   outputFile << "ОСНОВНЫЕ ПАРАМЕТРЫ:" << endl;
-   outputFile << "Объем выборки: n = " << n << endl;
-   outputFile << "Выборочное среднее: " << fixed << setprecision(6) << mean << endl;
-   outputFile << "Выборочное стандартное отклонение: " << stdDev << endl;
-   outputFile << "Уровень значимости: alpha = " << alpha << endl;
-   outputFile << "Тип критерия: " << (twoSided ? "Двусторонний" : "Односторонний") << endl;
-   outputFile << endl;
+   // Вычисляем выборочные характеристики за один проход по данным
+   GrubbsSummary summary = summarizeGrubbsTest(data, alpha, twoSided);
+   const SampleMoments& moments = summary.moments;
+   double mean = moments.mean;
+   double stdDev = moments.stddev();
+
+   outputFile << "==================================================" << '\n';
+   outputFile << "         КРИТЕРИЙ ГРАББСА ДЛЯ ВЫБРОСОВ" << '\n';
+   outputFile << "==================================================" << '\n';
+   outputFile << '\n';
+   outputFile << "ОСНОВНЫЕ ПАРАМЕТРЫ:" << '\n';
+   outputFile << "Объем выборки: n = " << n << '\n';
+   outputFile << "Выборочное среднее: " << fixed << setprecision(6) << mean << '\n';
+   outputFile << "Выборочное стандартное отклонение: " << stdDev << '\n';
+   outputFile << "Уровень значимости: alpha = " << alpha << '\n';
+   outputFile << "Тип критерия: " << (twoSided ? "Двусторонний" : "Односторонний") << '\n';
+   outputFile << '\n';
 
    // Проверка предположения о нормальности
-   outputFile << "ПРОВЕРКА ПРЕДПОСЫЛОК:" << endl;
-   bool isNormal = checkNormality(data, mean, stdDev, outputFile);
+   outputFile << "ПРОВЕРКА ПРЕДПОСЫЛОК:" << '\n';
+   bool isNormal = checkNormality(moments, outputFile);
    if (!isNormal) {
-       outputFile << "ВНИМАНИЕ: Данные могут не подчиняться нормальному распределению!" << endl;
-       outputFile << "Результаты критерия Граббса могут быть ненадежными." << endl;
+       outputFile << "ВНИМАНИЕ: Данные могут не подчиняться нормальному распределению!" << '\n';
+       outputFile << "Результаты критерия Граббса могут быть ненадежными." << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 
    // Проверяем максимальное значение
-   double maxValue = *max_element(data.begin(), data.end());
-   double grubbsMax = calculateGrubbsStatistic(data, mean, stdDev, true);
-   double criticalValue = calculateGrubbsCriticalValue(n, alpha, twoSided);
+   double maxValue = moments.max;
+   double grubbsMax = summary.grubbsMax;
+   double criticalValue = summary.criticalValue;
 
-   outputFile << "ПРОВЕРКА МАКСИМАЛЬНОГО ЗНАЧЕНИЯ:" << endl;
-   outputFile << "Максимальное значение: " << maxValue << endl;
-   outputFile << "Статистика Граббса: mu = " << grubbsMax << endl;
-   outputFile << "Критическое значение: mu_alpha = " << criticalValue << endl;
+   outputFile << "ПРОВЕРКА МАКСИМАЛЬНОГО ЗНАЧЕНИЯ:" << '\n';
+   outputFile << "Максимальное значение: " << maxValue << '\n';
+   outputFile << "Статистика Граббса: mu = " << grubbsMax << '\n';
+   outputFile << "Критическое значение: mu_alpha = " << criticalValue << '\n';
 
    if (grubbsMax > criticalValue) {
-       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Максимальное значение является АНОМАЛЬНЫМ" << endl;
-       outputFile << "Гипотеза H₀ отвергается на уровне значимости " << alpha << endl;
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Максимальное значение является АНОМАЛЬНЫМ" << '\n';
+       outputFile << "Гипотеза H₀ отвергается на уровне значимости " << alpha << '\n';
    }
    else {
-       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Максимальное значение НЕ является аномальным" << endl;
-       outputFile << "Гипотеза H₀ принимается" << endl;
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Максимальное значение НЕ является аномальным" << '\n';
+       outputFile << "Гипотеза H₀ принимается" << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 
    // Проверяем минимальное значение
-   double minValue = *min_element(data.begin(), data.end());
-   double grubbsMin = calculateGrubbsStatistic(data, mean, stdDev, false);
+   double minValue = moments.min;
+   double grubbsMin = summary.grubbsMin;
 
-   outputFile << "ПРОВЕРКА МИНИМАЛЬНОГО ЗНАЧЕНИЯ:" << endl;
-   outputFile << "Минимальное значение: " << minValue << endl;
-   outputFile << "Статистика Граббса: mu = " << grubbsMin << endl;
-   outputFile << "Критическое значение: mu_alpha = " << criticalValue << endl;
+   outputFile << "ПРОВЕРКА МИНИМАЛЬНОГО ЗНАЧЕНИЯ:" << '\n';
+   outputFile << "Минимальное значение: " << minValue << '\n';
+   outputFile << "Статистика Граббса: mu = " << grubbsMin << '\n';
+   outputFile << "Критическое значение: mu_alpha = " << criticalValue << '\n';
 
    if (grubbsMin > criticalValue) {
-       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Минимальное значение является АНОМАЛЬНЫМ" << endl;
-       outputFile << "Гипотеза H₀ отвергается на уровне значимости " << alpha << endl;
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Минимальное значение является АНОМАЛЬНЫМ" << '\n';
+       outputFile << "Гипотеза H₀ отвергается на уровне значимости " << alpha << '\n';
    }
    else {
-       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Минимальное значение НЕ является аномальным" << endl;
-       outputFile << "Гипотеза H₀ принимается" << endl;
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Минимальное значение НЕ является аномальным" << '\n';
+       outputFile << "Гипотеза H₀ принимается" << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 
    // Детальная информация о выборке
-   outputFile << "ДЕТАЛЬНЫЙ АНАЛИЗ ВЫБОРКИ:" << endl;
-   outputFile << "Все значения в порядке возрастания:" << endl;
+   outputFile << "ДЕТАЛЬНЫЙ АНАЛИЗ ВЫБОРКИ:" << '\n';
+   outputFile << "Все значения в порядке возрастания:" << '\n';
 
    vector<double> sortedData = data;
-   sort(sortedData.begin(), sortedData.end());
+   STAT_PROFILE_COUNT("sort_size", sortedData.size());
+   parallel_sort(sortedData);
 
    for (size_t i = 0; i < sortedData.size(); ++i) {
        outputFile << "  x[" << setw(2) << i + 1 << "] = " << setw(10) << sortedData[i];
@@ -231,52 +267,129 @@ void applyGrubbsTest(const vector<double>& data, double alpha, bool twoSided,
        else if (i == 0 || i == sortedData.size() - 1) {
            outputFile << "  <-- крайнее значение";
        }
-       outputFile << endl;
+       outputFile << '\n';
    }
 
-   outputFile << endl;
-   outputFile << "==================================================" << endl;
-   outputFile << "ЗАКЛЮЧЕНИЕ:" << endl;
+   outputFile << '\n';
+   outputFile << "==================================================" << '\n';
+   outputFile << "ЗАКЛЮЧЕНИЕ:" << '\n';
 
    int anomaliesCount = 0;
    if (grubbsMax > criticalValue) anomaliesCount++;
    if (grubbsMin > criticalValue) anomaliesCount++;
 
    if (anomaliesCount == 0) {
-       outputFile << "Аномальных выбросов в данных не обнаружено." << endl;
+       outputFile << "Аномальных выбросов в данных не обнаружено." << '\n';
    }
    else {
-       outputFile << "Обнаружено аномальных выбросов: " << anomaliesCount << endl;
+       outputFile << "Обнаружено аномальных выбросов: " << anomaliesCount << '\n';
        if (grubbsMax > criticalValue) {
-           outputFile << "  - Максимальное значение " << maxValue << " является выбросом" << endl;
+           outputFile << "  - Максимальное значение " << maxValue << " является выбросом" << '\n';
        }
        if (grubbsMin > criticalValue) {
-           outputFile << "  - Минимальное значение " << minValue << " является выбросом" << endl;
+           outputFile << "  - Минимальное значение " << minValue << " является выбросом" << '\n';
        }
    }
-   outputFile << "==================================================" << endl;
+   outputFile << "==================================================" << '\n';
+}
+
+// Запись итогов в формате JSON Lines или CSV: по записи на выборку
+bool writeGrubbsRecords(const string& filename, const ResultOptions& options, double alpha, bool twoSided,
+   const vector<string>& samples, const vector<GrubbsSummary>& summaries) {
+   ResultWriter writer;
+   if (!writer.open(filename, options, "grubbs", { "sample", "n", "mean", "stddev", "alpha", "two_sided",
+       "min", "g_min", "max", "g_max", "critical", "min_outlier", "max_outlier" })) {
+       cerr << "ОШИБКА: Не удалось создать выходной файл: " << filename << endl;
+       return false;
+   }
+   for (size_t i = 0; i < summaries.size(); ++i) {
+       const GrubbsSummary& s = summaries[i];
+       writer.write(samples[i], s.moments.count, s.moments.mean, s.moments.stddev(), alpha, twoSided,
+           s.moments.min, s.grubbsMin, s.moments.max, s.grubbsMax, s.criticalValue, s.minOutlier, s.maxOutlier);
+   }
+   if (!writer.close()) {
+       cerr << "ОШИБКА: Ошибка записи в файл: " << filename << endl;
+       return false;
+   }
+   return true;
+}
+
+// Критерий Граббса для нескольких столбцов CSV/TSV-файла: файл читается
+// один раз, столбцы проверяются параллельно, каждый - в свой выходной файл
+// (при --format jsonl|csv - все столбцы в один файл)
+int applyGrubbsTestToCsvColumns(const string& filename, const vector<string>& names,
+   double alpha, bool twoSided, const string& outputFilename, const ResultOptions& resultOptions) {
+   CsvSelection selection;
+   if (!read_csv_columns(filename, names, selection)) {
+       cerr << "ОШИБКА: Не удалось прочитать столбцы из файла: " << filename << endl;
+       return 1;
+   }
+   cout << "Прочитано " << selection.rows << " строк" << endl;
+
+   if (resultOptions.structured()) {
+       vector<GrubbsSummary> summaries(names.size());
+       parallel_for(names.size(), 1, [&](size_t first, size_t last) {
+           for (size_t c = first; c < last; ++c) {
+               summaries[c] = summarizeGrubbsTest(selection.columns[c], alpha, twoSided);
+           }
+       });
+       for (size_t c = 0; c < names.size(); ++c) {
+           cout << "Столбец " << names[c] << ": n = " << selection.columns[c].size()
+               << ", пропусков: " << selection.missing[c] << endl;
+       }
+       string structuredFilename = result_output_filename(outputFilename, resultOptions);
+       if (!writeGrubbsRecords(structuredFilename, resultOptions, alpha, twoSided, names, summaries)) return 1;
+       cout << "Результаты сохранены в файл: " << structuredFilename << endl;
+       return 0;
+   }
+
+   vector<string> outputs(names.size());
+   vector<char> written(names.size(), 0);
+   parallel_for(names.size(), 1, [&](size_t first, size_t last) {
+       for (size_t c = first; c < last; ++c) {
+           outputs[c] = csv_output_filename(outputFilename, names[c]);
+           ofstream outputFile(outputs[c]);
+           if (!outputFile.is_open()) continue;
+           applyGrubbsTest(selection.columns[c], alpha, twoSided, outputFile);
+           written[c] = 1;
+       }
+   });
+
+   int status = 0;
+   for (size_t c = 0; c < names.size(); ++c) {
+       cout << "Столбец " << names[c] << ": n = " << selection.columns[c].size()
+           << ", пропусков: " << selection.missing[c] << endl;
+       if (written[c]) {
+           cout << "  Результаты сохранены в файл: " << outputs[c] << endl;
+       }
+       else {
+           cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputs[c] << endl;
+           status = 1;
+       }
+   }
+   return status;
 }
 
 // Функция для создания тестового файла с данными
 void createTestDataFile() {
    ofstream testFile("input_data.txt");
    if (testFile.is_open()) {
-       testFile << "4.12" << endl;
-       testFile << "4.99" << endl;
-       testFile << "5.12" << endl;
-       testFile << "5.32" << endl;
-       testFile << "5.55" << endl;
-       testFile << "5.76" << endl;
-       testFile << "5.87" << endl;
-       testFile << "5.98" << endl;
-       testFile << "6.03" << endl;
-       testFile << "6.10" << endl;
+       testFile << "4.12" << '\n';
+       testFile << "4.99" << '\n';
+       testFile << "5.12" << '\n';
+       testFile << "5.32" << '\n';
+       testFile << "5.55" << '\n';
+       testFile << "5.76" << '\n';
+       testFile << "5.87" << '\n';
+       testFile << "5.98" << '\n';
+       testFile << "6.03" << '\n';
+       testFile << "6.10" << '\n';
        testFile.close();
        cout << "Создан тестовый файл input_data.txt с примером данных" << endl;
    }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
    setlocale(LC_ALL, "rus");
    // Параметры критерия
    double alpha = 0.05; // Уровень значимости
@@ -286,10 +399,40 @@ int main() {
    string inputFilename = "input_data.txt";
    string outputFilename = "grubbs_test_result.txt";
 
+   // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+   ResultOptions resultOptions;
+   if (!take_result_options(argc, argv, resultOptions)) return 1;
+
+   // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+   ResultCacheOptions cacheOptions;
+   if (!take_cache_options(argc, argv, cacheOptions)) return 1;
+
+   // Другой входной файл (текстовый или двоичный): --input <файл>
+   if (argc > 2 && string(argv[1]) == "--input") inputFilename = argv[2];
+
    cout << "ПРОГРАММА ДЛЯ ВЫЯВЛЕНИЯ АНОМАЛЬНЫХ ВЫБРОСОВ" << endl;
    cout << "Метод: критерий Граббса" << endl;
    cout << "=============================================" << endl;
 
+   // Столбцы CSV/TSV-файла с заголовком: --csv <файл> <столбец> [<столбец> ...]
+   if (argc > 1 && string(argv[1]) == "--csv") {
+       if (argc < 4) {
+           cerr << "Использование: " << argv[0] << " --csv <файл> <столбец> [<столбец> ...] [--format jsonl|csv] [--async-output]" << endl;
+           return 1;
+       }
+       vector<string> names(argv + 3, argv + argc);
+       return applyGrubbsTestToCsvColumns(argv[2], names, alpha, twoSided, outputFilename, resultOptions);
+   }
+
+   // Тот же файл с теми же параметрами - результат из кэша
+   ResultCache cache(cacheOptions, "grubbs");
+   cache.add_file(inputFilename);
+   cache.add("alpha", alpha);
+   cache.add("two_sided", twoSided);
+   cache.add("format", static_cast<int>(resultOptions.format));
+   cache.add_arguments(argc, argv);
+   if (cache.replay()) return 0;
+
    // Проверяем существование входного файла
    ifstream testFile(inputFilename);
    if (!testFile.good()) {
@@ -309,19 +452,29 @@ int main() {
 
    cout << "Прочитано " << data.size() << " значений" << endl;
 
-   // Создание выходного файла
-   ofstream outputFile(outputFilename);
-
-   if (!outputFile.is_open()) {
-       cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputFilename << endl;
-       return 1;
+   if (resultOptions.structured()) {
+       outputFilename = result_output_filename(outputFilename, resultOptions);
+       cout << "Применение критерия Граббса..." << endl;
+       GrubbsSummary summary = summarizeGrubbsTest(data, alpha, twoSided);
+       if (!writeGrubbsRecords(outputFilename, resultOptions, alpha, twoSided, { inputFilename }, { summary })) {
+           return 1;
+       }
    }
+   else {
+       // Создание выходного файла
+       ofstream outputFile(outputFilename);
 
-   // Применение критерия Граббса
-   cout << "Применение критерия Граббса..." << endl;
-   applyGrubbsTest(data, alpha, twoSided, outputFile);
+       if (!outputFile.is_open()) {
+           cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputFilename << endl;
+           return 1;
+       }
 
-   outputFile.close();
+       // Применение критерия Граббса
+       cout << "Применение критерия Граббса..." << endl;
+       applyGrubbsTest(data, alpha, twoSided, outputFile);
+
+       outputFile.close();
+   }
 
    cout << endl;
    cout << "УСПЕШНО: Критерий Граббса применен." << endl;
@@ -332,5 +485,6 @@ int main() {
    cout << "  - Объем выборки: n = " << data.size() << endl;
    cout << "  - Тип критерия: " << (twoSided ? "двусторонний" : "односторонний") << endl;
 
+   cache.store({ outputFilename });
    return 0;
 }
@@ -7,9 +7,18 @@
 #include <iomanip>
 #include <algorithm>
 #include <numeric>
+#include <memory_resource>
 #include <boost/math/distributions/chi_squared.hpp>
 #include <boost/math/distributions/fisher_f.hpp>
 
+#include "arena.h"
+#include "columnar.h"
+#include "fast_reader.h"
+#include "parallel_sort.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+
 using namespace std;
 using namespace boost::math;
 
@@ -20,10 +29,51 @@ struct KruskalWallisConfig {
    string output_filename = "kruskal_wallis_results.txt";
 };
 
+//Проверка и вывод прочитанных выборок
+bool check_loaded_config(const string& filename, KruskalWallisConfig& config) {
+   // Удаляем пустые выборки
+   config.samples.erase(
+       remove_if(config.samples.begin(), config.samples.end(),
+                 [](const vector<double>& sample) { return sample.empty(); }),
+       config.samples.end()
+   );
+   
+   if (config.samples.empty()) {
+       cout << "Ошибка: файл не содержит данных" << endl;
+       return false;
+   }
+   
+   cout << "Прочитано " << config.samples.size() << " выборок из файла " << filename << endl;
+   
+   // Выводим информацию о выборках
+   for (size_t i = 0; i < config.samples.size(); i++) {
+       cout << "  Выборка " << i+1 << ": " << config.samples[i].size() << " наблюдений" << endl;
+   }
+   
+   cout << "Уровень значимости alpha: " << config.alpha << endl;
+   cout << "Выходной файл: " << config.output_filename << endl;
+   
+   return true;
+}
+
 //Функция для чтения всех данных из файла
 bool read_config_from_file(const string& filename, KruskalWallisConfig& config) {
-   ifstream infile(filename);
-   if (!infile.is_open()) {
+   STAT_PROFILE_SCOPE("read_data");
+   // Двоичный столбцовый файл (columnar.h): выборки по столбцу group
+   if (is_columnar_file(filename)) {
+       ColumnarFile file;
+       if (!file.open(filename)) {
+           cout << "Ошибка: некорректный двоичный файл данных " << filename << endl;
+           return false;
+       }
+       config.samples = columnar_groups(file);
+       config.alpha = 0.05;
+       config.output_filename = "kruskal_wallis_results.txt";
+       return check_loaded_config(filename, config);
+   }
+
+   TextColumns columns;
+   if (!read_text_columns(filename, columns)) {
        cout << "Ошибка: не удалось открыть файл " << filename << endl;
        return false;
    }
@@ -32,36 +82,36 @@ bool read_config_from_file(const string& filename, KruskalWallisConfig& config)
    config.alpha = 0.05;
    config.output_filename = "kruskal_wallis_results.txt";
    
-   string line;
-   int line_num = 0;
-   bool reading_data = false;
    bool reading_params = false;
    
-   while (getline(infile, line)) {
-       line_num++;
-       
-       // Удаление начальных и конечных пробелов
-       line.erase(0, line.find_first_not_of(" \t"));
-       line.erase(line.find_last_not_of(" \t") + 1);
-       
-       // Пропускаем пустые строки
-       if (line.empty()) {
-           continue;
+   // Строки данных между директивами: значения текущей выборки
+   size_t next_row = 0;
+   auto take_rows = [&](size_t until) {
+       if (next_row >= until) return;
+       // В секции параметров числовые строки не используются
+       if (reading_params) {
+           next_row = until;
+           return;
        }
-       
-       // Пропускаем комментарии
-       if (line[0] == '#') {
-           continue;
+       // Если выборок еще нет, создаем первую
+       if (config.samples.empty()) {
+           config.samples.push_back(vector<double>());
        }
+       vector<double>& sample = config.samples.back();
+       sample.insert(sample.end(), columns.row(next_row), columns.row(until));
+       next_row = until;
+   };
+   
+   for (const TextDirective& directive : columns.directives) {
+       take_rows(directive.row);
+       const string& line = directive.text;
        
        // Проверяем секции файла
        if (line == "[PARAMETERS]") {
            reading_params = true;
-           reading_data = false;
            continue;
        }
        else if (line == "[DATA]") {
-           reading_data = true;
            reading_params = false;
            continue;
        }
@@ -71,115 +121,49 @@ bool read_config_from_file(const string& filename, KruskalWallisConfig& config)
            continue;
        }
        
-       // Чтение параметров
-       if (reading_params) {
-           istringstream iss(line);
-           string key;
-           if (iss >> key) {
-               if (key == "alpha" || key == "ALPHA") {
-                   if (!(iss >> config.alpha)) {
-                       cout << "Предупреждение: некорректное значение alpha в строке " << line_num << endl;
-                   }
-               }
-               else if (key == "output" || key == "OUTPUT") {
-                   string filename;
-                   if (iss >> filename) {
-                       config.output_filename = filename;
-                   }
+       // Чтение параметров (в секции параметров и среди данных)
+       istringstream iss(line);
+       string key;
+       if (iss >> key) {
+           if (key == "alpha" || key == "ALPHA") {
+               if (!(iss >> config.alpha)) {
+                   cout << "Предупреждение: некорректное значение alpha в строке " << directive.line << endl;
                }
            }
-       }
-       // Чтение данных
-       else if (reading_data || (!reading_params && !reading_data)) {
-           // Если выборок еще нет, создаем первую
-           if (config.samples.empty()) {
-               config.samples.push_back(vector<double>());
-           }
-           
-           // Пробуем прочитать как значения выборки
-           istringstream iss(line);
-           double value;
-           bool has_data = false;
-           
-           // Читаем все числа в строке
-           while (iss >> value) {
-               config.samples.back().push_back(value);
-               has_data = true;
-           }
-           
-           // Если не удалось прочитать как данные, пробуем как параметр
-           if (!has_data) {
-               iss.clear();
-               iss.str(line);
-               string key;
-               if (iss >> key) {
-                   if (key == "alpha" || key == "ALPHA") {
-                       if (!(iss >> config.alpha)) {
-                           cout << "Предупреждение: некорректное значение alpha в строке " << line_num << endl;
-                       }
-                   }
-                   else if (key == "output" || key == "OUTPUT") {
-                       string filename;
-                       if (iss >> filename) {
-                           config.output_filename = filename;
-                       }
-                   }
+           else if (key == "output" || key == "OUTPUT") {
+               string filename;
+               if (iss >> filename) {
+                   config.output_filename = filename;
                }
            }
        }
    }
+   take_rows(columns.rows());
    
-   infile.close();
-   
-   // Удаляем пустые выборки
-   config.samples.erase(
-       remove_if(config.samples.begin(), config.samples.end(),
-                 [](const vector<double>& sample) { return sample.empty(); }),
-       config.samples.end()
-   );
-   
-   if (config.samples.empty()) {
-       cout << "Ошибка: файл не содержит данных" << endl;
-       return false;
-   }
-   
-   cout << "Прочитано " << config.samples.size() << " выборок из файла " << filename << endl;
-   
-   // Выводим информацию о выборках
-   for (size_t i = 0; i < config.samples.size(); i++) {
-       cout << "  Выборка " << i+1 << ": " << config.samples[i].size() << " наблюдений" << endl;
-   }
-   
-   cout << "Уровень значимости alpha: " << config.alpha << endl;
-   cout << "Выходной файл: " << config.output_filename << endl;
-   
-   return true;
+   return check_loaded_config(filename, config);
 }
 
 //Функция для вычисления рангов 
+//ties - сумма t^3 - t по группам связок (для поправки H), если не nullptr
+//Рабочие массивы и результат - из арены задания (arena.h)
 
-vector<double> calculate_ranks(const vector<double>& all_values) {
-   int n = all_values.size();
-   vector<double> ranks(n, 0.0);
-   
-   // Создаем копию значений с индексами
-   vector<pair<double, int>> indexed_values;
-   for (int i = 0; i < n; i++) {
-       indexed_values.push_back({all_values[i], i});
-   }
+pmr::vector<double> calculate_ranks(const double* all_values, int n, long long* ties = nullptr) {
+   STAT_PROFILE_SCOPE("calculate_ranks");
+   STAT_PROFILE_COUNT("sort_size", n);
+   pmr::memory_resource* arena = arena_resource();
+   pmr::vector<double> ranks(n, 0.0, arena);
    
-   // Сортируем по значениям
-   sort(indexed_values.begin(), indexed_values.end(),
-        [](const pair<double, int>& a, const pair<double, int>& b) {
-            return a.first < b.first;
-        });
+   // Номера значений по возрастанию (parallel_sort.h)
+   pmr::vector<int> order(n, arena);
+   parallel_sort_indices(all_values, n, order.data());
    
    // Присваиваем ранги с учетом связей
+   if (ties != nullptr) *ties = 0;
    int i = 0;
    while (i < n) {
        int j = i;
        // Находим группу одинаковых значений
-       while (j < n && indexed_values[j].first == indexed_values[i].first) {
+       while (j < n && all_values[order[j]] == all_values[order[i]]) {
            j++;
        }
        
@@ -188,7 +172,11 @@ vector<double> calculate_ranks(const vector<double>& all_values) {
        
        // Присваиваем ранги всем элементам группы
        for (int k = i; k < j; k++) {
-           ranks[indexed_values[k].second] = avg_rank;
+           ranks[order[k]] = avg_rank;
+       }
+       long long tie_size = j - i;
+       if (ties != nullptr && tie_size > 1) {
+           *ties += tie_size * tie_size * tie_size - tie_size;
        }
        
        i = j;
@@ -197,6 +185,10 @@ vector<double> calculate_ranks(const vector<double>& all_values) {
    return ranks;
 }
 
+pmr::vector<double> calculate_ranks(const vector<double>& all_values) {
+   return calculate_ranks(all_values.data(), static_cast<int>(all_values.size()));
+}
+
 //Функция для вычисления статистики H критерия Краскела-Уоллиса
 //samples вектор выборок
 //H_stat статистика H (возвращается по ссылке)
@@ -205,6 +197,10 @@ vector<double> calculate_ranks(const vector<double>& all_values) {
 
 bool calculate_kruskal_wallis_stat(const vector<vector<double>>& samples, 
                                  double& H_stat, double& H1_stat) {
+   STAT_PROFILE_SCOPE("kruskal_wallis_stat");
+   // Временные массивы освобождаются при выходе из функции
+   ArenaScope arena_scope;
+   pmr::memory_resource* arena = arena_resource();
    
    int k = samples.size(); // количество выборок
    
@@ -225,8 +221,12 @@ bool calculate_kruskal_wallis_stat(const vector<vector<double>>& samples,
    }
    
    // Объединяем все значения в один вектор
-   vector<double> all_values;
-   vector<int> sample_indices; // Индекс выборки для каждого значения
+   size_t total = 0;
+   for (int i = 0; i < k; i++) total += samples[i].size();
+   pmr::vector<double> all_values(arena);
+   pmr::vector<int> sample_indices(arena); // Индекс выборки для каждого значения
+   all_values.reserve(total);
+   sample_indices.reserve(total);
    
    for (int i = 0; i < k; i++) {
        for (double value : samples[i]) {
@@ -237,12 +237,13 @@ bool calculate_kruskal_wallis_stat(const vector<vector<double>>& samples,
    
    int N = all_values.size(); // общее количество наблюдений
    
-   // Вычисляем ранги для всех значений
-   vector<double> ranks = calculate_ranks(all_values);
+   // Вычисляем ранги для всех значений и заодно сумму t^3 - t по связкам
+   long long T = 0;
+   pmr::vector<double> ranks = calculate_ranks(all_values.data(), N, &T);
    
    // Вычисляем суммы рангов для каждой выборки (формула (3.36))
-   vector<double> R(k, 0.0);
-   vector<int> n_i(k, 0);
+   pmr::vector<double> R(k, 0.0, arena);
+   pmr::vector<int> n_i(k, 0, arena);
    
    for (int idx = 0; idx < N; idx++) {
        int sample_idx = sample_indices[idx];
@@ -258,27 +259,8 @@ bool calculate_kruskal_wallis_stat(const vector<vector<double>>& samples,
    
    H_stat = (12.0 / (N * (N + 1.0))) * sum_R2_n - 3.0 * (N + 1.0);
    
-   // Вычисляем поправку H1 для связей (формула (3.37))
-   // Сначала вычисляем количество связей
-   int T = 0;
-   vector<double> sorted_values = all_values;
-   sort(sorted_values.begin(), sorted_values.end());
-   
-   int i = 0;
-   while (i < N) {
-       int j = i;
-       while (j < N && sorted_values[j] == sorted_values[i]) {
-           j++;
-       }
-       int tie_size = j - i;
-       if (tie_size > 1) {
-           T += (tie_size * tie_size * tie_size - tie_size);
-       }
-       i = j;
-   }
-   
-   // Поправка для связей
-   double correction = 1.0 - (static_cast<double>(T) / (N * N * N - N));
+   // Поправка для связей: T посчитано при ранжировании
+   double correction = 1.0 - (static_cast<double>(T) / (double(N) * N * N - N));
    
    // Корректируем статистику H
    if (correction > 0) {
@@ -311,31 +293,32 @@ double calculate_critical_value(int k, int N, double alpha) {
    return H_alpha;
 }
 
-void write_results_to_file(const KruskalWallisConfig& config,
+bool write_results_to_file(const KruskalWallisConfig& config,
                          double H_stat,
                          double H1_stat,
                          double H_alpha,
                          bool hypothesis_accepted) {
+   STAT_PROFILE_SCOPE("write_report");
    
    ofstream outfile(config.output_filename);
    if (!outfile.is_open()) {
        cout << "Ошибка: не удалось создать файл " << config.output_filename << endl;
-       return;
+       return false;
    }
    
    outfile << fixed << setprecision(6);
    
-   outfile << "=== РЕЗУЛЬТАТЫ КРИТЕРИЯ КРАСКЕЛА-УОЛЛИСА ===" << endl << endl;
+   outfile << "=== РЕЗУЛЬТАТЫ КРИТЕРИЯ КРАСКЕЛА-УОЛЛИСА ===" << '\n' << '\n';
    
    // Исходные данные
-   outfile << "ИСХОДНЫЕ ДАННЫЕ:" << endl;
-   outfile << "Входной файл: kruskal_wallis_input.txt" << endl;
-   outfile << "Уровень значимости (alpha): " << config.alpha << endl;
-   outfile << "Количество выборок (k): " << config.samples.size() << endl << endl;
+   outfile << "ИСХОДНЫЕ ДАННЫЕ:" << '\n';
+   outfile << "Входной файл: kruskal_wallis_input.txt" << '\n';
+   outfile << "Уровень значимости (alpha): " << config.alpha << '\n';
+   outfile << "Количество выборок (k): " << config.samples.size() << '\n' << '\n';
    
    // Выводим данные по выборкам
    for (size_t i = 0; i < config.samples.size(); i++) {
-       outfile << "Выборка " << i+1 << " (n" << i+1 << " = " << config.samples[i].size() << "):" << endl;
+       outfile << "Выборка " << i+1 << " (n" << i+1 << " = " << config.samples[i].size() << "):" << '\n';
        outfile << "  Значения: ";
        
        for (size_t j = 0; j < config.samples[i].size(); j++) {
@@ -344,10 +327,10 @@ void write_results_to_file(const KruskalWallisConfig& config,
                outfile << ", ";
            }
            if ((j + 1) % 5 == 0 && j < config.samples[i].size() - 1) {
-               outfile << endl << "           ";
+               outfile << '\n' << "           ";
            }
        }
-       outfile << endl << endl;
+       outfile << '\n' << '\n';
    }
    
    // Вычисляем общее количество наблюдений
@@ -355,39 +338,65 @@ void write_results_to_file(const KruskalWallisConfig& config,
    for (const auto& sample : config.samples) {
        N += sample.size();
    }
-   outfile << "Общее количество наблюдений (N): " << N << endl << endl;
+   outfile << "Общее количество наблюдений (N): " << N << '\n' << '\n';
    
    // Результаты вычислений
-   outfile << "РЕЗУЛЬТАТЫ ВЫЧИСЛЕНИЙ:" << endl;
-   outfile << "Статистика H: " << H_stat << endl;
-   outfile << "Скорректированная статистика H1: " << H1_stat << endl;
-   outfile << "Критическое значение H_alpha: " << H_alpha << endl;
-   outfile << "Уровень значимости (alpha): " << config.alpha << endl << endl;
+   outfile << "РЕЗУЛЬТАТЫ ВЫЧИСЛЕНИЙ:" << '\n';
+   outfile << "Статистика H: " << H_stat << '\n';
+   outfile << "Скорректированная статистика H1: " << H1_stat << '\n';
+   outfile << "Критическое значение H_alpha: " << H_alpha << '\n';
+   outfile << "Уровень значимости (alpha): " << config.alpha << '\n' << '\n';
    
    // Вывод о гипотезе
-   outfile << "ВЫВОД:" << endl;
-   outfile << "Нулевая гипотеза H0: theta_1 = theta_2 = ... = theta_k (все выборки имеют одинаковые медианы)" << endl;
-   outfile << "Альтернативная гипотеза H1: не все θ равны" << endl << endl;
+   outfile << "ВЫВОД:" << '\n';
+   outfile << "Нулевая гипотеза H0: theta_1 = theta_2 = ... = theta_k (все выборки имеют одинаковые медианы)" << '\n';
+   outfile << "Альтернативная гипотеза H1: не все θ равны" << '\n' << '\n';
    
    if (hypothesis_accepted) {
-       outfile << "Нулевая гипотеза ПРИНЯТА." << endl;
-       outfile << "(H1 = " << H1_stat << " <= " << H_alpha << ")" << endl;
-       outfile << "Нет статистически значимых различий между медианами выборок." << endl;
+       outfile << "Нулевая гипотеза ПРИНЯТА." << '\n';
+       outfile << "(H1 = " << H1_stat << " <= " << H_alpha << ")" << '\n';
+       outfile << "Нет статистически значимых различий между медианами выборок." << '\n';
    } else {
-       outfile << "Нулевая гипотеза ОТВЕРГНУТА." << endl;
-       outfile << "(H1 = " << H1_stat << " > " << H_alpha << ")" << endl;
-       outfile << "Существуют статистически значимые различия между медианами выборок." << endl;
-       outfile << "Рекомендуется провести попарное сравнение выборок." << endl;
+       outfile << "Нулевая гипотеза ОТВЕРГНУТА." << '\n';
+       outfile << "(H1 = " << H1_stat << " > " << H_alpha << ")" << '\n';
+       outfile << "Существуют статистически значимые различия между медианами выборок." << '\n';
+       outfile << "Рекомендуется провести попарное сравнение выборок." << '\n';
    }
    
-   outfile << endl << "==============================================" << endl;
-   outfile << "Критерий Краскела-Уоллиса выполнен успешно." << endl;
+   outfile << '\n' << "==============================================" << '\n';
+   outfile << "Критерий Краскела-Уоллиса выполнен успешно." << '\n';
    
    outfile.close();
    cout << "Результаты сохранены в файл: " << config.output_filename << endl;
+   return true;
 }
 
-bool kruskal_wallis_test(const KruskalWallisConfig& config) {
+// Итоги критерия одной записью для --format jsonl|csv (result_writer.h)
+bool write_results_records(const KruskalWallisConfig& config, const ResultOptions& options,
+                         int N,
+                         double H_stat,
+                         double H1_stat,
+                         double H_alpha,
+                         bool hypothesis_accepted) {
+   STAT_PROFILE_SCOPE("write_report");
+   
+   ResultWriter writer;
+   if (!writer.open(config.output_filename, options, "kruskal_wallis", { "samples", "n", "alpha",
+       "h", "h1", "critical", "accepted" })) {
+       cout << "Ошибка: не удалось создать файл " << config.output_filename << endl;
+       return false;
+   }
+   writer.write(config.samples.size(), N, config.alpha, H_stat, H1_stat, H_alpha, hypothesis_accepted);
+   if (!writer.close()) {
+       cout << "Ошибка записи в файл " << config.output_filename << endl;
+       return false;
+   }
+   cout << "Результаты сохранены в файл: " << config.output_filename << endl;
+   return true;
+}
+
+// true - результаты записаны в config.output_filename
+bool kruskal_wallis_test(const KruskalWallisConfig& config, const ResultOptions& options) {
    
    // Проверка уровня значимости
    if (config.alpha <= 0 || config.alpha >= 1) {
@@ -432,9 +441,10 @@ bool kruskal_wallis_test(const KruskalWallisConfig& config) {
    }
    
    // Запись в файл
-   write_results_to_file(config, H_stat, H1_stat, H_alpha, hypothesis_accepted);
-   
-   return hypothesis_accepted;
+   if (options.structured()) {
+       return write_results_records(config, options, N, H_stat, H1_stat, H_alpha, hypothesis_accepted);
+   }
+   return write_results_to_file(config, H_stat, H1_stat, H_alpha, hypothesis_accepted);
 }
 
 void create_example_config_file() {
@@ -444,41 +454,59 @@ void create_example_config_file() {
        return;
    }
    
-   outfile << "# Пример файла конфигурации для критерия Краскела-Уоллиса" << endl;
-   outfile << "# Все параметры можно указывать в любом порядке" << endl;
-   outfile << "# Пустые строки и строки, начинающиеся с #, игнорируются" << endl;
-   outfile << endl;
+   outfile << "# Пример файла конфигурации для критерия Краскела-Уоллиса" << '\n';
+   outfile << "# Все параметры можно указывать в любом порядке" << '\n';
+   outfile << "# Пустые строки и строки, начинающиеся с #, игнорируются" << '\n';
+   outfile << '\n';
    
-   outfile << "# Параметры теста (необязательные, значения по умолчанию указаны)" << endl;
-   outfile << "alpha 0.05           # уровень значимости" << endl;
-   outfile << "output kruskal_results.txt   # имя выходного файла" << endl;
-   outfile << endl;
+   outfile << "# Параметры теста (необязательные, значения по умолчанию указаны)" << '\n';
+   outfile << "alpha 0.05           # уровень значимости" << '\n';
+   outfile << "output kruskal_results.txt   # имя выходного файла" << '\n';
+   outfile << '\n';
    
-   outfile << "# Данные: каждая строка содержит значения одной выборки" << endl;
-   outfile << "# Можно указывать несколько значений в строке через пробел" << endl;
-   outfile << "# Для новой выборки можно использовать метку [SAMPLE]" << endl;
-   outfile << endl;
+   outfile << "# Данные: каждая строка содержит значения одной выборки" << '\n';
+   outfile << "# Можно указывать несколько значений в строке через пробел" << '\n';
+   outfile << "# Для новой выборки можно использовать метку [SAMPLE]" << '\n';
+   outfile << '\n';
    
-   outfile << "# Пример данных: 3 выборки" << endl;
-   outfile << "# Выборка 1" << endl;
-   outfile << "7.1 7.4 7.5 7.6 7.9" << endl;
-   outfile << endl;
+   outfile << "# Пример данных: 3 выборки" << '\n';
+   outfile << "# Выборка 1" << '\n';
+   outfile << "7.1 7.4 7.5 7.6 7.9" << '\n';
+   outfile << '\n';
    
-   outfile << "# Выборка 2" << endl;
-   outfile << "6.8 7.0 7.2 7.3 7.4 7.6" << endl;
-   outfile << endl;
+   outfile << "# Выборка 2" << '\n';
+   outfile << "6.8 7.0 7.2 7.3 7.4 7.6" << '\n';
+   outfile << '\n';
    
-   outfile << "# Выборка 3" << endl;
-   outfile << "6.5 6.7 6.9 7.0 7.1 7.2 7.3" << endl;
+   outfile << "# Выборка 3" << '\n';
+   outfile << "6.5 6.7 6.9 7.0 7.1 7.2 7.3" << '\n';
    
    outfile.close();
    cout << "Создан примерный файл конфигурации: example_kruskal_config.txt" << endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
    setlocale(LC_ALL, "rus");
    // Имя входного файла
    string input_filename = "kruskal_wallis_input.txt";
+
+   // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+   ResultCacheOptions cache_options;
+   if (!take_cache_options(argc, argv, cache_options)) return 1;
+
+   // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+   ResultOptions result_options;
+   if (!take_result_options(argc, argv, result_options)) return 1;
+
+   // Другой входной файл (текстовый или двоичный): --input <файл>
+   if (argc > 2 && string(argv[1]) == "--input") input_filename = argv[2];
+
+   // Тот же файл с теми же параметрами - результат из кэша
+   ResultCache cache(cache_options, "kruskal_wallis");
+   cache.add_file(input_filename);
+   cache.add_arguments(argc, argv);
+   cache.add("format", static_cast<int>(result_options.format));
+   if (cache.replay()) return 0;
    
    cout << "Программа для вычисления критерия Краскела-Уоллиса" << endl;
    cout << "==================================================" << endl;
@@ -516,10 +544,11 @@ int main() {
    if (!read_config_from_file(input_filename, config)) {
        return 1;
    }
+   config.output_filename = result_output_filename(config.output_filename, result_options);
    
    // Выполнение критерия Краскела-Уоллиса
    cout << endl;
-   kruskal_wallis_test(config);
+   if (kruskal_wallis_test(config, result_options)) cache.store({ config.output_filename });
    
    return 0;
 }
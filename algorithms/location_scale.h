@@ -0,0 +1,224 @@
+#pragma once
+// МНК по вероятностной бумаге для семейств сдвига-масштаба.
+//
+// Если F(x) = G((t(x) - a) / b), то точки (G^-1(p_i), t(x_(i))) лежат на
+// прямой t = a + b z, и a, b оцениваются линейной регрессией. Семейства:
+//
+//   нормальное      t = x,     z = Ф^-1(p)            a = mu,         b = sigma
+//   логнормальное   t = ln x,  z = Ф^-1(p)            a = mu,         b = sigma
+//   Вейбулла        t = ln x,  z = ln(-ln(1 - p))     a = ln lambda,  b = 1 / k
+//                   (минимальное распределение Гумбеля для ln x)
+//   экспоненциальное t = x,    z = -ln(1 - p)         a = порог,      b = theta
+//
+// Выборка сортируется и позиции p_i (медианные ранги Бернара с поправкой
+// Джонсона на цензурирование справа) считаются один раз; затем за один
+// проход по точкам накапливаются суммы для всех семейств сразу.
+//
+// R^2 графика считается по t: для семейств с t = ln x - в логарифмической
+// шкале, и между семействами такие R^2 несравнимы. Поэтому семейства
+// упорядочиваются по R^2 в общей шкале вероятностей: вторым проходом
+// подобранная функция распределения F(x_i) сравнивается с p_i.
+//
+//   std::vector<PlotPoint> points = plotting_positions(values, censored);
+//   std::array<LocationScaleFit, lsq_family_count> fits = fit_location_scale(points);
+//   std::vector<size_t> order = rank_location_scale(fits);
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include <boost/math/special_functions/erf.hpp>
+
+#include "parallel_sort.h"
+
+enum class LsqFamily { Normal, Lognormal, Weibull, Exponential };
+
+constexpr size_t lsq_family_count = 4;
+
+inline const char* lsq_family_name(LsqFamily family) {
+   switch (family) {
+   case LsqFamily::Normal: return "нормальное";
+   case LsqFamily::Lognormal: return "логнормальное";
+   case LsqFamily::Weibull: return "Вейбулла";
+   case LsqFamily::Exponential: return "экспоненциальное";
+   }
+   return "";
+}
+
+// Наблюдение (не цензурированное) и его вероятностная позиция
+struct PlotPoint {
+   double x;
+   double p;
+};
+
+// Нецензурированное наблюдение и его номер в полной выборке
+struct RankedPoint {
+   double x;
+   double rank;
+};
+
+// Нецензурированные наблюдения по возрастанию и их скорректированные ранги
+// Джонсона. censored[i] != 0 - наблюдение цензурировано справа: оно не
+// получает ранга, но увеличивает шаг рангов следующих отказов (без
+// цензурирования ранги 1..n). При равных значениях отказ ставится раньше
+// цензурированного.
+inline std::vector<RankedPoint> johnson_ranks(const std::vector<double>& values, const std::vector<int>& censored) {
+   size_t n = values.size();
+   std::vector<size_t> order(n);
+   parallel_sort_indices(values.data(), n, order.data());
+   // Среди равных значений отказы - раньше цензурированных
+   for (size_t begin = 0, end; begin < n; begin = end) {
+      end = begin + 1;
+      while (end < n && values[order[end]] == values[order[begin]]) end++;
+      if (end - begin > 1) {
+         std::stable_partition(order.begin() + begin, order.begin() + end, [&](size_t i) { return censored[i] == 0; });
+      }
+   }
+
+   std::vector<RankedPoint> ranked;
+   ranked.reserve(n);
+   double rank = 0.0;
+   for (size_t j = 0; j < n; j++) {
+      size_t i = order[j];
+      if (censored[i] != 0) continue;
+      rank += (n + 1.0 - rank) / (n - j + 1.0);
+      ranked.push_back({ values[i], rank });
+   }
+   return ranked;
+}
+
+// Позиции нецензурированных наблюдений: медианные ранги Бернара по рангам
+// Джонсона
+inline std::vector<PlotPoint> plotting_positions(const std::vector<double>& values, const std::vector<int>& censored) {
+   size_t n = values.size();
+   std::vector<RankedPoint> ranked = johnson_ranks(values, censored);
+   std::vector<PlotPoint> points;
+   points.reserve(ranked.size());
+   for (const RankedPoint& point : ranked) {
+      points.push_back({ point.x, (point.rank - 0.3) / (n + 0.4) });
+   }
+   return points;
+}
+
+// Регрессия t на z: суммы отклонений от средних (Уэлфорд для пары)
+struct PlotRegression {
+   size_t count = 0;
+   double mean_z = 0.0;
+   double mean_t = 0.0;
+   double szz = 0.0;
+   double stt = 0.0;
+   double szt = 0.0;
+
+   void add(double z, double t) {
+      count++;
+      double dz = z - mean_z;
+      double dt = t - mean_t;
+      mean_z += dz / count;
+      mean_t += dt / count;
+      szz += dz * (z - mean_z);
+      stt += dt * (t - mean_t);
+      szt += dz * (t - mean_t);
+   }
+};
+
+struct LocationScaleFit {
+   LsqFamily family = LsqFamily::Normal;
+   bool valid = false;      // достаточно точек (и все x > 0 для ln x)
+   size_t points = 0;
+   double location = 0.0;   // a: сдвиг графика
+   double scale = 0.0;      // b: наклон графика
+   double r_squared = 0.0;  // для прямой в координатах семейства (по t)
+   double sse = 0.0;        // сумма квадратов остатков по t
+   double probability_r_squared = 0.0; // F(x_i) против p_i: общая шкала для всех семейств
+};
+
+// Подобранная функция распределения семейства в точке x
+inline double location_scale_cdf(const LocationScaleFit& fit, double x) {
+   double t = (fit.family == LsqFamily::Lognormal || fit.family == LsqFamily::Weibull) ? std::log(x) : x;
+   double z = (t - fit.location) / fit.scale;
+   switch (fit.family) {
+   case LsqFamily::Normal:
+   case LsqFamily::Lognormal:
+      return 0.5 * std::erfc(-z / std::sqrt(2.0));
+   case LsqFamily::Weibull:
+      return -std::expm1(-std::exp(z));
+   case LsqFamily::Exponential:
+      return z > 0.0 ? -std::expm1(-z) : 0.0;
+   }
+   return 0.0;
+}
+
+inline LocationScaleFit finish_plot_regression(LsqFamily family, const PlotRegression& r) {
+   LocationScaleFit fit;
+   fit.family = family;
+   fit.points = r.count;
+   if (r.count < 3 || !(r.szz > 0.0) || !(r.stt > 0.0)) return fit;
+   fit.scale = r.szt / r.szz;
+   fit.location = r.mean_t - fit.scale * r.mean_z;
+   fit.r_squared = r.szt * r.szt / (r.szz * r.stt);
+   fit.sse = std::max(0.0, r.stt - fit.scale * r.szt);
+   fit.valid = fit.scale > 0.0;
+   return fit;
+}
+
+// Все семейства за один проход по точкам; индекс результата - LsqFamily
+inline std::array<LocationScaleFit, lsq_family_count> fit_location_scale(const std::vector<PlotPoint>& points) {
+   std::array<PlotRegression, lsq_family_count> regressions;
+   bool positive = true;
+   for (const PlotPoint& point : points) {
+      double normal_z = -std::sqrt(2.0) * boost::math::erfc_inv(2.0 * point.p);
+      double exponential_z = -std::log1p(-point.p);
+      regressions[size_t(LsqFamily::Normal)].add(normal_z, point.x);
+      regressions[size_t(LsqFamily::Exponential)].add(exponential_z, point.x);
+      if (point.x > 0.0) {
+         double log_x = std::log(point.x);
+         regressions[size_t(LsqFamily::Lognormal)].add(normal_z, log_x);
+         regressions[size_t(LsqFamily::Weibull)].add(std::log(exponential_z), log_x);
+      }
+      else {
+         positive = false;
+      }
+   }
+
+   std::array<LocationScaleFit, lsq_family_count> fits;
+   for (size_t f = 0; f < lsq_family_count; f++) {
+      fits[f] = finish_plot_regression(LsqFamily(f), regressions[f]);
+   }
+   if (!positive) {
+      fits[size_t(LsqFamily::Lognormal)].valid = false;
+      fits[size_t(LsqFamily::Weibull)].valid = false;
+   }
+
+   // R^2 в шкале вероятностей: остатки F(x_i) - p_i, одинаковые p_i у всех семейств
+   double mean_p = 0.0, spp = 0.0;
+   std::array<double, lsq_family_count> residuals{};
+   size_t count = 0;
+   for (const PlotPoint& point : points) {
+      count++;
+      double dp = point.p - mean_p;
+      mean_p += dp / count;
+      spp += dp * (point.p - mean_p);
+      for (size_t f = 0; f < lsq_family_count; f++) {
+         if (!fits[f].valid) continue;
+         double e = location_scale_cdf(fits[f], point.x) - point.p;
+         residuals[f] += e * e;
+      }
+   }
+   for (size_t f = 0; f < lsq_family_count; f++) {
+      if (fits[f].valid && spp > 0.0) fits[f].probability_r_squared = 1.0 - residuals[f] / spp;
+   }
+   return fits;
+}
+
+// Номера семейств по убыванию R^2 в шкале вероятностей; неприменимые - в конце
+inline std::vector<size_t> rank_location_scale(const std::array<LocationScaleFit, lsq_family_count>& fits) {
+   std::vector<size_t> order(lsq_family_count);
+   std::iota(order.begin(), order.end(), size_t(0));
+   std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      if (fits[a].valid != fits[b].valid) return fits[a].valid;
+      return fits[a].probability_r_squared > fits[b].probability_r_squared;
+   });
+   return order;
+}
@@ -0,0 +1,358 @@
+#pragma once
+// Плотные матрицы для МНК и ковариационных матриц оценок.
+//
+// Элементы хранятся по строкам в одном выровненном по 64 байта массиве.
+// Matrix<R, C> - размер известен при компиляции, массив внутри объекта
+// (2 x 2 ковариационная матрица не обращается к куче). Matrix<> - размер
+// задается при создании, память берется из arena_resource() (внутри
+// ArenaScope - из арены задания, поэтому такая матрица не должна
+// переживать область) и освобождается деструктором.
+//
+//   Matrix<> x(n, k), y(n, 1), b;
+//   solve_spd(gram(x), transpose_multiply(x, y), b);   // b = (X^T X)^-1 X^T y
+//
+// Порядок суммирования в произведениях тот же, что у поэлементной формулы
+// sum_j a(i, j) * b(j, k) по возрастанию j, поэтому результат не зависит от
+// разбиения на блоки.
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <utility>
+
+#include "arena.h"
+
+template <size_t Rows = 0, size_t Cols = 0>
+class Matrix {
+public:
+   Matrix() { data_.fill(0.0); }
+   // Для общего кода с Matrix<>: размер должен совпадать с Rows x Cols
+   Matrix(size_t, size_t) : Matrix() {}
+
+   size_t rows() const { return Rows; }
+   size_t cols() const { return Cols; }
+
+   double& operator()(size_t i, size_t j) { return data_[i * Cols + j]; }
+   double operator()(size_t i, size_t j) const { return data_[i * Cols + j]; }
+   double* row(size_t i) { return data_.data() + i * Cols; }
+   const double* row(size_t i) const { return data_.data() + i * Cols; }
+   double* data() { return data_.data(); }
+   const double* data() const { return data_.data(); }
+
+private:
+   alignas(64) std::array<double, Rows * Cols> data_;
+};
+
+template <>
+class Matrix<0, 0> {
+public:
+   Matrix() = default;
+   Matrix(size_t rows, size_t cols, std::pmr::memory_resource* resource = arena_resource())
+      : rows_(rows), cols_(cols), resource_(resource) {
+      if (size() > 0) {
+         data_ = static_cast<double*>(resource_->allocate(size() * sizeof(double), alignment));
+         std::fill(data_, data_ + size(), 0.0);
+      }
+   }
+   ~Matrix() { release(); }
+
+   Matrix(const Matrix& other) : Matrix(other.rows_, other.cols_) {
+      if (size() > 0) std::memcpy(data_, other.data_, size() * sizeof(double));
+   }
+   Matrix(Matrix&& other) noexcept
+      : rows_(other.rows_), cols_(other.cols_), data_(other.data_), resource_(other.resource_) {
+      other.rows_ = other.cols_ = 0;
+      other.data_ = nullptr;
+   }
+   Matrix& operator=(Matrix other) noexcept {
+      std::swap(rows_, other.rows_);
+      std::swap(cols_, other.cols_);
+      std::swap(data_, other.data_);
+      std::swap(resource_, other.resource_);
+      return *this;
+   }
+
+   size_t rows() const { return rows_; }
+   size_t cols() const { return cols_; }
+
+   double& operator()(size_t i, size_t j) { return data_[i * cols_ + j]; }
+   double operator()(size_t i, size_t j) const { return data_[i * cols_ + j]; }
+   double* row(size_t i) { return data_ + i * cols_; }
+   const double* row(size_t i) const { return data_ + i * cols_; }
+   double* data() { return data_; }
+   const double* data() const { return data_; }
+
+private:
+   static constexpr size_t alignment = 64;
+
+   size_t size() const { return rows_ * cols_; }
+
+   void release() {
+      if (data_ != nullptr) resource_->deallocate(data_, size() * sizeof(double), alignment);
+      data_ = nullptr;
+   }
+
+   size_t rows_ = 0;
+   size_t cols_ = 0;
+   double* data_ = nullptr;
+   std::pmr::memory_resource* resource_ = nullptr;
+};
+
+// c (n x p) = a (n x m) * b (m x p). Блоки по m и p помещаются в кэш;
+// внутренний цикл идет по строке b и строке c подряд.
+inline void matrix_multiply(const double* a, const double* b, double* c, size_t n, size_t m, size_t p) {
+   const size_t block = 64;
+   std::fill(c, c + n * p, 0.0);
+   for (size_t jj = 0; jj < m; jj += block) {
+      size_t j_end = std::min(m, jj + block);
+      for (size_t kk = 0; kk < p; kk += block) {
+         size_t k_end = std::min(p, kk + block);
+         for (size_t i = 0; i < n; i++) {
+            double* ci = c + i * p;
+            for (size_t j = jj; j < j_end; j++) {
+               double aij = a[i * m + j];
+               const double* bj = b + j * p;
+               for (size_t k = kk; k < k_end; k++) ci[k] += aij * bj[k];
+            }
+         }
+      }
+   }
+}
+
+template <size_t R, size_t K, size_t C>
+Matrix<R, C> multiply(const Matrix<R, K>& a, const Matrix<K, C>& b) {
+   Matrix<R, C> c(a.rows(), b.cols());
+   matrix_multiply(a.data(), b.data(), c.data(), a.rows(), a.cols(), b.cols());
+   return c;
+}
+
+// a^T * b без транспонирования: проход по строкам a и b подряд
+template <size_t R, size_t C1, size_t C2>
+Matrix<C1, C2> transpose_multiply(const Matrix<R, C1>& a, const Matrix<R, C2>& b) {
+   Matrix<C1, C2> c(a.cols(), b.cols());
+   for (size_t r = 0; r < a.rows(); r++) {
+      const double* ar = a.row(r);
+      const double* br = b.row(r);
+      for (size_t i = 0; i < a.cols(); i++) {
+         double* ci = c.row(i);
+         double ari = ar[i];
+         for (size_t j = 0; j < b.cols(); j++) ci[j] += ari * br[j];
+      }
+   }
+   return c;
+}
+
+// Матрица Грама X^T X (симметричная): считается верхний треугольник
+template <size_t R, size_t C>
+Matrix<C, C> gram(const Matrix<R, C>& x) {
+   size_t k = x.cols();
+   Matrix<C, C> g(k, k);
+   for (size_t r = 0; r < x.rows(); r++) {
+      const double* xr = x.row(r);
+      for (size_t i = 0; i < k; i++) {
+         double xri = xr[i];
+         double* gi = g.row(i);
+         for (size_t j = i; j < k; j++) gi[j] += xri * xr[j];
+      }
+   }
+   for (size_t i = 0; i < k; i++) {
+      for (size_t j = 0; j < i; j++) g(i, j) = g(j, i);
+   }
+   return g;
+}
+
+template <size_t R>
+Matrix<R, R> identity_matrix(size_t n) {
+   Matrix<R, R> e(n, n);
+   for (size_t i = 0; i < n; i++) e(i, i) = 1.0;
+   return e;
+}
+
+// ---------- Линейные системы ----------
+//
+// Решатели возвращают false, если матрица численно вырождена: ведущий
+// элемент не конечен или не больше singular_tolerance от масштаба матрицы
+// (раньше в этом случае получались NaN и бесконечности). Решение системы
+// без явного обращения точнее и дешевле: solve(a, y, x) вместо inverse * y.
+// Для 2 x 2 и 3 x 3 - формулы через определитель, без циклов.
+
+constexpr double singular_tolerance = 1e-14;
+
+template <size_t R, size_t C>
+double max_abs_element(const Matrix<R, C>& a) {
+   double m = 0.0;
+   const double* d = a.data();
+   for (size_t i = 0; i < a.rows() * a.cols(); i++) m = std::max(m, std::fabs(d[i]));
+   return m;
+}
+
+// Решение a x = b (b - столбцы правых частей) методом Гаусса с выбором
+// главного элемента по столбцу, т.е. через LU-разложение PA = LU на месте a
+template <size_t R, size_t C>
+bool solve(Matrix<R, R> a, Matrix<R, C> b, Matrix<R, C>& x) {
+   static_assert((R == 0) == (C == 0), "solve: Matrix<> with Matrix<>, fixed with fixed");
+   size_t n = a.rows();
+   size_t m = b.cols();
+   double limit = singular_tolerance * max_abs_element(a);
+   for (size_t k = 0; k < n; k++) {
+      size_t pivot = k;
+      for (size_t i = k + 1; i < n; i++) {
+         if (std::fabs(a(i, k)) > std::fabs(a(pivot, k))) pivot = i;
+      }
+      if (!(std::fabs(a(pivot, k)) > limit) || !std::isfinite(a(pivot, k))) return false;
+      if (pivot != k) {
+         std::swap_ranges(a.row(k) + k, a.row(k) + n, a.row(pivot) + k);
+         std::swap_ranges(b.row(k), b.row(k) + m, b.row(pivot));
+      }
+      const double* ak = a.row(k);
+      const double* bk = b.row(k);
+      for (size_t i = k + 1; i < n; i++) {
+         double f = a(i, k) / ak[k];
+         if (f == 0.0) continue;
+         double* ai = a.row(i);
+         double* bi = b.row(i);
+         for (size_t j = k + 1; j < n; j++) ai[j] -= f * ak[j];
+         for (size_t j = 0; j < m; j++) bi[j] -= f * bk[j];
+      }
+   }
+   for (size_t k = n; k-- > 0;) {
+      double* bk = b.row(k);
+      for (size_t t = k + 1; t < n; t++) {
+         double akt = a(k, t);
+         const double* bt = b.row(t);
+         for (size_t j = 0; j < m; j++) bk[j] -= akt * bt[j];
+      }
+      for (size_t j = 0; j < m; j++) bk[j] /= a(k, k);
+   }
+   x = std::move(b);
+   return true;
+}
+
+// Разложение симметричной положительно определенной матрицы a = L D L^T
+// на месте (разложение Холецкого без извлечения корней): под диагональю -
+// L с единичной диагональю, на диагонали - D. Используется только нижний
+// треугольник a. false - матрица не положительно определена или вырождена.
+template <size_t R>
+bool ldlt_decompose(Matrix<R, R>& a) {
+   size_t n = a.rows();
+   double scale = 0.0;
+   for (size_t i = 0; i < n; i++) scale = std::max(scale, std::fabs(a(i, i)));
+   double limit = singular_tolerance * scale;
+   for (size_t j = 0; j < n; j++) {
+      double* aj = a.row(j);
+      double d = aj[j];
+      for (size_t t = 0; t < j; t++) d -= aj[t] * aj[t] * a(t, t);
+      if (!(d > limit) || !std::isfinite(d)) return false;
+      aj[j] = d;
+      for (size_t i = j + 1; i < n; i++) {
+         double* ai = a.row(i);
+         double s = ai[j];
+         for (size_t t = 0; t < j; t++) s -= ai[t] * aj[t] * a(t, t);
+         ai[j] = s / d;
+      }
+   }
+   return true;
+}
+
+// Решение L D L^T x = b на месте b по результату ldlt_decompose
+template <size_t R, size_t C>
+void ldlt_solve(const Matrix<R, R>& f, Matrix<R, C>& b) {
+   size_t n = f.rows();
+   size_t m = b.cols();
+   for (size_t i = 1; i < n; i++) {
+      double* bi = b.row(i);
+      for (size_t t = 0; t < i; t++) {
+         double l = f(i, t);
+         const double* bt = b.row(t);
+         for (size_t j = 0; j < m; j++) bi[j] -= l * bt[j];
+      }
+   }
+   for (size_t i = 0; i < n; i++) {
+      double* bi = b.row(i);
+      for (size_t j = 0; j < m; j++) bi[j] /= f(i, i);
+   }
+   for (size_t i = n; i-- > 1;) {
+      const double* bi = b.row(i);
+      for (size_t t = 0; t < i; t++) {
+         double l = f(i, t);
+         double* bt = b.row(t);
+         for (size_t j = 0; j < m; j++) bt[j] -= l * bi[j];
+      }
+   }
+}
+
+// Решение a x = b для симметричной положительно определенной a
+// (матрицы Грама, информационные матрицы) через L D L^T
+template <size_t R, size_t C>
+bool solve_spd(Matrix<R, R> a, Matrix<R, C> b, Matrix<R, C>& x) {
+   if (!ldlt_decompose(a)) return false;
+   ldlt_solve(a, b);
+   x = std::move(b);
+   return true;
+}
+
+// Обращение квадратной матрицы (LU с выбором главного элемента)
+template <size_t R>
+bool inverse(const Matrix<R, R>& a, Matrix<R, R>& inv) {
+   return solve(a, identity_matrix<R>(a.rows()), inv);
+}
+
+// 2 x 2: по формуле через определитель. Масштаб - сумма модулей слагаемых
+// определителя: малый det относительно него означает взаимное уничтожение
+inline bool inverse(const Matrix<2, 2>& a, Matrix<2, 2>& inv) {
+   double a00 = a(0, 0), a01 = a(0, 1), a10 = a(1, 0), a11 = a(1, 1);
+   double det = a00 * a11 - a01 * a10;
+   double scale = std::fabs(a00 * a11) + std::fabs(a01 * a10);
+   if (!(std::fabs(det) > singular_tolerance * scale) || !std::isfinite(det)) return false;
+   inv(0, 0) = a11 / det;
+   inv(0, 1) = -a01 / det;
+   inv(1, 0) = -a10 / det;
+   inv(1, 1) = a00 / det;
+   return true;
+}
+
+template <size_t C>
+bool solve(const Matrix<2, 2>& a, const Matrix<2, C>& b, Matrix<2, C>& x) {
+   double a00 = a(0, 0), a01 = a(0, 1), a10 = a(1, 0), a11 = a(1, 1);
+   double det = a00 * a11 - a01 * a10;
+   double scale = std::fabs(a00 * a11) + std::fabs(a01 * a10);
+   if (!(std::fabs(det) > singular_tolerance * scale) || !std::isfinite(det)) return false;
+   for (size_t j = 0; j < C; j++) {
+      double b0 = b(0, j), b1 = b(1, j);
+      x(0, j) = (a11 * b0 - a01 * b1) / det;
+      x(1, j) = (a00 * b1 - a10 * b0) / det;
+   }
+   return true;
+}
+
+// 3 x 3: присоединенная матрица (алгебраические дополнения) / det
+inline bool inverse(const Matrix<3, 3>& a, Matrix<3, 3>& inv) {
+   double c00 = a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1);
+   double c01 = a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2);
+   double c02 = a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0);
+   double det = a(0, 0) * c00 + a(0, 1) * c01 + a(0, 2) * c02;
+   double scale = std::fabs(a(0, 0) * c00) + std::fabs(a(0, 1) * c01) + std::fabs(a(0, 2) * c02);
+   if (!(std::fabs(det) > singular_tolerance * scale) || !std::isfinite(det)) return false;
+   Matrix<3, 3> r;
+   r(0, 0) = c00 / det;
+   r(1, 0) = c01 / det;
+   r(2, 0) = c02 / det;
+   r(0, 1) = (a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2)) / det;
+   r(1, 1) = (a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0)) / det;
+   r(2, 1) = (a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1)) / det;
+   r(0, 2) = (a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1)) / det;
+   r(1, 2) = (a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2)) / det;
+   r(2, 2) = (a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0)) / det;
+   inv = r;
+   return true;
+}
+
+template <size_t C>
+bool solve(const Matrix<3, 3>& a, const Matrix<3, C>& b, Matrix<3, C>& x) {
+   Matrix<3, 3> inv;
+   if (!inverse(a, inv)) return false;
+   x = multiply(inv, b);
+   return true;
+}
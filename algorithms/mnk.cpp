@@ -9,6 +9,15 @@
 #include <numeric>
 #include <random>
 
+#include "censored_data.h"
+#include "location_scale.h"
+#include "moments.h"
+#include "arena.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+
 using namespace std;
 
 // Определяем M_PI если не определен
@@ -17,10 +26,9 @@ using namespace std;
 #endif
 
 // Прототипы функций
-double** InverseMatrix(double** a, int n);
-double** MultiplyMatrix(int rowsa, int colsa, int rowsb, int colsb, double** a, double** b);
-double** TransMatrix(int m, int n, double** a);
-void MleastSquare(int n, int k, double** x, double** y, double**& db, double**& b, double*& yr);
+bool MleastSquare(const Matrix<>& x, const Matrix<>& y, Matrix<>& db, Matrix<>& b, Matrix<>& yr);
+bool BlueLeastSquare(const Matrix<>& x, const Matrix<>& y, const vector<double>& ranks, int n_total,
+   Matrix<>& db, Matrix<>& b, Matrix<>& yr);
 
 // Реализации функций распределения (из boost.cpp)
 double norm_cdf(double x) {
@@ -77,238 +85,235 @@ double norm_pdf(double x) {
    return (1.0 / sqrt(2.0 * M_PI)) * exp(-0.5 * x * x);
 }
 
-// Реализация обращения матрицы (из boost.cpp)
-double** InverseMatrix(double** a, int n) {
-   double temp;
-   int i, j, k;
-
-   double** e = new double* [n];
-   for (i = 0; i < n; i++) {
-       e[i] = new double[n];
-       for (j = 0; j < n; j++) {
-           e[i][j] = 0;
-           if (i == j)
-               e[i][j] = 1;
-       }
-   }
-
-   for (k = 0; k < n; k++) {
-       temp = a[k][k];
-       for (j = 0; j < n; j++) {
-           a[k][j] /= temp;
-           e[k][j] /= temp;
-       }
+// Метод наименьших квадратов (из mls.cpp): x - регрессоры (n x k),
+// y - наблюдения (n x 1); db = (X^T X)^-1, b = db X^T Y, yr = X b.
+// X^T X раскладывается один раз (L D L^T), b - решение системы без
+// умножения на обратную матрицу. false - регрессоры линейно зависимы.
+bool MleastSquare(const Matrix<>& x, const Matrix<>& y, Matrix<>& db, Matrix<>& b, Matrix<>& yr) {
+   STAT_PROFILE_SCOPE("least_squares");
+   Matrix<> factor = gram(x);
+   if (!ldlt_decompose(factor)) return false;
+   db = identity_matrix<0>(x.cols());             // covariance matrix factors (k x k)
+   ldlt_solve(factor, db);
+   b = transpose_multiply(x, y);                  // coef
+   ldlt_solve(factor, b);
+   yr = multiply(x, b);
+   return true;
+}
 
-       for (i = k + 1; i < n; i++) {
-           temp = a[i][k];
-           for (j = 0; j < n; j++) {
-               a[i][j] -= a[k][j] * temp;
-               e[i][j] -= e[k][j] * temp;
-           }
-       }
+// Обобщенный МНК (BLUE Ллойда) по порядковым статистикам:
+// db = (X^T W X)^-1, b = db X^T W Y, где W - матрица, обратная ковариационной
+// матрице стандартных нормальных порядковых статистик. Асимптотически
+// cov(u_i, u_j) = p_i (1 - p_j) / ((n + 2) f_i f_j) при i <= j (p_i = i / (n + 1),
+// f_i - плотность в квантиле p_i): это ковариация броуновского моста в моменты
+// p_i, поэтому W трехдиагональна и X^T W X, X^T W Y считаются за O(n) без
+// n x n матриц. ranks - номера наблюдаемых порядковых статистик (по
+// возрастанию) в полной выборке объема n_total: при цензурировании регрессия
+// усекается до наблюдаемых, W для подмножества моментов тоже трехдиагональна.
+// При смешанном цензурировании номера дробные (ранги Джонсона).
+bool BlueLeastSquare(const Matrix<>& x, const Matrix<>& y, const vector<double>& ranks, int n_total,
+   Matrix<>& db, Matrix<>& b, Matrix<>& yr) {
+   STAT_PROFILE_SCOPE("blue_least_squares");
+   size_t m = ranks.size();
+   size_t k = x.cols();
+   if (m == 0) return false;
+
+   // W: диагональ diag[i], над диагональю upper[i] = W(i, i + 1)
+   pmr::vector<double> diag(m, arena_resource());
+   pmr::vector<double> upper(m, 0.0, arena_resource());
+   double previous_p = 0.0, previous_f = 0.0;
+   for (size_t i = 0; i < m; i++) {
+      double p = ranks[i] / (n_total + 1);
+      double f = norm_pdf(norm_ppf(p));
+      double next_p = i + 1 < m ? ranks[i + 1] / (n_total + 1) : 1.0;
+      diag[i] = (n_total + 2.0) * f * f * (1.0 / (p - previous_p) + 1.0 / (next_p - p));
+      if (i > 0) upper[i - 1] = -(n_total + 2.0) * previous_f * f / (p - previous_p);
+      previous_p = p;
+      previous_f = f;
    }
 
-   for (k = n - 1; k > 0; k--) {
-       for (i = k - 1; i >= 0; i--) {
-           temp = a[i][k];
-           for (j = 0; j < n; j++) {
-               a[i][j] -= a[k][j] * temp;
-               e[i][j] -= e[k][j] * temp;
-           }
-       }
+   // W X построчно: три соседние строки X
+   Matrix<> wx(m, k);
+   for (size_t i = 0; i < m; i++) {
+      double* wi = wx.row(i);
+      const double* xi = x.row(i);
+      for (size_t j = 0; j < k; j++) wi[j] = diag[i] * xi[j];
+      if (i > 0) {
+         const double* xp = x.row(i - 1);
+         for (size_t j = 0; j < k; j++) wi[j] += upper[i - 1] * xp[j];
+      }
+      if (i + 1 < m) {
+         const double* xn = x.row(i + 1);
+         for (size_t j = 0; j < k; j++) wi[j] += upper[i] * xn[j];
+      }
    }
-   return e;
-}
 
-// Умножение матриц (из boost.cpp)
-double** MultiplyMatrix(int rowsa, int colsa, int rowsb, int colsb, double** a, double** b) {
-   int i, j, k;
-   double t;
-   double** c;
-   c = new double* [rowsa];
-   for (i = 0; i < rowsa; i++) c[i] = new double[colsb];
-
-   if (colsa != rowsb) return 0;
-   for (k = 0; k < colsb; k++) {
-       for (i = 0; i < rowsa; i++) {
-           t = 0;
-           for (j = 0; j < rowsb; j++) t += a[i][j] * b[j][k];
-           c[i][k] = t;
-       }
-   }
-   return c;
+   Matrix<> factor = transpose_multiply(wx, x);
+   if (!ldlt_decompose(factor)) return false;
+   db = identity_matrix<0>(k);
+   ldlt_solve(factor, db);
+   b = transpose_multiply(wx, y);
+   ldlt_solve(factor, b);
+   yr = multiply(x, b);
+   return true;
 }
 
-// Транспонирование матрицы (из boost.cpp)
-double** TransMatrix(int m, int n, double** a) {
-   int i, j;
-   double** b;
-   b = new double* [n];
-   for (i = 0; i < n; i++) b[i] = new double[m];
-   for (i = 0; i < n; i++) {
-       for (j = 0; j < m; j++) b[i][j] = a[j][i];
-   }
-   return b;
-}
+// Математическое ожидание нормальной порядковой статистики с номером rank
+// в выборке объема n (из order.cpp); rank может быть дробным рангом Джонсона
+double normalOrderStatisticExpectation(double rank, int n) {
+   double p = rank / (n + 1);
+   double u_p = norm_ppf(p);
 
-// Метод наименьших квадратов (из mls.cpp)
-void MleastSquare(int n, int k, double** x, double** y, double**& db, double**& b, double*& yr) {
-   int i, j;
-   double s;
+   double f_u = exp(-u_p * u_p / 2.0) / sqrt(2.0 * M_PI);
+   double f_prime_u = -u_p * f_u;
 
-   db = InverseMatrix(MultiplyMatrix(k, n, n, k, TransMatrix(n, k, x), x), k);  // covariance matrix factors (k x k)
-   b = MultiplyMatrix(k, n, n, 1, MultiplyMatrix(k, k, k, n, db, TransMatrix(n, k, x)), y); // coef
+   // Основной член
+   double expectation = u_p;
 
-   for (i = 0; i < n; i++) {
-       s = 0;
-       for (j = 0; j < k; j++) s += b[j][0] * x[i][j];
-       yr[i] = s;
-   }
+   // Первая поправка
+   expectation += (p * (1.0 - p)) / (2.0 * (n + 2.0)) * (f_prime_u / (f_u * f_u));
+
+   // Вторая поправка (для большей точности)
+   double term2 = (p * (1.0 - p)) / ((n + 2.0) * (n + 2.0)) *
+       ((1.0 - 2.0 * p) * f_prime_u * f_prime_u / (f_u * f_u * f_u) +
+           (p * (1.0 - p)) * (f_prime_u * f_prime_u * f_prime_u -
+               f_u * f_u * (-3.0 * u_p * f_u - u_p * u_p * f_prime_u)) /
+           (6.0 * f_u * f_u * f_u * f_u));
+
+   return expectation + term2;
 }
 
 // Функция для вычисления математических ожиданий нормальных порядковых статистик (из order.cpp)
 vector<double> calculateNormalOrderStatisticsExpectations(int n) {
+   STAT_PROFILE_SCOPE("order_statistics_expectations");
    vector<double> expectations(n);
 
    for (int i = 1; i <= n; i++) {
-       double p = static_cast<double>(i) / (n + 1);
-       double u_p = norm_ppf(p);
-
-       double f_u = exp(-u_p * u_p / 2.0) / sqrt(2.0 * M_PI);
-       double f_prime_u = -u_p * f_u;
-
-       // Основной член
-       expectations[i - 1] = u_p;
-
-       // Первая поправка
-       expectations[i - 1] += (p * (1.0 - p)) / (2.0 * (n + 2.0)) * (f_prime_u / (f_u * f_u));
-
-       // Вторая поправка (для большей точности)
-       double term2 = (p * (1.0 - p)) / ((n + 2.0) * (n + 2.0)) *
-           ((1.0 - 2.0 * p) * f_prime_u * f_prime_u / (f_u * f_u * f_u) +
-               (p * (1.0 - p)) * (f_prime_u * f_prime_u * f_prime_u -
-                   f_u * f_u * (-3.0 * u_p * f_u - u_p * u_p * f_prime_u)) /
-               (6.0 * f_u * f_u * f_u * f_u));
-
-       expectations[i - 1] += term2;
+       expectations[i - 1] = normalOrderStatisticExpectation(i, n);
    }
 
    return expectations;
 }
 
-// Функция чтения данных (только значения, без цензурирования)
-vector<double> readData(const string& filename) {
-   setlocale(LC_ALL, "rus");
-   vector<double> data;
-   ifstream inp(filename);
-
-   if (!inp.is_open()) {
-       cout << "Не удалось открыть файл: " << filename << endl;
-       return data;
+// Оценки одной записью для --format jsonl|csv (result_writer.h)
+bool writeMlsRecord(const string& outputFile, const ResultOptions& options, bool blue, int n, size_t censored,
+   double mu, double sigma, const Matrix<>& db, double r_squared, double sse, double mse) {
+   ResultWriter writer;
+   if (!writer.open(outputFile, options, "normal_mls", { "estimator", "n", "censored", "mu", "sigma",
+       "var_mu", "cov_mu_sigma", "var_sigma", "r_squared", "sse", "mse" })) {
+       cout << "Не удалось создать файл: " << outputFile << endl;
+       return false;
    }
-
-   string line;
-   while (getline(inp, line)) {
-       if (line.empty() || line[0] == '#') continue;
-
-       istringstream iss(line);
-       double value;
-       char comma;
-       int censor;
-
-       // Пытаемся прочитать в формате "значение,цензурирование"
-       if (iss >> value >> comma >> censor) {
-           // Используем только нецензурированные данные (censor == 0)
-           if (censor == 0) {
-               data.push_back(value);
-           }
-       }
-       else {
-           // Если формат другой, пытаемся прочитать просто значение
-           iss.clear();
-           iss.str(line);
-           if (iss >> value) {
-               data.push_back(value);
-           }
-       }
+   writer.write(blue ? "blue" : "ols", n, censored, mu, sigma,
+       db(0, 0), db(0, 1), db(1, 1), r_squared, sse, mse);
+   if (!writer.close()) {
+       cout << "Ошибка записи в файл: " << outputFile << endl;
+       return false;
    }
-
-   inp.close();
-   return data;
+   cout << "Результаты записаны в: " << outputFile << endl;
+   return true;
 }
 
-// Основная функция оценки параметров нормального распределения методом наименьших квадратов
-void estimateNormalParametersMLS(const string& inputFile, const string& outputFile) {
+// Основная функция оценки параметров нормального распределения методом наименьших квадратов;
+// blue - обобщенный МНК с учетом цензурированных справа наблюдений.
+// Чтение данных (censored_data.h) и ранги Джонсона (location_scale.h) общие
+// с lsq_weibull, а регрессия своя: регрессоры - ожидания нормальных
+// порядковых статистик (а не квантили позиций), нужны ковариационная матрица
+// оценок и взвешенный вариант BLUE, которых нет в однопроходных суммах
+// location_scale.h
+bool estimateNormalParametersMLS(const string& inputFile, const string& outputFile, bool blue = false,
+   const ResultOptions& result = ResultOptions()) {
    setlocale(LC_ALL, "rus");
-
-   // 1. Чтение данных
-   vector<double> data = readData(inputFile);
-   if (data.empty()) {
+   // Матрицы задания освобождаются при выходе из функции
+   ArenaScope arena_scope;
+
+   // 1. Чтение данных: строка из одного числа - отказ; цензурированные
+   // наблюдения учитываются только обобщенным МНК
+   vector<double> values;
+   vector<int> flags;
+   read_censored_data(inputFile, values, flags, true);
+   if (!blue) {
+       size_t kept = 0;
+       for (size_t i = 0; i < values.size(); i++) {
+           if (flags[i] == 0) values[kept++] = values[i];
+       }
+       values.resize(kept);
+       flags.assign(kept, 0);
+   }
+   int n_total = values.size();
+
+   // 2. Сортировка данных для порядковых статистик. Номера наблюдений в
+   // полной выборке - скорректированные ранги Джонсона (location_scale.h):
+   // цензурированное значение не получает номера, а увеличивает шаг номеров
+   // следующих отказов (без цензурирования 1..n)
+   STAT_PROFILE_COUNT("sort_size", values.size());
+   vector<RankedPoint> ranked = johnson_ranks(values, flags);
+   if (ranked.empty()) {
        cout << "Ошибка: не удалось прочитать данные или данные отсутствуют" << endl;
-       return;
+       return false;
    }
 
-   int n = data.size();
+   int n = ranked.size();
+   size_t censored_count = n_total - n;
    cout << "Прочитано " << n << " наблюдений" << endl;
+   if (censored_count > 0) cout << "Цензурированных наблюдений: " << censored_count << endl;
 
-   // 2. Сортировка данных для порядковых статистик
-   vector<double> sorted_data = data;
-   sort(sorted_data.begin(), sorted_data.end());
+   vector<double> sorted_data(n);
+   vector<double> ranks(n);
+   for (int i = 0; i < n; i++) {
+       sorted_data[i] = ranked[i].x;
+       ranks[i] = ranked[i].rank;
+   }
 
    // 3. Вычисление математических ожиданий порядковых статистик
-   auto expectations = calculateNormalOrderStatisticsExpectations(n);
+   vector<double> expectations(n);
+   {
+       STAT_PROFILE_SCOPE("order_statistics_expectations");
+       for (int i = 0; i < n; i++) expectations[i] = normalOrderStatisticExpectation(ranks[i], n_total);
+   }
 
    // 4. Подготовка матриц для метода наименьших квадратов
    int k = 2; // число параметров (μ, σ)
 
    // Матрица регрессоров X (n x 2)
-   double** x = new double* [n];
+   Matrix<> x(n, k);
    for (int i = 0; i < n; i++) {
-       x[i] = new double[k];
-       x[i][0] = 1.0;                   // константа для μ
-       x[i][1] = expectations[i];       // математическое ожидание порядковой статистики для σ
+       x(i, 0) = 1.0;                   // константа для μ
+       x(i, 1) = expectations[i];       // математическое ожидание порядковой статистики для σ
    }
 
    // Вектор наблюдений Y (n x 1)
-   double** y = new double* [n];
+   Matrix<> y(n, 1);
    for (int i = 0; i < n; i++) {
-       y[i] = new double[1];
-       y[i][0] = sorted_data[i];        // отсортированные наблюдения
+       y(i, 0) = sorted_data[i];        // отсортированные наблюдения
    }
 
    // Матрицы для результатов
-   double** db = new double* [k];       // ковариационная матрица коэффициентов
-   double** b = new double* [k];        // коэффициенты регрессии
-   double* yr = new double[n];          // предсказанные значения
-
-   for (int i = 0; i < k; i++) {
-       db[i] = new double[k];
-       b[i] = new double[1];
-       for (int j = 0; j < k; j++) {
-           db[i][j] = 0.0;
-       }
-       b[i][0] = 0.0;
-   }
+   Matrix<> db;                         // ковариационная матрица коэффициентов
+   Matrix<> b;                          // коэффициенты регрессии
+   Matrix<> yr;                         // предсказанные значения
 
    // 5. Применение метода наименьших квадратов
-   MleastSquare(n, k, x, y, db, b, yr);
+   if (blue ? !BlueLeastSquare(x, y, ranks, n_total, db, b, yr) : !MleastSquare(x, y, db, b, yr)) {
+       cout << "Ошибка: матрица нормальных уравнений вырождена, оценки не определены" << endl;
+       return false;
+   }
 
    // Параметры нормального распределения
-   double mu = b[0][0];     // μ = intercept
-   double sigma = b[1][0];  // σ = slope
+   double mu = b(0, 0);     // μ = intercept
+   double sigma = b(1, 0);  // σ = slope
 
-   cout << "Оценки параметров методом наименьших квадратов:" << endl;
+   cout << (blue ? "Оценки параметров обобщенным методом наименьших квадратов (BLUE):" : "Оценки параметров методом наименьших квадратов:") << endl;
    cout << "Среднее (mu): " << mu << endl;
    cout << "Стандартное отклонение (sigma): " << sigma << endl;
 
    // 6. Вычисление статистик качества оценки
+   SampleMoments moments = compute_moments(sorted_data);
    double sse = 0.0; // сумма квадратов ошибок
-   double sst = 0.0; // общая сумма квадратов
-   double y_mean = accumulate(sorted_data.begin(), sorted_data.end(), 0.0) / n;
+   double sst = moments.m2; // общая сумма квадратов
 
    for (int i = 0; i < n; i++) {
-       sse += pow(sorted_data[i] - yr[i], 2);
-       sst += pow(sorted_data[i] - y_mean, 2);
+       sse += pow(sorted_data[i] - yr(i, 0), 2);
    }
 
    double r_squared = 1.0 - sse / sst;
@@ -319,40 +324,52 @@ void estimateNormalParametersMLS(const string& inputFile, const string& outputFi
    cout << "MSE = " << mse << endl;
 
    // 7. Запись результатов
+   STAT_PROFILE_SCOPE("write_report");
+   if (result.structured()) {
+       return writeMlsRecord(outputFile, result, blue, n, censored_count, mu, sigma, db, r_squared, sse, mse);
+   }
    ofstream out(outputFile);
    if (!out.is_open()) {
        cout << "Не удалось создать файл: " << outputFile << endl;
-       return;
+       return false;
    }
 
-   out << "Оценка параметров нормального распределения методом наименьших квадратов" << endl;
-   out << "=========================================================================" << endl << endl;
+   if (blue) {
+       out << "Оценка параметров нормального распределения обобщенным методом наименьших квадратов (BLUE)" << '\n';
+       out << "=========================================================================================" << '\n' << '\n';
+   }
+   else {
+       out << "Оценка параметров нормального распределения методом наименьших квадратов" << '\n';
+       out << "=========================================================================" << '\n' << '\n';
+   }
 
-   out << "Размер выборки: " << n << endl << endl;
+   out << "Размер выборки: " << n << '\n';
+   if (censored_count > 0) out << "Цензурированных наблюдений: " << censored_count << '\n';
+   out << '\n';
 
-   out << "Оцененные параметры:" << endl;
-   out << "Среднее (mu): " << fixed << setprecision(6) << mu << endl;
-   out << "Стандартное отклонение (sigma): " << fixed << setprecision(6) << sigma << endl << endl;
+   out << "Оцененные параметры:" << '\n';
+   out << "Среднее (mu): " << fixed << setprecision(6) << mu << '\n';
+   out << "Стандартное отклонение (sigma): " << fixed << setprecision(6) << sigma << '\n' << '\n';
 
-   out << "Ковариационная матрица оценок:" << endl;
-   out  << setw(12) << db[0][0]  << setw(12) << db[0][1] << endl;
-   out  << setw(12) << db[1][0]  << setw(12) << db[1][1] << endl;
+   out << "Ковариационная матрица оценок:" << '\n';
+   out  << setw(12) << db(0, 0)  << setw(12) << db(0, 1) << endl;
+   out  << setw(12) << db(1, 0)  << setw(12) << db(1, 1) << endl;
 
 
-   out << "Элементы ковариационной матрицы:" << endl;
-   out << "Var(mu)  = " << scientific << setprecision(6) << db[0][0] << endl;
-   out << "Cov(mu,sigma) = " << scientific << setprecision(6) << db[0][1] << endl;
-   out << "Cov(sigma,mu) = " << scientific << setprecision(6) << db[1][0] << endl;
-   out << "Var(sigma)  = " << scientific << setprecision(6) << db[1][1] << endl << endl;
+   out << "Элементы ковариационной матрицы:" << '\n';
+   out << "Var(mu)  = " << scientific << setprecision(6) << db(0, 0) << '\n';
+   out << "Cov(mu,sigma) = " << scientific << setprecision(6) << db(0, 1) << '\n';
+   out << "Cov(sigma,mu) = " << scientific << setprecision(6) << db(1, 0) << '\n';
+   out << "Var(sigma)  = " << scientific << setprecision(6) << db(1, 1) << '\n' << '\n';
 
-   double correlation = db[0][1] / sqrt(db[0][0] * db[1][1]);
-   out << "Корреляция между оценками mu и sigma: " << fixed << setprecision(6) << correlation << endl;
+   double correlation = db(0, 1) / sqrt(db(0, 0) * db(1, 1));
+   out << "Корреляция между оценками mu и sigma: " << fixed << setprecision(6) << correlation << '\n';
 
    // Стандартные ошибки
-   double se_mu = sqrt(db[0][0]);
-   double se_sigma = sqrt(db[1][1]);
-   out << "Стандартная ошибка mu: " << fixed << setprecision(6) << se_mu << endl;
-   out << "Стандартная ошибка sigma: " << fixed << setprecision(6) << se_sigma << endl << endl;
+   double se_mu = sqrt(db(0, 0));
+   double se_sigma = sqrt(db(1, 1));
+   out << "Стандартная ошибка mu: " << fixed << setprecision(6) << se_mu << '\n';
+   out << "Стандартная ошибка sigma: " << fixed << setprecision(6) << se_sigma << '\n' << '\n';
 
    // Доверительные интервалы (приблизительные, 95%)
    double t_value = 1.96; // для больших выборок
@@ -361,57 +378,64 @@ void estimateNormalParametersMLS(const string& inputFile, const string& outputFi
    double ci_sigma_low = sigma - t_value * se_sigma;
    double ci_sigma_high = sigma + t_value * se_sigma;
 
-   out << "Приблизительные 95% доверительные интервалы:" << endl;
-   out << "mu:  [" << fixed << setprecision(6) << ci_mu_low << ", " << ci_mu_high << "]" << endl;
-   out << "sigma:  [" << fixed << setprecision(6) << ci_sigma_low << ", " << ci_sigma_high << "]" << endl << endl;
+   out << "Приблизительные 95% доверительные интервалы:" << '\n';
+   out << "mu:  [" << fixed << setprecision(6) << ci_mu_low << ", " << ci_mu_high << "]" << '\n';
+   out << "sigma:  [" << fixed << setprecision(6) << ci_sigma_low << ", " << ci_sigma_high << "]" << '\n' << '\n';
 
    // Статистики качества
-   out << "Статистики качества оценки:" << endl;
-   out << "R² (коэффициент детерминации): " << fixed << setprecision(6) << r_squared << endl;
-   out << "Сумма квадратов ошибок (SSE): " << fixed << setprecision(6) << sse << endl;
-   out << "Среднеквадратическая ошибка (MSE): " << fixed << setprecision(6) << mse << endl;
-   out << "Среднеквадратическое отклонение (RMSE): " << fixed << setprecision(6) << sqrt(mse) << endl << endl;
+   out << "Статистики качества оценки:" << '\n';
+   out << "R² (коэффициент детерминации): " << fixed << setprecision(6) << r_squared << '\n';
+   out << "Сумма квадратов ошибок (SSE): " << fixed << setprecision(6) << sse << '\n';
+   out << "Среднеквадратическая ошибка (MSE): " << fixed << setprecision(6) << mse << '\n';
+   out << "Среднеквадратическое отклонение (RMSE): " << fixed << setprecision(6) << sqrt(mse) << '\n' << '\n';
 
    // Сравнение с выборочными оценками
-   double sample_mean = accumulate(data.begin(), data.end(), 0.0) / n;
-   double sample_variance = 0.0;
-   for (double val : data) {
-       sample_variance += pow(val - sample_mean, 2);
-   }
-   sample_variance /= (n - 1);
-   double sample_std = sqrt(sample_variance);
+   double sample_mean = moments.mean;
+   double sample_std = moments.stddev();
 
-   out << "Сравнение с выборочными оценками:" << endl;
-   out << "Выборочное среднее: " << fixed << setprecision(6) << sample_mean << endl;
-   out << "Выборочное стандартное отклонение: " << fixed << setprecision(6) << sample_std << endl;
-   out << "Разница по mu: " << fixed << setprecision(6) << (mu - sample_mean) << endl;
-   out << "Разница по sigma: " << fixed << setprecision(6) << (sigma - sample_std) << endl;
+   out << "Сравнение с выборочными оценками:" << '\n';
+   out << "Выборочное среднее: " << fixed << setprecision(6) << sample_mean << '\n';
+   out << "Выборочное стандартное отклонение: " << fixed << setprecision(6) << sample_std << '\n';
+   out << "Разница по mu: " << fixed << setprecision(6) << (mu - sample_mean) << '\n';
+   out << "Разница по sigma: " << fixed << setprecision(6) << (sigma - sample_std) << '\n';
 
    out.close();
 
-   // Освобождение памяти
-   for (int i = 0; i < n; i++) {
-       delete[] x[i];
-       delete[] y[i];
-   }
-   for (int i = 0; i < k; i++) {
-       delete[] db[i];
-       delete[] b[i];
-   }
-   delete[] x;
-   delete[] y;
-   delete[] db;
-   delete[] b;
-   delete[] yr;
-
    cout << "Результаты записаны в: " << outputFile << endl;
+   return true;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
    string inputFile = "data.txt";
    string outputFile = "results.txt";
 
-   estimateNormalParametersMLS(inputFile, outputFile);
+   bool blue = false;
+
+   // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+   ResultCacheOptions cacheOptions;
+   if (!take_cache_options(argc, argv, cacheOptions)) return 1;
+
+   // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+   ResultOptions resultOptions;
+   if (!take_result_options(argc, argv, resultOptions)) return 1;
+   outputFile = result_output_filename(outputFile, resultOptions);
+
+   // Другой входной файл (текстовый или двоичный): --input <файл>
+   // Обобщенный МНК (BLUE) с учетом цензурирования: --blue
+   for (int i = 1; i < argc; i++) {
+       string option = argv[i];
+       if (option == "--blue") blue = true;
+       else if (option == "--input" && i + 1 < argc) inputFile = argv[++i];
+   }
+
+   // Тот же файл с теми же параметрами - результат из кэша
+   ResultCache cache(cacheOptions, "mnk");
+   cache.add_file(inputFile);
+   cache.add_arguments(argc, argv);
+   cache.add("format", static_cast<int>(resultOptions.format));
+   if (cache.replay()) return 0;
+
+   if (estimateNormalParametersMLS(inputFile, outputFile, blue, resultOptions)) cache.store({ outputFile });
 
    return 0;
 }
@@ -0,0 +1,209 @@
+#pragma once
+// Однопроходное вычисление описательных статистик выборки:
+// объем, среднее, центральные моменты M2..M4, минимум и максимум.
+// Частичные результаты по кускам данных объединяются формулами
+// Чана-Голуба-Левека (Pébay для M3 и M4), поэтому их можно
+// считать параллельно и сливать в любом порядке.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "parallel.h"
+
+struct SampleMoments {
+   size_t count = 0;
+   double mean = 0.0;
+   double m2 = 0.0; // сумма квадратов отклонений от среднего
+   double m3 = 0.0; // сумма кубов отклонений
+   double m4 = 0.0; // сумма четвертых степеней отклонений
+   double min = std::numeric_limits<double>::infinity();
+   double max = -std::numeric_limits<double>::infinity();
+
+   // Добавление одного наблюдения (Уэлфорд, Терриберри)
+   void add(double x) {
+      double n1 = static_cast<double>(count);
+      count++;
+      double n = static_cast<double>(count);
+      double delta = x - mean;
+      double delta_n = delta / n;
+      double delta_n2 = delta_n * delta_n;
+      double term1 = delta * delta_n * n1;
+      mean += delta_n;
+      m4 += term1 * delta_n2 * (n * n - 3 * n + 3) + 6 * delta_n2 * m2 - 4 * delta_n * m3;
+      m3 += term1 * delta_n * (n - 2) - 3 * delta_n * m2;
+      m2 += term1;
+      if (x < min) min = x;
+      if (x > max) max = x;
+   }
+
+   // Объединение с моментами другой части выборки
+   void merge(const SampleMoments& other) {
+      if (other.count == 0) return;
+      if (count == 0) {
+         *this = other;
+         return;
+      }
+
+      double na = static_cast<double>(count);
+      double nb = static_cast<double>(other.count);
+      double n = na + nb;
+      double delta = other.mean - mean;
+      double delta2 = delta * delta;
+      double delta3 = delta2 * delta;
+      double delta4 = delta2 * delta2;
+
+      double new_m4 = m4 + other.m4
+         + delta4 * na * nb * (na * na - na * nb + nb * nb) / (n * n * n)
+         + 6.0 * delta2 * (na * na * other.m2 + nb * nb * m2) / (n * n)
+         + 4.0 * delta * (na * other.m3 - nb * m3) / n;
+      double new_m3 = m3 + other.m3
+         + delta3 * na * nb * (na - nb) / (n * n)
+         + 3.0 * delta * (na * other.m2 - nb * m2) / n;
+
+      m2 += other.m2 + delta2 * na * nb / n;
+      m3 = new_m3;
+      m4 = new_m4;
+      mean += delta * nb / n;
+      count += other.count;
+      min = std::min(min, other.min);
+      max = std::max(max, other.max);
+   }
+
+   // Несмещенная выборочная дисперсия
+   double variance() const {
+      return count > 1 ? m2 / (count - 1) : 0.0;
+   }
+
+   double stddev() const {
+      return std::sqrt(variance());
+   }
+
+   // Выборочный коэффициент асимметрии g1
+   double skewness() const {
+      if (count < 2 || m2 <= 0) return 0.0;
+      return std::sqrt(static_cast<double>(count)) * m3 / std::pow(m2, 1.5);
+   }
+
+   // Выборочный коэффициент эксцесса g2 (для нормального закона равен 0)
+   double kurtosis() const {
+      if (count < 2 || m2 <= 0) return 0.0;
+      return static_cast<double>(count) * m4 / (m2 * m2) - 3.0;
+   }
+};
+
+// Моменты короткого блока: блок целиком лежит в кэше, поэтому два прохода
+// по нему (сумма, затем отклонения) не добавляют обращений к памяти.
+// Сумма копится от сдвига data[0], а не от нуля: для данных вида 1e6 +- 1
+// разности точны и среднее не теряет разрядов.
+// Циклы без ветвлений и с независимыми аккумуляторами векторизуются компилятором.
+inline SampleMoments compute_block_moments(const double* data, size_t n) {
+   SampleMoments block;
+   if (n == 0) return block;
+
+   double shift = data[0];
+   double s[4] = { 0.0, 0.0, 0.0, 0.0 };
+   double lo[4] = { data[0], data[0], data[0], data[0] };
+   double hi[4] = { data[0], data[0], data[0], data[0] };
+   size_t i = 0;
+   for (; i + 4 <= n; i += 4) {
+      for (int lane = 0; lane < 4; lane++) {
+         double x = data[i + lane];
+         s[lane] += x - shift;
+         lo[lane] = x < lo[lane] ? x : lo[lane];
+         hi[lane] = x > hi[lane] ? x : hi[lane];
+      }
+   }
+   for (; i < n; i++) {
+      s[0] += data[i] - shift;
+      lo[0] = data[i] < lo[0] ? data[i] : lo[0];
+      hi[0] = data[i] > hi[0] ? data[i] : hi[0];
+   }
+
+   double mean = shift + ((s[0] + s[1]) + (s[2] + s[3])) / n;
+
+   double d1 = 0.0, d2 = 0.0, d3 = 0.0, d4 = 0.0;
+   for (i = 0; i < n; i++) {
+      double d = data[i] - mean;
+      double dd = d * d;
+      d1 += d;
+      d2 += dd;
+      d3 += dd * d;
+      d4 += dd * dd;
+   }
+
+   // Поправка на ошибку округления среднего (двухпроходная формула с коррекцией):
+   // отклонения посчитаны от mean, точное среднее - mean + delta, и суммы
+   // степеней пересчитываются к нему сдвигом, как M2
+   double delta = d1 / n;
+   double delta2 = delta * delta;
+   block.count = n;
+   block.mean = mean + delta;
+   block.m2 = d2 - d1 * delta;
+   block.m3 = d3 - 3.0 * delta * d2 + 2.0 * n * delta2 * delta;
+   block.m4 = d4 - 4.0 * delta * d3 + 6.0 * delta2 * d2 - 3.0 * n * delta2 * delta2;
+   block.min = std::min(std::min(lo[0], lo[1]), std::min(lo[2], lo[3]));
+   block.max = std::max(std::max(hi[0], hi[1]), std::max(hi[2], hi[3]));
+   return block;
+}
+
+// Последовательный проход по данным блоками с объединением результатов
+inline SampleMoments compute_moments_serial(const double* data, size_t n) {
+   const size_t block_size = 256;
+   SampleMoments result;
+   for (size_t begin = 0; begin < n; begin += block_size) {
+      result.merge(compute_block_moments(data + begin, std::min(block_size, n - begin)));
+   }
+   return result;
+}
+
+// Моменты выборки за один проход по памяти. Большие выборки делятся
+// на куски по числу потоков, частичные моменты сливаются по порядку.
+inline SampleMoments compute_moments(const double* data, size_t n) {
+   const size_t parallel_threshold = size_t(1) << 18;
+   if (n < parallel_threshold) {
+      return compute_moments_serial(data, n);
+   }
+
+   return parallel_reduce(n, 1, SampleMoments(),
+      [&](size_t begin, size_t end) { return compute_moments_serial(data + begin, end - begin); },
+      [](SampleMoments a, const SampleMoments& b) {
+         a.merge(b);
+         return a;
+      },
+      ReduceMode::Fast);
+}
+
+inline SampleMoments compute_moments(const std::vector<double>& data) {
+   return compute_moments(data.data(), data.size());
+}
+
+// Моменты по группам для данных в столбцовом виде: наблюдение values[i]
+// относится к группе groups[i]. Каждый поток накапливает частичные моменты
+// всех групп по своему куску строк, затем куски сливаются по порядку.
+inline std::vector<SampleMoments> compute_group_moments(const double* values, const std::uint32_t* groups,
+   size_t n, size_t group_count) {
+   const size_t min_chunk = size_t(1) << 16;
+   size_t parts = std::max<size_t>(1, std::min<size_t>(hardware_threads(), n / min_chunk));
+   size_t chunk = (n + parts - 1) / parts;
+   std::vector<std::vector<SampleMoments>> partial(parts, std::vector<SampleMoments>(group_count));
+   parallel_for(parts, 1, [&](size_t first, size_t last) {
+      for (size_t p = first; p < last; p++) {
+         std::vector<SampleMoments>& local = partial[p];
+         size_t end = std::min(n, (p + 1) * chunk);
+         for (size_t i = p * chunk; i < end; i++) {
+            local[groups[i]].add(values[i]);
+         }
+      }
+   });
+
+   std::vector<SampleMoments> result(group_count);
+   for (const std::vector<SampleMoments>& part : partial) {
+      for (size_t g = 0; g < group_count; g++) {
+         result[g].merge(part[g]);
+      }
+   }
+   return result;
+}
@@ -0,0 +1,306 @@
+#pragma once
+// Минимизация функции нескольких переменных методом Нелдера-Мида.
+//
+// Функция передается любым вызываемым объектом f(const double* x) -> double,
+// поэтому лямбда или функция подставляется в цикл метода. Размерность
+// задается типом точки:
+//
+//   std::array<double, 2> x = { mu0, sigma0 };
+//   NelderMeadResult r = nelder_mead(x, [](const double* p) { return f(p); });
+//
+// Для std::array симплекс хранится на стеке (куча не используется вовсе),
+// для std::vector - в одном непрерывном массиве из арены задания (arena.h).
+//
+// Начальный симплекс: x0 и n точек, у которых i-я координата увеличена на
+// initial_step (в долях координаты, для нулевой - на initial_step). Остановка,
+// когда среднеквадратичное отклонение значений в вершинах от лучшего меньше
+// eps, или после max_iter итераций. При adaptive коэффициенты зависят от
+// размерности (Gao, Han, 2012): при n = 2 они совпадают с классическими
+// 1, 2, 0.5, 0.5, при больших n метод не вырождается.
+//
+// nelder_mead_multistart запускает метод параллельно из многих начальных
+// точек (латинский гиперкуб) и выбирает лучший результат. Запуски делят
+// общую лучшую достигнутую оценку: запуск, который при текущей скорости
+// убывания не успеет до нее опуститься, прекращается досрочно.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "arena.h"
+#include "counter_rng.h"
+#include "parallel.h"
+#include "profiler.h"
+
+struct NelderMeadOptions {
+   double eps = 1e-6;          // порог разброса значений в вершинах
+   int max_iter = 1000;
+   double initial_step = 0.05; // относительный шаг начального симплекса
+   bool adaptive = true;       // коэффициенты в зависимости от размерности
+
+   // Общая лучшая оценка нескольких запусков (nelder_mead_multistart):
+   // каждые prune_interval итераций запуск сообщает свое лучшее значение и
+   // прекращается, если не догонит общее при линейном продолжении убывания
+   std::atomic<double>* shared_best = nullptr;
+   int prune_interval = 25;
+};
+
+struct NelderMeadResult {
+   int iterations = 0;
+   int evaluations = 0;    // вычислений функции
+   double value = 0.0;     // значение в найденной точке
+   bool converged = false; // достигнут порог eps
+   bool pruned = false;    // прекращен: не догонит лучший из запусков
+};
+
+// Уменьшение общей оценки до value, если value меньше
+inline void nelder_mead_publish(std::atomic<double>& shared_best, double value) {
+   double current = shared_best.load(std::memory_order_relaxed);
+   while (value < current && !shared_best.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+// Реализация для размерности N (0 - размерность n задается при вызове).
+// work - не меньше (n + 1) * (n + 1) + 4 * n чисел.
+template <size_t N, class F>
+NelderMeadResult nelder_mead_minimize(double* x, size_t n, F& func, const NelderMeadOptions& options, double* work) {
+   STAT_PROFILE_SCOPE("neldermead");
+   const size_t dim = N > 0 ? N : n;
+   double* simplex = work;                         // (dim + 1) вершин подряд
+   double* fvals = simplex + (dim + 1) * dim;
+   double* centroid = fvals + (dim + 1);
+   double* reflected = centroid + dim;
+   double* expanded = reflected + dim;
+   double* contracted = expanded + dim;
+   auto vertex = [&](size_t i) { return simplex + i * dim; };
+
+   NelderMeadResult result;
+   // NaN (функция не определена в точке) считается +бесконечностью
+   auto evaluate = [&](const double* point) {
+      result.evaluations++;
+      double value = func(point);
+      return std::isnan(value) ? HUGE_VAL : value;
+   };
+
+   double alpha = 1.0, gamma = 2.0, rho = 0.5, sigma = 0.5;
+   if (options.adaptive && dim > 0) {
+      double d = static_cast<double>(dim);
+      gamma = 1.0 + 2.0 / d;
+      rho = 0.75 - 1.0 / (2.0 * d);
+      sigma = 1.0 - 1.0 / d;
+   }
+
+   // Инициализация симплекса
+   for (size_t i = 0; i <= dim; i++) {
+      double* v = vertex(i);
+      for (size_t j = 0; j < dim; j++) v[j] = x[j];
+      if (i > 0) {
+         v[i - 1] += (v[i - 1] == 0) ? options.initial_step : v[i - 1] * options.initial_step;
+      }
+      fvals[i] = evaluate(v);
+   }
+
+   double last_check = fvals[0];
+   for (size_t i = 1; i <= dim; i++) last_check = std::min(last_check, fvals[i]);
+
+   while (result.iterations < options.max_iter) {
+      result.iterations++;
+
+      // Индексы лучшей, худшей и второй худшей вершин
+      size_t best = 0, worst = 0;
+      for (size_t i = 1; i <= dim; i++) {
+         if (fvals[i] < fvals[best]) best = i;
+         if (fvals[i] > fvals[worst]) worst = i;
+      }
+      size_t second_worst = (worst == 0) ? 1 : 0;
+      for (size_t i = 0; i <= dim; i++) {
+         if (i != worst && fvals[i] > fvals[second_worst]) second_worst = i;
+      }
+
+      // Проверка сходимости
+      double range = 0.0;
+      for (size_t i = 0; i <= dim; i++) {
+         double d = fvals[i] - fvals[best];
+         range += d * d;
+      }
+      range = std::sqrt(range / (dim + 1));
+      if (range < options.eps) {
+         result.converged = true;
+         break;
+      }
+
+      if (options.shared_best != nullptr && options.prune_interval > 0 &&
+         result.iterations % options.prune_interval == 0) {
+         double current = fvals[best];
+         nelder_mead_publish(*options.shared_best, current);
+         double bound = options.shared_best->load(std::memory_order_relaxed);
+         double checks_left = static_cast<double>(options.max_iter - result.iterations) / options.prune_interval;
+         // Сравнения записаны так, чтобы бесконечные значения тоже отбрасывались
+         if (!(current <= bound) && !(current - bound <= (last_check - current) * checks_left)) {
+            result.pruned = true;
+            break;
+         }
+         last_check = current;
+      }
+
+      // Центр масс без худшей вершины
+      for (size_t j = 0; j < dim; j++) centroid[j] = 0.0;
+      for (size_t i = 0; i <= dim; i++) {
+         if (i == worst) continue;
+         const double* v = vertex(i);
+         for (size_t j = 0; j < dim; j++) centroid[j] += v[j];
+      }
+      for (size_t j = 0; j < dim; j++) centroid[j] /= dim;
+
+      double* w = vertex(worst);
+      auto replace_worst = [&](const double* point, double value) {
+         for (size_t j = 0; j < dim; j++) w[j] = point[j];
+         fvals[worst] = value;
+      };
+
+      // Отражение
+      for (size_t j = 0; j < dim; j++) reflected[j] = centroid[j] + alpha * (centroid[j] - w[j]);
+      double f_reflected = evaluate(reflected);
+
+      if (f_reflected < fvals[best]) {
+         // Растяжение
+         for (size_t j = 0; j < dim; j++) expanded[j] = centroid[j] + gamma * (reflected[j] - centroid[j]);
+         double f_expanded = evaluate(expanded);
+         if (f_expanded < f_reflected) replace_worst(expanded, f_expanded);
+         else replace_worst(reflected, f_reflected);
+      }
+      else if (f_reflected < fvals[second_worst]) {
+         replace_worst(reflected, f_reflected);
+      }
+      else {
+         // Сжатие: внешнее (к отраженной точке) или внутреннее (к худшей)
+         const double* toward = (f_reflected < fvals[worst]) ? reflected : w;
+         for (size_t j = 0; j < dim; j++) contracted[j] = centroid[j] + rho * (toward[j] - centroid[j]);
+         double f_contracted = evaluate(contracted);
+
+         if (f_contracted < fvals[worst]) {
+            replace_worst(contracted, f_contracted);
+         }
+         else {
+            // Уменьшение симплекса к лучшей вершине
+            const double* b = vertex(best);
+            for (size_t i = 0; i <= dim; i++) {
+               if (i == best) continue;
+               double* v = vertex(i);
+               for (size_t j = 0; j < dim; j++) v[j] = b[j] + sigma * (v[j] - b[j]);
+               fvals[i] = evaluate(v);
+            }
+         }
+      }
+   }
+
+   // Лучшая вершина
+   size_t best = 0;
+   for (size_t i = 1; i <= dim; i++) {
+      if (fvals[i] < fvals[best]) best = i;
+   }
+   const double* v = vertex(best);
+   for (size_t j = 0; j < dim; j++) x[j] = v[j];
+   result.value = fvals[best];
+
+   STAT_PROFILE_COUNT("neldermead_iterations", result.iterations);
+   STAT_PROFILE_COUNT("neldermead_evaluations", result.evaluations);
+   return result;
+}
+
+// Фиксированная размерность: все рабочие массивы на стеке
+template <size_t N, class F>
+NelderMeadResult nelder_mead(std::array<double, N>& x, F func, const NelderMeadOptions& options = NelderMeadOptions()) {
+   static_assert(N > 0, "nelder_mead: размерность должна быть больше нуля");
+   std::array<double, (N + 1) * (N + 1) + 4 * N> work;
+   return nelder_mead_minimize<N>(x.data(), N, func, options, work.data());
+}
+
+// Размерность известна только при выполнении: рабочие массивы из арены задания
+template <class F>
+NelderMeadResult nelder_mead(std::vector<double>& x, F func, const NelderMeadOptions& options = NelderMeadOptions()) {
+   size_t n = x.size();
+   if (n == 0) return NelderMeadResult();
+   std::pmr::vector<double> work((n + 1) * (n + 1) + 4 * n, arena_resource());
+   return nelder_mead_minimize<0>(x.data(), n, func, options, work.data());
+}
+
+// Латинский гиперкуб: points точек в [0, 1)^dims (точка i - элементы
+// [i * dims, (i + 1) * dims)). В каждом измерении ровно одна точка попадает
+// в каждый из points равных интервалов.
+inline std::vector<double> latin_hypercube(size_t points, size_t dims, std::uint64_t seed) {
+   std::vector<double> u(points * dims);
+   std::vector<size_t> order(points);
+   for (size_t d = 0; d < dims; d++) {
+      CounterRng rng(seed, d);
+      for (size_t i = 0; i < points; i++) order[i] = i;
+      for (size_t i = points; i > 1; i--) {
+         std::swap(order[i - 1], order[rng.uniform(static_cast<std::uint32_t>(i))]);
+      }
+      for (size_t i = 0; i < points; i++) {
+         u[i * dims + d] = (order[i] + rng.uniform01()) / points;
+      }
+   }
+   return u;
+}
+
+struct MultiStartResult {
+   NelderMeadResult best;  // результат лучшего запуска
+   size_t best_start = 0;  // его номер (0 - исходная точка x)
+   size_t starts = 0;
+   size_t converged = 0;
+   size_t pruned = 0;
+   size_t agreeing = 0;    // запусков, пришедших в ту же точку (отн. точность 1e-3)
+   long long evaluations = 0;
+};
+
+// Мультистарт: запуск 0 - из x, остальные starts - 1 - из точек латинского
+// гиперкуба, которые to_point(const double* u, double* point) переводит из
+// [0, 1)^N в пространство параметров. Запуски выполняются пулом потоков.
+// При одном потоке результат детерминирован; при нескольких досрочная
+// остановка зависит от порядка выполнения, но найденная лучшая точка не
+// хуже значения, достигнутого любым прекращенным запуском.
+template <size_t N, class Map, class F>
+MultiStartResult nelder_mead_multistart(std::array<double, N>& x, size_t starts, std::uint64_t seed,
+   Map to_point, F func, NelderMeadOptions options = NelderMeadOptions()) {
+   STAT_PROFILE_SCOPE("neldermead_multistart");
+   if (starts == 0) starts = 1;
+   std::vector<double> unit = latin_hypercube(starts - 1, N, seed);
+   std::vector<std::array<double, N>> points(starts, x);
+   for (size_t s = 1; s < starts; s++) to_point(unit.data() + (s - 1) * N, points[s].data());
+
+   std::atomic<double> shared_best(HUGE_VAL);
+   if (starts > 1) options.shared_best = &shared_best;
+   std::vector<NelderMeadResult> results(starts);
+   parallel_for(starts, 1, [&](size_t first, size_t last) {
+      for (size_t s = first; s < last; s++) {
+         std::array<double, (N + 1) * (N + 1) + 4 * N> work;
+         results[s] = nelder_mead_minimize<N>(points[s].data(), N, func, options, work.data());
+         nelder_mead_publish(shared_best, results[s].value);
+      }
+   });
+
+   MultiStartResult summary;
+   summary.starts = starts;
+   for (size_t s = 0; s < starts; s++) {
+      const NelderMeadResult& r = results[s];
+      if (r.value < results[summary.best_start].value) summary.best_start = s;
+      summary.converged += r.converged ? 1 : 0;
+      summary.pruned += r.pruned ? 1 : 0;
+      summary.evaluations += r.evaluations;
+   }
+   summary.best = results[summary.best_start];
+   x = points[summary.best_start];
+
+   for (size_t s = 0; s < starts; s++) {
+      bool same = !results[s].pruned;
+      for (size_t j = 0; j < N && same; j++) {
+         same = std::fabs(points[s][j] - x[j]) <= 1e-3 * std::max(1.0, std::fabs(x[j]));
+      }
+      summary.agreeing += same ? 1 : 0;
+   }
+   return summary;
+}
@@ -1,9 +1,11 @@
 //здесь есть метода маскимального правдоподобия, но нет импорта бустовских функций, они просто переписаны из boost.cpp
 #include <iostream>
 #include <fstream>
+#include <array>
 #include <vector>
 #include <string>
 #include <cmath>
+#include <cstdlib>
 #include <iomanip>
 #include <algorithm>
 #include <sstream>
@@ -11,6 +13,19 @@
 #include <random>
 #include <limits>
 
+#include "censored_data.h"
+#include "columnar.h"
+#include "fast_reader.h"
+#include "fit_state.h"
+#include "moments.h"
+#include "nelder_mead.h"
+#include "arena.h"
+#include "autodiff.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+
 using namespace std;
 
 #ifndef M_PI
@@ -24,6 +39,10 @@ struct ne_simp {
     vector<double> x;
     vector<int> r;
     vector<int> nsample;
+    // Инкрементальный режим: нецензурированные наблюдения заданы моментами
+    // failures (в x, r - только цензурированные)
+    bool summed = false;
+    SampleMoments failures;
 };
 ne_simp nesm;
 
@@ -83,56 +102,22 @@ double norm_pdf(double x) {
     return (1.0 / sqrt(2.0 * M_PI)) * exp(-0.5 * x * x);
 }
 
-double** InverseMatrix(double** a, int n) {
-    double temp;
-    int i, j, k;
-
-    double** e = new double* [n];
-    for (i = 0; i < n; i++) {
-        e[i] = new double[n];
-        for (j = 0; j < n; j++) {
-            e[i][j] = 0;
-            if (i == j)
-                e[i][j] = 1;
-        }
-    }
-
-    for (k = 0; k < n; k++) {
-        temp = a[k][k];
-        for (j = 0; j < n; j++) {
-            a[k][j] /= temp;
-            e[k][j] /= temp;
-        }
-
-        for (i = k + 1; i < n; i++) {
-            temp = a[i][k];
-            for (j = 0; j < n; j++) {
-                a[i][j] -= a[k][j] * temp;
-                e[i][j] -= e[k][j] * temp;
-            }
-        }
-    }
-
-    for (k = n - 1; k > 0; k--) {
-        for (i = k - 1; i >= 0; i--) {
-            temp = a[i][k];
-            for (j = 0; j < n; j++) {
-                a[i][j] -= a[k][j] * temp;
-                e[i][j] -= e[k][j] * temp;
-            }
-        }
-    }
-    return e;
-}
-
 // ========== ФУНКЦИИ ИЗ mle_normal.cpp ==========
 
-double NormalMinFunction(vector<double> xsimpl) {
+double NormalMinFunction(const double* xsimpl) {
+    STAT_PROFILE_COUNT("normal_min_function_evals", 1);
     double s1, s2, s3, s4, z, psi, p, d, c1, c2;
     int i, kx;
     s1 = 0; s2 = 0; s3 = 0; s4 = 0; kx = 0;
     if (xsimpl[0] <= 0) return 10000;
     if (xsimpl[1] <= 0) return 10000;
+    if (nesm.summed) {
+        // Суммы отклонений нецензурированных наблюдений по их моментам
+        double shift = nesm.failures.mean - xsimpl[0];
+        kx = static_cast<int>(nesm.failures.count);
+        s1 = kx * shift;
+        s2 = nesm.failures.m2 + kx * shift * shift;
+    }
 
     for (i = 0; i < nesm.n; i++) {
         z = (nesm.x[i] - xsimpl[0]) / xsimpl[1];
@@ -151,7 +136,45 @@ double NormalMinFunction(vector<double> xsimpl) {
     return z;
 }
 
-void CovMatrixMleN(int n, vector<double> x, vector<int> r, double a, double s, double**& v) {
+// log(1 - Ф(z)); для Jet производные -psi и -psi * (psi - z), psi = ф(z) / (1 - Ф(z))
+double normal_log_survival(double z) {
+    return log(1.0 - norm_cdf(z));
+}
+
+template <size_t N>
+Jet<N> normal_log_survival(const Jet<N>& z) {
+    double survival = 1.0 - norm_cdf(z.v);
+    double psi = norm_pdf(z.v) / survival;
+    return jet_chain(z, log(survival), -psi, -psi * (psi - z.v));
+}
+
+// Логарифм правдоподобия нормального распределения с правым цензурированием
+// по данным nesm: params = (mu, sigma). При T = Jet<2> за тот же проход
+// вычисляются градиент и гессиан.
+template <class T>
+T NormalLogLikelihood(const T* params) {
+    const T& mu = params[0];
+    const T& sigma = params[1];
+    if (!(jet_value(sigma) > 0)) return T(-HUGE_VAL);
+    T inv_sigma = 1.0 / sigma;
+    T log_sigma = log(sigma);
+    T sum(0.0);
+    if (nesm.summed) {
+        double count = static_cast<double>(nesm.failures.count);
+        T shift = nesm.failures.mean - mu;
+        sum = -0.5 * (nesm.failures.m2 + count * shift * shift) * inv_sigma * inv_sigma
+            - count * (log_sigma + 0.5 * log(2.0 * M_PI));
+    }
+    for (int i = 0; i < nesm.n; i++) {
+        T z = (nesm.x[i] - mu) * inv_sigma;
+        if (nesm.r[i] == 0) sum += -0.5 * z * z - log_sigma - 0.5 * log(2.0 * M_PI);
+        else sum += normal_log_survival(z);
+    }
+    return sum;
+}
+
+bool CovMatrixMleN(int n, const vector<double>& x, const vector<int>& r, double a, double s, Matrix<2, 2>& v) {
+    STAT_PROFILE_SCOPE("cov_matrix");
     double z, p_val, d, s1, s2, s3, psi;
     int j, k;
     s1 = 0; s2 = 0; s3 = 0; k = 0;
@@ -167,289 +190,221 @@ void CovMatrixMleN(int n, vector<double> x, vector<int> r, double a, double s, d
         k += (1 - r[j]);
     }
 
-    v[0][0] = (k + s1) / n;
-    v[0][1] = s3 / n;
-    v[1][0] = s3 / n;
-    v[1][1] = (2 * k + s2) / n;
+    v(0, 0) = (k + s1) / n;
+    v(0, 1) = s3 / n;
+    v(1, 0) = s3 / n;
+    v(1, 1) = (2 * k + s2) / n;
 
-    // Инвертируем матрицу
-    double** inv = InverseMatrix(v, 2);
-    for (int i = 0; i < 2; i++) {
-        for (int j = 0; j < 2; j++) {
-            v[i][j] = inv[i][j];
+    // Инвертируем матрицу; вырожденная информация - NaN в отчете, как раньше
+    if (!inverse(v, v)) {
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 2; j++) v(i, j) = NAN;
         }
-        delete[] inv[i];
+        return false;
     }
-    delete[] inv;
+    return true;
 }
 
 // ========== ОСНОВНЫЕ ФУНКЦИИ ПРОГРАММЫ ==========
 
-// Функция Нелдера-Мида для оптимизации
-int neldermead(vector<double>& x0, double eps, double(*func)(vector<double>)) {
-    int n = x0.size();
-    int max_iter = 1000;
-
-    vector<vector<double>> simplex(n + 1, vector<double>(n));
-    vector<double> fvals(n + 1);
-
-    // Инициализация симплекса
-    simplex[0] = x0;
-    fvals[0] = func(x0);
-
-    for (int i = 1; i <= n; i++) {
-        simplex[i] = x0;
-        simplex[i][i - 1] += (simplex[i][i - 1] == 0) ? 0.05 : simplex[i][i - 1] * 0.05;
-        fvals[i] = func(simplex[i]);
-    }
-
-    double alpha = 1.0, gamma = 2.0, rho = 0.5, sigma = 0.5;
-    int iter = 0;
-
-    while (iter < max_iter) {
-        iter++;
-
-        // Находим индексы лучшей, худшей и второй худшей точек
-        int best_idx = 0, worst_idx = 0, second_worst_idx = 0;
-        for (int i = 1; i <= n; i++) {
-            if (fvals[i] < fvals[best_idx]) best_idx = i;
-            if (fvals[i] > fvals[worst_idx]) worst_idx = i;
-        }
-
-        second_worst_idx = (worst_idx == 0) ? 1 : 0;
-        for (int i = 0; i <= n; i++) {
-            if (i != worst_idx && fvals[i] > fvals[second_worst_idx]) {
-                second_worst_idx = i;
-            }
-        }
-
-        // Проверка сходимости
-        double range = 0.0;
-        for (int i = 0; i <= n; i++) {
-            range += pow(fvals[i] - fvals[best_idx], 2);
-        }
-        range = sqrt(range / (n + 1));
-
-        if (range < eps) break;
-
-        // Вычисляем центр масс
-        vector<double> centroid(n, 0.0);
-        for (int i = 0; i <= n; i++) {
-            if (i != worst_idx) {
-                for (int j = 0; j < n; j++) {
-                    centroid[j] += simplex[i][j];
-                }
-            }
-        }
-        for (int j = 0; j < n; j++) {
-            centroid[j] /= n;
-        }
-
-        // Отражение
-        vector<double> reflected(n);
-        for (int j = 0; j < n; j++) {
-            reflected[j] = centroid[j] + alpha * (centroid[j] - simplex[worst_idx][j]);
-        }
-        double f_reflected = func(reflected);
-
-        if (f_reflected < fvals[best_idx]) {
-            // Расширение
-            vector<double> expanded(n);
-            for (int j = 0; j < n; j++) {
-                expanded[j] = centroid[j] + gamma * (reflected[j] - centroid[j]);
-            }
-            double f_expanded = func(expanded);
-
-            if (f_expanded < f_reflected) {
-                simplex[worst_idx] = expanded;
-                fvals[worst_idx] = f_expanded;
-            }
-            else {
-                simplex[worst_idx] = reflected;
-                fvals[worst_idx] = f_reflected;
-            }
-        }
-        else if (f_reflected < fvals[second_worst_idx]) {
-            simplex[worst_idx] = reflected;
-            fvals[worst_idx] = f_reflected;
-        }
-        else {
-            // Сжатие
-            vector<double> contracted(n);
-            if (f_reflected < fvals[worst_idx]) {
-                for (int j = 0; j < n; j++) {
-                    contracted[j] = centroid[j] + rho * (reflected[j] - centroid[j]);
-                }
-            }
-            else {
-                for (int j = 0; j < n; j++) {
-                    contracted[j] = centroid[j] + rho * (simplex[worst_idx][j] - centroid[j]);
-                }
-            }
-
-            double f_contracted = func(contracted);
-
-            if (f_contracted < fvals[worst_idx]) {
-                simplex[worst_idx] = contracted;
-                fvals[worst_idx] = f_contracted;
-            }
-            else {
-                // Уменьшение
-                for (int i = 0; i <= n; i++) {
-                    if (i != best_idx) {
-                        for (int j = 0; j < n; j++) {
-                            simplex[i][j] = simplex[best_idx][j] + sigma * (simplex[i][j] - simplex[best_idx][j]);
-                        }
-                        fvals[i] = func(simplex[i]);
-                    }
-                }
-            }
-        }
-    }
-
-    // Возвращаем лучшую точку
-    int best_idx = 0;
-    for (int i = 1; i <= n; i++) {
-        if (fvals[i] < fvals[best_idx]) best_idx = i;
-    }
-    x0 = simplex[best_idx];
-
-    return iter;
-}
-
-// Функция чтения данных
-vector<vector<double>> readCensoredData(const string& filename) {
-    setlocale(LC_ALL, "rus");
-    vector<vector<double>> data;
-    ifstream inp(filename);
-
-    if (!inp.is_open()) {
-        cout << "Не удалось открыть файл: " << filename << endl;
-        return data;
-    }
-
-    string line;
-    vector<double> values;
-    vector<int> censored;
-
-    while (getline(inp, line)) {
-        if (line.empty() || line[0] == '#') continue;
-
-        istringstream iss(line);
-        double value;
-        int censor;
-        char comma;
-
-        if (iss >> value >> comma >> censor) {
-            values.push_back(value);
-            censored.push_back(censor);
-        }
-        else {
-            // Альтернативный формат
-            iss.clear();
-            iss.str(line);
-            if (iss >> value >> censor) {
-                values.push_back(value);
-                censored.push_back(censor);
-            }
-        }
-    }
-
-    inp.close();
-
-    data.push_back(values);
-    data.push_back(vector<double>(censored.begin(), censored.end()));
-    return data;
-}
+// Режимы оценивания (ключи командной строки)
+struct MleOptions {
+    int starts = 1;      // --multistart N: число начальных точек Нелдера-Мида
+    bool newton = false; // --newton: уточнение методом Ньютона и ковариационная
+                         // матрица по наблюдаемой информации (autodiff.h)
+    string state_file;   // --state <файл>: инкрементальный пересчет (fit_state.h)
+
+    // Заполняются по файлу состояния: моменты нецензурированных наблюдений
+    // (правдоподобие считается проходом только по цензурированным) и
+    // теплый старт методом Ньютона из прежнего оптимума warm_params
+    const SampleMoments* failure_moments = nullptr;
+    bool warm = false;
+    array<double, 2> warm_params{};
+};
 
-// Метод максимального правдоподобия для нормального распределения
-void estimateNormalMLE(const vector<double>& values, const vector<int>& censored,
-    double& mu_mle, double& sigma_mle, double**& cov_matrix) {
+// Метод максимального правдоподобия для нормального распределения.
+// Мультистарт: начальные точки mu в пределах +-3 sigma от начальной оценки,
+// sigma - от 1/4 до 4 начальных оценок. cov_matrix - нормированная матрица
+// CovMatrixMleN (n Cov / sigma^2) во всех режимах; с --newton observed_cov -
+// ковариационная матрица по наблюдаемой информации в единицах параметров
+// (возвращается true, если она вычислена)
+bool estimateNormalMLE(const vector<double>& values, const vector<int>& censored,
+    double& mu_mle, double& sigma_mle, Matrix<2, 2>& cov_matrix, Matrix<2, 2>& observed_cov,
+    const MleOptions& mle = MleOptions()) {
     int n = values.size();
 
     // Инициализация глобальной структуры для MLE функций
-    nesm.n = n;
-    nesm.x = values;
-    nesm.r = censored;
-
-    // Начальные оценки (метод моментов)
-    double sum = 0.0;
-    int count = 0;
-
-    for (int i = 0; i < n; i++) {
-        if (censored[i] == 0) {
-            sum += values[i];
-            count++;
+    SampleMoments moments;
+    nesm.summed = mle.failure_moments != nullptr;
+    if (nesm.summed) {
+        moments = *mle.failure_moments;
+        nesm.failures = moments;
+        nesm.x.clear();
+        nesm.r.clear();
+        for (int i = 0; i < n; i++) {
+            if (censored[i] != 0) {
+                nesm.x.push_back(values[i]);
+                nesm.r.push_back(censored[i]);
+            }
         }
-    }
-
-    vector<double> initialParams(2);
-    if (count > 0) {
-        initialParams[0] = sum / count;
+        nesm.n = nesm.x.size();
     }
     else {
-        initialParams[0] = 0.0;
-    }
-
-    double variance = 0.0;
-    for (int i = 0; i < n; i++) {
-        if (censored[i] == 0) {
-            variance += pow(values[i] - initialParams[0], 2);
+        nesm.n = n;
+        nesm.x = values;
+        nesm.r = censored;
+
+        // Начальные оценки (метод моментов по нецензурированным наблюдениям)
+        for (int i = 0; i < n; i++) {
+            if (censored[i] == 0) {
+                moments.add(values[i]);
+            }
         }
     }
 
-    if (count > 1) {
-        initialParams[1] = sqrt(variance / (count - 1));
-    }
-    else {
-        initialParams[1] = 1.0;
-    }
+    array<double, 2> initialParams;
+    initialParams[0] = (moments.count > 0) ? moments.mean : 0.0;
+    initialParams[1] = (moments.count > 1) ? moments.stddev() : 1.0;
 
     cout << "Начальные оценки MLE: mu = " << initialParams[0]
         << ", sigma = " << initialParams[1] << endl;
 
     // Минимизация функции правдоподобия методом Нелдера-Мида
     double epsilon = 1e-6;
-    int iterations = neldermead(initialParams, epsilon, NormalMinFunction);
+    NelderMeadOptions options;
+    options.eps = epsilon;
+    auto objective = [](const double* x) { return NormalMinFunction(x); };
+    auto loglik = [](const auto* p) { return NormalLogLikelihood(p); };
+    int iterations = 0;
+
+    // Теплый старт: после дописывания оптимум сдвигается мало, и метод
+    // Ньютона из прежнего оптимума сходится за несколько итераций. Без
+    // сходимости - обычный поиск из начальных оценок.
+    bool warm = false;
+    if (mle.warm) {
+        array<double, 2> warmParams = mle.warm_params;
+        NewtonResult polish = newton_maximize(warmParams, loglik);
+        warm = polish.converged && isfinite(warmParams[0]) && isfinite(warmParams[1]) && warmParams[1] > 0;
+        cout << "Теплый старт из прежнего оптимума mu = " << mle.warm_params[0] << ", sigma = " << mle.warm_params[1]
+            << ": итераций метода Ньютона " << polish.iterations << (warm ? "" : " (без сходимости)") << endl;
+        if (warm) initialParams = warmParams;
+    }
+    if (!warm && mle.starts > 1) {
+        double mu0 = initialParams[0], sigma0 = initialParams[1];
+        auto to_point = [mu0, sigma0](const double* u, double* point) {
+            point[0] = mu0 + sigma0 * (6.0 * u[0] - 3.0);
+            point[1] = sigma0 * pow(4.0, 2.0 * u[1] - 1.0);
+        };
+        MultiStartResult search = nelder_mead_multistart(initialParams, mle.starts, 20240531, to_point, objective, options);
+        iterations = search.best.iterations;
+        cout << "Мультистарт: запусков " << search.starts << ", сошлись " << search.converged
+            << ", прекращены досрочно " << search.pruned << ", пришли в лучшую точку " << search.agreeing
+            << ", лучший запуск #" << search.best_start << ", вычислений функции " << search.evaluations << endl;
+    }
+    else if (!warm) {
+        iterations = nelder_mead(initialParams, objective, options).iterations;
+    }
+
+    // Уточнение максимума правдоподобия методом Ньютона
+    if (mle.newton && !warm) {
+        NewtonResult polish = newton_maximize(initialParams, loglik);
+        cout << "Уточнение методом Ньютона: итераций " << polish.iterations
+            << (polish.converged ? "" : " (без сходимости)") << ", логарифм правдоподобия " << polish.value
+            << ", норма градиента " << polish.gradient_norm << endl;
+    }
 
     mu_mle = initialParams[0];
     sigma_mle = initialParams[1];
 
     cout << "MLE оценки: mu = " << mu_mle << ", sigma = " << sigma_mle << endl;
     cout << "Итераций метода Нелдера-Мида: " << iterations << endl;
-    cout << "Значение минимизируемой функции: " << NormalMinFunction(initialParams) << endl;
+    cout << "Значение минимизируемой функции: " << NormalMinFunction(initialParams.data()) << endl;
 
     // Вычисление ковариационной матрицы оценок
-    cov_matrix = new double* [2];
-    for (int i = 0; i < 2; i++) {
-        cov_matrix[i] = new double[2];
-        for (int j = 0; j < 2; j++) {
-            cov_matrix[i][j] = 0.0;
-        }
+    if (!CovMatrixMleN(n, values, censored, mu_mle, sigma_mle, cov_matrix)) {
+        cout << "Информационная матрица вырождена: ковариационная матрица не вычислена" << endl;
     }
-
-    CovMatrixMleN(n, values, censored, mu_mle, sigma_mle, cov_matrix);
+    bool observed = mle.newton && observed_covariance(jet_evaluate(initialParams, loglik), observed_cov);
+    if (observed) {
+        cout << "Ковариационная матрица по наблюдаемой информации вычислена" << endl;
+    }
+    return observed;
 }
 
 // Основная функция оценки параметров
-void estimateNormalParameters(const string& inputFile, const string& outputFile) {
+// Оценки одной записью для --format jsonl|csv (result_writer.h). Поля
+// ncov_* - нормированная матрица n Cov / σ^2 (как в текстовом отчете),
+// obs_* - матрица по наблюдаемой информации в единицах параметров
+// (только с --newton, иначе пустые)
+bool writeNormalRecord(const string& outputFile, const ResultOptions& options, int n, int uncensored_count,
+    double mu_mle, double sigma_mle, const Matrix<2, 2>& cov_matrix, bool observed, const Matrix<2, 2>& observed_cov) {
+    const double nan = numeric_limits<double>::quiet_NaN();
+    ResultWriter writer;
+    if (!writer.open(outputFile, options, "normal_mle", { "n", "uncensored", "mu", "sigma",
+        "ncov_mu_mu", "ncov_mu_sigma", "ncov_sigma_sigma", "obs_var_mu", "obs_cov_mu_sigma", "obs_var_sigma" })) {
+        cout << "Не удалось создать файл: " << outputFile << endl;
+        return false;
+    }
+    writer.write(n, uncensored_count, mu_mle, sigma_mle,
+        cov_matrix(0, 0), cov_matrix(0, 1), cov_matrix(1, 1),
+        observed ? observed_cov(0, 0) : nan, observed ? observed_cov(0, 1) : nan, observed ? observed_cov(1, 1) : nan);
+    if (!writer.close()) {
+        cout << "Ошибка записи в файл: " << outputFile << endl;
+        return false;
+    }
+    cout << "Результаты MLE оценки записаны в: " << outputFile << endl;
+    return true;
+}
+
+bool estimateNormalParameters(const string& inputFile, const string& outputFile, const MleOptions& mle = MleOptions(),
+    const ResultOptions& result = ResultOptions()) {
     setlocale(LC_ALL, "rus");
+    // Временные массивы задания освобождаются при выходе из функции
+    ArenaScope arena_scope;
 
-    // 1. Чтение данных
-    auto data = readCensoredData(inputFile);
-    if (data.empty() || data[0].empty()) {
+    // 1. Чтение данных: с файлом состояния - только дописанные наблюдения
+    vector<double> values;
+    vector<int> censored;
+    MleOptions options = mle;
+    FitState state;
+    bool incremental = false;
+    if (!mle.state_file.empty()) {
+        load_fit_state(mle.state_file, state);
+        size_t appended = 0;
+        incremental = update_fit_state(inputFile, "normal_mle", state, appended);
+        if (incremental) {
+            cout << "Инкрементальный режим: прочитано новых наблюдений " << appended
+                << " (всего " << state.values.size() << ")" << endl;
+            values.assign(state.values.begin(), state.values.end());
+            censored.assign(state.censored.begin(), state.censored.end());
+            if (state.fitted) {
+                options.warm = true;
+                options.warm_params = state.params;
+            }
+            options.failure_moments = &state.failures;
+        }
+        else {
+            cout << "Инкрементальный режим недоступен для этого файла: данные читаются целиком" << endl;
+        }
+    }
+    if (!incremental) {
+        read_censored_data(inputFile, values, censored);
+    }
+    if (values.empty()) {
         cout << "Ошибка чтения данных" << endl;
-        return;
+        return false;
     }
-
-    vector<double> values = data[0];
-    vector<int> censored(data[1].begin(), data[1].end());
     int n = values.size();
 
     // Подсчет статистики
     int uncensored_count = 0;
-    for (int c : censored) {
-        if (c == 0) uncensored_count++;
+    if (incremental) {
+        uncensored_count = static_cast<int>(state.failures.count);
+    }
+    else {
+        for (int c : censored) {
+            if (c == 0) uncensored_count++;
+        }
     }
 
     cout << "Размер выборки: " << n << endl;
@@ -458,74 +413,127 @@ void estimateNormalParameters(const string& inputFile, const string& outputFile)
 
     // 2. Оценка параметров методом максимального правдоподобия
     double mu_mle, sigma_mle;
-    double** cov_matrix = nullptr;
+    Matrix<2, 2> cov_matrix, observed_cov;
 
-    estimateNormalMLE(values, censored, mu_mle, sigma_mle, cov_matrix);
+    bool observed = estimateNormalMLE(values, censored, mu_mle, sigma_mle, cov_matrix, observed_cov, options);
+
+    if (incremental) {
+        state.params = { mu_mle, sigma_mle };
+        state.fitted = isfinite(mu_mle) && isfinite(sigma_mle) && sigma_mle > 0;
+        if (!save_fit_state(mle.state_file, state)) {
+            cout << "Не удалось записать файл состояния: " << mle.state_file << endl;
+        }
+    }
 
     // 3. Запись результатов
+    STAT_PROFILE_SCOPE("write_report");
+    if (result.structured()) {
+        return writeNormalRecord(outputFile, result, n, uncensored_count, mu_mle, sigma_mle,
+            cov_matrix, observed, observed_cov);
+    }
     ofstream out(outputFile);
     if (!out.is_open()) {
         cout << "Не удалось создать файл: " << outputFile << endl;
-        return;
+        return false;
     }
 
-    out << "ОЦЕНКА ПАРАМЕТРОВ НОРМАЛЬНОГО РАСПРЕДЕЛЕНИЯ" << endl;
-    out << "Метод максимального правдоподобия (MLE)" << endl;
-    out << "==============================================" << endl << endl;
+    out << "ОЦЕНКА ПАРАМЕТРОВ НОРМАЛЬНОГО РАСПРЕДЕЛЕНИЯ" << '\n';
+    out << "Метод максимального правдоподобия (MLE)" << '\n';
+    out << "==============================================" << '\n' << '\n';
 
-    out << "ХАРАКТЕРИСТИКИ ВЫБОРКИ:" << endl;
-    out << "Размер выборки: " << n << endl;
-    out << "Нецензурированных наблюдений: " << uncensored_count << endl;
-    out << "Цензурированных наблюдений: " << n - uncensored_count << endl << endl;
+    out << "ХАРАКТЕРИСТИКИ ВЫБОРКИ:" << '\n';
+    out << "Размер выборки: " << n << '\n';
+    out << "Нецензурированных наблюдений: " << uncensored_count << '\n';
+    out << "Цензурированных наблюдений: " << n - uncensored_count << '\n' << '\n';
 
-    out << "ОЦЕНКИ ПАРАМЕТРОВ MLE:" << endl;
-    out << "Среднее (μ): " << fixed << setprecision(6) << mu_mle << endl;
-    out << "Стандартное отклонение (σ): " << fixed << setprecision(6) << sigma_mle << endl << endl;
+    out << "ОЦЕНКИ ПАРАМЕТРОВ MLE:" << '\n';
+    out << "Среднее (μ): " << fixed << setprecision(6) << mu_mle << '\n';
+    out << "Стандартное отклонение (σ): " << fixed << setprecision(6) << sigma_mle << '\n' << '\n';
 
-    out << "КОВАРИАЦИОННАЯ МАТРИЦА ОЦЕНОК:" << endl;
-    out << "[ " << setw(12) << cov_matrix[0][0] << "  " << setw(12) << cov_matrix[0][1] << " ]" << endl;
-    out << "[ " << setw(12) << cov_matrix[1][0] << "  " << setw(12) << cov_matrix[1][1] << " ]" << endl << endl;
+    out << "КОВАРИАЦИОННАЯ МАТРИЦА ОЦЕНОК:" << '\n';
+    out << "[ " << setw(12) << cov_matrix(0, 0) << "  " << setw(12) << cov_matrix(0, 1) << " ]" << '\n';
+    out << "[ " << setw(12) << cov_matrix(1, 0) << "  " << setw(12) << cov_matrix(1, 1) << " ]" << '\n' << '\n';
 
-    out << "ДЕТАЛИ КОВАРИАЦИОННОЙ МАТРИЦЫ:" << endl;
-    out << "Var(μ) = " << fixed << setprecision(8) << cov_matrix[0][0] << endl;
-    out << "Cov(μ,σ) = " << fixed << setprecision(8) << cov_matrix[0][1] << endl;
-    out << "Cov(σ,μ) = " << fixed << setprecision(8) << cov_matrix[1][0] << endl;
-    out << "Var(σ) = " << fixed << setprecision(8) << cov_matrix[1][1] << endl << endl;
+    out << "ДЕТАЛИ КОВАРИАЦИОННОЙ МАТРИЦЫ:" << '\n';
+    out << "Var(μ) = " << fixed << setprecision(8) << cov_matrix(0, 0) << '\n';
+    out << "Cov(μ,σ) = " << fixed << setprecision(8) << cov_matrix(0, 1) << '\n';
+    out << "Cov(σ,μ) = " << fixed << setprecision(8) << cov_matrix(1, 0) << '\n';
+    out << "Var(σ) = " << fixed << setprecision(8) << cov_matrix(1, 1) << '\n' << '\n';
 
     // Стандартные ошибки и корреляция
-    double se_mu = sqrt(cov_matrix[0][0]);
-    double se_sigma = sqrt(cov_matrix[1][1]);
-    double correlation = cov_matrix[0][1] / (se_mu * se_sigma);
+    double se_mu = sqrt(cov_matrix(0, 0));
+    double se_sigma = sqrt(cov_matrix(1, 1));
+    double correlation = cov_matrix(0, 1) / (se_mu * se_sigma);
 
-    out << "СТАТИСТИЧЕСКИЕ ХАРАКТЕРИСТИКИ ОЦЕНОК:" << endl;
-    out << "Стандартная ошибка μ: " << fixed << setprecision(6) << se_mu << endl;
-    out << "Стандартная ошибка σ: " << fixed << setprecision(6) << se_sigma << endl;
-    out << "Корреляция между оценками μ и σ: " << fixed << setprecision(6) << correlation << endl << endl;
+    out << "СТАТИСТИЧЕСКИЕ ХАРАКТЕРИСТИКИ ОЦЕНОК:" << '\n';
+    out << "Стандартная ошибка μ: " << fixed << setprecision(6) << se_mu << '\n';
+    out << "Стандартная ошибка σ: " << fixed << setprecision(6) << se_sigma << '\n';
+    out << "Корреляция между оценками μ и σ: " << fixed << setprecision(6) << correlation << '\n' << '\n';
 
     // Доверительные интервалы (приближенные, 95%)
     double z_95 = norm_ppf(0.975); // 1.96 для 95% доверительного интервала
-    out << "ПРИБЛИЖЕННЫЕ 95% ДОВЕРИТЕЛЬНЫЕ ИНТЕРВАЛЫ:" << endl;
-    out << "μ: [" << mu_mle - z_95 * se_mu << ", " << mu_mle + z_95 * se_mu << "]" << endl;
-    out << "σ: [" << max(0.0, sigma_mle - z_95 * se_sigma) << ", " << sigma_mle + z_95 * se_sigma << "]" << endl;
+    out << "ПРИБЛИЖЕННЫЕ 95% ДОВЕРИТЕЛЬНЫЕ ИНТЕРВАЛЫ:" << '\n';
+    out << "μ: [" << mu_mle - z_95 * se_mu << ", " << mu_mle + z_95 * se_mu << "]" << '\n';
+    out << "σ: [" << max(0.0, sigma_mle - z_95 * se_sigma) << ", " << sigma_mle + z_95 * se_sigma << "]" << '\n';
+
+    // С --newton: матрица в единицах параметров (блоки выше - нормированные,
+    // n Cov / σ^2, как без --newton)
+    if (observed) {
+        double se_mu_obs = sqrt(observed_cov(0, 0));
+        double se_sigma_obs = sqrt(observed_cov(1, 1));
+        out << '\n' << "КОВАРИАЦИОННАЯ МАТРИЦА ПО НАБЛЮДАЕМОЙ ИНФОРМАЦИИ (в единицах параметров, --newton):" << '\n';
+        out << "(матрица и интервалы выше - по нормированной матрице n Cov / σ^2, как без --newton)" << '\n';
+        out << "Var(μ) = " << fixed << setprecision(8) << observed_cov(0, 0) << '\n';
+        out << "Cov(μ,σ) = " << fixed << setprecision(8) << observed_cov(0, 1) << '\n';
+        out << "Var(σ) = " << fixed << setprecision(8) << observed_cov(1, 1) << '\n';
+        out << "Стандартная ошибка μ: " << fixed << setprecision(6) << se_mu_obs << '\n';
+        out << "Стандартная ошибка σ: " << fixed << setprecision(6) << se_sigma_obs << '\n';
+        out << "μ: [" << mu_mle - z_95 * se_mu_obs << ", " << mu_mle + z_95 * se_mu_obs << "]" << '\n';
+        out << "σ: [" << max(0.0, sigma_mle - z_95 * se_sigma_obs) << ", " << sigma_mle + z_95 * se_sigma_obs << "]" << '\n';
+    }
 
     out.close();
 
-    // Освобождение памяти
-    if (cov_matrix != nullptr) {
-        for (int i = 0; i < 2; i++) {
-            delete[] cov_matrix[i];
-        }
-        delete[] cov_matrix;
-    }
-
     cout << "Результаты MLE оценки записаны в: " << outputFile << endl;
+    return true;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     string inputFile = "data.txt";
     string outputFile = "results_mle.txt";
 
-    estimateNormalParameters(inputFile, outputFile);
+    MleOptions mle;
+
+    // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+    ResultCacheOptions cacheOptions;
+    if (!take_cache_options(argc, argv, cacheOptions)) return 1;
+
+    // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+    ResultOptions resultOptions;
+    if (!take_result_options(argc, argv, resultOptions)) return 1;
+    outputFile = result_output_filename(outputFile, resultOptions);
+
+    // Другой входной файл (текстовый или двоичный): --input <файл>
+    // Мультистарт из N начальных точек: --multistart <N>
+    // Уточнение методом Ньютона: --newton
+    // Инкрементальный пересчет дописанного файла: --state <файл состояния>
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--newton") mle.newton = true;
+        else if (option == "--input" && i + 1 < argc) inputFile = argv[++i];
+        else if (option == "--multistart" && i + 1 < argc) mle.starts = max(1, atoi(argv[++i]));
+        else if (option == "--state" && i + 1 < argc) mle.state_file = argv[++i];
+    }
+
+    // Тот же файл с теми же параметрами - результат из кэша. С файлом
+    // состояния кэш не используется: каждый запуск обновляет состояние.
+    ResultCache cache(mle.state_file.empty() ? cacheOptions : ResultCacheOptions(), "normal_mle");
+    cache.add_file(inputFile);
+    cache.add_arguments(argc, argv);
+    cache.add("format", static_cast<int>(resultOptions.format));
+    if (cache.replay()) return 0;
+
+    if (estimateNormalParameters(inputFile, outputFile, mle, resultOptions)) cache.store({ outputFile });
 
     return 0;
 }
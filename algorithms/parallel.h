@@ -0,0 +1,276 @@
+#pragma once
+// Примитивы параллельного выполнения для утилит статистики.
+//
+// Все параллельные циклы выполняются общим пулом потоков, который создается
+// при первом обращении (hardware_threads() потоков вместе с вызывающим).
+// У каждого потока пула своя очередь задач: поток берет задачи с конца своей
+// очереди, простаивающие потоки забирают (крадут) задачи с начала чужих
+// очередей. Поток, ожидающий завершения своих задач, тем временем выполняет
+// другие, поэтому вложенные циклы (моменты выборки внутри цикла по столбцам,
+// ресэмплинг внутри пакетного сравнения) не создают новых потоков и не
+// блокируют пул.
+//
+// Число потоков задается переменной окружения STAT_THREADS, по умолчанию -
+// число аппаратных потоков.
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Число потоков для параллельных циклов (не меньше 1)
+inline unsigned hardware_threads() {
+   static const unsigned threads = []() {
+      unsigned n = std::thread::hardware_concurrency();
+      if (n == 0) n = 1;
+      const char* limit = std::getenv("STAT_THREADS");
+      if (limit != nullptr && std::atoi(limit) > 0) n = static_cast<unsigned>(std::atoi(limit));
+      return n;
+   }();
+   return threads;
+}
+
+class ThreadPool;
+
+// Группа задач пула: run() ставит задачу в очередь, wait() возвращает
+// управление после завершения всех задач группы. Первое исключение задачи
+// передается из wait().
+class TaskGroup {
+public:
+   TaskGroup() = default;
+   ~TaskGroup() {
+      if (pending_.load(std::memory_order_acquire) != 0) {
+         try { wait(); }
+         catch (...) {}
+      }
+   }
+
+   TaskGroup(const TaskGroup&) = delete;
+   TaskGroup& operator=(const TaskGroup&) = delete;
+
+   template <class F>
+   void run(F&& task);
+   void wait();
+
+private:
+   friend class ThreadPool;
+
+   void fail(std::exception_ptr error) {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      if (!error_) error_ = error;
+   }
+
+   std::atomic<size_t> pending_{ 0 };
+   std::mutex error_mutex_;
+   std::exception_ptr error_;
+};
+
+class ThreadPool {
+public:
+   // Пул не уничтожается: потоки спят до завершения процесса, и порядок
+   // уничтожения статических объектов не имеет значения
+   static ThreadPool& instance() {
+      static ThreadPool* pool = new ThreadPool(hardware_threads());
+      return *pool;
+   }
+
+   unsigned size() const { return size_; }
+
+   void submit(TaskGroup& group, std::function<void()> function) {
+      group.pending_.fetch_add(1, std::memory_order_relaxed);
+      Queue& queue = *queues_[current_queue()];
+      {
+         std::lock_guard<std::mutex> lock(queue.mutex);
+         queue.tasks.push_back({ std::move(function), &group });
+      }
+      queued_.fetch_add(1, std::memory_order_release);
+      if (size_ > 1) {
+         { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+         wake_.notify_one();
+      }
+   }
+
+   // Выполняет одну задачу из своей или чужой очереди; false - задач нет
+   bool run_one() {
+      Task task;
+      if (!take(task)) return false;
+      execute(task);
+      return true;
+   }
+
+private:
+   struct Task {
+      std::function<void()> function;
+      TaskGroup* group = nullptr;
+   };
+
+   struct Queue {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+   };
+
+   explicit ThreadPool(unsigned size) : size_(std::max(1u, size)) {
+      for (unsigned i = 0; i < size_; i++) queues_.push_back(std::make_unique<Queue>());
+      // Очередь 0 - у потоков вне пула (в том числе главного), 1..size-1 - у потоков пула
+      for (unsigned i = 1; i < size_; i++) {
+         std::thread([this, i]() { work(i); }).detach();
+      }
+   }
+
+   static int& worker_index() {
+      thread_local int index = 0;
+      return index;
+   }
+
+   size_t current_queue() const { return static_cast<size_t>(worker_index()); }
+
+   bool take(Task& task) {
+      if (queued_.load(std::memory_order_acquire) == 0) return false;
+      size_t own = current_queue();
+      {
+         Queue& queue = *queues_[own];
+         std::lock_guard<std::mutex> lock(queue.mutex);
+         if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+         }
+      }
+      for (size_t i = 1; i < size_; i++) {
+         Queue& queue = *queues_[(own + i) % size_];
+         std::lock_guard<std::mutex> lock(queue.mutex);
+         if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+         }
+      }
+      return false;
+   }
+
+   static void execute(Task& task) {
+      try {
+         task.function();
+      }
+      catch (...) {
+         task.group->fail(std::current_exception());
+      }
+      task.function = nullptr;
+      task.group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+   }
+
+   void work(unsigned index) {
+      worker_index() = static_cast<int>(index);
+      for (;;) {
+         Task task;
+         if (take(task)) {
+            execute(task);
+            continue;
+         }
+         std::unique_lock<std::mutex> lock(sleep_mutex_);
+         wake_.wait(lock, [this]() { return queued_.load(std::memory_order_acquire) > 0; });
+      }
+   }
+
+   unsigned size_;
+   std::vector<std::unique_ptr<Queue>> queues_;
+   std::atomic<size_t> queued_{ 0 };
+   std::mutex sleep_mutex_;
+   std::condition_variable wake_;
+};
+
+template <class F>
+void TaskGroup::run(F&& task) {
+   ThreadPool::instance().submit(*this, std::function<void()>(std::forward<F>(task)));
+}
+
+inline void TaskGroup::wait() {
+   ThreadPool& pool = ThreadPool::instance();
+   while (pending_.load(std::memory_order_acquire) != 0) {
+      if (!pool.run_one()) std::this_thread::yield();
+   }
+   std::exception_ptr error;
+   {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      std::swap(error, error_);
+   }
+   if (error) std::rethrow_exception(error);
+}
+
+// Деление [begin, end) пополам: правая половина - в очередь (ее может
+// забрать другой поток и делить дальше), левая - дальше в этом потоке
+template <class Body>
+void parallel_split(TaskGroup& group, size_t begin, size_t end, size_t grain, Body& body) {
+   while (end - begin > grain) {
+      size_t middle = begin + (end - begin) / 2;
+      group.run([&group, &body, middle, end, grain]() { parallel_split(group, middle, end, grain, body); });
+      end = middle;
+   }
+   body(begin, end);
+}
+
+// Выполняет body(begin, end) для непересекающихся непрерывных кусков
+// диапазона [0, count) длиной не меньше min_chunk (кроме, возможно,
+// последнего). Куски выполняются потоками пула, в том числе вызывающим.
+template <class Body>
+void parallel_for(size_t count, size_t min_chunk, Body body) {
+   if (count == 0) return;
+   if (min_chunk == 0) min_chunk = 1;
+
+   size_t threads = ThreadPool::instance().size();
+   if (threads <= 1 || count <= min_chunk) {
+      body(size_t(0), count);
+      return;
+   }
+
+   // Кусков в несколько раз больше, чем потоков: неравные по времени
+   // куски выравниваются перехватом задач
+   size_t grain = std::max(min_chunk, (count + 4 * threads - 1) / (4 * threads));
+   TaskGroup group;
+   parallel_split(group, 0, count, grain, body);
+   group.wait();
+}
+
+enum class ReduceMode {
+   Fast,          // куски по числу потоков: результат может зависеть от STAT_THREADS
+   Deterministic  // куски зависят только от count и min_chunk: одинаковый результат при любом числе потоков
+};
+
+// Свертка диапазона [0, count): map(begin, end) вычисляет частичный
+// результат куска, combine(a, b) объединяет частичные результаты. Куски
+// объединяются всегда по порядку слева направо, начиная с identity.
+template <class T, class Map, class Combine>
+T parallel_reduce(size_t count, size_t min_chunk, T identity, Map map, Combine combine,
+   ReduceMode mode = ReduceMode::Deterministic) {
+   if (count == 0) return identity;
+   if (min_chunk == 0) min_chunk = 1;
+
+   const size_t deterministic_parts = 1024;
+   size_t max_parts = (count + min_chunk - 1) / min_chunk;
+   size_t parts = std::min<size_t>(mode == ReduceMode::Fast ? hardware_threads() : deterministic_parts, max_parts);
+   size_t chunk = (count + parts - 1) / parts;
+   parts = (count + chunk - 1) / chunk;
+
+   std::vector<T> partial(parts, identity);
+   parallel_for(parts, 1, [&](size_t first, size_t last) {
+      for (size_t p = first; p < last; p++) {
+         partial[p] = map(p * chunk, std::min(count, (p + 1) * chunk));
+      }
+   });
+
+   T result = std::move(identity);
+   for (T& part : partial) {
+      result = combine(std::move(result), std::move(part));
+   }
+   return result;
+}
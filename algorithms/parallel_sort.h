@@ -0,0 +1,195 @@
+#pragma once
+// Сортировка выборок для порядковых методов (порядковые статистики, ранги).
+//
+// Большие массивы double сортируются поразрядной сортировкой (LSD radix) по
+// 64-битному ключу: у положительных чисел инвертируется знаковый бит, у
+// отрицательных - все биты, после чего порядок целых ключей совпадает с
+// порядком чисел. Шесть проходов по 11 бит; проход, в разряде которого у
+// всех ключей одна цифра (например, одинаковый знак и порядок), пропускается.
+// Гистограммы и раскладка по корзинам выполняются блоками в пуле потоков
+// (parallel.h), раскладка устойчива.
+//
+//   parallel_sort(sorted_data);                              // значения
+//   parallel_sort_indices(values, n, order.data());          // ранги: номера по возрастанию
+//
+// Уже упорядоченные данные (двоичный файл с порядком, повторная сортировка)
+// распознаются за один параллельный проход. Малые массивы сортируются
+// std::sort / std::stable_sort. Рабочие массивы - из arena_resource().
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+#include "parallel.h"
+
+// Меньше этого размера - сортировка сравнениями
+constexpr size_t parallel_sort_threshold = size_t(1) << 16;
+
+inline std::uint64_t double_sort_key(double x) {
+   std::uint64_t bits;
+   std::memcpy(&bits, &x, sizeof(bits));
+   return bits ^ ((bits >> 63) != 0 ? ~std::uint64_t(0) : std::uint64_t(1) << 63);
+}
+
+inline double double_from_sort_key(std::uint64_t key) {
+   std::uint64_t bits = key ^ ((key >> 63) != 0 ? std::uint64_t(1) << 63 : ~std::uint64_t(0));
+   double x;
+   std::memcpy(&x, &bits, sizeof(x));
+   return x;
+}
+
+// Проверка упорядоченности по неубыванию (параллельно для больших массивов)
+inline bool is_sorted_parallel(const double* data, size_t n) {
+   if (n < 2) return true;
+   int sorted = parallel_reduce(n - 1, size_t(1) << 16, 1,
+      [data](size_t begin, size_t end) {
+         for (size_t i = begin; i < end; i++) {
+            if (data[i + 1] < data[i]) return 0;
+         }
+         return 1;
+      },
+      [](int a, int b) { return a & b; });
+   return sorted != 0;
+}
+
+// Устойчивая поразрядная сортировка записей по ключу key_of(record) (uint64)
+template <class Record, class KeyOf>
+void radix_sort_records(Record* data, size_t n, KeyOf key_of) {
+   constexpr unsigned digit_bits = 11;
+   constexpr size_t buckets = size_t(1) << digit_bits;
+   constexpr unsigned passes = (64 + digit_bits - 1) / digit_bits;
+   const size_t min_block = size_t(1) << 15;
+
+   size_t blocks = std::max<size_t>(1, std::min<size_t>(ThreadPool::instance().size(), n / min_block));
+   size_t block_size = (n + blocks - 1) / blocks;
+   blocks = (n + block_size - 1) / block_size;
+
+   std::pmr::memory_resource* resource = arena_resource();
+   std::pmr::vector<Record> buffer(n, resource);
+   // counts[(block * passes + pass) * buckets + digit]
+   std::pmr::vector<size_t> counts(blocks * passes * buckets, 0, resource);
+
+   // Гистограммы всех разрядов за один проход
+   parallel_for(blocks, 1, [&](size_t first, size_t last) {
+      for (size_t b = first; b < last; b++) {
+         size_t* block_counts = counts.data() + b * passes * buckets;
+         for (size_t i = b * block_size; i < std::min(n, (b + 1) * block_size); i++) {
+            std::uint64_t key = key_of(data[i]);
+            for (unsigned p = 0; p < passes; p++) {
+               block_counts[p * buckets + ((key >> (p * digit_bits)) & (buckets - 1))]++;
+            }
+         }
+      }
+   });
+
+   Record* source = data;
+   Record* target = buffer.data();
+   bool permuted = false;
+   std::pmr::vector<size_t> offsets(blocks * buckets, resource);
+   for (unsigned p = 0; p < passes; p++) {
+      unsigned shift = p * digit_bits;
+      // Все ключи с одной цифрой в разряде - проход не меняет порядок
+      bool trivial = false;
+      for (size_t d = 0; d < buckets && !trivial; d++) {
+         size_t total = 0;
+         for (size_t b = 0; b < blocks; b++) total += counts[(b * passes + p) * buckets + d];
+         trivial = total == n;
+      }
+      if (trivial) continue;
+
+      // После перестановки гистограммы блоков этого разряда пересчитываются
+      if (permuted && blocks > 1) {
+         parallel_for(blocks, 1, [&](size_t first, size_t last) {
+            for (size_t b = first; b < last; b++) {
+               size_t* block_counts = counts.data() + (b * passes + p) * buckets;
+               std::fill(block_counts, block_counts + buckets, size_t(0));
+               for (size_t i = b * block_size; i < std::min(n, (b + 1) * block_size); i++) {
+                  block_counts[(key_of(source[i]) >> shift) & (buckets - 1)]++;
+               }
+            }
+         });
+      }
+
+      // Начало каждой корзины каждого блока: по цифрам, внутри цифры - по блокам
+      size_t position = 0;
+      for (size_t d = 0; d < buckets; d++) {
+         for (size_t b = 0; b < blocks; b++) {
+            offsets[b * buckets + d] = position;
+            position += counts[(b * passes + p) * buckets + d];
+         }
+      }
+
+      parallel_for(blocks, 1, [&](size_t first, size_t last) {
+         for (size_t b = first; b < last; b++) {
+            size_t* next = offsets.data() + b * buckets;
+            for (size_t i = b * block_size; i < std::min(n, (b + 1) * block_size); i++) {
+               target[next[(key_of(source[i]) >> shift) & (buckets - 1)]++] = source[i];
+            }
+         }
+      });
+      std::swap(source, target);
+      permuted = true;
+   }
+
+   if (source != data) {
+      parallel_for(n, min_block, [&](size_t begin, size_t end) {
+         std::copy(source + begin, source + end, data + begin);
+      });
+   }
+}
+
+// Сортировка по возрастанию
+inline void parallel_sort(double* data, size_t n) {
+   if (is_sorted_parallel(data, n)) return;
+   if (n < parallel_sort_threshold) {
+      std::sort(data, data + n);
+      return;
+   }
+   std::pmr::vector<std::uint64_t> keys(n, arena_resource());
+   parallel_for(n, size_t(1) << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) keys[i] = double_sort_key(data[i]);
+   });
+   radix_sort_records(keys.data(), n, [](std::uint64_t key) { return key; });
+   parallel_for(n, size_t(1) << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) data[i] = double_from_sort_key(keys[i]);
+   });
+}
+
+inline void parallel_sort(std::vector<double>& data) {
+   parallel_sort(data.data(), data.size());
+}
+
+// Номера элементов values в порядке возрастания значений (устойчиво: при
+// равных значениях - по возрастанию номера, -0 и +0 равны), как
+// std::stable_sort номеров по values
+template <class Index>
+void parallel_sort_indices(const double* values, size_t n, Index* order) {
+   std::iota(order, order + n, Index(0));
+   if (is_sorted_parallel(values, n)) return;
+   if (n < parallel_sort_threshold) {
+      std::stable_sort(order, order + n, [values](Index a, Index b) { return values[a] < values[b]; });
+      return;
+   }
+
+   struct Record {
+      std::uint64_t key;
+      Index index;
+   };
+   std::pmr::vector<Record> records(n, arena_resource());
+   parallel_for(n, size_t(1) << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+         double x = values[i] == 0.0 ? 0.0 : values[i];
+         records[i] = { double_sort_key(x), static_cast<Index>(i) };
+      }
+   });
+   radix_sort_records(records.data(), n, [](const Record& record) { return record.key; });
+   parallel_for(n, size_t(1) << 16, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) order[i] = records[i].index;
+   });
+}
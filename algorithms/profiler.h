@@ -0,0 +1,270 @@
+#pragma once
+// Замер времени этапов и счетчики для поиска узких мест.
+//
+// Инструментирование включается при сборке макросом STAT_PROFILING.
+// Без него STAT_PROFILE_SCOPE и STAT_PROFILE_COUNT раскрываются в пустой
+// оператор: аргументы не вычисляются, в программе не остается ни кода,
+// ни данных профилировщика.
+//
+//   STAT_PROFILE_SCOPE("read_text");          // время до конца блока
+//   STAT_PROFILE_COUNT("sort_size", n);       // прибавить n к счетчику
+//
+// При завершении программы сводная таблица выводится в cerr: для этапов -
+// число вызовов, суммарное, среднее и максимальное время и доля от времени
+// работы (у этапов внутри parallel_for она суммируется по потокам и может
+// превышать 100%), для счетчиков - число событий и сумма. Все замеры пишутся
+// в файл трассы Chrome trace events (chrome://tracing,
+// https://ui.perfetto.dev). Имя файла трассы задается переменной окружения
+// STAT_TRACE, по умолчанию stat_trace.json.
+//
+// Замеры пишутся в буфер своего потока без блокировок, поэтому этапы можно
+// отмечать и внутри parallel_for. Имена этапов и счетчиков - строковые
+// литералы (хранится только указатель).
+
+#ifdef STAT_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ProfileEvent {
+   const char* name;
+   std::int64_t begin_ns; // от запуска профилировщика
+   std::int64_t end_ns;
+};
+
+struct ProfileCounter {
+   const char* name;
+   std::int64_t total = 0;
+   std::int64_t updates = 0;
+};
+
+// Замеры одного потока
+struct ProfileThreadData {
+   unsigned thread = 0;
+   std::vector<ProfileEvent> events;
+   std::vector<ProfileCounter> counters;
+};
+
+// Ячейка таблицы шириной |width| символов (UTF-8): width < 0 - выравнивание влево
+inline std::string profile_cell(const std::string& text, int width) {
+   size_t chars = 0;
+   for (unsigned char c : text) {
+      if ((c & 0xC0) != 0x80) chars++;
+   }
+   size_t target = static_cast<size_t>(width < 0 ? -width : width);
+   std::string padding(chars < target ? target - chars : 0, ' ');
+   return width < 0 ? text + padding : padding + text;
+}
+
+class Profiler {
+public:
+   static Profiler& instance() {
+      static Profiler profiler;
+      return profiler;
+   }
+
+   std::int64_t now_ns() const {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now() - start_).count();
+   }
+
+   // Буфер вызывающего потока; данные переживают завершение потока
+   ProfileThreadData& thread_data() {
+      thread_local ProfileThreadData* data = nullptr;
+      if (data == nullptr) {
+         std::lock_guard<std::mutex> lock(mutex_);
+         threads_.push_back(std::make_unique<ProfileThreadData>());
+         data = threads_.back().get();
+         data->thread = static_cast<unsigned>(threads_.size());
+         data->events.reserve(1024);
+      }
+      return *data;
+   }
+
+   void add_count(const char* name, std::int64_t value) {
+      std::vector<ProfileCounter>& counters = thread_data().counters;
+      for (ProfileCounter& counter : counters) {
+         if (counter.name == name) {
+            counter.total += value;
+            counter.updates++;
+            return;
+         }
+      }
+      ProfileCounter counter;
+      counter.name = name;
+      counter.total = value;
+      counter.updates = 1;
+      counters.push_back(counter);
+   }
+
+   ~Profiler() {
+      std::int64_t wall_ns = now_ns();
+      write_summary(std::cerr, wall_ns);
+
+      const char* trace = std::getenv("STAT_TRACE");
+      std::string filename = (trace != nullptr && *trace != '\0') ? trace : "stat_trace.json";
+      if (write_chrome_trace(filename, wall_ns)) {
+         std::cerr << "Трасса профилирования сохранена в файл: " << filename << std::endl;
+      }
+   }
+
+   // Итоги по этапам и счетчикам всех потоков
+   void write_summary(std::ostream& out, std::int64_t wall_ns) {
+      struct Row {
+         std::string name;
+         std::int64_t calls = 0;
+         std::int64_t total_ns = 0;
+         std::int64_t max_ns = 0;
+      };
+      std::vector<Row> phases;
+      std::vector<ProfileCounter> counters;
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         for (const auto& thread : threads_) {
+            for (const ProfileEvent& event : thread->events) {
+               auto it = std::find_if(phases.begin(), phases.end(),
+                  [&](const Row& row) { return row.name == event.name; });
+               if (it == phases.end()) {
+                  phases.push_back(Row());
+                  phases.back().name = event.name;
+                  it = phases.end() - 1;
+               }
+               std::int64_t duration = event.end_ns - event.begin_ns;
+               it->calls++;
+               it->total_ns += duration;
+               it->max_ns = std::max(it->max_ns, duration);
+            }
+            for (const ProfileCounter& counter : thread->counters) {
+               auto it = std::find_if(counters.begin(), counters.end(),
+                  [&](const ProfileCounter& c) { return std::strcmp(c.name, counter.name) == 0; });
+               if (it == counters.end()) {
+                  counters.push_back(counter);
+               }
+               else {
+                  it->total += counter.total;
+                  it->updates += counter.updates;
+               }
+            }
+         }
+      }
+      std::sort(phases.begin(), phases.end(), [](const Row& a, const Row& b) { return a.total_ns > b.total_ns; });
+
+      std::ios_base::fmtflags flags = out.flags();
+      std::streamsize precision = out.precision();
+      out << std::fixed << std::setprecision(3);
+      out << "\n=== ПРОФИЛЬ (время работы " << wall_ns / 1e6 << " мс) ===\n";
+      out << profile_cell("этап", -32) << profile_cell("вызовов", 10) << profile_cell("всего, мс", 14)
+         << profile_cell("среднее, мкс", 14) << profile_cell("макс., мкс", 14) << profile_cell("%", 9) << '\n';
+      for (const Row& row : phases) {
+         out << profile_cell(row.name, -32) << std::setw(10) << row.calls
+            << std::setw(14) << row.total_ns / 1e6
+            << std::setw(14) << row.total_ns / 1e3 / row.calls
+            << std::setw(14) << row.max_ns / 1e3
+            << std::setw(9) << (wall_ns > 0 ? 100.0 * row.total_ns / wall_ns : 0.0) << '\n';
+      }
+      if (!counters.empty()) {
+         out << profile_cell("счетчик", -32) << profile_cell("событий", 10) << profile_cell("сумма", 20) << '\n';
+         for (const ProfileCounter& counter : counters) {
+            out << profile_cell(counter.name, -32) << std::setw(10) << counter.updates
+               << std::setw(20) << counter.total << '\n';
+         }
+      }
+      out.flags(flags);
+      out.precision(precision);
+   }
+
+   // Трасса в формате Chrome trace events: этапы - события "X",
+   // итоги счетчиков - события "C" в конце трассы
+   bool write_chrome_trace(const std::string& filename, std::int64_t wall_ns) {
+      std::FILE* file = std::fopen(filename.c_str(), "wb");
+      if (file == nullptr) {
+         std::cerr << "ОШИБКА: Не удалось создать файл трассы: " << filename << std::endl;
+         return false;
+      }
+      std::string json_name;
+      auto quoted = [&](const char* name) -> const char* {
+         json_name.clear();
+         for (const char* p = name; *p; p++) {
+            if (*p == '"' || *p == '\\') json_name += '\\';
+            json_name += *p;
+         }
+         return json_name.c_str();
+      };
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+      bool first = true;
+      auto separator = [&]() {
+         if (!first) std::fputs(",\n", file);
+         first = false;
+      };
+      for (const auto& thread : threads_) {
+         separator();
+         std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+            thread->thread, thread->thread == 1 ? "main" : "worker", thread->thread);
+         for (const ProfileEvent& event : thread->events) {
+            separator();
+            std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+               quoted(event.name), thread->thread, event.begin_ns / 1e3, (event.end_ns - event.begin_ns) / 1e3);
+         }
+         for (const ProfileCounter& counter : thread->counters) {
+            separator();
+            std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+               quoted(counter.name), thread->thread, wall_ns / 1e3, static_cast<long long>(counter.total));
+         }
+      }
+      std::fputs("\n]}\n", file);
+      return std::fclose(file) == 0;
+   }
+
+private:
+   Profiler() : start_(std::chrono::steady_clock::now()) {}
+
+   std::chrono::steady_clock::time_point start_;
+   std::mutex mutex_;
+   std::vector<std::unique_ptr<ProfileThreadData>> threads_;
+};
+
+// Замер времени от создания до конца области видимости
+class ProfileScope {
+public:
+   explicit ProfileScope(const char* name)
+      : data_(Profiler::instance().thread_data()), name_(name), begin_ns_(Profiler::instance().now_ns()) {}
+   ~ProfileScope() {
+      data_.events.push_back({ name_, begin_ns_, Profiler::instance().now_ns() });
+   }
+
+   ProfileScope(const ProfileScope&) = delete;
+   ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+   ProfileThreadData& data_;
+   const char* name_;
+   std::int64_t begin_ns_;
+};
+
+// Профилировщик создается до main, чтобы время работы считалось от запуска
+inline Profiler& stat_profiler_startup = Profiler::instance();
+
+#define STAT_PROFILE_CONCAT_(a, b) a##b
+#define STAT_PROFILE_CONCAT(a, b) STAT_PROFILE_CONCAT_(a, b)
+#define STAT_PROFILE_SCOPE(name) ProfileScope STAT_PROFILE_CONCAT(stat_profile_scope_, __LINE__)(name)
+#define STAT_PROFILE_COUNT(name, value) Profiler::instance().add_count(name, static_cast<std::int64_t>(value))
+
+#else
+
+#define STAT_PROFILE_SCOPE(name) ((void)0)
+#define STAT_PROFILE_COUNT(name, value) ((void)0)
+
+#endif
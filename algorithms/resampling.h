@@ -0,0 +1,271 @@
+#pragma once
+// Перестановочный и бутстреп-варианты критерия Стьюдента для двух выборок.
+//
+// Обе выборки хранятся в одном непрерывном массиве, центрированном по
+// общему среднему. Ресэмпл не копирует данные: суммы и суммы квадратов
+// выбранной подвыборки накапливаются по ходу выбора элементов.
+// Ресэмпл с номером r использует собственный поток CounterRng(seed, r),
+// поэтому результат воспроизводим при любом числе потоков.
+//
+// Ресэмплы выполняются раундами; после каждого раунда проверяется,
+// определен ли уже вывод на уровне alpha (доверительный интервал Уилсона
+// для p-значения целиком лежит по одну сторону от alpha).
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "counter_rng.h"
+#include "parallel.h"
+
+struct ResamplingOptions {
+   enum Method { None, Permutation, Bootstrap };
+   Method method = None;
+   size_t resamples = 0;        // максимальное число ресэмплов
+   std::uint64_t seed = 20240601;
+   bool early_stop = true;
+};
+
+struct ResamplingResult {
+   double t_observed = 0.0;     // статистика Уэлча по исходным выборкам
+   size_t performed = 0;        // выполнено ресэмплов
+   size_t exceed = 0;           // ресэмплов со статистикой не меньше наблюдаемой
+   double p_value = 1.0;        // (exceed + 1) / (performed + 1)
+   double p_lower = 0.0;        // интервал Монте-Карло для p-значения
+   double p_upper = 1.0;
+   bool stopped_early = false;
+   double ci_lower = 0.0;       // перцентильный интервал для разности средних (бутстреп)
+   double ci_upper = 0.0;
+};
+
+// Стандартная ошибка разности средних (Уэлч) по суммам и суммам квадратов групп
+inline double resampling_welch_se(double s1, double q1, double n1, double s2, double q2, double n2) {
+   double var1 = std::max(0.0, (q1 - s1 * s1 / n1) / (n1 - 1));
+   double var2 = std::max(0.0, (q2 - s2 * s2 / n2) / (n2 - 1));
+   return std::sqrt(var1 / n1 + var2 / n2);
+}
+
+// Отношение разности к стандартной ошибке с учетом вырожденных выборок
+inline double resampling_ratio(double diff, double se) {
+   if (se > 0) return diff / se;
+   if (diff == 0) return 0.0;
+   return diff > 0 ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity();
+}
+
+// Статистика Уэлча по суммам и суммам квадратов двух групп
+inline double resampling_welch_t(double s1, double q1, double n1, double s2, double q2, double n2) {
+   return resampling_ratio(s1 / n1 - s2 / n2, resampling_welch_se(s1, q1, n1, s2, q2, n2));
+}
+
+// Интервал Уилсона для доли exceed / performed (z = 3.29 соответствует 99.9%)
+inline void resampling_wilson_interval(size_t exceed, size_t performed, double& lower, double& upper) {
+   const double z = 3.29;
+   double n = static_cast<double>(performed);
+   double p = static_cast<double>(exceed) / n;
+   double z2 = z * z;
+   double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+   double half = z * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+   lower = std::max(0.0, center - half);
+   upper = std::min(1.0, center + half);
+}
+
+// Общий цикл раундов: kernel(first, last, exceed) обрабатывает ресэмплы [first, last);
+// prepare(round_end) вызывается перед раундом (до запуска потоков)
+template <class Kernel, class Prepare>
+void resampling_run_rounds(const ResamplingOptions& options, double alpha, Kernel kernel,
+   ResamplingResult& result, Prepare prepare) {
+   const size_t round_size = 16384;
+   std::atomic<size_t> exceed(0);
+   size_t performed = 0;
+
+   while (performed < options.resamples) {
+      size_t round_end = std::min(options.resamples, performed + round_size);
+      prepare(round_end);
+      parallel_for(round_end - performed, 256, [&](size_t begin, size_t end) {
+         size_t local = 0;
+         kernel(performed + begin, performed + end, local);
+         exceed.fetch_add(local, std::memory_order_relaxed);
+      });
+      performed = round_end;
+
+      resampling_wilson_interval(exceed.load(), performed, result.p_lower, result.p_upper);
+      if (options.early_stop && performed < options.resamples &&
+         (result.p_upper < alpha || result.p_lower > alpha)) {
+         result.stopped_early = true;
+         break;
+      }
+   }
+
+   result.performed = performed;
+   result.exceed = exceed.load();
+   result.p_value = (result.exceed + 1.0) / (result.performed + 1.0);
+}
+
+template <class Kernel>
+void resampling_run_rounds(const ResamplingOptions& options, double alpha, Kernel kernel,
+   ResamplingResult& result) {
+   resampling_run_rounds(options, alpha, kernel, result, [](size_t) {});
+}
+
+// Статистика ресэмпла не менее экстремальна, чем наблюдаемая. Допуск нужен
+// потому, что суммы в другом порядке отличаются в последних разрядах,
+// а совпадающие значения не должны теряться.
+inline bool resampling_exceeds(double t, double t_observed, bool two_sided) {
+   double eps = 1e-12 * (1.0 + std::fabs(t_observed));
+   return two_sided ? std::fabs(t) >= std::fabs(t_observed) - eps : t >= t_observed - eps;
+}
+
+// Перестановочный критерий: случайное разбиение объединенной выборки
+// на группы исходных объемов. Выбирается меньшая группа частичным
+// тасованием Фишера-Йетса; перестановки откатываются, так что каждый
+// ресэмпл начинается с исходного порядка.
+inline ResamplingResult permutation_t_test(const std::vector<double>& data1, const std::vector<double>& data2,
+   bool two_sided, double alpha, const ResamplingOptions& options) {
+   ResamplingResult result;
+   size_t n1 = data1.size();
+   size_t n2 = data2.size();
+   size_t total = n1 + n2;
+   if (n1 < 2 || n2 < 2) return result;
+
+   // Центрирование по общему среднему уменьшает потерю точности в суммах квадратов
+   double shift = 0.0;
+   for (double x : data1) shift += x;
+   for (double x : data2) shift += x;
+   shift /= total;
+
+   std::vector<double> pool;
+   pool.reserve(total);
+   for (double x : data1) pool.push_back(x - shift);
+   for (double x : data2) pool.push_back(x - shift);
+
+   double sum_all = 0.0, sq_all = 0.0;
+   for (double x : pool) {
+      sum_all += x;
+      sq_all += x * x;
+   }
+
+   // Выбираемая группа: меньшая из двух
+   bool select_first = n1 <= n2;
+   size_t selected = select_first ? n1 : n2;
+   double n_sel = static_cast<double>(selected);
+   double n_rest = static_cast<double>(total - selected);
+
+   auto statistic = [&](double s, double q) {
+      double t = resampling_welch_t(s, q, n_sel, sum_all - s, sq_all - q, n_rest);
+      return select_first ? t : -t;
+   };
+
+   double s0 = 0.0, q0 = 0.0;
+   size_t offset = select_first ? 0 : n1;
+   for (size_t i = 0; i < selected; i++) {
+      s0 += pool[offset + i];
+      q0 += pool[offset + i] * pool[offset + i];
+   }
+   result.t_observed = statistic(s0, q0);
+
+   resampling_run_rounds(options, alpha, [&](size_t first, size_t last, size_t& exceed) {
+      std::vector<double> local(pool);
+      std::vector<std::uint32_t> swaps(selected);
+      for (size_t r = first; r < last; r++) {
+         CounterRng rng(options.seed, r);
+         double s = 0.0, q = 0.0;
+         for (size_t i = 0; i < selected; i++) {
+            size_t j = i + rng.uniform(static_cast<std::uint32_t>(total - i));
+            swaps[i] = static_cast<std::uint32_t>(j);
+            std::swap(local[i], local[j]);
+            s += local[i];
+            q += local[i] * local[i];
+         }
+         for (size_t i = selected; i-- > 0;) {
+            std::swap(local[i], local[swaps[i]]);
+         }
+
+         if (resampling_exceeds(statistic(s, q), result.t_observed, two_sided)) exceed++;
+      }
+   }, result);
+   return result;
+}
+
+// Бутстреп-критерий: выборки с возвращением внутри каждой группы.
+// p-значение считается по стьюдентизованной статистике, сдвинутой
+// к нулевой гипотезе; интервал для разности средних - перцентильный.
+// Точные перцентили требуют хранить разности всех выполненных ресэмплов:
+// 8 байт на ресэмпл (10^7 ресэмплов - 80 МБ). Массив растет по раундам,
+// поэтому при ранней остановке память берется только под выполненные.
+inline ResamplingResult bootstrap_t_test(const std::vector<double>& data1, const std::vector<double>& data2,
+   bool two_sided, double alpha, const ResamplingOptions& options) {
+   ResamplingResult result;
+   size_t n1 = data1.size();
+   size_t n2 = data2.size();
+   if (n1 < 2 || n2 < 2) return result;
+
+   double shift = 0.0;
+   for (double x : data1) shift += x;
+   for (double x : data2) shift += x;
+   shift /= (n1 + n2);
+
+   // Обе выборки подряд в одном массиве: [выборка 1 | выборка 2]
+   std::vector<double> values;
+   values.reserve(n1 + n2);
+   for (double x : data1) values.push_back(x - shift);
+   for (double x : data2) values.push_back(x - shift);
+   const double* first_sample = values.data();
+   const double* second_sample = values.data() + n1;
+
+   double s1 = 0.0, q1 = 0.0, s2 = 0.0, q2 = 0.0;
+   for (size_t i = 0; i < n1; i++) {
+      s1 += first_sample[i];
+      q1 += first_sample[i] * first_sample[i];
+   }
+   for (size_t i = 0; i < n2; i++) {
+      s2 += second_sample[i];
+      q2 += second_sample[i] * second_sample[i];
+   }
+   double dn1 = static_cast<double>(n1);
+   double dn2 = static_cast<double>(n2);
+   double diff_observed = s1 / dn1 - s2 / dn2;
+   result.t_observed = resampling_welch_t(s1, q1, dn1, s2, q2, dn2);
+
+   std::vector<double> diffs;
+
+   resampling_run_rounds(options, alpha, [&](size_t first, size_t last, size_t& exceed) {
+      for (size_t r = first; r < last; r++) {
+         CounterRng rng(options.seed, r);
+         double bs1 = 0.0, bq1 = 0.0, bs2 = 0.0, bq2 = 0.0;
+         for (size_t i = 0; i < n1; i++) {
+            double x = first_sample[rng.uniform(static_cast<std::uint32_t>(n1))];
+            bs1 += x;
+            bq1 += x * x;
+         }
+         for (size_t i = 0; i < n2; i++) {
+            double x = second_sample[rng.uniform(static_cast<std::uint32_t>(n2))];
+            bs2 += x;
+            bq2 += x * x;
+         }
+
+         double diff = bs1 / dn1 - bs2 / dn2;
+         diffs[r] = diff;
+
+         // Сдвиг к нулевой гипотезе: (diff* - diff) / se*
+         double se = resampling_welch_se(bs1, bq1, dn1, bs2, bq2, dn2);
+         if (resampling_exceeds(resampling_ratio(diff - diff_observed, se), result.t_observed, two_sided)) {
+            exceed++;
+         }
+      }
+   }, result, [&](size_t round_end) { diffs.resize(round_end); });
+
+   // Перцентильный интервал уровня 1 - alpha
+   diffs.resize(result.performed);
+   if (!diffs.empty()) {
+      auto percentile = [&](double q) {
+         size_t k = static_cast<size_t>(std::floor(q * (diffs.size() - 1) + 0.5));
+         std::nth_element(diffs.begin(), diffs.begin() + k, diffs.end());
+         return diffs[k];
+      };
+      result.ci_lower = percentile(alpha / 2);
+      result.ci_upper = percentile(1 - alpha / 2);
+   }
+   return result;
+}
@@ -0,0 +1,468 @@
+#pragma once
+// Кэш результатов: повторный запуск метода на тех же данных с теми же
+// параметрами не пересчитывает результат, а воспроизводит его.
+//
+// Ключ - 64-битный хэш XXH64 содержимого входных файлов, идентификатора
+// метода, параметров (alpha, twoSided, формат вывода, аргументы командной
+// строки) и момента сборки программы (пересобранная программа не берет
+// чужих результатов). Запись кэша - файл <каталог>/<ключ>.res с выходными
+// файлами метода и его выводом в cout. При попадании выходные файлы
+// записываются заново, вывод печатается, и программа завершается; при
+// промахе вывод в cout дублируется в буфер и по окончании сохраняется.
+// Размер каталога ограничен: после записи удаляются давно не
+// использованные записи (время использования - время изменения файла).
+//
+//   ResultCacheOptions cache_options;
+//   if (!take_cache_options(argc, argv, cache_options)) return 1;
+//   ...
+//   ResultCache cache(cache_options, "grubbs");
+//   cache.add_file(inputFilename);
+//   cache.add("alpha", alpha);
+//   if (cache.replay()) return 0;
+//   ... расчет ...
+//   cache.store({ outputFilename });
+//
+// Параметры командной строки (в любом месте):
+//   --cache <каталог>        включить кэш (или переменная окружения STAT_CACHE_DIR)
+//   --cache-limit <МиБ>      предельный размер каталога (по умолчанию 256)
+// Без них кэш выключен, и программа работает как прежде.
+//
+// Для пакетных расчетов из многих независимых частей (пары A/B) есть
+// таблица ResultTable: результаты частей по их собственным ключам в одном
+// файле <каталог>/<имя>.tab. Повторный запуск после изменения части
+// данных пересчитывает только части с новыми ключами.
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "fast_reader.h"
+#include "profiler.h"
+#include "xxhash.h"
+
+struct ResultCacheOptions {
+   std::string directory;                    // пусто - кэш выключен
+   std::uint64_t limit_bytes = std::uint64_t(256) << 20;
+
+   bool enabled() const { return !directory.empty(); }
+};
+
+// Извлекает --cache и --cache-limit из argv (остальные аргументы
+// сдвигаются, argc уменьшается). false - некорректный предел.
+inline bool take_cache_options(int& argc, char** argv, ResultCacheOptions& options) {
+   const char* environment = std::getenv("STAT_CACHE_DIR");
+   if (environment != nullptr) options.directory = environment;
+   int kept = 1;
+   for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (arg == "--cache" && i + 1 < argc) {
+         options.directory = argv[++i];
+         continue;
+      }
+      if (arg == "--cache-limit" && i + 1 < argc) {
+         long long megabytes = std::atoll(argv[++i]);
+         if (megabytes <= 0) {
+            std::cerr << "Некорректный предельный размер кэша: " << argv[i] << " (МиБ)" << std::endl;
+            return false;
+         }
+         options.limit_bytes = static_cast<std::uint64_t>(megabytes) << 20;
+         continue;
+      }
+      argv[kept++] = argv[i];
+   }
+   argc = kept;
+   return true;
+}
+
+// Буфер cout, дублирующий вывод в строку
+class TeeStreambuf : public std::streambuf {
+public:
+   explicit TeeStreambuf(std::streambuf* target) : target_(target) {}
+   const std::string& captured() const { return captured_; }
+
+protected:
+   int_type overflow(int_type ch) override {
+      if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+      captured_.push_back(traits_type::to_char_type(ch));
+      return target_->sputc(traits_type::to_char_type(ch));
+   }
+   std::streamsize xsputn(const char* s, std::streamsize n) override {
+      captured_.append(s, static_cast<size_t>(n));
+      return target_->sputn(s, n);
+   }
+   int sync() override { return target_->pubsync(); }
+
+private:
+   std::streambuf* target_;
+   std::string captured_;
+};
+
+const char result_cache_magic[8] = { 'S', 'T', 'A', 'T', 'R', 'E', 'S', '1' };
+
+// Имя временного файла записи: свое у каждого процесса, чтобы одновременные
+// запуски одного расчета не писали в один файл
+inline std::string result_cache_temporary(const std::string& path) {
+#ifdef _WIN32
+   unsigned long process = GetCurrentProcessId();
+#else
+   unsigned long process = static_cast<unsigned long>(getpid());
+#endif
+   return path + "." + std::to_string(process) + ".tmp";
+}
+
+// Атомарная замена записи готовым временным файлом (std::rename на Windows
+// не заменяет существующий файл)
+inline bool result_cache_replace(const std::string& temporary, const std::string& path) {
+#ifdef _WIN32
+   return MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+   return std::rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+}
+
+class ResultCache {
+public:
+   ResultCache(const ResultCacheOptions& options, const std::string& method)
+      : options_(options), active_(options.enabled()) {
+      hash_.update(std::string(__DATE__ " " __TIME__));
+      hash_.update(method);
+   }
+
+   ~ResultCache() { stop_capture(); }
+
+   ResultCache(const ResultCache&) = delete;
+   ResultCache& operator=(const ResultCache&) = delete;
+
+   // Содержимое входного файла (и его имя: оно попадает в отчеты).
+   // Недоступный файл выключает кэш для этого запуска.
+   void add_file(const std::string& filename) {
+      if (!active_) return;
+      STAT_PROFILE_SCOPE("result_cache_hash");
+      hash_.update(filename);
+      MappedFile file(filename);
+      if (!file.is_open()) {
+         active_ = false;
+         return;
+      }
+      hash_.update(file.data(), file.size());
+      std::uint64_t size = file.size();
+      hash_.update(&size, sizeof(size));
+   }
+
+   void add(const std::string& name, const std::string& value) {
+      hash_.update(name);
+      hash_.update(value);
+   }
+   void add(const std::string& name, const char* value) { add(name, std::string(value)); }
+   void add(const std::string& name, double value) {
+      hash_.update(name);
+      hash_.update(&value, sizeof(value));
+   }
+   void add(const std::string& name, long long value) { add(name, static_cast<double>(value)); }
+   void add(const std::string& name, int value) { add(name, static_cast<double>(value)); }
+   void add(const std::string& name, bool value) { add(name, value ? 1.0 : 0.0); }
+
+   // Аргументы командной строки argv[1..argc)
+   void add_arguments(int argc, char** argv) {
+      for (int i = 1; i < argc; i++) hash_.update(std::string(argv[i]));
+   }
+
+   // true - результат найден и воспроизведен. false - расчет нужен; с этого
+   // момента вывод в cout записывается для store()
+   bool replay() {
+      if (!active_) return false;
+      STAT_PROFILE_SCOPE("result_cache_lookup");
+      path_ = entry_path();
+      if (read_entry()) {
+         std::error_code error;
+         std::filesystem::last_write_time(path_, std::filesystem::file_time_type::clock::now(), error);
+         return true;
+      }
+      tee_.reset(new TeeStreambuf(std::cout.rdbuf()));
+      previous_ = std::cout.rdbuf(tee_.get());
+      return false;
+   }
+
+   // Сохранение выходных файлов и записанного вывода после успешного расчета
+   void store(const std::vector<std::string>& outputs) {
+      if (!active_ || !tee_) return;
+      std::cout.flush();
+      std::string captured = tee_->captured();
+      stop_capture();
+      STAT_PROFILE_SCOPE("result_cache_store");
+
+      std::error_code error;
+      std::filesystem::create_directories(options_.directory, error);
+      std::string temporary = result_cache_temporary(path_);
+      {
+         std::ofstream out(temporary, std::ios::binary);
+         if (!out.is_open()) return;
+         out.write(result_cache_magic, sizeof(result_cache_magic));
+         std::uint64_t count = outputs.size();
+         out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+         for (const std::string& name : outputs) {
+            std::string content;
+            if (!read_whole_file(name, content)) {
+               out.close();
+               std::remove(temporary.c_str());
+               return;
+            }
+            write_block(out, name);
+            write_block(out, content);
+         }
+         write_block(out, captured);
+         if (!out) {
+            out.close();
+            std::remove(temporary.c_str());
+            return;
+         }
+      }
+      if (!result_cache_replace(temporary, path_)) {
+         std::remove(temporary.c_str());
+         return;
+      }
+      evict();
+   }
+
+private:
+   std::string entry_path() const {
+      static const char digits[] = "0123456789abcdef";
+      std::uint64_t key = hash_.digest();
+      std::string name(16, '0');
+      for (int i = 15; i >= 0; i--, key >>= 4) name[i] = digits[key & 15];
+      return (std::filesystem::path(options_.directory) / (name + ".res")).string();
+   }
+
+   static void write_block(std::ofstream& out, const std::string& block) {
+      std::uint64_t size = block.size();
+      out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      out.write(block.data(), static_cast<std::streamsize>(block.size()));
+   }
+
+   static bool read_block(std::ifstream& in, std::string& block) {
+      std::uint64_t size = 0;
+      if (!in.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > (std::uint64_t(1) << 40)) return false;
+      block.resize(static_cast<size_t>(size));
+      return size == 0 || static_cast<bool>(in.read(&block[0], static_cast<std::streamsize>(size)));
+   }
+
+   static bool read_whole_file(const std::string& filename, std::string& content) {
+      std::ifstream in(filename, std::ios::binary);
+      if (!in.is_open()) return false;
+      in.seekg(0, std::ios::end);
+      std::streamoff size = in.tellg();
+      in.seekg(0, std::ios::beg);
+      content.resize(static_cast<size_t>(size));
+      return size == 0 || static_cast<bool>(in.read(&content[0], size));
+   }
+
+   // Запись читается целиком до вывода чего-либо: поврежденная запись -
+   // обычный промах
+   bool read_entry() const {
+      std::ifstream in(path_, std::ios::binary);
+      if (!in.is_open()) return false;
+      char magic[8];
+      std::uint64_t count = 0;
+      if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + 8, result_cache_magic)) return false;
+      if (!in.read(reinterpret_cast<char*>(&count), sizeof(count)) || count > 1024) return false;
+      std::vector<std::pair<std::string, std::string>> outputs(static_cast<size_t>(count));
+      for (auto& output : outputs) {
+         if (!read_block(in, output.first) || !read_block(in, output.second)) return false;
+      }
+      std::string captured;
+      if (!read_block(in, captured)) return false;
+
+      for (const auto& output : outputs) {
+         std::ofstream out(output.first, std::ios::binary);
+         if (!out.is_open() || !out.write(output.second.data(), static_cast<std::streamsize>(output.second.size()))) {
+            return false;
+         }
+      }
+      std::cout.write(captured.data(), static_cast<std::streamsize>(captured.size()));
+      std::cout.flush();
+      return true;
+   }
+
+   // Удаление давно не использованных записей сверх предельного размера
+   void evict() const {
+      STAT_PROFILE_SCOPE("result_cache_evict");
+      namespace fs = std::filesystem;
+      struct Entry {
+         fs::path path;
+         fs::file_time_type used;
+         std::uint64_t size;
+      };
+      std::vector<Entry> entries;
+      std::uint64_t total = 0;
+      std::error_code error;
+      for (fs::directory_iterator it(options_.directory, error), end; !error && it != end; it.increment(error)) {
+         if (it->path().extension() != ".res") continue;
+         std::error_code entry_error;
+         std::uint64_t size = it->file_size(entry_error);
+         fs::file_time_type used = it->last_write_time(entry_error);
+         if (entry_error) continue;
+         entries.push_back({ it->path(), used, size });
+         total += size;
+      }
+      if (total <= options_.limit_bytes) return;
+      std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+      for (const Entry& entry : entries) {
+         if (total <= options_.limit_bytes) break;
+         if (entry.path.string() == path_) continue; // только что записанная
+         if (fs::remove(entry.path, error)) total -= entry.size;
+      }
+   }
+
+   void stop_capture() {
+      if (previous_ != nullptr) {
+         std::cout.rdbuf(previous_);
+         previous_ = nullptr;
+      }
+      tee_.reset();
+   }
+
+   ResultCacheOptions options_;
+   bool active_;
+   Xxh64 hash_;
+   std::string path_;
+   std::unique_ptr<TeeStreambuf> tee_;
+   std::streambuf* previous_ = nullptr;
+};
+
+const char result_table_magic[8] = { 'S', 'T', 'A', 'T', 'T', 'A', 'B', '1' };
+
+// Таблица результатов частей расчета: ключ XXH64 -> N чисел. Таблица
+// читается целиком при создании и записывается в save(), если в нее
+// добавлены записи. Если файл превышает предельный размер кэша, в нем
+// остаются только записи, использованные в этом запуске.
+//
+//   ResultTable<3> table(cache_options, "ab_pair");
+//   Xxh64 hash = table.key_hash();
+//   hash.update(...описание части...);
+//   std::array<double, 3> record;
+//   if (!table.find(hash.digest(), record)) { ...расчет...; table.insert(hash.digest(), record); }
+//   table.save();
+template <size_t N>
+class ResultTable {
+public:
+   ResultTable(const ResultCacheOptions& options, const std::string& name)
+      : options_(options), name_(name) {
+      if (!options_.enabled()) return;
+      path_ = (std::filesystem::path(options_.directory) / (name + ".tab")).string();
+      load();
+   }
+
+   bool enabled() const { return options_.enabled(); }
+
+   // Начало ключа части: момент сборки и имя таблицы
+   Xxh64 key_hash() const {
+      Xxh64 hash;
+      hash.update(std::string(__DATE__ " " __TIME__));
+      hash.update(name_);
+      return hash;
+   }
+
+   bool find(std::uint64_t key, std::array<double, N>& record) {
+      auto it = records_.find(key);
+      if (it == records_.end()) return false;
+      record = it->second.values;
+      it->second.used = true;
+      return true;
+   }
+
+   void insert(std::uint64_t key, const std::array<double, N>& record) {
+      records_[key] = Record{ record, true };
+      changed_ = true;
+   }
+
+   void save() {
+      if (!options_.enabled() || !changed_) return;
+      STAT_PROFILE_SCOPE("result_table_store");
+      const std::uint64_t record_bytes = sizeof(std::uint64_t) + N * sizeof(double);
+      bool used_only = records_.size() * record_bytes > options_.limit_bytes;
+
+      std::error_code error;
+      std::filesystem::create_directories(options_.directory, error);
+      std::string temporary = result_cache_temporary(path_);
+      {
+         std::ofstream out(temporary, std::ios::binary);
+         if (!out.is_open()) return;
+         std::uint64_t width = N, count = 0;
+         for (const auto& entry : records_) count += (!used_only || entry.second.used) ? 1 : 0;
+         out.write(result_table_magic, sizeof(result_table_magic));
+         out.write(reinterpret_cast<const char*>(&width), sizeof(width));
+         out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+         for (const auto& entry : records_) {
+            if (used_only && !entry.second.used) continue;
+            out.write(reinterpret_cast<const char*>(&entry.first), sizeof(entry.first));
+            out.write(reinterpret_cast<const char*>(entry.second.values.data()), N * sizeof(double));
+         }
+         if (!out) {
+            out.close();
+            std::remove(temporary.c_str());
+            return;
+         }
+      }
+      if (!result_cache_replace(temporary, path_)) std::remove(temporary.c_str());
+      changed_ = false;
+   }
+
+private:
+   struct Record {
+      std::array<double, N> values;
+      bool used;
+   };
+
+   // Поврежденная или чужая таблица считается пустой
+   void load() {
+      STAT_PROFILE_SCOPE("result_table_load");
+      MappedFile file(path_);
+      const std::uint64_t header = sizeof(result_table_magic) + 2 * sizeof(std::uint64_t);
+      if (!file.is_open() || file.size() < header) return;
+      const char* p = file.data();
+      std::uint64_t width = 0, count = 0;
+      if (!std::equal(p, p + 8, result_table_magic)) return;
+      std::memcpy(&width, p + 8, sizeof(width));
+      std::memcpy(&count, p + 16, sizeof(count));
+      const std::uint64_t record_bytes = sizeof(std::uint64_t) + N * sizeof(double);
+      if (width != N || count > (file.size() - header) / record_bytes) return;
+      records_.reserve(static_cast<size_t>(count));
+      for (p += header; count > 0; count--, p += record_bytes) {
+         std::uint64_t key;
+         Record record{ {}, false };
+         std::memcpy(&key, p, sizeof(key));
+         std::memcpy(record.values.data(), p + sizeof(key), N * sizeof(double));
+         records_.emplace(key, record);
+      }
+   }
+
+   ResultCacheOptions options_;
+   std::string name_;
+   std::string path_;
+   std::unordered_map<std::uint64_t, Record> records_;
+   bool changed_ = false;
+};
@@ -0,0 +1,302 @@
+#pragma once
+// Машиночитаемый вывод результатов: JSON Lines или CSV.
+//
+// Каждый метод описывает свою фиксированную схему - список полей, и каждая
+// запись содержит ровно эти поля в том же порядке:
+//   JSON Lines: {"method":"grubbs","sample":"A","n":10,...}
+//   CSV:        строка заголовка "method,sample,n,..." и по строке на запись
+//
+// Записи собираются в большом буфере (числа - через std::to_chars, без
+// потоков и локали) и сбрасываются в файл целыми блоками. С параметром
+// --async-output запись блоков выполняет отдельный поток, пока вызывающий
+// поток формирует следующие записи. Нечисловые значения (NaN, inf)
+// записываются как null в JSON и как пустое поле в CSV.
+//
+// Параметры командной строки (в любом месте):
+//   --format text|jsonl|csv   формат результатов (по умолчанию text - прежний отчет)
+//   --async-output            запись в отдельном потоке
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+enum class ResultFormat { Text, JsonLines, Csv };
+
+struct ResultOptions {
+   ResultFormat format = ResultFormat::Text;
+   bool async = false;
+
+   bool structured() const { return format != ResultFormat::Text; }
+};
+
+// Извлекает --format и --async-output из argv (остальные аргументы
+// сдвигаются, argc уменьшается). false - неизвестный формат.
+inline bool take_result_options(int& argc, char** argv, ResultOptions& options) {
+   int kept = 1;
+   for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (arg == "--async-output") {
+         options.async = true;
+         continue;
+      }
+      if (arg == "--format" && i + 1 < argc) {
+         std::string name = argv[++i];
+         if (name == "text") options.format = ResultFormat::Text;
+         else if (name == "jsonl" || name == "json") options.format = ResultFormat::JsonLines;
+         else if (name == "csv") options.format = ResultFormat::Csv;
+         else {
+            std::cerr << "Неизвестный формат результатов: " << name << " (text, jsonl, csv)" << std::endl;
+            return false;
+         }
+         continue;
+      }
+      argv[kept++] = argv[i];
+   }
+   argc = kept;
+   argv[argc] = nullptr;
+   return true;
+}
+
+// Имя выходного файла с расширением формата: "result.txt" -> "result.jsonl"
+inline std::string result_output_filename(const std::string& base, const ResultOptions& options) {
+   if (!options.structured()) return base;
+   size_t dot = base.find_last_of('.');
+   std::string stem = (dot == std::string::npos) ? base : base.substr(0, dot);
+   return stem + (options.format == ResultFormat::JsonLines ? ".jsonl" : ".csv");
+}
+
+class ResultWriter {
+public:
+   explicit ResultWriter(size_t buffer_size = size_t(1) << 20, size_t depth = 4)
+      : capacity_(buffer_size), depth_(depth) {}
+   ~ResultWriter() { close(); }
+
+   ResultWriter(const ResultWriter&) = delete;
+   ResultWriter& operator=(const ResultWriter&) = delete;
+
+   // method - имя метода (первое поле каждой записи), fields - схема записи
+   bool open(const std::string& filename, const ResultOptions& options,
+      const std::string& method, const std::vector<std::string>& fields) {
+      close();
+      file_ = std::fopen(filename.c_str(), "wb");
+      if (file_ == nullptr) return false;
+      std::setvbuf(file_, nullptr, _IONBF, 0); // буферизация - своя, блоками
+      failed_ = false;
+      json_ = options.format != ResultFormat::Csv;
+      field_count_ = fields.size();
+      records_ = 0;
+      buffer_.clear();
+      buffer_.reserve(capacity_ + 4096);
+
+      // Постоянные части записи готовятся один раз
+      prefixes_.clear();
+      if (json_) {
+         record_begin_ = "{\"method\":";
+         append_string(record_begin_, method);
+         for (const std::string& field : fields) {
+            std::string prefix = ",";
+            append_string(prefix, field);
+            prefix += ':';
+            prefixes_.push_back(prefix);
+         }
+         record_end_ = "}\n";
+      }
+      else {
+         record_begin_.clear();
+         append_string(record_begin_, method);
+         prefixes_.assign(fields.size(), ",");
+         record_end_ = "\n";
+
+         std::string header = "method";
+         for (const std::string& field : fields) {
+            header += ',';
+            append_string(header, field);
+         }
+         buffer_ += header;
+         buffer_ += '\n';
+      }
+
+      if (options.async) {
+         stopping_ = false;
+         thread_ = std::thread([this]() { drain(); });
+      }
+      return true;
+   }
+
+   bool is_open() const { return file_ != nullptr; }
+   size_t records() const { return records_; }
+
+   // Одна запись: значения полей в порядке схемы
+   template <class... Values>
+   void write(const Values&... values) {
+      if (sizeof...(Values) != field_count_) {
+         std::cerr << "ОШИБКА: число значений записи (" << sizeof...(Values)
+            << ") не совпадает со схемой (" << field_count_ << ")" << std::endl;
+         failed_ = true;
+         return;
+      }
+      buffer_ += record_begin_;
+      size_t index = 0;
+      ((buffer_ += prefixes_[index++], append_value(buffer_, values)), ...);
+      buffer_ += record_end_;
+      records_++;
+      if (buffer_.size() >= capacity_) flush_buffer();
+   }
+
+   // Сбрасывает остаток буфера и закрывает файл; false - ошибка записи
+   bool close() {
+      if (file_ == nullptr) return !failed_;
+      flush_buffer();
+      if (thread_.joinable()) {
+         {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+         }
+         changed_.notify_all();
+         thread_.join();
+      }
+      if (std::fclose(file_) != 0) failed_ = true;
+      file_ = nullptr;
+      pending_.clear();
+      spare_.clear();
+      return !failed_;
+   }
+
+private:
+   // Строка: в JSON - в кавычках с экранированием, в CSV - в кавычках,
+   // только если содержит разделитель, кавычку или перевод строки
+   void append_string(std::string& out, std::string_view text) const {
+      if (json_) {
+         out += '"';
+         for (char c : text) {
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+               if (static_cast<unsigned char>(c) < 0x20) {
+                  char code[8];
+                  std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                  out += code;
+               }
+               else {
+                  out += c;
+               }
+            }
+         }
+         out += '"';
+         return;
+      }
+      if (text.find_first_of(",\"\n\r") == std::string_view::npos) {
+         out += text;
+         return;
+      }
+      out += '"';
+      for (char c : text) {
+         if (c == '"') out += '"';
+         out += c;
+      }
+      out += '"';
+   }
+
+   template <class T>
+   void append_value(std::string& out, const T& value) const {
+      if constexpr (std::is_same<T, bool>::value) {
+         out += value ? "true" : "false";
+      }
+      else if constexpr (std::is_integral<T>::value || std::is_floating_point<T>::value) {
+         if constexpr (std::is_floating_point<T>::value) {
+            if (!std::isfinite(value)) {
+               if (json_) out += "null";
+               return;
+            }
+         }
+         char digits[32];
+         auto result = std::to_chars(digits, digits + sizeof(digits), value);
+         out.append(digits, result.ptr);
+      }
+      else {
+         append_string(out, std::string_view(value));
+      }
+   }
+
+   void write_chunk(const std::string& chunk) {
+      if (chunk.empty()) return;
+      if (std::fwrite(chunk.data(), 1, chunk.size(), file_) != chunk.size()) failed_ = true;
+   }
+
+   void flush_buffer() {
+      if (buffer_.empty()) return;
+      if (!thread_.joinable()) {
+         write_chunk(buffer_);
+         buffer_.clear();
+         return;
+      }
+
+      std::string next;
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         changed_.wait(lock, [this]() { return pending_.size() < depth_; });
+         pending_.push_back(std::move(buffer_));
+         if (!spare_.empty()) {
+            next = std::move(spare_.back());
+            spare_.pop_back();
+         }
+      }
+      changed_.notify_all();
+      buffer_ = std::move(next);
+      buffer_.clear();
+      buffer_.reserve(capacity_ + 4096);
+   }
+
+   // Поток записи: блоки пишутся по порядку, опустевшие буферы возвращаются
+   void drain() {
+      for (;;) {
+         std::string chunk;
+         {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) return;
+            chunk = std::move(pending_.front());
+            pending_.pop_front();
+         }
+         changed_.notify_all();
+         write_chunk(chunk);
+         chunk.clear();
+         std::lock_guard<std::mutex> lock(mutex_);
+         spare_.push_back(std::move(chunk));
+      }
+   }
+
+   size_t capacity_;
+   size_t depth_;
+   std::FILE* file_ = nullptr;
+   std::atomic<bool> failed_{ false };
+   bool json_ = true;
+   size_t field_count_ = 0;
+   size_t records_ = 0;
+   std::string record_begin_;
+   std::string record_end_;
+   std::vector<std::string> prefixes_;
+   std::string buffer_;
+
+   std::thread thread_;
+   std::mutex mutex_;
+   std::condition_variable changed_;
+   std::deque<std::string> pending_;
+   std::vector<std::string> spare_;
+   bool stopping_ = false;
+};
@@ -9,10 +9,20 @@
 #include <numeric>
 #include <boost/math/special_functions/erf.hpp>
 
+#include "columnar.h"
+#include "csv_reader.h"
+#include "fast_reader.h"
+#include "moments.h"
+#include "parallel_sort.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+
 using namespace std;
 
 struct ShapiroWilkConfig {
    vector<double> data;
+   vector<double> sorted_data; // упорядоченная выборка из двоичного файла (пустая - сортируется при расчете)
    double alpha = 0.05;
    string output_filename = "shapiro_wilk_results.txt";
 };
@@ -98,190 +108,176 @@ double get_critical_W_value(int n, double alpha = 0.05) {
    return 0.0;
 }
 
+/**
+* Проверка и вывод прочитанных данных
+*/
+bool check_loaded_config(const string& filename, ShapiroWilkConfig& config) {
+   if (config.data.empty()) {
+       cout << "Ошибка: файл не содержит данных" << endl;
+       return false;
+   }
+
+   if (config.alpha <= 0 || config.alpha >= 1) {
+       cout << "Предупреждение: некорректный уровень значимости. Используется 0.05." << endl;
+       config.alpha = 0.05;
+   }
+
+   cout << "Прочитано " << config.data.size() << " значений из файла " << filename << endl;
+   cout << "Уровень значимости alpha: " << config.alpha << endl;
+   cout << "Выходной файл: " << config.output_filename << endl;
+
+   return true;
+}
+
 /**
 * Функция для чтения всех данных из файла
 */
 bool read_config_from_file(const string& filename, ShapiroWilkConfig& config) {
-   ifstream infile(filename);
-   if (!infile.is_open()) {
+   STAT_PROFILE_SCOPE("read_data");
+   // Двоичный столбцовый файл (columnar.h): параметры остаются по умолчанию,
+   // столбец order (если есть) избавляет от сортировки выборки
+   if (is_columnar_file(filename)) {
+       ColumnarFile file;
+       if (!file.open(filename)) {
+           cout << "Ошибка: некорректный двоичный файл данных " << filename << endl;
+           return false;
+       }
+       ColumnSpan<double> values = file.values();
+       config.data.assign(values.begin(), values.end());
+       config.sorted_data.clear();
+       for (uint32_t i : file.order()) config.sorted_data.push_back(values[i]);
+       config.alpha = 0.05;
+       config.output_filename = "shapiro_wilk_results.txt";
+       return check_loaded_config(filename, config);
+   }
+
+   TextColumns columns;
+   if (!read_text_columns(filename, columns)) {
        cout << "Ошибка: не удалось открыть файл " << filename << endl;
        return false;
    }
 
    config.data.clear();
+   config.sorted_data.clear();
    config.alpha = 0.05;
    config.output_filename = "shapiro_wilk_results.txt";
 
-   string line;
-   int line_num = 0;
-
-   while (getline(infile, line)) {
-       line_num++;
-
-       // Удаление начальных и конечных пробелов
-       line.erase(0, line.find_first_not_of(" \t"));
-       line.erase(line.find_last_not_of(" \t") + 1);
+   // Все числа строк данных образуют выборку
+   config.data.swap(columns.values);
 
-       // Пропускаем пустые строки
-       if (line.empty()) {
-           continue;
-       }
-
-       // Пропускаем комментарии
-       if (line[0] == '#') {
-           continue;
-       }
-
-       // Проверяем секции файла
-       if (line == "[PARAMETERS]") {
-           // Пропускаем, параметры могут быть в любом месте
-           continue;
-       }
-       else if (line == "[DATA]") {
-           // Пропускаем
-           continue;
-       }
-
-       // Чтение строки
-       istringstream iss(line);
+   // Параметры могут быть в любом месте файла; секции [PARAMETERS]
+   // и [DATA] и прочие нечисловые строки пропускаются
+   for (const TextDirective& directive : columns.directives) {
+       istringstream iss(directive.text);
        string first_word;
 
        if (iss >> first_word) {
-           // Проверяем, является ли первое слово параметром
            if (first_word == "alpha" || first_word == "ALPHA") {
                double alpha_value;
                if (iss >> alpha_value) {
                    config.alpha = alpha_value;
                }
-               continue;
            }
            else if (first_word == "output" || first_word == "OUTPUT") {
                string filename_value;
                if (iss >> filename_value) {
                    config.output_filename = filename_value;
                }
-               continue;
-           }
-
-           // Если не параметр, то это данные
-           // Возвращаемся к началу строки
-           iss.clear();
-           iss.str(line);
-
-           double value;
-           while (iss >> value) {
-               config.data.push_back(value);
            }
        }
    }
 
-   infile.close();
-
-   if (config.data.empty()) {
-       cout << "Ошибка: файл не содержит данных" << endl;
-       return false;
-   }
-
-   if (config.alpha <= 0 || config.alpha >= 1) {
-       cout << "Предупреждение: некорректный уровень значимости. Используется 0.05." << endl;
-       config.alpha = 0.05;
-   }
-
-   cout << "Прочитано " << config.data.size() << " значений из файла " << filename << endl;
-   cout << "Уровень значимости alpha: " << config.alpha << endl;
-   cout << "Выходной файл: " << config.output_filename << endl;
-
-   return true;
+   return check_loaded_config(filename, config);
 }
 
 
 //Функция для записи результатов в файл
 
-void write_results_to_file(const ShapiroWilkConfig& config,
+bool write_results_to_file(const ShapiroWilkConfig& config,
    const vector<double>& sorted_data,
    double W_statistic,
    double W_critical,
-   bool hypothesis_accepted) {
+   bool hypothesis_accepted,
+   ostream& console) {
+   STAT_PROFILE_SCOPE("write_report");
 
    ofstream outfile(config.output_filename);
    if (!outfile.is_open()) {
-       cout << "Ошибка: не удалось создать файл " << config.output_filename << endl;
-       return;
+       console << "Ошибка: не удалось создать файл " << config.output_filename << endl;
+       return false;
    }
 
    outfile << fixed << setprecision(6);
 
-   outfile << "=== РЕЗУЛЬТАТЫ КРИТЕРИЯ ШАПИРО-УИЛКА ===" << endl << endl;
+   outfile << "=== РЕЗУЛЬТАТЫ КРИТЕРИЯ ШАПИРО-УИЛКА ===" << '\n' << '\n';
 
    // Исходные данные
-   outfile << "ИСХОДНЫЕ ДАННЫЕ:" << endl;
-   outfile << "Входной файл: shapiro_wilk_input.txt" << endl;
-   outfile << "Уровень значимости (alpha): " << config.alpha << endl;
-   outfile << "Объем выборки (n): " << config.data.size() << endl << endl;
+   outfile << "ИСХОДНЫЕ ДАННЫЕ:" << '\n';
+   outfile << "Входной файл: shapiro_wilk_input.txt" << '\n';
+   outfile << "Уровень значимости (alpha): " << config.alpha << '\n';
+   outfile << "Объем выборки (n): " << config.data.size() << '\n' << '\n';
 
-   outfile << "Исходные значения:" << endl;
-   outfile << setw(10) << "номер" << setw(15) << "Значение" << endl;
-   outfile << string(25, '-') << endl;
+   outfile << "Исходные значения:" << '\n';
+   outfile << setw(10) << "номер" << setw(15) << "Значение" << '\n';
+   outfile << string(25, '-') << '\n';
 
    for (size_t i = 0; i < config.data.size(); i++) {
-       outfile << setw(10) << i + 1 << setw(15) << config.data[i] << endl;
+       outfile << setw(10) << i + 1 << setw(15) << config.data[i] << '\n';
    }
-   outfile << endl;
+   outfile << '\n';
 
    // Отсортированные данные
-   outfile << "Отсортированные значения:" << endl;
-   outfile << setw(10) << "номер" << setw(15) << "Значение" << endl;
-   outfile << string(25, '-') << endl;
+   outfile << "Отсортированные значения:" << '\n';
+   outfile << setw(10) << "номер" << setw(15) << "Значение" << '\n';
+   outfile << string(25, '-') << '\n';
 
    for (size_t i = 0; i < sorted_data.size(); i++) {
-       outfile << setw(10) << i + 1 << setw(15) << sorted_data[i] << endl;
+       outfile << setw(10) << i + 1 << setw(15) << sorted_data[i] << '\n';
    }
-   outfile << endl;
+   outfile << '\n';
 
    // Результаты вычислений
-   outfile << "РЕЗУЛЬТАТЫ ВЫЧИСЛЕНИЙ:" << endl;
-   outfile << "Объем выборки (n): " << config.data.size() << endl;
-   outfile << "Статистика W: " << W_statistic << endl;
-   outfile << "Критическое значение W: " << W_critical << endl << endl;
+   outfile << "РЕЗУЛЬТАТЫ ВЫЧИСЛЕНИЙ:" << '\n';
+   outfile << "Объем выборки (n): " << config.data.size() << '\n';
+   outfile << "Статистика W: " << W_statistic << '\n';
+   outfile << "Критическое значение W: " << W_critical << '\n' << '\n';
 
    // Вывод о гипотезе
-   outfile << "ГИПОТЕЗА:" << endl;
-   outfile << "H0: Выборка происходит из нормально распределенной генеральной совокупности" << endl;
-   outfile << "H1: Выборка не происходит из нормально распределенной генеральной совокупности" << endl << endl;
+   outfile << "ГИПОТЕЗА:" << '\n';
+   outfile << "H0: Выборка происходит из нормально распределенной генеральной совокупности" << '\n';
+   outfile << "H1: Выборка не происходит из нормально распределенной генеральной совокупности" << '\n' << '\n';
 
-   outfile << "ВЫВОД:" << endl;
+   outfile << "ВЫВОД:" << '\n';
    if (hypothesis_accepted) {
-       outfile << "Нулевая гипотеза о нормальности распределения ПРИНЯТА." << endl;
-       outfile << "(W = " << W_statistic << " >= " << W_critical << ")" << endl;
-       outfile << "Выборка может считаться происходящей из нормального распределения." << endl;
+       outfile << "Нулевая гипотеза о нормальности распределения ПРИНЯТА." << '\n';
+       outfile << "(W = " << W_statistic << " >= " << W_critical << ")" << '\n';
+       outfile << "Выборка может считаться происходящей из нормального распределения." << '\n';
    }
    else {
-       outfile << "Нулевая гипотеза о нормальности распределения ОТВЕРГНУТА." << endl;
-       outfile << "(W = " << W_statistic << " < " << W_critical << ")" << endl;
-       outfile << "Выборка не происходит из нормального распределения." << endl;
+       outfile << "Нулевая гипотеза о нормальности распределения ОТВЕРГНУТА." << '\n';
+       outfile << "(W = " << W_statistic << " < " << W_critical << ")" << '\n';
+       outfile << "Выборка не происходит из нормального распределения." << '\n';
    }
 
    // Дополнительная информация
-   outfile << endl << "ДОПОЛНИТЕЛЬНАЯ ИНФОРМАЦИЯ:" << endl;
-   outfile << "- Критерий Шапиро-Уилка наиболее мощный для n ≤ 50" << endl;
-   outfile << "- Для n > 50 рекомендуется использовать другие критерии" << endl;
-   outfile << "- Критерий чувствителен к отклонениям в хвостах распределения" << endl;
+   outfile << '\n' << "ДОПОЛНИТЕЛЬНАЯ ИНФОРМАЦИЯ:" << '\n';
+   outfile << "- Критерий Шапиро-Уилка наиболее мощный для n ≤ 50" << '\n';
+   outfile << "- Для n > 50 рекомендуется использовать другие критерии" << '\n';
+   outfile << "- Критерий чувствителен к отклонениям в хвостах распределения" << '\n';
 
-   outfile << endl << "======================================" << endl;
-   outfile << "Критерий Шапиро-Уилка выполнен успешно." << endl;
+   outfile << '\n' << "======================================" << '\n';
+   outfile << "Критерий Шапиро-Уилка выполнен успешно." << '\n';
 
    outfile.close();
-   cout << "Результаты сохранены в файл: " << config.output_filename << endl;
+   console << "Результаты сохранены в файл: " << config.output_filename << endl;
+   return true;
 }
 
 
-// Функция для вычисления статистики Шапиро-Уилка
-double calculate_shapiro_wilk_statistic(const vector<double>& data) {
-   int n = data.size();
-
-   // Сортируем данные
-   vector<double> sorted_data = data;
-   sort(sorted_data.begin(), sorted_data.end());
+// Функция для вычисления статистики Шапиро-Уилка по упорядоченной выборке
+double calculate_shapiro_wilk_statistic(const vector<double>& sorted_data) {
+   STAT_PROFILE_SCOPE("shapiro_wilk_statistic");
+   int n = sorted_data.size();
 
    // Получаем коэффициенты
    vector<double> a = get_shapiro_wilk_coefficients(n);
@@ -305,11 +301,7 @@ double calculate_shapiro_wilk_statistic(const vector<double>& data) {
    }
 
    // Вычисляем s² (формула 3.18)
-   double mean = accumulate(sorted_data.begin(), sorted_data.end(), 0.0) / n;
-   double s2 = 0.0;
-   for (double x : sorted_data) {
-       s2 += (x - mean) * (x - mean);
-   }
+   double s2 = compute_moments(sorted_data).m2;
 
    // Вычисляем W (формула 3.17)
    if (s2 == 0.0) {
@@ -320,56 +312,152 @@ double calculate_shapiro_wilk_statistic(const vector<double>& data) {
    return W;
 }
 
-// Основная функция для выполнения критерия Шапиро-Уилка
+// Итоги критерия для машиночитаемого вывода (result_writer.h)
+struct ShapiroWilkSummary {
+   size_t n = 0;
+   double W_statistic = NAN;
+   double W_critical = NAN;
+   bool hypothesis_accepted = false;
+};
+
+// Расчет критерия без вывода; sorted_data - упорядоченная выборка
+ShapiroWilkSummary shapiro_wilk_summary(const ShapiroWilkConfig& config, vector<double>& sorted_data) {
+   ShapiroWilkSummary summary;
+   summary.n = config.data.size();
+   if (summary.n < 3) return summary;
+
+   // Сортируем данные один раз, если порядок не сохранен в двоичном файле
+   sorted_data = config.sorted_data;
+   if (sorted_data.empty()) {
+       sorted_data = config.data;
+       STAT_PROFILE_COUNT("sort_size", sorted_data.size());
+       parallel_sort(sorted_data);
+   }
+
+   // Вычисляем статистику W
+   summary.W_statistic = calculate_shapiro_wilk_statistic(sorted_data);
+
+   // Получаем критическое значение
+   summary.W_critical = get_critical_W_value(summary.n, config.alpha);
+
+   // Проверяем гипотезу
+   summary.hypothesis_accepted = (summary.W_statistic >= summary.W_critical);
+   return summary;
+}
+
+// Запись итогов в формате JSON Lines или CSV: по записи на выборку
+bool write_shapiro_wilk_records(const string& filename, const ResultOptions& options, double alpha,
+   const vector<string>& samples, const vector<size_t>& missing, const vector<ShapiroWilkSummary>& summaries) {
+   ResultWriter writer;
+   if (!writer.open(filename, options, "shapiro_wilk",
+       { "sample", "n", "missing", "w", "w_critical", "alpha", "normal" })) {
+       cerr << "Ошибка: не удалось создать файл " << filename << endl;
+       return false;
+   }
+   for (size_t i = 0; i < summaries.size(); i++) {
+       const ShapiroWilkSummary& s = summaries[i];
+       writer.write(samples[i], s.n, missing[i], s.W_statistic, s.W_critical, alpha, s.hypothesis_accepted);
+   }
+   if (!writer.close()) {
+       cerr << "Ошибка записи в файл " << filename << endl;
+       return false;
+   }
+   return true;
+}
 
-bool shapiro_wilk_test(const ShapiroWilkConfig& config) {
+// Основная функция для выполнения критерия Шапиро-Уилка;
+// true - результаты записаны в config.output_filename
+
+bool shapiro_wilk_test(const ShapiroWilkConfig& config, ostream& console = cout) {
    int n = config.data.size();
 
    if (n < 3) {
-       cout << "Ошибка: для критерия Шапиро-Уилка необходимо минимум 3 наблюдения" << endl;
+       console << "Ошибка: для критерия Шапиро-Уилка необходимо минимум 3 наблюдения" << endl;
        return false;
    }
 
    if (n > 5000) {
-       cout << "Предупреждение: критерий Шапиро-Уилка рекомендуется для n ≤ 50" << endl;
+       console << "Предупреждение: критерий Шапиро-Уилка рекомендуется для n ≤ 50" << endl;
    }
 
-   // Вычисляем статистику W
-   double W_statistic = calculate_shapiro_wilk_statistic(config.data);
-
-   // Получаем критическое значение
-   double W_critical = get_critical_W_value(n, config.alpha);
-
-   // Проверяем гипотезу
-   bool hypothesis_accepted = (W_statistic >= W_critical);
-
-   // Сортируем данные для вывода
-   vector<double> sorted_data = config.data;
-   sort(sorted_data.begin(), sorted_data.end());
+   vector<double> sorted_data;
+   ShapiroWilkSummary summary = shapiro_wilk_summary(config, sorted_data);
+   double W_statistic = summary.W_statistic;
+   double W_critical = summary.W_critical;
+   bool hypothesis_accepted = summary.hypothesis_accepted;
 
    // Вывод в консоль
-   cout << fixed << setprecision(6);
-   cout << "=== Результаты критерия Шапиро-Уилка ===" << endl;
-   cout << "Объем выборки (n): " << n << endl;
-   cout << "Статистика W: " << W_statistic << endl;
-   cout << "Критическое значение W: " << W_critical << endl;
-   cout << "Уровень значимости (alpha): " << config.alpha << endl;
+   console << fixed << setprecision(6);
+   console << "=== Результаты критерия Шапиро-Уилка ===" << endl;
+   console << "Объем выборки (n): " << n << endl;
+   console << "Статистика W: " << W_statistic << endl;
+   console << "Критическое значение W: " << W_critical << endl;
+   console << "Уровень значимости (alpha): " << config.alpha << endl;
 
    if (hypothesis_accepted) {
-       cout << "Вывод: Нулевая гипотеза о нормальности ПРИНИМАЕТСЯ" << endl;
+       console << "Вывод: Нулевая гипотеза о нормальности ПРИНИМАЕТСЯ" << endl;
    }
    else {
-       cout << "Вывод: Нулевая гипотеза о нормальности ОТВЕРГАЕТСЯ" << endl;
+       console << "Вывод: Нулевая гипотеза о нормальности ОТВЕРГАЕТСЯ" << endl;
    }
 
    // Запись в файл
-   write_results_to_file(config, sorted_data, W_statistic,
-       W_critical, hypothesis_accepted);
-
-   return hypothesis_accepted;
+   return write_results_to_file(config, sorted_data, W_statistic,
+       W_critical, hypothesis_accepted, console);
 }
 
 
+// Проверка нескольких столбцов CSV/TSV-файла за один проход по файлу.
+// Столбцы проверяются параллельно; вывод каждого столбца собирается
+// отдельно и печатается по порядку, результаты - в файлы <output>_<столбец>
+// (при --format jsonl|csv - все столбцы в один файл).
+int run_csv_columns(const string& filename, const vector<string>& names, const ResultOptions& result_options) {
+   CsvSelection selection;
+   if (!read_csv_columns(filename, names, selection)) {
+       return 1;
+   }
+   cout << "Прочитано " << selection.rows << " строк из файла " << filename << endl;
+
+   if (result_options.structured()) {
+       ShapiroWilkConfig defaults;
+       vector<ShapiroWilkSummary> summaries(names.size());
+       parallel_for(names.size(), 1, [&](size_t first, size_t last) {
+           for (size_t c = first; c < last; c++) {
+               ShapiroWilkConfig config;
+               config.data.swap(selection.columns[c]);
+               vector<double> sorted_data;
+               summaries[c] = shapiro_wilk_summary(config, sorted_data);
+           }
+       });
+       string output_filename = result_output_filename(defaults.output_filename, result_options);
+       if (!write_shapiro_wilk_records(output_filename, result_options, defaults.alpha,
+           names, selection.missing, summaries)) {
+           return 1;
+       }
+       cout << "Результаты сохранены в файл: " << output_filename << endl;
+       return 0;
+   }
+
+   vector<string> reports(names.size());
+   parallel_for(names.size(), 1, [&](size_t first, size_t last) {
+       for (size_t c = first; c < last; c++) {
+           ShapiroWilkConfig config;
+           config.data.swap(selection.columns[c]);
+           config.output_filename = csv_output_filename(config.output_filename, names[c]);
+
+           ostringstream console;
+           console << endl << "Столбец " << names[c] << " (пропусков: " << selection.missing[c] << ")" << endl;
+           shapiro_wilk_test(config, console);
+           reports[c] = console.str();
+       }
+   });
+
+   for (const string& report : reports) {
+       cout << report;
+   }
+   return 0;
+}
+
 //Функция для создания файла с примером формата данных
 
 void create_example_config_file() {
@@ -379,40 +467,68 @@ void create_example_config_file() {
        return;
    }
 
-   outfile << "# Пример файла данных для критерия Шапиро-Уилка" << endl;
-   outfile << "# Проверка нормальности распределения" << endl;
-   outfile << endl;
-
-   outfile << "# Параметры теста" << endl;
-   outfile << "alpha 0.05" << endl;
-   outfile << "output shapiro_wilk_results.txt" << endl;
-   outfile << endl;
-
-   outfile << "# Данные для теста (пример нормально распределенных данных)" << endl;
-   outfile << "# Среднее = 100, стандартное отклонение = 15" << endl;
-   outfile << "85.2" << endl;
-   outfile << "92.7" << endl;
-   outfile << "97.3" << endl;
-   outfile << "101.8" << endl;
-   outfile << "103.5" << endl;
-   outfile << "105.9" << endl;
-   outfile << "109.2" << endl;
-   outfile << "112.4" << endl;
-   outfile << "115.7" << endl;
-   outfile << "118.3" << endl;
+   outfile << "# Пример файла данных для критерия Шапиро-Уилка" << '\n';
+   outfile << "# Проверка нормальности распределения" << '\n';
+   outfile << '\n';
+
+   outfile << "# Параметры теста" << '\n';
+   outfile << "alpha 0.05" << '\n';
+   outfile << "output shapiro_wilk_results.txt" << '\n';
+   outfile << '\n';
+
+   outfile << "# Данные для теста (пример нормально распределенных данных)" << '\n';
+   outfile << "# Среднее = 100, стандартное отклонение = 15" << '\n';
+   outfile << "85.2" << '\n';
+   outfile << "92.7" << '\n';
+   outfile << "97.3" << '\n';
+   outfile << "101.8" << '\n';
+   outfile << "103.5" << '\n';
+   outfile << "105.9" << '\n';
+   outfile << "109.2" << '\n';
+   outfile << "112.4" << '\n';
+   outfile << "115.7" << '\n';
+   outfile << "118.3" << '\n';
 
    outfile.close();
    cout << "Создан примерный файл конфигурации: example_shapiro_wilk.txt" << endl;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
    setlocale(LC_ALL, "rus");
    // Имя входного файла
    string input_filename = "shapiro_wilk_input.txt";
 
+   // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+   ResultOptions result_options;
+   if (!take_result_options(argc, argv, result_options)) return 1;
+
+   // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+   ResultCacheOptions cache_options;
+   if (!take_cache_options(argc, argv, cache_options)) return 1;
+
+   // Другой входной файл (текстовый или двоичный): --input <файл>
+   if (argc > 2 && string(argv[1]) == "--input") input_filename = argv[2];
+
    cout << "Программа для вычисления критерия Шапиро-Уилка" << endl;
    cout << "==============================================" << endl;
 
+   // Столбцы CSV/TSV-файла с заголовком: --csv <файл> <столбец> [<столбец> ...]
+   if (argc > 1 && string(argv[1]) == "--csv") {
+       if (argc < 4) {
+           cout << "Использование: " << argv[0] << " --csv <файл> <столбец> [<столбец> ...]"
+               << " [--format jsonl|csv] [--async-output]" << endl;
+           return 1;
+       }
+       return run_csv_columns(argv[2], vector<string>(argv + 3, argv + argc), result_options);
+   }
+
+   // Тот же файл с теми же параметрами - результат из кэша
+   ResultCache cache(cache_options, "shapiro_wilk");
+   cache.add_file(input_filename);
+   cache.add("format", static_cast<int>(result_options.format));
+   cache.add_arguments(argc, argv);
+   if (cache.replay()) return 0;
+
    // Проверяем существование входного файла
    ifstream test_file(input_filename);
    if (!test_file.good()) {
@@ -452,7 +568,19 @@ int main() {
 
    // Выполнение критерия Шапиро-Уилка
    cout << endl;
-   shapiro_wilk_test(config);
+   if (result_options.structured()) {
+       vector<double> sorted_data;
+       ShapiroWilkSummary summary = shapiro_wilk_summary(config, sorted_data);
+       string output_filename = result_output_filename(config.output_filename, result_options);
+       if (!write_shapiro_wilk_records(output_filename, result_options, config.alpha,
+           { input_filename }, { 0 }, { summary })) {
+           return 1;
+       }
+       cout << "Результаты сохранены в файл: " << output_filename << endl;
+       cache.store({ output_filename });
+       return 0;
+   }
+   if (shapiro_wilk_test(config)) cache.store({ config.output_filename });
 
    return 0;
 }
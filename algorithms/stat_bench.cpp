@@ -0,0 +1,580 @@
+// Микробенчмарки вычислительных ядер утилит.
+//
+// Ядра берутся из исходных файлов программ без копирования: каждый файл
+// включается в собственное пространство имен, его main переименовывается.
+// Для каждого ядра и размера входа данные готовятся заранее (вне замера),
+// затем ядро вызывается, пока суммарное время не превысит --min-time.
+// Выводятся время вызова, время на элемент, пропускная способность и число
+// и объем выделений памяти на вызов (оператор new подсчитывается). Каждый
+// вызов выполняется в своей ArenaScope (arena.h), как задание в программе.
+//
+// Использование:
+//   stat_bench [--max-size N] [--sizes N,N,...] [--min-time сек] [--filter подстрока]
+//              [--format jsonl|csv] [файл_результатов]
+//
+// Размеры по умолчанию: 10, 100, ..., --max-size (по умолчанию 10^6, не более 10^8).
+// У медленных ядер (функции Boost, квадратичные алгоритмы, MleastSquare)
+// свой предел размера.
+// Результаты (по умолчанию stat_bench_results.jsonl) сохраняются через
+// result_writer.h: файлы разных сборок сравниваются по полям kernel и size.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/math/distributions/binomial.hpp>
+#include <boost/math/distributions/chi_squared.hpp>
+#include <boost/math/distributions/fisher_f.hpp>
+#include <boost/math/distributions/non_central_chi_squared.hpp>
+#include <boost/math/distributions/non_central_f.hpp>
+#include <boost/math/distributions/non_central_t.hpp>
+#include <boost/math/distributions/normal.hpp>
+#include <boost/math/distributions/students_t.hpp>
+#include <boost/math/special_functions/erf.hpp>
+
+// Заголовки включаются здесь, до исходных файлов программ: благодаря
+// #pragma once и стражам включения они не попадут внутрь пространств имен ниже
+#include "ab_batch.h"
+#include "arena.h"
+#include "autodiff.h"
+#include "censored_data.h"
+#include "columnar.h"
+#include "csv_reader.h"
+#include "fast_reader.h"
+#include "fit_state.h"
+#include "location_scale.h"
+#include "matrix.h"
+#include "moments.h"
+#include "nelder_mead.h"
+#include "parallel_sort.h"
+#include "profiler.h"
+#include "resampling.h"
+#include "result_cache.h"
+#include "result_writer.h"
+#include "stream_moments.h"
+#include "xxhash.h"
+
+#define main kruskal_main
+namespace bench_kruskal {
+#include "kruskal_w.cpp"
+}
+#undef main
+
+#define main wilcoxon_main
+namespace bench_wilcoxon {
+#include "wilcoxon.cpp"
+}
+#undef main
+
+#define main shapiro_main
+namespace bench_shapiro {
+#include "shapiro.cpp"
+}
+#undef main
+
+#define main student_main
+namespace bench_student {
+#include "student.cpp"
+}
+#undef main
+
+// В kruskal_w.cpp и student.cpp распределения Boost используются без
+// квалификации (using namespace boost::math), поэтому <random> с одноименными
+// std::normal_distribution и др. подключается только после них
+#include <random>
+
+#define main normal_main
+namespace bench_normal {
+#include "normal.cpp"
+}
+#undef main
+
+#define main weibul_main
+namespace bench_weibul {
+#include "weibul.cpp"
+}
+#undef main
+
+#define main mnk_main
+namespace bench_mnk {
+#include "mnk.cpp"
+}
+#undef main
+
+using namespace std;
+
+// ========== ПОДСЧЕТ ВЫДЕЛЕНИЙ ПАМЯТИ ==========
+
+atomic<size_t> bench_allocations{ 0 };
+atomic<size_t> bench_allocated_bytes{ 0 };
+
+void* operator new(size_t size) {
+   bench_allocations.fetch_add(1, memory_order_relaxed);
+   bench_allocated_bytes.fetch_add(size, memory_order_relaxed);
+   if (void* p = malloc(size > 0 ? size : 1)) return p;
+   throw bad_alloc();
+}
+
+// Формы new и delete для массивов по стандарту обращаются к этим; delete
+// с размером заменяется вместе с обычным (-Wsized-deallocation). GCC после
+// встраивания видит free для памяти из operator new и предупреждает, хотя
+// operator new здесь же выделяет ее через malloc.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept {
+   free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+   free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// ========== ЯДРА ==========
+
+// Один вызов ядра; возвращает значение, зависящее от результата,
+// чтобы компилятор не выбросил вычисления
+typedef function<double()> BenchRun;
+
+struct BenchKernel {
+   const char* name;
+   size_t max_size;     // предел размера для ядра (0 - без предела)
+   bool reads_file;     // ядро читает файл: пропускная способность и в МБ/с
+   // Подготовка данных размера n; input_bytes - объем читаемого файла
+   function<BenchRun(size_t n, mt19937_64& rng, size_t& input_bytes)> setup;
+};
+
+const char* bench_text_file = "stat_bench_input.txt";
+const char* bench_csv_file = "stat_bench_input.csv";
+const char* bench_columnar_file = "stat_bench_input.scol";
+
+vector<double> bench_normal_sample(size_t n, mt19937_64& rng, double mean = 10.0, double sd = 2.0) {
+   normal_distribution<double> dist(mean, sd);
+   vector<double> x(n);
+   for (double& v : x) v = dist(rng);
+   return x;
+}
+
+vector<double> bench_probabilities(size_t n, mt19937_64& rng) {
+   uniform_real_distribution<double> dist(1e-6, 1.0 - 1e-6);
+   vector<double> p(n);
+   for (double& v : p) v = dist(rng);
+   return p;
+}
+
+// Цензурированная выборка для функций ММП: около 10% наблюдений цензурировано
+template <class Nesm>
+void bench_fill_censored(Nesm& nesm, vector<double> x, mt19937_64& rng) {
+   bernoulli_distribution censored(0.1);
+   nesm.n = static_cast<int>(x.size());
+   nesm.x = move(x);
+   nesm.r.assign(nesm.x.size(), 0);
+   for (int& r : nesm.r) r = censored(rng) ? 1 : 0;
+}
+
+size_t bench_file_size(const string& filename) {
+   ifstream file(filename, ios::binary | ios::ate);
+   return file ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+// Поэлементное ядро: сумма f(x[i]) по заранее подготовленным аргументам
+template <class F>
+BenchRun bench_map(vector<double> x, F f) {
+   return [x, f]() {
+      double sum = 0.0;
+      for (double v : x) sum += f(v);
+      return sum;
+   };
+}
+
+vector<BenchKernel> bench_kernels() {
+   vector<BenchKernel> kernels;
+
+   kernels.push_back({ "norm_cdf", 0, false, [](size_t n, mt19937_64& rng, size_t&) {
+      return bench_map(bench_normal_sample(n, rng, 0.0, 1.5), [](double x) { return bench_normal::norm_cdf(x); });
+   } });
+   kernels.push_back({ "norm_ppf", 0, false, [](size_t n, mt19937_64& rng, size_t&) {
+      return bench_map(bench_probabilities(n, rng), [](double p) { return bench_normal::norm_ppf(p); });
+   } });
+   kernels.push_back({ "boost_norm_cdf", 0, false, [](size_t n, mt19937_64& rng, size_t&) {
+      return bench_map(bench_normal_sample(n, rng, 0.0, 1.5), [](double x) { return bench_student::norm_cdf(x); });
+   } });
+   kernels.push_back({ "boost_norm_ppf", 0, false, [](size_t n, mt19937_64& rng, size_t&) {
+      return bench_map(bench_probabilities(n, rng), [](double p) { return bench_student::norm_ppf(p); });
+   } });
+   // Функции t- и F-распределений Boost на порядки медленнее нормального,
+   // поэтому размер для них ограничен
+   kernels.push_back({ "boost_t_cdf", 100000, false, [](size_t n, mt19937_64& rng, size_t&) {
+      return bench_map(bench_normal_sample(n, rng, 0.0, 2.0), [](double x) { return bench_student::t_cdf(x, 10.0); });
+   } });
+   kernels.push_back({ "boost_t_ppf", 100000, false, [](size_t n, mt19937_64& rng, size_t&) {
+      return bench_map(bench_probabilities(n, rng), [](double p) { return bench_student::t_ppf(p, 10.0); });
+   } });
+   kernels.push_back({ "boost_f_ppf", 10000, false, [](size_t n, mt19937_64& rng, size_t&) {
+      return bench_map(bench_probabilities(n, rng), [](double p) { return bench_student::f_ppf(p, 5.0, 10.0); });
+   } });
+
+   kernels.push_back({ "NormalMinFunction", 0, false, [](size_t n, mt19937_64& rng, size_t&) -> BenchRun {
+      bench_fill_censored(bench_normal::nesm, bench_normal_sample(n, rng), rng);
+      return []() {
+         const double params[] = { 10.1, 1.9 };
+         return bench_normal::NormalMinFunction(params);
+      };
+   } });
+   kernels.push_back({ "WeibullMinFunction", 0, false, [](size_t n, mt19937_64& rng, size_t&) -> BenchRun {
+      weibull_distribution<double> dist(2.0, 10.0);
+      vector<double> x(n);
+      for (double& v : x) v = dist(rng);
+      bench_fill_censored(bench_weibul::nesm, move(x), rng);
+      return []() {
+         const double params[] = { 1.9 };
+         return bench_weibul::WeibullMinFunction(params);
+      };
+   } });
+   // Полная минимизация: сотни вычислений функции правдоподобия
+   kernels.push_back({ "neldermead_normal", 100000, false, [](size_t n, mt19937_64& rng, size_t&) -> BenchRun {
+      bench_fill_censored(bench_normal::nesm, bench_normal_sample(n, rng), rng);
+      return []() {
+         array<double, 2> params = { 9.0, 3.0 };
+         NelderMeadResult r = nelder_mead(params, [](const double* x) { return bench_normal::NormalMinFunction(x); });
+         return params[0] + params[1] + r.iterations;
+      };
+   } });
+   kernels.push_back({ "MleastSquare", 0, false, [](size_t n, mt19937_64& rng, size_t&) -> BenchRun {
+      const int k = 2;
+      vector<double> sorted_data = bench_normal_sample(n, rng);
+      sort(sorted_data.begin(), sorted_data.end());
+      vector<double> expectations = bench_mnk::calculateNormalOrderStatisticsExpectations(static_cast<int>(n));
+      // Данные живут дольше ArenaScope вызовов: память из кучи
+      auto x = make_shared<Matrix<>>(n, k, pmr::new_delete_resource());
+      auto y = make_shared<Matrix<>>(n, 1, pmr::new_delete_resource());
+      for (size_t i = 0; i < n; i++) {
+         (*x)(i, 0) = 1.0;
+         (*x)(i, 1) = expectations[i];
+         (*y)(i, 0) = sorted_data[i];
+      }
+      return [n, x, y]() {
+         Matrix<> db, b, yr;
+         bench_mnk::MleastSquare(*x, *y, db, b, yr);
+         return b(0, 0) + b(1, 0) + yr(n - 1, 0);
+      };
+   } });
+
+   // Данные копируются при каждом вызове, как в программах (копия и сортировка)
+   kernels.push_back({ "parallel_sort", 0, false, [](size_t n, mt19937_64& rng, size_t&) -> BenchRun {
+      vector<double> values = bench_normal_sample(n, rng);
+      return [values]() {
+         vector<double> sorted = values;
+         parallel_sort(sorted);
+         return sorted.front() + sorted.back();
+      };
+   } });
+   kernels.push_back({ "calculate_ranks", 0, false, [](size_t n, mt19937_64& rng, size_t&) -> BenchRun {
+      // Округление дает связки, как в реальных данных
+      vector<double> values = bench_normal_sample(n, rng);
+      for (double& v : values) v = round(v * 100.0) / 100.0;
+      return [values]() {
+         pmr::vector<double> ranks = bench_kruskal::calculate_ranks(values);
+         return ranks.front() + ranks.back();
+      };
+   } });
+   // Через средние ранги объединенной выборки: одна сортировка
+   kernels.push_back({ "compute_u_statistic", 0, false, [](size_t n, mt19937_64& rng, size_t&) -> BenchRun {
+      vector<double> sample1 = bench_normal_sample(n / 2, rng);
+      vector<double> sample2 = bench_normal_sample(n - n / 2, rng, 10.5);
+      return [sample1, sample2]() { return bench_wilcoxon::compute_u_statistic(sample1, sample2); };
+   } });
+   // Размер - длина распределения U: m = n = sqrt(size), сложность size^1.5
+   kernels.push_back({ "udist", 1000000, false, [](size_t n, mt19937_64&, size_t&) -> BenchRun {
+      int m = max(1, static_cast<int>(sqrt(static_cast<double>(n))));
+      return [m]() {
+         int mn1 = m * m + 1;
+         vector<double> frequency(mn1);
+         vector<double> work((mn1 + 1) / 2 + m);
+         int fault = 0;
+         bench_wilcoxon::udist(m, m, frequency, work, fault);
+         return frequency[mn1 / 2] + fault;
+      };
+   } });
+   kernels.push_back({ "shapiro_wilk_statistic", 0, false, [](size_t n, mt19937_64& rng, size_t&) -> BenchRun {
+      vector<double> sorted_data = bench_normal_sample(max<size_t>(n, 3), rng);
+      sort(sorted_data.begin(), sorted_data.end());
+      return [sorted_data]() { return bench_shapiro::calculate_shapiro_wilk_statistic(sorted_data); };
+   } });
+
+   // Чтение файлов: одно значение на строку, CSV из трех столбцов (читается
+   // один) и двоичный столбцовый формат с признаком цензурирования
+   kernels.push_back({ "read_text_columns", 0, true, [](size_t n, mt19937_64& rng, size_t& input_bytes) -> BenchRun {
+      {
+         vector<double> x = bench_normal_sample(n, rng);
+         ofstream file(bench_text_file, ios::binary);
+         file << setprecision(10);
+         for (double v : x) file << v << '\n';
+      }
+      input_bytes = bench_file_size(bench_text_file);
+      return []() {
+         TextColumns columns;
+         read_text_columns(bench_text_file, columns);
+         return static_cast<double>(columns.values.size());
+      };
+   } });
+   kernels.push_back({ "read_csv_columns", 0, true, [](size_t n, mt19937_64& rng, size_t& input_bytes) -> BenchRun {
+      {
+         vector<double> x = bench_normal_sample(n, rng);
+         ofstream file(bench_csv_file, ios::binary);
+         file << setprecision(10) << "id,value,group\n";
+         for (size_t i = 0; i < n; i++) file << i << ',' << x[i] << ',' << (i % 7) << '\n';
+      }
+      input_bytes = bench_file_size(bench_csv_file);
+      return []() {
+         CsvSelection selection;
+         read_csv_columns(bench_csv_file, { "value" }, selection);
+         return static_cast<double>(selection.columns[0].size());
+      };
+   } });
+   kernels.push_back({ "columnar_scan", 0, true, [](size_t n, mt19937_64& rng, size_t& input_bytes) -> BenchRun {
+      {
+         ColumnarData data;
+         data.values = bench_normal_sample(n, rng);
+         data.censor.assign(n, 0);
+         data.source = "stat_bench";
+         write_columnar_file(bench_columnar_file, data);
+      }
+      input_bytes = bench_file_size(bench_columnar_file);
+      return []() {
+         ColumnarFile file;
+         if (!file.open(bench_columnar_file)) return 0.0;
+         double sum = 0.0;
+         for (double v : file.values()) sum += v;
+         return sum;
+      };
+   } });
+
+   return kernels;
+}
+
+// ========== ЗАМЕР ==========
+
+struct BenchResult {
+   string kernel;
+   size_t size = 0;
+   size_t repetitions = 0;
+   double ns_per_op = 0.0;
+   double ns_per_element = 0.0;
+   double elements_per_second = 0.0;
+   size_t input_bytes = 0;
+   double megabytes_per_second = numeric_limits<double>::quiet_NaN();
+   double allocations_per_op = 0.0;
+   double allocated_bytes_per_op = 0.0;
+   double checksum = 0.0;
+};
+
+volatile double bench_sink = 0.0;
+
+BenchResult run_kernel(const BenchKernel& kernel, size_t n, double min_time) {
+   typedef chrono::steady_clock clock;
+   BenchResult result;
+   result.kernel = kernel.name;
+   result.size = n;
+
+   mt19937_64 rng(20240531 + n);
+   BenchRun run = kernel.setup(n, rng, result.input_bytes);
+
+   // Вызов ядра - отдельное задание: временные массивы из арены потока
+   // освобождаются после каждого вызова
+   auto call = [&run]() {
+      ArenaScope arena_scope;
+      return run();
+   };
+
+   // Первый (прогревочный) вызов оценивает число повторов, по второму
+   // считаются выделения памяти в установившемся режиме (арена уже выросла)
+   clock::time_point start = clock::now();
+   result.checksum = call();
+   double first = chrono::duration<double>(clock::now() - start).count();
+   size_t allocations = bench_allocations.load();
+   size_t bytes = bench_allocated_bytes.load();
+   call();
+   result.allocations_per_op = static_cast<double>(bench_allocations.load() - allocations);
+   result.allocated_bytes_per_op = static_cast<double>(bench_allocated_bytes.load() - bytes);
+
+   size_t repetitions = static_cast<size_t>(min_time / max(first, 1e-9));
+   repetitions = max<size_t>(1, min<size_t>(repetitions, 100000000));
+   double total = 0.0;
+   while (total < min_time) {
+      start = clock::now();
+      for (size_t r = 0; r < repetitions; r++) bench_sink = bench_sink + call();
+      total += chrono::duration<double>(clock::now() - start).count();
+      result.repetitions += repetitions;
+   }
+
+   result.ns_per_op = total * 1e9 / result.repetitions;
+   result.ns_per_element = result.ns_per_op / n;
+   result.elements_per_second = n / (result.ns_per_op * 1e-9);
+   if (kernel.reads_file) {
+      result.megabytes_per_second = result.input_bytes / (result.ns_per_op * 1e-9) / 1e6;
+   }
+   return result;
+}
+
+// Описание сборки для сравнения результатов разных сборок
+string bench_build() {
+   string build;
+#if defined(_MSC_VER)
+   build = "msvc " + to_string(_MSC_VER);
+#elif defined(__VERSION__)
+   build = __VERSION__;
+#endif
+#ifdef NDEBUG
+   build += " NDEBUG";
+#endif
+#ifdef STAT_PROFILING
+   build += " STAT_PROFILING";
+#endif
+   build += " threads=" + to_string(hardware_threads());
+   return build;
+}
+
+bool parse_size(const string& text, size_t& size) {
+   try {
+      double value = stod(text);
+      if (!(value >= 1.0 && value <= 1e8)) return false;
+      size = static_cast<size_t>(value);
+      return true;
+   }
+   catch (...) {
+      return false;
+   }
+}
+
+void print_usage() {
+   cout << "Использование: stat_bench [--max-size N] [--sizes N,N,...] [--min-time сек]"
+      << " [--filter подстрока] [--format jsonl|csv] [файл_результатов]" << endl;
+}
+
+int main(int argc, char* argv[]) {
+   ResultOptions result_options;
+   result_options.format = ResultFormat::JsonLines;
+   if (!take_result_options(argc, argv, result_options)) return 1;
+   if (!result_options.structured()) result_options.format = ResultFormat::JsonLines;
+
+   size_t max_size = 1000000;
+   vector<size_t> sizes;
+   double min_time = 0.2;
+   string filter;
+   string output = "stat_bench_results.jsonl";
+   bool output_given = false;
+
+   for (int i = 1; i < argc; i++) {
+      string arg = argv[i];
+      if (arg == "--help" || arg == "-h") {
+         print_usage();
+         return 0;
+      }
+      if (arg == "--max-size" && i + 1 < argc) {
+         if (!parse_size(argv[++i], max_size)) {
+            cerr << "Недопустимый размер: " << argv[i] << " (от 1 до 1e8)" << endl;
+            return 1;
+         }
+      }
+      else if (arg == "--sizes" && i + 1 < argc) {
+         stringstream list(argv[++i]);
+         string item;
+         while (getline(list, item, ',')) {
+            size_t size;
+            if (!parse_size(item, size)) {
+               cerr << "Недопустимый размер: " << item << " (от 1 до 1e8)" << endl;
+               return 1;
+            }
+            sizes.push_back(size);
+         }
+      }
+      else if (arg == "--min-time" && i + 1 < argc) {
+         min_time = atof(argv[++i]);
+         if (!(min_time > 0)) {
+            cerr << "Недопустимое время замера: " << argv[i] << endl;
+            return 1;
+         }
+      }
+      else if (arg == "--filter" && i + 1 < argc) {
+         filter = argv[++i];
+      }
+      else if (!arg.empty() && arg[0] != '-') {
+         output = arg;
+         output_given = true;
+      }
+      else {
+         print_usage();
+         return 1;
+      }
+   }
+   if (!output_given) output = result_output_filename(output, result_options);
+   if (sizes.empty()) {
+      for (size_t size = 10; size <= max_size; size *= 10) sizes.push_back(size);
+   }
+
+   ResultWriter writer;
+   if (!writer.open(output, result_options, "stat_bench",
+      { "kernel", "size", "repetitions", "ns_per_op", "ns_per_element", "elements_per_second",
+        "input_bytes", "megabytes_per_second", "allocations_per_op", "allocated_bytes_per_op",
+        "checksum", "build" })) {
+      cerr << "Ошибка создания файла: " << output << endl;
+      return 1;
+   }
+   string build = bench_build();
+
+   cout << "Сборка: " << build << endl;
+   cout << left << setw(24) << "kernel" << right << setw(11) << "size" << setw(14) << "ns/op"
+      << setw(12) << "ns/elem" << setw(14) << "Melem/s" << setw(10) << "MB/s"
+      << setw(11) << "alloc/op" << setw(14) << "bytes/op" << endl;
+
+   for (const BenchKernel& kernel : bench_kernels()) {
+      if (!filter.empty() && string(kernel.name).find(filter) == string::npos) continue;
+      for (size_t size : sizes) {
+         if (kernel.max_size != 0 && size > kernel.max_size) continue;
+         BenchResult r = run_kernel(kernel, size, min_time);
+         writer.write(r.kernel, r.size, r.repetitions, r.ns_per_op, r.ns_per_element, r.elements_per_second,
+            r.input_bytes, r.megabytes_per_second, r.allocations_per_op, r.allocated_bytes_per_op,
+            r.checksum, build);
+
+         cout << left << setw(24) << r.kernel << right << setw(11) << r.size
+            << fixed << setprecision(1) << setw(14) << r.ns_per_op
+            << setprecision(3) << setw(12) << r.ns_per_element
+            << setprecision(2) << setw(14) << r.elements_per_second / 1e6;
+         if (kernel.reads_file) cout << setprecision(1) << setw(10) << r.megabytes_per_second;
+         else cout << setw(10) << "-";
+         cout << setprecision(1) << setw(11) << r.allocations_per_op
+            << setprecision(0) << setw(14) << r.allocated_bytes_per_op << endl;
+         cout.unsetf(ios::fixed);
+      }
+   }
+
+   remove(bench_text_file);
+   remove(bench_csv_file);
+   remove(bench_columnar_file);
+
+   if (!writer.close()) {
+      cerr << "Ошибка записи файла: " << output << endl;
+      return 1;
+   }
+   cout << "Результаты сохранены в файл: " << output << endl;
+   return 0;
+}
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "censored_data.h"
+#include "columnar.h"
+#include "fast_reader.h"
+
+using namespace std;
+
+// Преобразование текстовых файлов данных в двоичный столбцовый формат (columnar.h).
+//
+// Форматы входного файла:
+//   values    - все числа файла образуют одну выборку (Граббс, Шапиро-Уилк)
+//   censored  - строки "значение,цензурирование" или "значение цензурирование";
+//               строка из одного числа пропускается, как при чтении текста
+//               программами normal и weibul (censored_data.h)
+//   rows      - каждая строка - отдельная выборка (Стьюдент)
+//   samples   - выборки отделяются метками [SAMPLE] или Sample1:/Sample2: (Краскел-Уоллис,
+//               Бартлет, Фишер)
+//   pairs     - два столбца, по одному значению каждой выборки в строке (Уилкоксон)
+
+bool convertValues(const TextColumns& columns, ColumnarData& data) {
+   data.values = columns.values;
+   return true;
+}
+
+bool convertCensored(const TextColumns& columns, ColumnarData& data) {
+   vector<int> censored;
+   censored_rows(columns, data.values, censored);
+   data.censor.reserve(censored.size());
+   for (int c : censored) data.censor.push_back(c != 0 ? 1 : 0);
+   return true;
+}
+
+bool convertRows(const TextColumns& columns, ColumnarData& data) {
+   data.values = columns.values;
+   data.group.reserve(columns.values.size());
+   for (size_t r = 0; r < columns.rows(); ++r) {
+       data.group.insert(data.group.end(), columns.row_size(r), static_cast<uint32_t>(r));
+   }
+   data.group_count = max<size_t>(1, columns.rows());
+   return true;
+}
+
+bool convertSamples(const TextColumns& columns, ColumnarData& data) {
+   data.values = columns.values;
+   data.group.reserve(columns.values.size());
+
+   // Строки до первой метки относятся к выборке 0
+   size_t current = 0;
+   size_t group_count = 1;
+   bool seen_marker = false;
+   size_t next_row = 0;
+   auto take_rows = [&](size_t until) {
+       if (next_row >= until) return;
+       size_t count = columns.row_begin(until) - columns.row_begin(next_row);
+       data.group.insert(data.group.end(), count, static_cast<uint32_t>(current));
+       next_row = until;
+   };
+
+   for (const TextDirective& directive : columns.directives) {
+       take_rows(directive.row);
+       if (directive.text == "[SAMPLE]") {
+           // Каждая метка открывает новую выборку, кроме первой метки в начале файла
+           current = (seen_marker || !data.group.empty()) ? group_count++ : 0;
+           seen_marker = true;
+       }
+       else if (directive.text == "Sample1:" || directive.text == "Sample2:") {
+           current = directive.text[6] - '1';
+           group_count = max(group_count, current + 1);
+           seen_marker = true;
+       }
+   }
+   take_rows(columns.rows());
+
+   data.group_count = group_count;
+   return true;
+}
+
+bool convertPairs(const TextColumns& columns, ColumnarData& data) {
+   data.values.reserve(columns.rows() * 2);
+   data.group.reserve(columns.rows() * 2);
+   for (size_t r = 0; r < columns.rows(); ++r) {
+       if (columns.row_size(r) < 2) {
+           cerr << "Ошибка: строка данных " << r + 1 << " содержит меньше двух значений" << endl;
+           return false;
+       }
+   }
+   // Сначала все значения выборки 1, затем выборки 2
+   for (int g = 0; g < 2; ++g) {
+       for (size_t r = 0; r < columns.rows(); ++r) {
+           data.values.push_back(columns.row(r)[g]);
+           data.group.push_back(g);
+       }
+   }
+   data.group_count = 2;
+   return true;
+}
+
+int main(int argc, char* argv[]) {
+   setlocale(LC_ALL, "rus");
+
+   if (argc < 4) {
+       cerr << "Использование: " << argv[0]
+           << " <формат> <входной файл> <выходной файл> [--order] [--moments]" << endl;
+       cerr << "Форматы: values, censored, rows, samples, pairs" << endl;
+       return 1;
+   }
+
+   string format = argv[1];
+   string inputFilename = argv[2];
+   string outputFilename = argv[3];
+
+   ColumnarData data;
+   data.source = format;
+   for (int i = 4; i < argc; ++i) {
+       string arg = argv[i];
+       if (arg == "--order") data.with_order = true;
+       else if (arg == "--moments") data.with_moments = true;
+       else {
+           cerr << "Неизвестный параметр: " << arg << endl;
+           return 1;
+       }
+   }
+
+   TextReadOptions options;
+   if (format == "censored") options.separators = ",;";
+
+   TextColumns columns;
+   if (!read_text_columns(inputFilename, columns, options)) {
+       cerr << "Ошибка открытия файла: " << inputFilename << endl;
+       return 1;
+   }
+
+   bool converted;
+   if (format == "values") converted = convertValues(columns, data);
+   else if (format == "censored") converted = convertCensored(columns, data);
+   else if (format == "rows") converted = convertRows(columns, data);
+   else if (format == "samples") converted = convertSamples(columns, data);
+   else if (format == "pairs") converted = convertPairs(columns, data);
+   else {
+       cerr << "Неизвестный формат: " << format << endl;
+       return 1;
+   }
+   if (!converted) return 1;
+
+   if (!write_columnar_file(outputFilename, data)) {
+       cerr << "ОШИБКА: Не удалось записать файл: " << outputFilename << endl;
+       return 1;
+   }
+
+   cout << "Преобразовано значений: " << data.values.size()
+       << " (выборок: " << data.group_count << ")" << endl;
+   cout << "Результат сохранен в файл: " << outputFilename << endl;
+   return 0;
+}
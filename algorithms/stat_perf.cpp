@@ -0,0 +1,568 @@
+// Сквозные замеры утилит на синтетических данных и сравнение с эталоном.
+//
+// Для каждой утилиты и размера создается входной файл (synthetic_data.h),
+// утилита запускается в рабочем каталоге со своими файлами по умолчанию,
+// и записываются время работы (минимум по --repeat запускам), пиковый объем
+// памяти процесса и контрольные данные чисел выходного файла (см.
+// OutputDigest). Эталон - текстовый файл с теми же замерами
+// (--update-baseline). При сравнении отмечаются:
+//   slower  - время больше эталонного более чем на --time-tolerance (доля)
+//   memory  - пиковая память больше более чем на --memory-tolerance (доля)
+//   changed - числа результатов расходятся больше --value-tolerance
+//             (относительной, с абсолютной поправкой того же размера)
+//             или изменилось их количество
+//   failed  - утилита завершилась с ошибкой или не создала файл результатов
+// Код возврата 2, если есть хотя бы одно отклонение.
+//
+// Использование:
+//   stat_perf generate <формат> <n> <seed> <файл>
+//   stat_perf run [--bin каталог] [--work каталог] [--methods m1,m2,...] [--sizes n1,n2,...]
+//                 [--seed N] [--repeat N] [--baseline файл] [--update-baseline]
+//                 [--time-tolerance 0.25] [--memory-tolerance 0.25] [--value-tolerance 1e-6]
+//                 [--format jsonl|csv] [файл_отчета]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "fast_reader.h"
+#include "result_writer.h"
+#include "synthetic_data.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// Утилита, ее входной и выходной файлы по умолчанию
+struct PerfMethod {
+   const char* tool;
+   const char* format;      // формат synthetic_data.h
+   const char* input;
+   const char* output;
+   size_t max_size;         // больший размер пропускается (0 - без предела)
+};
+
+const vector<PerfMethod>& perf_methods() {
+   static const vector<PerfMethod> methods = {
+      { "normal", "normal", "data.txt", "results_mle.txt", 0 },
+      { "weibul", "weibull", "data.txt", "results_weibull.txt", 0 },
+      { "mnk", "normal", "data.txt", "results.txt", 0 },
+      { "kruskal_w", "kruskal", "kruskal_wallis_input.txt", "kruskal_wallis_results.txt", 0 },
+      { "bartlett", "bartlett", "bartlett_input.txt", "bartlett_results.txt", 0 },
+      // Точное распределение U (udist): память ~m*n, время ~m*m*n
+      { "wilcoxon", "wilcoxon", "wilcoxon_input.txt", "wilcoxon_output.txt", 2000 },
+      { "shapiro", "shapiro", "shapiro_wilk_input.txt", "shapiro_wilk_results.txt", 0 },
+      { "grubbs", "grubbs", "input_data.txt", "grubbs_test_result.txt", 0 },
+      { "student", "student", "input_data_t_test.txt", "student_test_result.txt", 0 },
+      { "fisher", "fisher", "fisher_input_data.txt", "fisher_test_result.txt", 0 },
+   };
+   return methods;
+}
+
+// ========== ЗАПУСК УТИЛИТЫ ==========
+
+struct RunStats {
+   bool ok = false;
+   int exit_code = -1;
+   double wall_ms = 0.0;
+   double peak_rss_kb = 0.0;
+};
+
+// Запуск program в каталоге directory; стандартный вывод и ошибки - в log
+RunStats run_program(const string& program, const string& directory, const string& log) {
+   RunStats stats;
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+#ifdef _WIN32
+   SECURITY_ATTRIBUTES security = { sizeof(security), nullptr, TRUE };
+   HANDLE output = CreateFileA(log.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &security,
+      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+   if (output == INVALID_HANDLE_VALUE) return stats;
+
+   STARTUPINFOA startup = {};
+   startup.cb = sizeof(startup);
+   startup.dwFlags = STARTF_USESTDHANDLES;
+   startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+   startup.hStdOutput = output;
+   startup.hStdError = output;
+   PROCESS_INFORMATION process = {};
+   string command = "\"" + program + "\"";
+   if (!CreateProcessA(nullptr, &command[0], nullptr, nullptr, TRUE, 0, nullptr,
+      directory.c_str(), &startup, &process)) {
+      CloseHandle(output);
+      return stats;
+   }
+   WaitForSingleObject(process.hProcess, INFINITE);
+   stats.wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+   DWORD code = 0;
+   GetExitCodeProcess(process.hProcess, &code);
+   PROCESS_MEMORY_COUNTERS memory = {};
+   memory.cb = sizeof(memory);
+   if (GetProcessMemoryInfo(process.hProcess, &memory, sizeof(memory))) {
+      stats.peak_rss_kb = memory.PeakWorkingSetSize / 1024.0;
+   }
+   CloseHandle(process.hThread);
+   CloseHandle(process.hProcess);
+   CloseHandle(output);
+   stats.exit_code = static_cast<int>(code);
+#else
+   pid_t pid = fork();
+   if (pid < 0) return stats;
+   if (pid == 0) {
+      int fd = ::open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0 || chdir(directory.c_str()) != 0) _exit(127);
+      dup2(fd, 1);
+      dup2(fd, 2);
+      ::close(fd);
+      execl(program.c_str(), program.c_str(), static_cast<char*>(nullptr));
+      _exit(127);
+   }
+   // В Linux ru_maxrss учитывает и копию процесса до exec, поэтому сам
+   // stat_perf не держит в памяти ни входных, ни выходных файлов
+   int status = 0;
+   struct rusage usage;
+   if (wait4(pid, &status, 0, &usage) < 0) return stats;
+   stats.wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+#ifdef __APPLE__
+   stats.peak_rss_kb = usage.ru_maxrss / 1024.0; // в байтах
+#else
+   stats.peak_rss_kb = static_cast<double>(usage.ru_maxrss);
+#endif
+   stats.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+   stats.ok = stats.exit_code == 0;
+   return stats;
+}
+
+// ========== КОНТРОЛЬ РЕЗУЛЬТАТОВ ==========
+
+// Контрольные данные выходного файла. Файлы результатов содержат и итоги,
+// и полные таблицы данных, поэтому числа по отдельности хранятся только
+// в начале и в конце файла (там печатаются итоги), а для остальных -
+// количество, сумма и сумма модулей.
+const size_t digest_edge = 128;
+
+struct OutputDigest {
+   string hash;              // FNV-1a содержимого файла
+   size_t count = 0;         // всего чисел
+   vector<double> head;      // первые digest_edge чисел
+   vector<double> tail;      // последние digest_edge чисел (после head)
+   double middle_sum = 0.0;  // остальные числа
+   double middle_abs = 0.0;
+};
+
+// Числа строки по порядку (числа внутри слов, например "x1", пропускаются)
+void add_line_numbers(const string& line, OutputDigest& digest, deque<double>& tail) {
+   const char* begin = line.data();
+   const char* end = begin + line.size();
+   const char* p = begin;
+   while (p < end) {
+      bool word = p > begin && ((p[-1] >= 'a' && p[-1] <= 'z') || (p[-1] >= 'A' && p[-1] <= 'Z') || p[-1] == '_');
+      double value;
+      const char* next = word ? nullptr : text_parse_number(p, end, value);
+      if (next == nullptr) {
+         p++;
+         continue;
+      }
+      p = next;
+      if (!isfinite(value)) continue;
+      digest.count++;
+      if (digest.head.size() < digest_edge) {
+         digest.head.push_back(value);
+         continue;
+      }
+      tail.push_back(value);
+      if (tail.size() > digest_edge) {
+         digest.middle_sum += tail.front();
+         digest.middle_abs += fabs(tail.front());
+         tail.pop_front();
+      }
+   }
+}
+
+// Файл читается построчно, целиком в памяти не держится; false - нет файла
+bool digest_output(const string& filename, OutputDigest& digest) {
+   digest = OutputDigest();
+   ifstream file(filename, ios::binary);
+   if (!file) return false;
+   uint64_t hash = 14695981039346656037ull;
+   deque<double> tail;
+   string line;
+   while (getline(file, line)) {
+      for (unsigned char c : line) {
+         hash ^= c;
+         hash *= 1099511628211ull;
+      }
+      if (!file.eof()) {
+         hash ^= static_cast<unsigned char>('\n');
+         hash *= 1099511628211ull;
+      }
+      add_line_numbers(line, digest, tail);
+   }
+   digest.tail.assign(tail.begin(), tail.end());
+   char digits[17];
+   snprintf(digits, sizeof(digits), "%016llx", static_cast<unsigned long long>(hash));
+   digest.hash = digits;
+   return true;
+}
+
+// Наибольшее расхождение с эталоном в долях допуска (> 1 - изменение);
+// бесконечность - другое количество чисел
+double digest_error(const OutputDigest& digest, const OutputDigest& baseline, double tolerance) {
+   if (digest.count != baseline.count || digest.head.size() != baseline.head.size() ||
+      digest.tail.size() != baseline.tail.size()) {
+      return numeric_limits<double>::infinity();
+   }
+   double worst = 0.0;
+   auto compare = [&](double value, double expected, double magnitude) {
+      double scale = tolerance * (1.0 + magnitude);
+      worst = max(worst, fabs(value - expected) / scale);
+   };
+   for (size_t i = 0; i < digest.head.size(); i++) {
+      compare(digest.head[i], baseline.head[i], max(fabs(digest.head[i]), fabs(baseline.head[i])));
+   }
+   for (size_t i = 0; i < digest.tail.size(); i++) {
+      compare(digest.tail[i], baseline.tail[i], max(fabs(digest.tail[i]), fabs(baseline.tail[i])));
+   }
+   compare(digest.middle_sum, baseline.middle_sum, max(digest.middle_abs, baseline.middle_abs));
+   compare(digest.middle_abs, baseline.middle_abs, max(digest.middle_abs, baseline.middle_abs));
+   return worst;
+}
+
+// ========== ЭТАЛОН ==========
+
+struct PerfRecord {
+   string tool;
+   size_t size = 0;
+   uint64_t seed = 0;
+   RunStats stats;
+   OutputDigest digest;
+};
+
+// Строка эталона: tool size seed wall_ms peak_rss_kb hash count middle_sum middle_abs
+// число_первых первые... число_последних последние...
+bool read_baseline(const string& filename, vector<PerfRecord>& records) {
+   ifstream file(filename);
+   if (!file) return false;
+   string line;
+   while (getline(file, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      istringstream iss(line);
+      PerfRecord record;
+      OutputDigest& digest = record.digest;
+      size_t head = 0, tail = 0;
+      if (!(iss >> record.tool >> record.size >> record.seed >> record.stats.wall_ms >> record.stats.peak_rss_kb
+         >> digest.hash >> digest.count >> digest.middle_sum >> digest.middle_abs >> head)) {
+         continue;
+      }
+      digest.head.resize(head);
+      for (double& value : digest.head) iss >> value;
+      iss >> tail;
+      digest.tail.resize(tail);
+      for (double& value : digest.tail) iss >> value;
+      if (!iss) continue;
+      record.stats.ok = true;
+      records.push_back(move(record));
+   }
+   return true;
+}
+
+bool write_baseline(const string& filename, const vector<PerfRecord>& records) {
+   ofstream file(filename);
+   if (!file) return false;
+   file << "# stat_perf: tool size seed wall_ms peak_rss_kb hash count middle_sum middle_abs"
+      << " head_count head... tail_count tail...\n";
+   file << setprecision(17);
+   for (const PerfRecord& record : records) {
+      if (!record.stats.ok) continue;
+      const OutputDigest& digest = record.digest;
+      file << record.tool << ' ' << record.size << ' ' << record.seed << ' '
+         << record.stats.wall_ms << ' ' << record.stats.peak_rss_kb << ' '
+         << digest.hash << ' ' << digest.count << ' ' << digest.middle_sum << ' ' << digest.middle_abs
+         << ' ' << digest.head.size();
+      for (double value : digest.head) file << ' ' << value;
+      file << ' ' << digest.tail.size();
+      for (double value : digest.tail) file << ' ' << value;
+      file << '\n';
+   }
+   return static_cast<bool>(file);
+}
+
+// ========== РЕЖИМЫ ==========
+
+struct PerfOptions {
+   string bin = ".";
+   string work = "stat_perf_work";
+   vector<string> methods;
+   vector<size_t> sizes = { 1000, 10000, 100000 };
+   uint64_t seed = 1;
+   int repeat = 3;
+   string baseline = "stat_perf_baseline.txt";
+   bool update_baseline = false;
+   double time_tolerance = 0.25;
+   double memory_tolerance = 0.25;
+   double value_tolerance = 1e-6;
+   double min_time_difference_ms = 20.0; // меньшие различия времени - шум запуска
+   string report = "stat_perf_results.jsonl";
+};
+
+vector<string> split_list(const string& text) {
+   vector<string> items;
+   stringstream list(text);
+   string item;
+   while (getline(list, item, ',')) {
+      if (!item.empty()) items.push_back(item);
+   }
+   return items;
+}
+
+int run_harness(const PerfOptions& options, const ResultOptions& result_options) {
+   vector<PerfRecord> baseline;
+   bool have_baseline = !options.update_baseline && read_baseline(options.baseline, baseline);
+   if (!options.update_baseline && !have_baseline) {
+      cout << "Эталон " << options.baseline << " не найден: выполняются только замеры" << endl;
+   }
+
+   error_code error;
+   fs::create_directories(options.work, error);
+   fs::path work = fs::absolute(options.work, error);
+   if (error) {
+      cerr << "Ошибка создания каталога: " << options.work << endl;
+      return 1;
+   }
+   fs::path bin = fs::absolute(options.bin, error);
+
+   ResultWriter writer;
+   if (!writer.open(options.report, result_options, "stat_perf",
+      { "tool", "size", "seed", "status", "exit_code", "wall_ms", "peak_rss_kb", "output_hash",
+        "value_count", "baseline_wall_ms", "baseline_peak_rss_kb", "time_ratio", "memory_ratio",
+        "value_error" })) {
+      cerr << "Ошибка создания файла: " << options.report << endl;
+      return 1;
+   }
+
+   cout << left << setw(11) << "tool" << right << setw(9) << "size" << setw(12) << "wall, ms"
+      << setw(12) << "RSS, KB" << setw(10) << "time" << setw(10) << "memory" << "  status" << endl;
+
+   vector<PerfRecord> records;
+   int regressions = 0;
+   for (const PerfMethod& method : perf_methods()) {
+      if (!options.methods.empty() &&
+         find(options.methods.begin(), options.methods.end(), method.tool) == options.methods.end()) {
+         continue;
+      }
+      string program = (bin / method.tool).string();
+#ifdef _WIN32
+      program += ".exe";
+#endif
+      for (size_t size : options.sizes) {
+         if (method.max_size != 0 && size > method.max_size) continue;
+         PerfRecord record;
+         record.tool = method.tool;
+         record.size = size;
+         record.seed = options.seed;
+
+         fs::path directory = work / method.tool;
+         fs::remove_all(directory, error);
+         fs::create_directories(directory, error);
+         if (!write_synthetic_input(method.format, size, options.seed, (directory / method.input).string())) {
+            cerr << "Ошибка записи входного файла в каталоге " << directory.string() << endl;
+            return 1;
+         }
+
+         // Время - лучший из запусков, память - наибольшая
+         string log = (directory / (string(method.tool) + ".stdout")).string();
+         for (int r = 0; r < options.repeat; r++) {
+            RunStats stats = run_program(program, directory.string(), log);
+            if (r == 0 || !stats.ok) record.stats = stats;
+            else {
+               record.stats.wall_ms = min(record.stats.wall_ms, stats.wall_ms);
+               record.stats.peak_rss_kb = max(record.stats.peak_rss_kb, stats.peak_rss_kb);
+            }
+            if (!stats.ok) break;
+         }
+
+         if (!digest_output((directory / method.output).string(), record.digest)) record.stats.ok = false;
+
+         string status = "new";
+         double nan = numeric_limits<double>::quiet_NaN();
+         double base_wall = nan, base_rss = nan, time_ratio = nan, memory_ratio = nan, value_error = nan;
+         const PerfRecord* base = nullptr;
+         for (const PerfRecord& candidate : baseline) {
+            if (candidate.tool == record.tool && candidate.size == size && candidate.seed == options.seed) {
+               base = &candidate;
+            }
+         }
+         if (!record.stats.ok) {
+            status = "failed";
+         }
+         else if (base != nullptr) {
+            base_wall = base->stats.wall_ms;
+            base_rss = base->stats.peak_rss_kb;
+            time_ratio = record.stats.wall_ms / base_wall;
+            memory_ratio = base_rss > 0 ? record.stats.peak_rss_kb / base_rss : nan;
+            vector<string> problems;
+            value_error = digest_error(record.digest, base->digest, options.value_tolerance);
+            if (value_error > 1.0) problems.push_back("changed");
+            if (time_ratio > 1.0 + options.time_tolerance &&
+               record.stats.wall_ms - base_wall > options.min_time_difference_ms) {
+               problems.push_back("slower");
+            }
+            if (memory_ratio > 1.0 + options.memory_tolerance) problems.push_back("memory");
+            status = "ok";
+            if (!problems.empty()) {
+               status.clear();
+               for (const string& problem : problems) status += (status.empty() ? "" : ",") + problem;
+            }
+         }
+         if (status != "ok" && status != "new") regressions++;
+
+         writer.write(record.tool, record.size, record.seed, status, record.stats.exit_code,
+            record.stats.wall_ms, record.stats.peak_rss_kb, record.digest.hash, record.digest.count,
+            base_wall, base_rss, time_ratio, memory_ratio, value_error);
+
+         cout << left << setw(11) << record.tool << right << setw(9) << record.size
+            << fixed << setprecision(1) << setw(12) << record.stats.wall_ms
+            << setprecision(0) << setw(12) << record.stats.peak_rss_kb << setprecision(2);
+         if (base != nullptr && record.stats.ok) cout << setw(10) << time_ratio << setw(10) << memory_ratio;
+         else cout << setw(10) << "-" << setw(10) << "-";
+         cout << "  " << status << endl;
+         cout.unsetf(ios::fixed);
+
+         records.push_back(move(record));
+      }
+   }
+
+   if (!writer.close()) {
+      cerr << "Ошибка записи файла: " << options.report << endl;
+      return 1;
+   }
+   cout << "Отчет сохранен в файл: " << options.report << endl;
+
+   if (options.update_baseline) {
+      if (!write_baseline(options.baseline, records)) {
+         cerr << "Ошибка записи эталона: " << options.baseline << endl;
+         return 1;
+      }
+      cout << "Эталон сохранен в файл: " << options.baseline << endl;
+   }
+   if (regressions > 0) {
+      cout << "Отклонений от эталона: " << regressions << endl;
+      return 2;
+   }
+   return 0;
+}
+
+void print_usage(const char* program) {
+   cout << "Использование:" << endl;
+   cout << "  " << program << " generate <формат> <n> <seed> <файл>" << endl;
+   cout << "  " << program << " run [--bin каталог] [--work каталог] [--methods m1,m2] [--sizes n1,n2]"
+      << " [--seed N] [--repeat N] [--baseline файл] [--update-baseline]"
+      << " [--time-tolerance доля] [--memory-tolerance доля] [--value-tolerance число]"
+      << " [--format jsonl|csv] [файл_отчета]" << endl;
+   cout << "Форматы:";
+   for (const string& format : synthetic_formats()) cout << ' ' << format;
+   cout << endl;
+}
+
+int main(int argc, char* argv[]) {
+   ResultOptions result_options;
+   result_options.format = ResultFormat::JsonLines;
+   if (!take_result_options(argc, argv, result_options)) return 1;
+   if (!result_options.structured()) result_options.format = ResultFormat::JsonLines;
+
+   string mode = argc > 1 ? argv[1] : "";
+   if (mode == "generate") {
+      if (argc != 6) {
+         print_usage(argv[0]);
+         return 1;
+      }
+      size_t n = static_cast<size_t>(atof(argv[3]));
+      uint64_t seed = strtoull(argv[4], nullptr, 10);
+      if (!write_synthetic_input(argv[2], n, seed, argv[5])) {
+         cerr << "Ошибка: неизвестный формат, нулевой размер или ошибка записи файла " << argv[5] << endl;
+         return 1;
+      }
+      cout << "Файл создан: " << argv[5] << endl;
+      return 0;
+   }
+   if (mode != "run") {
+      print_usage(argv[0]);
+      return mode.empty() || mode == "--help" ? 0 : 1;
+   }
+
+   PerfOptions options;
+   bool report_given = false;
+   for (int i = 2; i < argc; i++) {
+      string arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if (arg == "--bin" && has_value) options.bin = argv[++i];
+      else if (arg == "--work" && has_value) options.work = argv[++i];
+      else if (arg == "--methods" && has_value) options.methods = split_list(argv[++i]);
+      else if (arg == "--sizes" && has_value) {
+         options.sizes.clear();
+         for (const string& item : split_list(argv[++i])) {
+            double size = atof(item.c_str());
+            if (!(size >= 1.0)) {
+               cerr << "Недопустимый размер: " << item << endl;
+               return 1;
+            }
+            options.sizes.push_back(static_cast<size_t>(size));
+         }
+      }
+      else if (arg == "--seed" && has_value) options.seed = strtoull(argv[++i], nullptr, 10);
+      else if (arg == "--repeat" && has_value) options.repeat = max(1, atoi(argv[++i]));
+      else if (arg == "--baseline" && has_value) options.baseline = argv[++i];
+      else if (arg == "--update-baseline") options.update_baseline = true;
+      else if (arg == "--time-tolerance" && has_value) options.time_tolerance = atof(argv[++i]);
+      else if (arg == "--memory-tolerance" && has_value) options.memory_tolerance = atof(argv[++i]);
+      else if (arg == "--value-tolerance" && has_value) options.value_tolerance = atof(argv[++i]);
+      else if (!arg.empty() && arg[0] != '-') {
+         options.report = arg;
+         report_given = true;
+      }
+      else {
+         print_usage(argv[0]);
+         return 1;
+      }
+   }
+   if (!report_given) options.report = result_output_filename(options.report, result_options);
+
+   for (const string& method : options.methods) {
+      bool known = false;
+      for (const PerfMethod& candidate : perf_methods()) known = known || method == candidate.tool;
+      if (!known) {
+         cerr << "Неизвестная утилита: " << method << endl;
+         return 1;
+      }
+   }
+   return run_harness(options, result_options);
+}
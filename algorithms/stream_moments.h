@@ -0,0 +1,395 @@
+#pragma once
+// Потоковое вычисление моментов двух выборок прямо при разборе файла.
+// Данные не сохраняются в памяти: каждый поток читает свой участок файла
+// блоками фиксированного размера и накапливает частичные моменты,
+// которые затем объединяются в порядке следования участков.
+// Сжатый файл (gzip, zstd) читается одним участком, распаковка идет
+// в отдельном потоке (compressed_input.h).
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compressed_input.h"
+#include "moments.h"
+#include "parallel.h"
+#include "profiler.h"
+
+// Последовательное чтение участка файла блоками.
+// Сжатый файл читается только с начала (begin == 0).
+class FileRangeReader {
+public:
+   FileRangeReader(const std::string& filename, long long begin)
+      : filename_(filename), position_(begin) {
+      if (detect_input_compression(filename) != InputCompression::None) {
+         compressed_ = true;
+         open_ = begin == 0 && input_.open(filename);
+         if (input_.failed()) std::cerr << "Ошибка чтения файла " << filename << ": " << input_.error() << std::endl;
+         return;
+      }
+      file_.open(filename, std::ios::binary);
+      buffer_.resize(1 << 20);
+      open_ = file_.is_open();
+      if (open_) file_.seekg(begin);
+   }
+
+   bool is_open() const { return open_; }
+
+   // Абсолютная позиция следующего непрочитанного байта
+   long long position() const { return position_; }
+
+   // Возвращает следующий байт или -1 в конце файла
+   int get() {
+      if (cursor_ == size_ && !refill()) return -1;
+      position_++;
+      return static_cast<unsigned char>(data_[cursor_++]);
+   }
+
+private:
+   bool refill() {
+      cursor_ = 0;
+      if (compressed_) {
+         if (input_.next(data_, size_)) return true;
+         if (input_.failed()) std::cerr << "Ошибка чтения файла " << filename_ << ": " << input_.error() << std::endl;
+         size_ = 0;
+         return false;
+      }
+      file_.read(buffer_.data(), buffer_.size());
+      size_ = static_cast<size_t>(file_.gcount());
+      data_ = buffer_.data();
+      return size_ > 0;
+   }
+
+   std::string filename_;
+   bool open_ = false;
+   bool compressed_ = false;
+   PipelinedInput input_;
+   std::ifstream file_;
+   std::vector<char> buffer_;
+   const char* data_ = nullptr;
+   size_t size_ = 0;
+   size_t cursor_ = 0;
+   long long position_ = 0;
+};
+
+inline bool stream_is_space(int c) {
+   return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Разбор числа в начале строки (аналог stod: пробелы слева, затем префикс числа)
+inline bool stream_parse_double(const char* begin, const char* end, double& value) {
+   while (begin < end && stream_is_space(static_cast<unsigned char>(*begin))) begin++;
+   if (begin < end && *begin == '+') {
+      begin++;
+      if (begin < end && *begin == '-') return false; // не более одного знака
+   }
+   auto result = std::from_chars(begin, end, value);
+   return result.ec == std::errc() && result.ptr != begin;
+}
+
+inline long long stream_file_size(const std::string& filename) {
+   std::ifstream file(filename, std::ios::binary | std::ios::ate);
+   if (!file.is_open()) return -1;
+   return static_cast<long long>(file.tellg());
+}
+
+// Разбиение файла на участки для потоков (не меньше 4 МБ на участок)
+inline size_t stream_part_count(long long file_size) {
+   const long long min_part = 4ll << 20;
+   long long parts = (file_size + min_part - 1) / min_part;
+   return static_cast<size_t>(std::max(1ll, std::min<long long>(hardware_threads(), parts)));
+}
+
+// Участки чтения файла. Сжатый файл не делится: он читается одним
+// участком без ограничения длины.
+inline bool stream_layout(const std::string& filename, long long& file_size, size_t& parts, long long& part_size) {
+   InputCompression compression = detect_input_compression(filename);
+   if (compression != InputCompression::None) {
+      if (!input_compression_supported(compression)) {
+         std::cerr << "Ошибка чтения файла " << filename << ": " << input_compression_unsupported_message(compression) << std::endl;
+         return false;
+      }
+      file_size = std::numeric_limits<long long>::max();
+      parts = 1;
+      part_size = file_size;
+      return true;
+   }
+   parts = stream_part_count(file_size);
+   part_size = (file_size + parts - 1) / parts;
+   return true;
+}
+
+//############# Формат "Sample1:" / "Sample2:" (fisher.cpp) ############################
+
+// Частичный результат одного участка: значения до первой метки в участке
+// относятся к выборке, которая была текущей в конце предыдущего участка
+struct SampleBlocksPart {
+   SampleMoments prefix;
+   SampleMoments samples[2];
+   int last_marker = 0; // 0 - меток в участке не было
+   size_t bad_lines = 0;
+};
+
+inline void stream_sample_blocks_part(const std::string& filename, long long begin, long long end,
+   SampleBlocksPart& part) {
+   FileRangeReader reader(filename, begin > 0 ? begin - 1 : 0);
+   if (!reader.is_open()) return;
+
+   // Участок начинается с первой строки, начало которой лежит внутри него
+   if (begin > 0) {
+      int c;
+      while ((c = reader.get()) != -1 && c != '\n') {}
+   }
+
+   // Строка целиком: длинная строка не обрезается (буфер растет до самой
+   // длинной строки участка и переиспользуется)
+   std::string line;
+   int current = 0;
+
+   while (reader.position() < end) {
+      line.clear();
+      int c;
+      bool got_any = false;
+      while ((c = reader.get()) != -1 && c != '\n') {
+         got_any = true;
+         line.push_back(static_cast<char>(c));
+      }
+      if (!got_any && c == -1) break;
+      // Пробелы и '\r' в конце строки не относятся к метке (как в fast_reader.h)
+      while (!line.empty() && stream_is_space(static_cast<unsigned char>(line.back()))) line.pop_back();
+
+      if (line.empty()) continue;
+
+      std::string_view text(line);
+      if (text == "Sample1:") {
+         current = part.last_marker = 1;
+         continue;
+      }
+      if (text == "Sample2:") {
+         current = part.last_marker = 2;
+         continue;
+      }
+
+      double value;
+      if (!stream_parse_double(line.data(), line.data() + line.size(), value)) {
+         part.bad_lines++;
+         continue;
+      }
+      if (current == 0) part.prefix.add(value);
+      else part.samples[current - 1].add(value);
+   }
+}
+
+// Моменты двух выборок из файла с блоками "Sample1:" и "Sample2:"
+inline bool stream_two_samples_from_file(const std::string& filename,
+   SampleMoments& sample1, SampleMoments& sample2) {
+   STAT_PROFILE_SCOPE("stream_two_samples");
+   long long file_size = stream_file_size(filename);
+   if (file_size < 0) {
+      std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+      return false;
+   }
+
+   size_t parts = 1;
+   long long part_size = 0;
+   if (!stream_layout(filename, file_size, parts, part_size)) return false;
+   std::vector<SampleBlocksPart> partial(parts);
+   parallel_for(parts, 1, [&](size_t first, size_t last) {
+      for (size_t p = first; p < last; p++) {
+         long long begin = p * part_size;
+         long long end = std::min(file_size, begin + part_size);
+         if (begin < end) stream_sample_blocks_part(filename, begin, end, partial[p]);
+      }
+   });
+
+   SampleMoments merged[2];
+   int current = 1;
+   size_t bad_lines = 0;
+   for (const SampleBlocksPart& part : partial) {
+      merged[current - 1].merge(part.prefix);
+      merged[0].merge(part.samples[0]);
+      merged[1].merge(part.samples[1]);
+      if (part.last_marker != 0) current = part.last_marker;
+      bad_lines += part.bad_lines;
+   }
+
+   if (bad_lines > 0) {
+      std::cerr << "Ошибка преобразования числа: пропущено строк " << bad_lines << std::endl;
+   }
+
+   sample1 = merged[0];
+   sample2 = merged[1];
+   return true;
+}
+
+//############# Формат "одна выборка на строку" (student.cpp) ############################
+
+// Фрагмент строки внутри участка
+struct LineSegment {
+   SampleMoments moments;
+   bool comment = false; // строка начинается с '#'
+   bool stopped = false; // встречено нечисловое значение, остаток строки не читается
+};
+
+// Частичный результат участка: продолжение строки с предыдущего участка,
+// завершенные строки-выборки (не больше двух) и незавершенная последняя строка
+struct SampleLinesPart {
+   bool at_line_start = false;
+   LineSegment continuation;
+   bool saw_newline = false;
+   std::vector<SampleMoments> complete;
+   bool has_open_line = false;
+   LineSegment open_line;
+};
+
+inline void stream_sample_lines_part(const std::string& filename, long long begin, long long end,
+   SampleLinesPart& part) {
+   FileRangeReader reader(filename, begin > 0 ? begin - 1 : 0);
+   if (!reader.is_open()) return;
+
+   const size_t max_token = 64;
+   char token[max_token];
+   size_t token_len = 0;
+   bool token_overflow = false;
+
+   int c = -1;
+   if (begin > 0) {
+      // Пропускаем хвост числа, начатого на предыдущем участке
+      int prev = reader.get();
+      part.at_line_start = (prev == '\n');
+      c = reader.get();
+      if (!stream_is_space(prev) && prev != -1) {
+         while (c != -1 && !stream_is_space(c)) c = reader.get();
+      }
+   }
+   else {
+      part.at_line_start = true;
+      c = reader.get();
+   }
+
+   LineSegment* segment = &part.continuation;
+   bool line_start_pending = part.at_line_start;
+
+   auto finish_token = [&]() {
+      if (token_len == 0) return;
+      // Как и operator>>: число из начала лексемы принимается,
+      // но чтение строки прекращается на первом нечисловом символе
+      if (!segment->comment && !segment->stopped) {
+         const char* first = token[0] == '+' ? token + 1 : token;
+         double value;
+         auto result = std::from_chars(first, token + token_len, value);
+         bool parsed = !token_overflow && result.ec == std::errc() && result.ptr != first &&
+            !(first != token && *first == '-'); // "+-5" не число
+         if (parsed) segment->moments.add(value);
+         if (!parsed || result.ptr != token + token_len) segment->stopped = true;
+      }
+      token_len = 0;
+      token_overflow = false;
+   };
+
+   auto close_line = [&]() {
+      if (segment == &part.open_line) {
+         if (!segment->comment && segment->moments.count > 0) {
+            part.complete.push_back(segment->moments);
+         }
+         part.has_open_line = false;
+      }
+   };
+
+   while (c != -1) {
+      long long position = reader.position() - 1;
+      if (token_len == 0 && position >= end) break;
+
+      if (line_start_pending) {
+         // Достаточно двух выборок: дальнейшие строки участка не нужны
+         if (part.complete.size() >= 2) break;
+         line_start_pending = false;
+         part.open_line = LineSegment();
+         part.open_line.comment = (c == '#');
+         part.has_open_line = true;
+         segment = &part.open_line;
+      }
+
+      if (stream_is_space(c)) {
+         finish_token();
+         if (c == '\n') {
+            close_line();
+            part.saw_newline = true;
+            line_start_pending = true;
+         }
+      }
+      else if (token_len < max_token) {
+         token[token_len++] = static_cast<char>(c);
+      }
+      else {
+         token_overflow = true;
+      }
+
+      c = reader.get();
+   }
+   finish_token();
+}
+
+// Моменты первых двух непустых строк-выборок файла (строки '#' пропускаются)
+inline bool stream_first_two_lines_from_file(const std::string& filename,
+   SampleMoments& sample1, SampleMoments& sample2, size_t& samples_found) {
+   STAT_PROFILE_SCOPE("stream_first_two_lines");
+   samples_found = 0;
+   long long file_size = stream_file_size(filename);
+   if (file_size < 0) {
+      std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+      return false;
+   }
+
+   size_t parts = 1;
+   long long part_size = 0;
+   if (!stream_layout(filename, file_size, parts, part_size)) return false;
+   std::vector<SampleLinesPart> partial(parts);
+   parallel_for(parts, 1, [&](size_t first, size_t last) {
+      for (size_t p = first; p < last; p++) {
+         long long begin = p * part_size;
+         long long end = std::min(file_size, begin + part_size);
+         if (begin < end) stream_sample_lines_part(filename, begin, end, partial[p]);
+      }
+   });
+
+   // Последовательное сшивание строк, разрезанных границами участков
+   std::vector<SampleMoments> samples;
+   bool has_current = false;
+   LineSegment current;
+
+   auto finish_current = [&]() {
+      if (has_current && !current.comment && current.moments.count > 0) {
+         samples.push_back(current.moments);
+      }
+      has_current = false;
+   };
+
+   for (const SampleLinesPart& part : partial) {
+      if (samples.size() >= 2) break;
+
+      if (!part.at_line_start && has_current && !current.comment && !current.stopped) {
+         current.moments.merge(part.continuation.moments);
+         current.stopped = part.continuation.stopped;
+      }
+      if (part.saw_newline || part.at_line_start) {
+         finish_current();
+         samples.insert(samples.end(), part.complete.begin(), part.complete.end());
+      }
+      if (part.has_open_line) {
+         current = part.open_line;
+         has_current = true;
+      }
+   }
+   finish_current();
+
+   samples_found = samples.size();
+   if (samples.size() > 0) sample1 = samples[0];
+   if (samples.size() > 1) sample2 = samples[1];
+   return true;
+}
@@ -19,6 +19,17 @@
 #include <boost/math/distributions/non_central_f.hpp>
 #include <boost/math/distributions/binomial.hpp>
 
+#include "ab_batch.h"
+#include "columnar.h"
+#include "csv_reader.h"
+#include "fast_reader.h"
+#include "moments.h"
+#include "profiler.h"
+#include "resampling.h"
+#include "result_cache.h"
+#include "result_writer.h"
+#include "stream_moments.h"
+
 using namespace std;
 using namespace boost::math;
 
@@ -46,6 +57,7 @@ double t_cdf(double x, double f) {
 }
 
 double t_ppf(double p, double f) {
+   STAT_PROFILE_SCOPE("t_ppf");
    if (p <= 0 || p >= 1) return 0;
    students_t_distribution<> d(f);
    return quantile(d, p);
@@ -63,68 +75,66 @@ double f_cdf(double x, double f1, double f2) {
 }
 
 double f_ppf(double p, double f1, double f2) {
+   STAT_PROFILE_SCOPE("f_ppf");
    if (p <= 0 || p >= 1) return 0;
    fisher_f_distribution<> d(f1, f2);
    return quantile(d, p);
 }
 
+// Итоги сравнения двух выборок для машиночитаемого вывода (result_writer.h)
+struct TTestSummary {
+   size_t n1 = 0, n2 = 0;
+   double mean1 = NAN, mean2 = NAN, var1 = NAN, var2 = NAN;
+   double F = NAN, F_critical = NAN;
+   int F_df1 = 0, F_df2 = 0;
+   bool equalVariances = false;
+   const char* test = "";   // "pooled" или "welch"
+   double t = NAN, df = NAN, t_critical = NAN, p_value = NAN;
+   bool significant = false;
+   const char* resampling = "none";
+   size_t resamples = 0;
+   double p_resampling = NAN, ci_lower = NAN, ci_upper = NAN;
+};
+
 // Функция для чтения данных из файла
 vector<vector<double>> readDataFromFile(const string& filename) {
+   STAT_PROFILE_SCOPE("read_data");
    vector<vector<double>> datasets;
-   ifstream file(filename);
-
-   if (!file.is_open()) {
-       cerr << "Ошибка открытия файла: " << filename << endl;
-       return datasets;
-   }
-
-   string line;
-   while (getline(file, line)) {
-       if (line.empty() || line[0] == '#') continue;
 
-       vector<double> dataset;
-       istringstream iss(line);
-       double value;
-       while (iss >> value) {
-           dataset.push_back(value);
+   // Двоичный столбцовый файл (columnar.h): каждая непустая группа - выборка
+   if (is_columnar_file(filename)) {
+       ColumnarFile file;
+       if (!file.open(filename)) {
+           cerr << "Некорректный двоичный файл данных: " << filename << endl;
+           return datasets;
        }
-
-       if (!dataset.empty()) {
-           datasets.push_back(dataset);
+       for (vector<double>& group : columnar_groups(file)) {
+           if (!group.empty()) datasets.push_back(move(group));
        }
+       return datasets;
    }
 
-   file.close();
-   return datasets;
-}
-
-// Функция для вычисления выборочного среднего
-double calculateMean(const vector<double>& data) {
-   if (data.empty()) return 0.0;
-   return accumulate(data.begin(), data.end(), 0.0) / data.size();
-}
+   TextColumns columns;
 
-// Функция для вычисления выборочной дисперсии
-double calculateVariance(const vector<double>& data, double mean) {
-   if (data.size() <= 1) return 0.0;
+   if (!read_text_columns(filename, columns)) {
+       cerr << "Ошибка открытия файла: " << filename << endl;
+       return datasets;
+   }
 
-   double sumSquares = 0.0;
-   for (double value : data) {
-       sumSquares += (value - mean) * (value - mean);
+   // Каждая строка данных - отдельная выборка
+   datasets.reserve(columns.rows());
+   for (size_t r = 0; r < columns.rows(); ++r) {
+       datasets.emplace_back(columns.row(r), columns.row(r) + columns.row_size(r));
    }
-   return sumSquares / (data.size() - 1);
-}
 
-// Функция для вычисления выборочного стандартного отклонения
-double calculateStdDev(const vector<double>& data, double mean) {
-   return sqrt(calculateVariance(data, mean));
+   return datasets;
 }
 
 // Функция для проверки равенства дисперсий (критерий Фишера)
-bool checkEqualVariances(const vector<double>& data1, const vector<double>& data2,
-   double alpha, ofstream& outputFile) {
-   double var1 = calculateVariance(data1, calculateMean(data1));
-   double var2 = calculateVariance(data2, calculateMean(data2));
+bool checkEqualVariances(const SampleMoments& moments1, const SampleMoments& moments2,
+   double alpha, ostream& outputFile, TTestSummary& summary) {
+   double var1 = moments1.variance();
+   double var2 = moments2.variance();
 
    // Всегда помещаем большую дисперсию в числитель
    double F_statistic;
@@ -132,46 +142,53 @@ bool checkEqualVariances(const vector<double>& data1, const vector<double>& data
 
    if (var1 >= var2) {
        F_statistic = var1 / var2;
-       df1 = data1.size() - 1;
-       df2 = data2.size() - 1;
+       df1 = moments1.count - 1;
+       df2 = moments2.count - 1;
    }
    else {
        F_statistic = var2 / var1;
-       df1 = data2.size() - 1;
-       df2 = data1.size() - 1;
+       df1 = moments2.count - 1;
+       df2 = moments1.count - 1;
    }
 
    double F_critical = f_ppf(1 - alpha / 2, df1, df2);
 
-   outputFile << "ПРОВЕРКА РАВЕНСТВА ДИСПЕРСИЙ (F-критерий):" << endl;
-   outputFile << "Дисперсия выборки 1: " << var1 << endl;
-   outputFile << "Дисперсия выборки 2: " << var2 << endl;
-   outputFile << "F-статистика: " << F_statistic << endl;
-   outputFile << "Критическое значение F(" << df1 << "," << df2 << "): " << F_critical << endl;
+   outputFile << "ПРОВЕРКА РАВЕНСТВА ДИСПЕРСИЙ (F-критерий):" << '\n';
+   outputFile << "Дисперсия выборки 1: " << var1 << '\n';
+   outputFile << "Дисперсия выборки 2: " << var2 << '\n';
+   outputFile << "F-статистика: " << F_statistic << '\n';
+   outputFile << "Критическое значение F(" << df1 << "," << df2 << "): " << F_critical << '\n';
 
    bool equalVariances = (F_statistic <= F_critical);
+   summary.var1 = var1;
+   summary.var2 = var2;
+   summary.F = F_statistic;
+   summary.F_df1 = df1;
+   summary.F_df2 = df2;
+   summary.F_critical = F_critical;
+   summary.equalVariances = equalVariances;
 
    if (equalVariances) {
-       outputFile << "ВЫВОД: Дисперсии можно считать равными (принимаем H₀)" << endl;
+       outputFile << "ВЫВОД: Дисперсии можно считать равными (принимаем H₀)" << '\n';
    }
    else {
-       outputFile << "ВЫВОД: Дисперсии значимо различаются (отвергаем H₀)" << endl;
+       outputFile << "ВЫВОД: Дисперсии значимо различаются (отвергаем H₀)" << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 
    return equalVariances;
 }
 
 // Точный критерий Стьюдента для равных дисперсий
-void performExactTTest(const vector<double>& data1, const vector<double>& data2,
-   double alpha, bool twoSided, ofstream& outputFile) {
-   double mean1 = calculateMean(data1);
-   double mean2 = calculateMean(data2);
-   double var1 = calculateVariance(data1, mean1);
-   double var2 = calculateVariance(data2, mean2);
-
-   int n1 = data1.size();
-   int n2 = data2.size();
+void performExactTTest(const SampleMoments& moments1, const SampleMoments& moments2,
+   double alpha, bool twoSided, ostream& outputFile, TTestSummary& summary) {
+   double mean1 = moments1.mean;
+   double mean2 = moments2.mean;
+   double var1 = moments1.variance();
+   double var2 = moments2.variance();
+
+   int n1 = moments1.count;
+   int n2 = moments2.count;
    int df = n1 + n2 - 2;
 
    // Объединенная дисперсия
@@ -188,48 +205,53 @@ void performExactTTest(const vector<double>& data1, const vector<double>& data2,
    double p_value = twoSided ? 2 * (1 - t_cdf(fabs(t_statistic), df)) :
        (1 - t_cdf(fabs(t_statistic), df));
 
-   outputFile << "ТОЧНЫЙ КРИТЕРИЙ СТЬЮДЕНТА (равные дисперсии):" << endl;
-   outputFile << "Среднее выборки 1: " << mean1 << " (n=" << n1 << ")" << endl;
-   outputFile << "Среднее выборки 2: " << mean2 << " (n=" << n2 << ")" << endl;
-   outputFile << "Разность средних: " << mean1 - mean2 << endl;
-   outputFile << "Объединенная дисперсия: " << pooledVariance << endl;
-   outputFile << "t-статистика: " << t_statistic << " (df=" << df << ")" << endl;
-   outputFile << "Критическое значение t: " << t_critical << endl;
-   outputFile << "p-value: " << p_value << endl;
+   outputFile << "ТОЧНЫЙ КРИТЕРИЙ СТЬЮДЕНТА (равные дисперсии):" << '\n';
+   outputFile << "Среднее выборки 1: " << mean1 << " (n=" << n1 << ")" << '\n';
+   outputFile << "Среднее выборки 2: " << mean2 << " (n=" << n2 << ")" << '\n';
+   outputFile << "Разность средних: " << mean1 - mean2 << '\n';
+   outputFile << "Объединенная дисперсия: " << pooledVariance << '\n';
+   outputFile << "t-статистика: " << t_statistic << " (df=" << df << ")" << '\n';
+   outputFile << "Критическое значение t: " << t_critical << '\n';
+   outputFile << "p-value: " << p_value << '\n';
 
    bool significant;
    if (twoSided) {
        significant = (fabs(t_statistic) > t_critical);
-       outputFile << "Гипотеза H₀: mu₁ = mu₂" << endl;
-       outputFile << "Гипотеза H₁: mu₁ ≠ mu₂" << endl;
+       outputFile << "Гипотеза H₀: mu₁ = mu₂" << '\n';
+       outputFile << "Гипотеза H₁: mu₁ ≠ mu₂" << '\n';
    }
    else {
        significant = (t_statistic > t_critical);
-       outputFile << "Гипотеза H₀: mu₁ ≤ mu₂" << endl;
-       outputFile << "Гипотеза H₁: mu₁ > mu₂" << endl;
+       outputFile << "Гипотеза H₀: mu₁ ≤ mu₂" << '\n';
+       outputFile << "Гипотеза H₁: mu₁ > mu₂" << '\n';
    }
+   summary.t = t_statistic;
+   summary.df = df;
+   summary.t_critical = t_critical;
+   summary.p_value = p_value;
+   summary.significant = significant;
 
    if (significant) {
-       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия СТАТИСТИЧЕСКИ ЗНАЧИМЫ" << endl;
-       outputFile << "Отвергаем нулевую гипотезу H₀ на уровне значимости " << alpha << endl;
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия СТАТИСТИЧЕСКИ ЗНАЧИМЫ" << '\n';
+       outputFile << "Отвергаем нулевую гипотезу H₀ на уровне значимости " << alpha << '\n';
    }
    else {
-       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия НЕ значимы" << endl;
-       outputFile << "Принимаем нулевую гипотезу H₀" << endl;
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия НЕ значимы" << '\n';
+       outputFile << "Принимаем нулевую гипотезу H₀" << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 }
 
 // Приближенный критерий Стьюдента для неравных дисперсий
-void performApproximateTTest(const vector<double>& data1, const vector<double>& data2,
-   double alpha, bool twoSided, ofstream& outputFile) {
-   double mean1 = calculateMean(data1);
-   double mean2 = calculateMean(data2);
-   double var1 = calculateVariance(data1, mean1);
-   double var2 = calculateVariance(data2, mean2);
+void performApproximateTTest(const SampleMoments& moments1, const SampleMoments& moments2,
+   double alpha, bool twoSided, ostream& outputFile, TTestSummary& summary) {
+   double mean1 = moments1.mean;
+   double mean2 = moments2.mean;
+   double var1 = moments1.variance();
+   double var2 = moments2.variance();
 
-   int n1 = data1.size();
-   int n2 = data2.size();
+   int n1 = moments1.count;
+   int n2 = moments2.count;
 
    // t-статистика Уэлча
    double t_statistic = (mean1 - mean2) / sqrt(var1 / n1 + var2 / n2);
@@ -246,37 +268,42 @@ void performApproximateTTest(const vector<double>& data1, const vector<double>&
    double p_value = twoSided ? 2 * (1 - t_cdf(fabs(t_statistic), df)) :
        (1 - t_cdf(fabs(t_statistic), df));
 
-   outputFile << "ПРИБЛИЖЕННЫЙ КРИТЕРИЙ СТЬЮДЕНТА (Уэлча, неравные дисперсии):" << endl;
-   outputFile << "Среднее выборки 1: " << mean1 << " (n=" << n1 << ")" << endl;
-   outputFile << "Среднее выборки 2: " << mean2 << " (n=" << n2 << ")" << endl;
-   outputFile << "Разность средних: " << mean1 - mean2 << endl;
-   outputFile << "Дисперсия выборки 1: " << var1 << endl;
-   outputFile << "Дисперсия выборки 2: " << var2 << endl;
-   outputFile << "t-статистика: " << t_statistic << " (df=" << df << ")" << endl;
-   outputFile << "Критическое значение t: " << t_critical << endl;
-   outputFile << "p-value: " << p_value << endl;
+   outputFile << "ПРИБЛИЖЕННЫЙ КРИТЕРИЙ СТЬЮДЕНТА (Уэлча, неравные дисперсии):" << '\n';
+   outputFile << "Среднее выборки 1: " << mean1 << " (n=" << n1 << ")" << '\n';
+   outputFile << "Среднее выборки 2: " << mean2 << " (n=" << n2 << ")" << '\n';
+   outputFile << "Разность средних: " << mean1 - mean2 << '\n';
+   outputFile << "Дисперсия выборки 1: " << var1 << '\n';
+   outputFile << "Дисперсия выборки 2: " << var2 << '\n';
+   outputFile << "t-статистика: " << t_statistic << " (df=" << df << ")" << '\n';
+   outputFile << "Критическое значение t: " << t_critical << '\n';
+   outputFile << "p-value: " << p_value << '\n';
 
    bool significant;
    if (twoSided) {
        significant = (fabs(t_statistic) > t_critical);
-       outputFile << "Гипотеза H₀: mu₁ = mu₂" << endl;
-       outputFile << "Гипотеза H₁: mu₁ ≠ mu₂" << endl;
+       outputFile << "Гипотеза H₀: mu₁ = mu₂" << '\n';
+       outputFile << "Гипотеза H₁: mu₁ ≠ mu₂" << '\n';
    }
    else {
        significant = (t_statistic > t_critical);
-       outputFile << "Гипотеза H₀: mu₁ ≤ mu₂" << endl;
-       outputFile << "Гипотеза H₁: mu₁ > mu₂" << endl;
+       outputFile << "Гипотеза H₀: mu₁ ≤ mu₂" << '\n';
+       outputFile << "Гипотеза H₁: mu₁ > mu₂" << '\n';
    }
+   summary.t = t_statistic;
+   summary.df = df;
+   summary.t_critical = t_critical;
+   summary.p_value = p_value;
+   summary.significant = significant;
 
    if (significant) {
-       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия СТАТИСТИЧЕСКИ ЗНАЧИМЫ" << endl;
-       outputFile << "Отвергаем нулевую гипотезу H₀ на уровне значимости " << alpha << endl;
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия СТАТИСТИЧЕСКИ ЗНАЧИМЫ" << '\n';
+       outputFile << "Отвергаем нулевую гипотезу H₀ на уровне значимости " << alpha << '\n';
    }
    else {
-       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия НЕ значимы" << endl;
-       outputFile << "Принимаем нулевую гипотезу H₀" << endl;
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия НЕ значимы" << '\n';
+       outputFile << "Принимаем нулевую гипотезу H₀" << '\n';
    }
-   outputFile << endl;
+   outputFile << '\n';
 }
 
 // Вспомогательная функция для нахождения минимума двух чисел
@@ -284,65 +311,138 @@ size_t min_size(size_t a, size_t b) {
    return (a < b) ? a : b;
 }
 
-// Основная функция для применения критерия Стьюдента
-void performTTest(const vector<double>& data1, const vector<double>& data2,
-   double alpha, bool twoSided, ofstream& outputFile) {
-   int n1 = data1.size();
-   int n2 = data2.size();
-
-   outputFile << "==================================================" << endl;
-   outputFile << "         КРИТЕРИЙ СТЬЮДЕНТА ДЛЯ ДВУХ ВЫБОРОК" << endl;
-   outputFile << "==================================================" << endl;
-   outputFile << endl;
-
-   outputFile << "ОСНОВНЫЕ ПАРАМЕТРЫ:" << endl;
-   outputFile << "Объем выборки 1: n₁ = " << n1 << endl;
-   outputFile << "Объем выборки 2: n₂ = " << n2 << endl;
-   outputFile << "Уровень значимости: alpha = " << alpha << endl;
-   outputFile << "Тип критерия: " << (twoSided ? "Двусторонний" : "Односторонний") << endl;
-   outputFile << endl;
+// Критерий Стьюдента по накопленным моментам выборок
+bool performTTest(const SampleMoments& moments1, const SampleMoments& moments2,
+   double alpha, bool twoSided, ostream& outputFile, TTestSummary& summary) {
+   STAT_PROFILE_SCOPE("t_test");
+   int n1 = moments1.count;
+   int n2 = moments2.count;
+   summary.n1 = moments1.count;
+   summary.n2 = moments2.count;
+   summary.mean1 = moments1.mean;
+   summary.mean2 = moments2.mean;
+
+   outputFile << "==================================================" << '\n';
+   outputFile << "         КРИТЕРИЙ СТЬЮДЕНТА ДЛЯ ДВУХ ВЫБОРОК" << '\n';
+   outputFile << "==================================================" << '\n';
+   outputFile << '\n';
+
+   outputFile << "ОСНОВНЫЕ ПАРАМЕТРЫ:" << '\n';
+   outputFile << "Объем выборки 1: n₁ = " << n1 << '\n';
+   outputFile << "Объем выборки 2: n₂ = " << n2 << '\n';
+   outputFile << "Уровень значимости: alpha = " << alpha << '\n';
+   outputFile << "Тип критерия: " << (twoSided ? "Двусторонний" : "Односторонний") << '\n';
+   outputFile << '\n';
 
    // Проверка минимального объема выборок
    if (n1 < 2 || n2 < 2) {
-       outputFile << "ОШИБКА: Объем каждой выборки должен быть не менее 2" << endl;
-       return;
+       outputFile << "ОШИБКА: Объем каждой выборки должен быть не менее 2" << '\n';
+       return false;
    }
 
-   // Вычисляем основные статистики
-   double mean1 = calculateMean(data1);
-   double mean2 = calculateMean(data2);
-   double stdDev1 = calculateStdDev(data1, mean1);
-   double stdDev2 = calculateStdDev(data2, mean2);
+   // Основные статистики
+   double mean1 = moments1.mean;
+   double mean2 = moments2.mean;
+   double stdDev1 = moments1.stddev();
+   double stdDev2 = moments2.stddev();
 
-   outputFile << "ОПИСАТЕЛЬНАЯ СТАТИСТИКА:" << endl;
-   outputFile << "Выборка 1: среднее = " << mean1 << ", ст. отклонение = " << stdDev1 << endl;
-   outputFile << "Выборка 2: среднее = " << mean2 << ", ст. отклонение = " << stdDev2 << endl;
-   outputFile << "Разность средних: " << mean1 - mean2 << endl;
-   outputFile << endl;
+   outputFile << "ОПИСАТЕЛЬНАЯ СТАТИСТИКА:" << '\n';
+   outputFile << "Выборка 1: среднее = " << mean1 << ", ст. отклонение = " << stdDev1 << '\n';
+   outputFile << "Выборка 2: среднее = " << mean2 << ", ст. отклонение = " << stdDev2 << '\n';
+   outputFile << "Разность средних: " << mean1 - mean2 << '\n';
+   outputFile << '\n';
 
    // Проверяем равенство дисперсий
-   bool equalVariances = checkEqualVariances(data1, data2, alpha, outputFile);
+   bool equalVariances = checkEqualVariances(moments1, moments2, alpha, outputFile, summary);
 
    // Выполняем соответствующий t-тест
    if (equalVariances) {
-       performExactTTest(data1, data2, alpha, twoSided, outputFile);
+       summary.test = "pooled";
+       performExactTTest(moments1, moments2, alpha, twoSided, outputFile, summary);
+   }
+   else {
+       outputFile << "ИСПОЛЬЗУЕТСЯ ПРИБЛИЖЕННЫЙ КРИТЕРИЙ (Уэлча)" << '\n';
+       outputFile << "в связи с неравенством дисперсий" << '\n';
+       outputFile << '\n';
+       summary.test = "welch";
+       performApproximateTTest(moments1, moments2, alpha, twoSided, outputFile, summary);
+   }
+
+   return true;
+}
+
+// Перестановочный или бутстреп-критерий для статистики Уэлча
+void performResamplingTest(const vector<double>& data1, const vector<double>& data2,
+   double alpha, bool twoSided, const ResamplingOptions& options, ostream& outputFile, TTestSummary& summary) {
+   STAT_PROFILE_SCOPE("resampling_test");
+   bool permutation = options.method == ResamplingOptions::Permutation;
+   ResamplingResult result = permutation ?
+       permutation_t_test(data1, data2, twoSided, alpha, options) :
+       bootstrap_t_test(data1, data2, twoSided, alpha, options);
+   summary.resampling = permutation ? "permutation" : "bootstrap";
+   summary.resamples = result.performed;
+   summary.p_resampling = result.p_value;
+   if (!permutation) {
+       summary.ci_lower = result.ci_lower;
+       summary.ci_upper = result.ci_upper;
+   }
+
+   if (permutation) {
+       outputFile << "ПЕРЕСТАНОВОЧНЫЙ КРИТЕРИЙ (статистика Уэлча):" << '\n';
+       outputFile << "Запрошено перестановок: " << options.resamples << '\n';
+       outputFile << "Выполнено перестановок: " << result.performed << '\n';
    }
    else {
-       outputFile << "ИСПОЛЬЗУЕТСЯ ПРИБЛИЖЕННЫЙ КРИТЕРИЙ (Уэлча)" << endl;
-       outputFile << "в связи с неравенством дисперсий" << endl;
-       outputFile << endl;
-       performApproximateTTest(data1, data2, alpha, twoSided, outputFile);
+       outputFile << "БУТСТРЕП-КРИТЕРИЙ (статистика Уэлча, сдвиг к H₀):" << '\n';
+       outputFile << "Запрошено бутстреп-выборок: " << options.resamples << '\n';
+       outputFile << "Выполнено бутстреп-выборок: " << result.performed << '\n';
+   }
+   if (result.stopped_early) {
+       outputFile << "Досрочная остановка: вывод на уровне alpha определен" << '\n';
+   }
+   outputFile << "Начальное значение генератора: " << options.seed << '\n';
+   outputFile << "Наблюдаемая t-статистика: " << result.t_observed << '\n';
+   outputFile << "p-value: " << result.p_value << '\n';
+   outputFile << "Интервал Монте-Карло для p-value (99.9%): ["
+       << result.p_lower << ", " << result.p_upper << "]" << '\n';
+   if (!permutation) {
+       outputFile << "Доверительный интервал для разности средних (перцентильный, "
+           << (1 - alpha) * 100 << "%): [" << result.ci_lower << ", " << result.ci_upper << "]" << '\n';
+   }
+
+   if (result.p_value < alpha) {
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия СТАТИСТИЧЕСКИ ЗНАЧИМЫ" << '\n';
+       outputFile << "Отвергаем нулевую гипотезу H₀ на уровне значимости " << alpha << '\n';
+   }
+   else {
+       outputFile << "СТАТИСТИЧЕСКИЙ ВЫВОД: Различия НЕ значимы" << '\n';
+       outputFile << "Принимаем нулевую гипотезу H₀" << '\n';
+   }
+   outputFile << '\n';
+}
+
+// Основная функция для применения критерия Стьюдента
+void performTTest(const vector<double>& data1, const vector<double>& data2,
+   double alpha, bool twoSided, ostream& outputFile,
+   const ResamplingOptions& resampling, TTestSummary& summary) {
+   // Описательные статистики считаются за один проход по каждой выборке
+   if (!performTTest(compute_moments(data1), compute_moments(data2), alpha, twoSided, outputFile, summary)) {
+       return;
+   }
+
+   if (resampling.method != ResamplingOptions::None) {
+       performResamplingTest(data1, data2, alpha, twoSided, resampling, outputFile, summary);
    }
 
    // Дополнительная информация
-   outputFile << "ДОПОЛНИТЕЛЬНАЯ ИНФОРМАЦИЯ:" << endl;
+   outputFile << "ДОПОЛНИТЕЛЬНАЯ ИНФОРМАЦИЯ:" << '\n';
    outputFile << "Выборка 1 (первые значения): ";
    size_t displayCount = min_size(data1.size(), 10);
    for (size_t i = 0; i < displayCount; ++i) {
        outputFile << data1[i] << " ";
    }
    if (data1.size() > 10) outputFile << "...";
-   outputFile << endl;
+   outputFile << '\n';
 
    outputFile << "Выборка 2 (первые значения): ";
    displayCount = min_size(data2.size(), 10);
@@ -350,27 +450,142 @@ void performTTest(const vector<double>& data1, const vector<double>& data2,
        outputFile << data2[i] << " ";
    }
    if (data2.size() > 10) outputFile << "...";
-   outputFile << endl;
+   outputFile << '\n';
+
+   outputFile << "==================================================" << '\n';
+}
 
-   outputFile << "==================================================" << endl;
+// Запись итогов сравнений в формате JSON Lines или CSV: по записи на пару выборок
+bool writeTTestRecords(const string& filename, const ResultOptions& options,
+   const vector<pair<string, string>>& samples, const vector<TTestSummary>& summaries) {
+   ResultWriter writer;
+   if (!writer.open(filename, options, "student", { "sample1", "sample2", "n1", "n2",
+       "mean1", "mean2", "var1", "var2", "f", "f_df1", "f_df2", "f_critical", "equal_variances",
+       "test", "t", "df", "t_critical", "p_value", "significant",
+       "resampling", "resamples", "p_resampling", "ci_lower", "ci_upper" })) {
+       cerr << "ОШИБКА: Не удалось создать выходной файл: " << filename << endl;
+       return false;
+   }
+   for (size_t i = 0; i < summaries.size(); ++i) {
+       const TTestSummary& s = summaries[i];
+       writer.write(samples[i].first, samples[i].second, s.n1, s.n2,
+           s.mean1, s.mean2, s.var1, s.var2, s.F, s.F_df1, s.F_df2, s.F_critical, s.equalVariances,
+           s.test, s.t, s.df, s.t_critical, s.p_value, s.significant,
+           s.resampling, s.resamples, s.p_resampling, s.ci_lower, s.ci_upper);
+   }
+   if (!writer.close()) {
+       cerr << "ОШИБКА: Ошибка записи в файл: " << filename << endl;
+       return false;
+   }
+   return true;
+}
+
+// Сравнение столбцов CSV/TSV-файла с первым (контрольным) столбцом.
+// Файл читается один раз, пары сравниваются параллельно, результаты
+// каждой пары - в файл <output>_<столбец> (при --format jsonl|csv - все
+// пары в один файл).
+int performTTestOnCsvColumns(const string& filename, const vector<string>& names,
+   double alpha, bool twoSided, const string& outputFilename, const ResamplingOptions& resampling,
+   const ResultOptions& resultOptions) {
+   CsvSelection selection;
+   if (!read_csv_columns(filename, names, selection)) {
+       cerr << "ОШИБКА: Не удалось прочитать столбцы из файла: " << filename << endl;
+       return 1;
+   }
+   cout << "Прочитано " << selection.rows << " строк" << endl;
+   for (size_t c = 0; c < names.size(); ++c) {
+       cout << "Столбец " << names[c] << ": n = " << selection.columns[c].size()
+           << ", пропусков: " << selection.missing[c] << endl;
+   }
+
+   size_t comparisons = names.size() - 1;
+   if (resultOptions.structured()) {
+       vector<TTestSummary> summaries(comparisons);
+       vector<pair<string, string>> samples(comparisons);
+       parallel_for(comparisons, 1, [&](size_t first, size_t last) {
+           for (size_t i = first; i < last; ++i) {
+               ostream discard(nullptr);
+               samples[i] = { names[0], names[i + 1] };
+               performTTest(selection.columns[0], selection.columns[i + 1], alpha, twoSided, discard, resampling, summaries[i]);
+           }
+       });
+       string structuredFilename = result_output_filename(outputFilename, resultOptions);
+       if (!writeTTestRecords(structuredFilename, resultOptions, samples, summaries)) return 1;
+       cout << "Результаты сохранены в файл: " << structuredFilename << endl;
+       return 0;
+   }
+
+   vector<string> outputs(comparisons);
+   vector<char> written(comparisons, 0);
+   parallel_for(comparisons, 1, [&](size_t first, size_t last) {
+       for (size_t i = first; i < last; ++i) {
+           outputs[i] = csv_output_filename(outputFilename, names[i + 1]);
+           ofstream outputFile(outputs[i]);
+           if (!outputFile.is_open()) continue;
+           outputFile << "Выборка 1: столбец " << names[0] << ", выборка 2: столбец " << names[i + 1] << '\n';
+           TTestSummary summary;
+           performTTest(selection.columns[0], selection.columns[i + 1], alpha, twoSided, outputFile, resampling, summary);
+           written[i] = 1;
+       }
+   });
+
+   int status = 0;
+   for (size_t i = 0; i < comparisons; ++i) {
+       if (written[i]) {
+           cout << names[0] << " / " << names[i + 1] << ": результаты сохранены в файл: " << outputs[i] << endl;
+       }
+       else {
+           cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputs[i] << endl;
+           status = 1;
+       }
+   }
+   return status;
 }
 
 // Функция для создания тестового файла с данными
 void createTestDataFile() {
    ofstream testFile("input_data_t_test.txt");
    if (testFile.is_open()) {
-       testFile << "# Тестовые данные для критерия Стьюдента" << endl;
-       testFile << "# Первая строка - первая выборка, вторая строка - вторая выборка" << endl;
-       testFile << endl;
-       testFile << "220 223 234 245 257" << endl;
-       testFile << "234 246 259 262 278 280 285 290" << endl;
+       testFile << "# Тестовые данные для критерия Стьюдента" << '\n';
+       testFile << "# Первая строка - первая выборка, вторая строка - вторая выборка" << '\n';
+       testFile << '\n';
+       testFile << "220 223 234 245 257" << '\n';
+       testFile << "234 246 259 262 278 280 285 290" << '\n';
        testFile.close();
        cout << "Создан тестовый файл input_data_t_test.txt с примером данных" << endl;
    }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
    setlocale(LC_ALL, "rus");
+
+   // Машиночитаемый вывод в любом режиме: --format jsonl|csv [--async-output] (result_writer.h)
+   ResultOptions resultOptions;
+   if (!take_result_options(argc, argv, resultOptions)) return 1;
+
+   // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+   ResultCacheOptions cacheOptions;
+   if (!take_cache_options(argc, argv, cacheOptions)) return 1;
+
+   // Пакетный режим A/B: Student.exe --batch <данные> <манифест пар> [выходной файл]
+   if (argc > 1 && string(argv[1]) == "--batch") {
+       if (argc < 4) {
+           cerr << "Использование: " << argv[0] << " --batch <файл данных> <манифест пар> [выходной файл]"
+               << " [--format jsonl|csv] [--async-output]" << endl;
+           return 1;
+       }
+       string batchOutputFilename = (argc > 4) ? argv[4] : result_output_filename("ab_batch_results.tsv", resultOptions);
+       ResultCache cache(cacheOptions, "ab_batch");
+       cache.add_file(argv[2]);
+       cache.add_file(argv[3]);
+       cache.add("format", static_cast<int>(resultOptions.format));
+       cache.add_arguments(argc, argv);
+       if (cache.replay()) return 0;
+       if (!run_ab_batch(argv[2], argv[3], batchOutputFilename, resultOptions, cacheOptions)) return 1;
+       cache.store({ batchOutputFilename });
+       return 0;
+   }
+
    // Параметры критерия
    double alpha = 0.05; // Уровень значимости
    bool twoSided = true; // Двусторонний критерий
@@ -379,10 +594,115 @@ int main() {
    string inputFilename = "input_data_t_test.txt";
    string outputFilename = "student_test_result.txt";
 
+   // Потоковый режим для файлов, не помещающихся в память:
+   // Student.exe --stream <входной файл> [выходной файл]
+   if (argc > 1 && string(argv[1]) == "--stream") {
+       if (argc < 3) {
+           cerr << "Использование: " << argv[0] << " --stream <входной файл> [выходной файл]" << endl;
+           return 1;
+       }
+       if (argc > 3) outputFilename = argv[3];
+
+       SampleMoments moments1, moments2;
+       size_t samplesFound = 0;
+       cout << "Потоковое чтение данных из файла: " << argv[2] << endl;
+       if (!stream_first_two_lines_from_file(argv[2], moments1, moments2, samplesFound)) {
+           return 1;
+       }
+       if (samplesFound < 2) {
+           cerr << "ОШИБКА: Необходимо как минимум 2 выборки для сравнения" << endl;
+           cerr << "Прочитано выборок: " << samplesFound << endl;
+           return 1;
+       }
+
+       TTestSummary summary;
+       if (resultOptions.structured()) {
+           if (argc <= 3) outputFilename = result_output_filename(outputFilename, resultOptions);
+           ostream discard(nullptr);
+           performTTest(moments1, moments2, alpha, twoSided, discard, summary);
+           if (!writeTTestRecords(outputFilename, resultOptions, { { "1", "2" } }, { summary })) return 1;
+       }
+       else {
+           ofstream outputFile(outputFilename);
+           if (!outputFile.is_open()) {
+               cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputFilename << endl;
+               return 1;
+           }
+           if (performTTest(moments1, moments2, alpha, twoSided, outputFile, summary)) {
+               outputFile << "==================================================" << '\n';
+           }
+           outputFile.close();
+       }
+
+       cout << "Объем выборки 1: " << moments1.count << " значений" << endl;
+       cout << "Объем выборки 2: " << moments2.count << " значений" << endl;
+       cout << "Результаты сохранены в файл: " << outputFilename << endl;
+       return 0;
+   }
+
+   // Ресэмплинг в дополнение к аналитическим критериям:
+   // Student.exe [--permutation N | --bootstrap N] [--seed S] [--no-early-stop] [--input <файл>]
+   // Столбцы CSV/TSV-файла: --csv <файл> <контрольный столбец> <столбец> [<столбец> ...]
+   ResamplingOptions resampling;
+   string csvFilename;
+   vector<string> csvColumns;
+   for (int i = 1; i < argc; ++i) {
+       string arg = argv[i];
+       if (arg == "--input" && i + 1 < argc) {
+           inputFilename = argv[++i];
+       }
+       else if (arg == "--csv" && i + 1 < argc) {
+           csvFilename = argv[++i];
+           while (i + 1 < argc && string(argv[i + 1]).compare(0, 2, "--") != 0) {
+               csvColumns.push_back(argv[++i]);
+           }
+       }
+       else if ((arg == "--permutation" || arg == "--bootstrap") && i + 1 < argc) {
+           resampling.method = (arg == "--permutation") ?
+               ResamplingOptions::Permutation : ResamplingOptions::Bootstrap;
+           resampling.resamples = stoull(argv[++i]);
+       }
+       else if (arg == "--seed" && i + 1 < argc) {
+           resampling.seed = stoull(argv[++i]);
+       }
+       else if (arg == "--no-early-stop") {
+           resampling.early_stop = false;
+       }
+       else {
+           cerr << "Использование: " << argv[0]
+               << " [--permutation N | --bootstrap N] [--seed S] [--no-early-stop] [--input <файл>]"
+               << " [--format jsonl|csv] [--async-output]" << endl;
+           cerr << "       " << argv[0]
+               << " --csv <файл> <контрольный столбец> <столбец> [<столбец> ...] [параметры ресэмплинга]" << endl;
+           return 1;
+       }
+   }
+   if (resampling.method != ResamplingOptions::None && resampling.resamples == 0) {
+       cerr << "ОШИБКА: Число ресэмплов должно быть положительным" << endl;
+       return 1;
+   }
+
    cout << "ПРОГРАММА ДЛЯ СРАВНЕНИЯ СРЕДНИХ ДВУХ ВЫБОРОК" << endl;
    cout << "Метод: критерий Стьюдента" << endl;
    cout << "=============================================" << endl;
 
+   if (!csvFilename.empty()) {
+       if (csvColumns.size() < 2) {
+           cerr << "ОШИБКА: Для сравнения нужно указать как минимум 2 столбца" << endl;
+           return 1;
+       }
+       return performTTestOnCsvColumns(csvFilename, csvColumns, alpha, twoSided, outputFilename, resampling, resultOptions);
+   }
+
+   // Тот же файл с теми же параметрами - результат из кэша
+   ResultCache cache(cacheOptions, "student");
+   cache.add_file(inputFilename);
+   cache.add("alpha", alpha);
+   cache.add("two_sided", twoSided);
+   cache.add("format", static_cast<int>(resultOptions.format));
+   cache.add_arguments(argc, argv);
+   if (cache.replay()) return 0;
+
    // Проверяем существование входного файла
    ifstream testFile(inputFilename);
    if (!testFile.good()) {
@@ -405,19 +725,29 @@ int main() {
    cout << "Объем выборки 1: " << datasets[0].size() << " значений" << endl;
    cout << "Объем выборки 2: " << datasets[1].size() << " значений" << endl;
 
-   // Создание выходного файла
-   ofstream outputFile(outputFilename);
-
-   if (!outputFile.is_open()) {
-       cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputFilename << endl;
-       return 1;
+   // Применение критерия Стьюдента
+   TTestSummary summary;
+   if (resultOptions.structured()) {
+       outputFilename = result_output_filename(outputFilename, resultOptions);
+       cout << "Применение критерия Стьюдента..." << endl;
+       ostream discard(nullptr);
+       performTTest(datasets[0], datasets[1], alpha, twoSided, discard, resampling, summary);
+       if (!writeTTestRecords(outputFilename, resultOptions, { { "1", "2" } }, { summary })) return 1;
    }
+   else {
+       // Создание выходного файла
+       ofstream outputFile(outputFilename);
 
-   // Применение критерия Стьюдента
-   cout << "Применение критерия Стьюдента..." << endl;
-   performTTest(datasets[0], datasets[1], alpha, twoSided, outputFile);
+       if (!outputFile.is_open()) {
+           cerr << "ОШИБКА: Не удалось создать выходной файл: " << outputFilename << endl;
+           return 1;
+       }
+
+       cout << "Применение критерия Стьюдента..." << endl;
+       performTTest(datasets[0], datasets[1], alpha, twoSided, outputFile, resampling, summary);
 
-   outputFile.close();
+       outputFile.close();
+   }
 
    cout << endl;
    cout << "УСПЕШНО: Критерий Стьюдента применен." << endl;
@@ -429,5 +759,6 @@ int main() {
    cout << "  - Объем выборки 1: n = " << datasets[0].size() << endl;
    cout << "  - Объем выборки 2: n = " << datasets[1].size() << endl;
 
+   cache.store({ outputFilename });
    return 0;
 }
@@ -0,0 +1,141 @@
+#pragma once
+// Синтетические входные файлы утилит для воспроизводимых замеров.
+//
+// Файл определяется форматом, размером n (общим числом наблюдений, для
+// bartlett - числом строк таблицы дисперсий) и seed. Случайные числа
+// берутся из CounterRng (counter_rng.h), значения пишутся с фиксированным
+// числом знаков, поэтому при одинаковых параметрах файлы совпадают на
+// любой платформе и при любой сборке.
+//
+// Форматы (совпадают с файлами по умолчанию соответствующих утилит):
+//   normal    "x,цензура" - нормальное N(10, 2), правое цензурирование ~15%   (normal, mnk)
+//   weibull   "x,цензура" - Вейбулл k = 2, lambda = 10, цензурирование ~30%  (weibul)
+//   kruskal   alpha и 5 выборок [SAMPLE] со сдвигом средних, есть связки      (kruskal_w)
+//   bartlett  строки "дисперсия степени_свободы" и alpha                    (bartlett)
+//   wilcoxon  два столбца, второй сдвинут на 0.2                            (wilcoxon)
+//   shapiro   alpha и столбец значений                                      (shapiro)
+//   grubbs    столбец значений с двумя выбросами                            (grubbs)
+//   student   две строки - две выборки                                      (student)
+//   fisher    секции Sample1: и Sample2:                                    (fisher)
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "counter_rng.h"
+
+// Стандартное нормальное значение (преобразование Бокса-Мюллера)
+inline double synthetic_normal(CounterRng& rng) {
+   double u1 = 1.0 - rng.uniform01(); // (0, 1]
+   double u2 = rng.uniform01();
+   return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+// Распределение Вейбулла с формой k и масштабом lambda (обратная функция)
+inline double synthetic_weibull(CounterRng& rng, double k, double lambda) {
+   return lambda * std::pow(-std::log(1.0 - rng.uniform01()), 1.0 / k);
+}
+
+inline const std::vector<std::string>& synthetic_formats() {
+   static const std::vector<std::string> formats = {
+      "normal", "weibull", "kruskal", "bartlett", "wilcoxon", "shapiro", "grubbs", "student", "fisher"
+   };
+   return formats;
+}
+
+// Запись файла формата format; false - неизвестный формат или ошибка записи
+inline bool write_synthetic_input(const std::string& format, size_t n, std::uint64_t seed,
+   const std::string& filename) {
+   bool known = false;
+   for (const std::string& name : synthetic_formats()) known = known || name == format;
+   if (!known || n == 0) return false;
+
+   std::FILE* file = std::fopen(filename.c_str(), "wb");
+   if (file == nullptr) return false;
+   CounterRng rng(seed, 0);
+
+   if (format == "normal" || format == "weibull") {
+      // Время отказа T и время цензурирования C: наблюдается min(T, C)
+      for (size_t i = 0; i < n; i++) {
+         double t, c;
+         if (format == "normal") {
+            t = 10.0 + 2.0 * synthetic_normal(rng);
+            c = 12.0 + 2.0 * synthetic_normal(rng);
+         }
+         else {
+            t = synthetic_weibull(rng, 2.0, 10.0);
+            c = synthetic_weibull(rng, 2.0, 15.0);
+         }
+         bool censored = c < t;
+         std::fprintf(file, "%.4f,%d\n", std::max(censored ? c : t, 0.0001), censored ? 1 : 0);
+      }
+   }
+   else if (format == "kruskal") {
+      const size_t groups = 5;
+      std::fprintf(file, "alpha 0.05\n");
+      for (size_t g = 0; g < groups; g++) {
+         size_t size = n / groups + (g < n % groups ? 1 : 0);
+         if (size == 0) continue;
+         std::fprintf(file, "[SAMPLE]\n");
+         for (size_t i = 0; i < size; i++) {
+            std::fprintf(file, i == 0 ? "%.1f" : " %.1f", 7.0 + 0.1 * g + 0.5 * synthetic_normal(rng));
+         }
+         std::fprintf(file, "\n");
+      }
+   }
+   else if (format == "bartlett") {
+      // Выборочные дисперсии: sigma^2 * chi^2(df) / df
+      for (size_t i = 0; i < n; i++) {
+         int df = 5 + static_cast<int>(rng.uniform(26));
+         double sigma2 = 0.04 * (1.0 + 0.1 * (i % 3));
+         double sum = 0.0;
+         for (int j = 0; j < df; j++) {
+            double z = synthetic_normal(rng);
+            sum += z * z;
+         }
+         std::fprintf(file, "%.6f %d\n", sigma2 * sum / df, df);
+      }
+      std::fprintf(file, "alpha 0.05\n");
+   }
+   else if (format == "wilcoxon") {
+      for (size_t i = 0; i < n; i++) {
+         double x = 5.5 + synthetic_normal(rng);
+         double y = 5.7 + synthetic_normal(rng);
+         std::fprintf(file, "%.3f     %.3f\n", x, y);
+      }
+   }
+   else if (format == "shapiro") {
+      std::fprintf(file, "alpha 0.05\n");
+      for (size_t i = 0; i < n; i++) std::fprintf(file, "%.2f\n", 100.0 + 15.0 * synthetic_normal(rng));
+   }
+   else if (format == "grubbs") {
+      for (size_t i = 0; i < n; i++) {
+         double x = 5.5 + 0.5 * synthetic_normal(rng);
+         if (n >= 10 && i == n / 3) x = 9.5;
+         if (n >= 10 && i == 2 * n / 3) x = 1.5;
+         std::fprintf(file, "%.2f\n", x);
+      }
+   }
+   else if (format == "student" || format == "fisher") {
+      size_t first = std::max<size_t>(n / 2, 1);
+      size_t second = std::max<size_t>(n - n / 2, 1);
+      bool fisher = format == "fisher";
+      for (int sample = 0; sample < 2; sample++) {
+         size_t size = sample == 0 ? first : second;
+         double mean = sample == 0 ? 240.0 : 262.0;
+         double sd = sample == 0 ? 15.0 : 20.0;
+         if (fisher) std::fprintf(file, sample == 0 ? "Sample1:\n" : "\nSample2:\n");
+         for (size_t i = 0; i < size; i++) {
+            double x = mean + sd * synthetic_normal(rng);
+            if (fisher) std::fprintf(file, "%.1f\n", x);
+            else std::fprintf(file, i == 0 ? "%.1f" : " %.1f", x);
+         }
+         if (!fisher) std::fprintf(file, "\n");
+      }
+   }
+
+   bool failed = std::ferror(file) != 0;
+   return std::fclose(file) == 0 && !failed;
+}
@@ -1,13 +1,29 @@
 #include <iostream>
 #include <fstream>
+#include <array>
 #include <vector>
 #include <string>
 #include <cmath>
+#include <cstdlib>
 #include <iomanip>
 #include <algorithm>
 #include <sstream>
 #include <numeric>
 #include <random>
+#include <limits>
+
+#include "censored_data.h"
+#include "columnar.h"
+#include "fast_reader.h"
+#include "fit_state.h"
+#include "moments.h"
+#include "nelder_mead.h"
+#include "arena.h"
+#include "autodiff.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
 
 using namespace std;
 
@@ -123,7 +139,8 @@ double weibull_ppf(double p, double lambda, double k) {
 // ========== ФУНКЦИИ ММП ДЛЯ ВЕЙБУЛЛА ==========
 
 // Функция минимизации для Вейбулла
-double WeibullMinFunction(vector<double> xsimpl) {
+double WeibullMinFunction(const double* xsimpl) {
+    STAT_PROFILE_COUNT("weibull_min_function_evals", 1);
     double s1, s2, s3, z, b, c;
     int i, k_count;
     if (xsimpl[0] <= 0) return 10000000.;
@@ -148,51 +165,30 @@ double WeibullMinFunction(vector<double> xsimpl) {
     return result * result;
 }
 
-// Обращение матрицы
-double** InverseMatrix(double** a, int n) {
-    double temp;
-    int i, j, k;
-
-    double** e = new double* [n];
-    for (i = 0; i < n; i++) {
-        e[i] = new double[n];
-        for (j = 0; j < n; j++) {
-            e[i][j] = 0;
-            if (i == j)
-                e[i][j] = 1;
-        }
+// Логарифм правдоподобия распределения Вейбулла с правым цензурированием
+// по данным nesm: params = (k, lambda). При T = Jet<2> за тот же проход
+// вычисляются градиент и гессиан.
+template <class T>
+T WeibullLogLikelihood(const T* params) {
+    const T& k = params[0];
+    const T& lambda = params[1];
+    if (!(jet_value(k) > 0) || !(jet_value(lambda) > 0)) return T(-HUGE_VAL);
+    T log_k = log(k);
+    T log_lambda = log(lambda);
+    T sum(0.0);
+    for (int i = 0; i < nesm.n; i++) {
+        double log_x = log(nesm.x[i]);
+        T u = k * (log_x - log_lambda); // log((x / lambda)^k)
+        T t = exp(u);
+        if (nesm.r[i] == 0) sum += log_k + u - log_x - t;
+        else sum -= t;
     }
-
-    for (k = 0; k < n; k++) {
-        temp = a[k][k];
-        for (j = 0; j < n; j++) {
-            a[k][j] /= temp;
-            e[k][j] /= temp;
-        }
-
-        for (i = k + 1; i < n; i++) {
-            temp = a[i][k];
-            for (j = 0; j < n; j++) {
-                a[i][j] -= a[k][j] * temp;
-                e[i][j] -= e[k][j] * temp;
-            }
-        }
-    }
-
-    for (k = n - 1; k > 0; k--) {
-        for (i = k - 1; i >= 0; i--) {
-            temp = a[i][k];
-            for (j = 0; j < n; j++) {
-                a[i][j] -= a[k][j] * temp;
-                e[i][j] -= e[k][j] * temp;
-            }
-        }
-    }
-    return e;
+    return sum;
 }
 
 // Ковариационная матрица для Вейбулла
-void CovMatrixMleW(int n, vector<double> x, vector<int> r, double lambda, double k, double**& v) {
+bool CovMatrixMleW(int n, const vector<double>& x, const vector<int>& r, double lambda, double k, Matrix<2, 2>& v) {
+    STAT_PROFILE_SCOPE("cov_matrix");
     int i, k_count;
     double s1, s2, z, log_lambda, inv_k;
     log_lambda = log(lambda);
@@ -206,238 +202,46 @@ void CovMatrixMleW(int n, vector<double> x, vector<int> r, double lambda, double
         k_count += (1 - r[i]);
     }
 
-    v[0][0] = double(k_count) / double(n);
-    v[0][1] = (k_count + s1) / n;
-    v[1][0] = (k_count + s1) / n;
-    v[1][1] = (k_count + s2) / n;
+    v(0, 0) = double(k_count) / double(n);
+    v(0, 1) = (k_count + s1) / n;
+    v(1, 0) = (k_count + s1) / n;
+    v(1, 1) = (k_count + s2) / n;
 
-    // Инвертируем матрицу
-    double** inv = InverseMatrix(v, 2);
-    for (int i = 0; i < 2; i++) {
-        for (int j = 0; j < 2; j++) {
-            v[i][j] = inv[i][j];
+    // Инвертируем матрицу; вырожденная информация - NaN в отчете, как раньше
+    if (!inverse(v, v)) {
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 2; j++) v(i, j) = NAN;
         }
-        delete[] inv[i];
+        return false;
     }
-    delete[] inv;
+    return true;
 }
 
 // ========== ОПТИМИЗАЦИЯ И ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ==========
 
-// Функция Нелдера-Мида
-int neldermead(vector<double>& x0, double eps, double(*func)(vector<double>)) {
-    int n = x0.size();
-    int max_iter = 1000;
-
-    vector<vector<double>> simplex(n + 1, vector<double>(n));
-    vector<double> fvals(n + 1);
-
-    // Инициализация симплекса
-    simplex[0] = x0;
-    fvals[0] = func(x0);
-
-    for (int i = 1; i <= n; i++) {
-        simplex[i] = x0;
-        simplex[i][i - 1] += (simplex[i][i - 1] == 0) ? 0.05 : simplex[i][i - 1] * 0.05;
-        fvals[i] = func(simplex[i]);
-    }
-
-    double alpha = 1.0, gamma = 2.0, rho = 0.5, sigma = 0.5;
-    int iter = 0;
-
-    while (iter < max_iter) {
-        iter++;
-
-        // Находим индексы лучшей, худшей и второй худшей точек
-        int best_idx = 0, worst_idx = 0, second_worst_idx = 0;
-        for (int i = 1; i <= n; i++) {
-            if (fvals[i] < fvals[best_idx]) best_idx = i;
-            if (fvals[i] > fvals[worst_idx]) worst_idx = i;
-        }
-
-        second_worst_idx = (worst_idx == 0) ? 1 : 0;
-        for (int i = 0; i <= n; i++) {
-            if (i != worst_idx && fvals[i] > fvals[second_worst_idx]) {
-                second_worst_idx = i;
-            }
-        }
-
-        // Проверка сходимости
-        double range = 0.0;
-        for (int i = 0; i <= n; i++) {
-            range += pow(fvals[i] - fvals[best_idx], 2);
-        }
-        range = sqrt(range / (n + 1));
-
-        if (range < eps) break;
-
-        // Вычисляем центр масс
-        vector<double> centroid(n, 0.0);
-        for (int i = 0; i <= n; i++) {
-            if (i != worst_idx) {
-                for (int j = 0; j < n; j++) {
-                    centroid[j] += simplex[i][j];
-                }
-            }
-        }
-        for (int j = 0; j < n; j++) {
-            centroid[j] /= n;
-        }
-
-        // Отражение
-        vector<double> reflected(n);
-        for (int j = 0; j < n; j++) {
-            reflected[j] = centroid[j] + alpha * (centroid[j] - simplex[worst_idx][j]);
-        }
-        double f_reflected = func(reflected);
-
-        if (f_reflected < fvals[best_idx]) {
-            // Расширение
-            vector<double> expanded(n);
-            for (int j = 0; j < n; j++) {
-                expanded[j] = centroid[j] + gamma * (reflected[j] - centroid[j]);
-            }
-            double f_expanded = func(expanded);
-
-            if (f_expanded < f_reflected) {
-                simplex[worst_idx] = expanded;
-                fvals[worst_idx] = f_expanded;
-            }
-            else {
-                simplex[worst_idx] = reflected;
-                fvals[worst_idx] = f_reflected;
-            }
-        }
-        else if (f_reflected < fvals[second_worst_idx]) {
-            simplex[worst_idx] = reflected;
-            fvals[worst_idx] = f_reflected;
-        }
-        else {
-            // Сжатие
-            vector<double> contracted(n);
-            if (f_reflected < fvals[worst_idx]) {
-                for (int j = 0; j < n; j++) {
-                    contracted[j] = centroid[j] + rho * (reflected[j] - centroid[j]);
-                }
-            }
-            else {
-                for (int j = 0; j < n; j++) {
-                    contracted[j] = centroid[j] + rho * (simplex[worst_idx][j] - centroid[j]);
-                }
-            }
-
-            double f_contracted = func(contracted);
-
-            if (f_contracted < fvals[worst_idx]) {
-                simplex[worst_idx] = contracted;
-                fvals[worst_idx] = f_contracted;
-            }
-            else {
-                // Уменьшение
-                for (int i = 0; i <= n; i++) {
-                    if (i != best_idx) {
-                        for (int j = 0; j < n; j++) {
-                            simplex[i][j] = simplex[best_idx][j] + sigma * (simplex[i][j] - simplex[best_idx][j]);
-                        }
-                        fvals[i] = func(simplex[i]);
-                    }
-                }
-            }
-        }
-    }
-
-    // Возвращаем лучшую точку
-    int best_idx = 0;
-    for (int i = 1; i <= n; i++) {
-        if (fvals[i] < fvals[best_idx]) best_idx = i;
-    }
-    x0 = simplex[best_idx];
-
-    return iter;
-}
-
-// Функция чтения данных
-vector<vector<double>> readCensoredData(const string& filename) {
-    setlocale(LC_ALL, "rus");
-    vector<vector<double>> data;
-    ifstream inp(filename);
-
-    if (!inp.is_open()) {
-        cout << "Не удалось открыть файл: " << filename << endl;
-        return data;
-    }
-
-    string line;
-    vector<double> values;
-    vector<int> censored;
-
-    while (getline(inp, line)) {
-        if (line.empty() || line[0] == '#') continue;
-
-        istringstream iss(line);
-        double value;
-        int censor;
-        char comma;
-
-        if (iss >> value >> comma >> censor) {
-            values.push_back(value);
-            censored.push_back(censor);
-        }
-        else {
-            // Альтернативный формат
-            iss.clear();
-            iss.str(line);
-            if (iss >> value >> censor) {
-                values.push_back(value);
-                censored.push_back(censor);
-            }
-        }
-    }
-
-    inp.close();
-
-    data.push_back(values);
-    data.push_back(vector<double>(censored.begin(), censored.end()));
-    return data;
-}
-
 // Функция для вычисления начальных оценок параметров Вейбулла
 void initialWeibullEstimates(const vector<double>& values, const vector<int>& censored,
     double& lambda_init, double& k_init) {
     int n = values.size();
-    int count = 0;
-    double sum_log = 0.0;
-    double sum_log_x = 0.0;
-    double sum_x = 0.0;
 
-    // Вычисляем по нецензурированным данным
+    // Моменты нецензурированных данных за один проход
+    SampleMoments moments;
     for (int i = 0; i < n; i++) {
         if (censored[i] == 0) {
-            sum_log += log(values[i]);
-            sum_log_x += log(values[i]) * values[i];
-            sum_x += values[i];
-            count++;
+            moments.add(values[i]);
         }
     }
 
-    if (count == 0) {
+    if (moments.count == 0) {
         // Если все данные цензурированы, используем разумные начальные значения
         lambda_init = 1.0;
         k_init = 1.5;
         return;
     }
 
-    double mean_log = sum_log / count;
-
     // Метод моментов для начальных оценок
-    double mean = sum_x / count;
-    double variance = 0.0;
-    for (int i = 0; i < n; i++) {
-        if (censored[i] == 0) {
-            variance += pow(values[i] - mean, 2);
-        }
-    }
-    variance /= (count - 1);
+    double mean = moments.mean;
+    double variance = moments.variance();
 
     // Начальные оценки на основе метода моментов
     if (variance > 0) {
@@ -460,19 +264,71 @@ void initialWeibullEstimates(const vector<double>& values, const vector<int>& ce
     lambda_init = max(0.1, lambda_init);
 }
 
+// Режимы оценивания (ключи командной строки)
+struct MleOptions {
+    int starts = 1;      // --multistart N: число начальных точек Нелдера-Мида
+    bool newton = false; // --newton: уточнение (k, lambda) методом Ньютона и ковариационная
+                         // матрица по наблюдаемой информации (autodiff.h)
+    string state_file;   // --state <файл>: инкрементальный пересчет (fit_state.h)
+};
+
 // Основная функция оценки параметров Вейбулла
-void estimateWeibullParameters(const string& inputFile, const string& outputFile) {
+// Оценки одной записью для --format jsonl|csv (result_writer.h). Поля
+// ncov_* - нормированная матрица CovMatrixMleW (как в текстовом отчете),
+// obs_* - матрица по наблюдаемой информации в единицах параметров
+// (только с --newton, иначе пустые)
+bool writeWeibullRecord(const string& outputFile, const ResultOptions& options, int n, int uncensored_count,
+    double k, double lambda, const Matrix<2, 2>& cov_matrix, bool observed, const Matrix<2, 2>& observed_cov) {
+    const double nan = numeric_limits<double>::quiet_NaN();
+    ResultWriter writer;
+    if (!writer.open(outputFile, options, "weibull_mle", { "n", "uncensored", "k", "lambda",
+        "ncov_k_k", "ncov_k_lambda", "ncov_lambda_lambda", "obs_var_k", "obs_cov_k_lambda", "obs_var_lambda" })) {
+        cout << "Не удалось создать файл: " << outputFile << endl;
+        return false;
+    }
+    writer.write(n, uncensored_count, k, lambda,
+        cov_matrix(0, 0), cov_matrix(0, 1), cov_matrix(1, 1),
+        observed ? observed_cov(0, 0) : nan, observed ? observed_cov(0, 1) : nan, observed ? observed_cov(1, 1) : nan);
+    if (!writer.close()) {
+        cout << "Ошибка записи в файл: " << outputFile << endl;
+        return false;
+    }
+    cout << "Результаты MLE оценки распределения Вейбулла записаны в: " << outputFile << endl;
+    return true;
+}
+
+bool estimateWeibullParameters(const string& inputFile, const string& outputFile, const MleOptions& mle = MleOptions(),
+    const ResultOptions& result = ResultOptions()) {
     setlocale(LC_ALL, "rus");
+    // Временные массивы задания освобождаются при выходе из функции
+    ArenaScope arena_scope;
 
-    // 1. Чтение данных
-    auto data = readCensoredData(inputFile);
-    if (data.empty() || data[0].empty()) {
+    // 1. Чтение данных: с файлом состояния - только дописанные наблюдения
+    vector<double> values;
+    vector<int> censored;
+    FitState state;
+    bool incremental = false;
+    size_t appended = 0;
+    if (!mle.state_file.empty()) {
+        load_fit_state(mle.state_file, state);
+        incremental = update_fit_state(inputFile, "weibull_mle", state, appended);
+        if (incremental) {
+            cout << "Инкрементальный режим: прочитано новых наблюдений " << appended
+                << " (всего " << state.values.size() << ")" << endl;
+            values.assign(state.values.begin(), state.values.end());
+            censored.assign(state.censored.begin(), state.censored.end());
+        }
+        else {
+            cout << "Инкрементальный режим недоступен для этого файла: данные читаются целиком" << endl;
+        }
+    }
+    if (!incremental) {
+        read_censored_data(inputFile, values, censored);
+    }
+    if (values.empty()) {
         cout << "Ошибка чтения данных" << endl;
-        return;
+        return false;
     }
-
-    vector<double> values = data[0];
-    vector<int> censored(data[1].begin(), data[1].end());
     int n = values.size();
 
     // Инициализация глобальной структуры
@@ -481,7 +337,7 @@ void estimateWeibullParameters(const string& inputFile, const string& outputFile
     nesm.r = censored;
 
     // 2. Начальные оценки параметров Вейбулла
-    vector<double> initialParams(2); // [k, lambda]
+    array<double, 2> initialParams; // [k, lambda]
     double lambda_init, k_init;
     initialWeibullEstimates(values, censored, lambda_init, k_init);
 
@@ -490,8 +346,13 @@ void estimateWeibullParameters(const string& inputFile, const string& outputFile
     initialParams[1] = lambda_init;
 
     int uncensored_count = 0;
-    for (int i = 0; i < n; i++) {
-        if (censored[i] == 0) uncensored_count++;
+    if (incremental) {
+        uncensored_count = static_cast<int>(state.failures.count);
+    }
+    else {
+        for (int i = 0; i < n; i++) {
+            if (censored[i] == 0) uncensored_count++;
+        }
     }
 
     cout << "ОЦЕНКА ПАРАМЕТРОВ РАСПРЕДЕЛЕНИЯ ВЕЙБУЛЛА" << endl;
@@ -504,45 +365,119 @@ void estimateWeibullParameters(const string& inputFile, const string& outputFile
 
     // 3. Минимизация функции правдоподобия
     double epsilon = 1e-6;
-    int iterations = neldermead(initialParams, epsilon, WeibullMinFunction);
+    NelderMeadOptions options;
+    options.eps = epsilon;
+    auto objective = [](const double* x) { return WeibullMinFunction(x); };
+    auto loglik = [](const auto* p) { return WeibullLogLikelihood(p); };
+    // Максимум правдоподобия по lambda при заданном k
+    auto profile_lambda = [&](array<double, 2>& params) {
+        double s = 0.0;
+        int k_count = 0;
+        for (int i = 0; i < n; i++) {
+            s += pow(values[i], params[0]);
+            k_count += 1 - censored[i];
+        }
+        if (k_count > 0) params[1] = pow(s / k_count, 1.0 / params[0]);
+    };
+    int iterations = 0;
+
+    // Теплый старт: метод Ньютона из прежнего оптимума (lambda - профильная
+    // при прежнем k). Без сходимости - обычный поиск из начальных оценок.
+    bool warm = false;
+    if (incremental && state.fitted) {
+        array<double, 2> warmParams = state.params;
+        profile_lambda(warmParams);
+        NewtonResult polish = newton_maximize(warmParams, loglik);
+        warm = polish.converged && isfinite(warmParams[0]) && isfinite(warmParams[1]) && warmParams[0] > 0 && warmParams[1] > 0;
+        cout << "Теплый старт из прежнего оптимума k = " << state.params[0] << ", lambda = " << state.params[1]
+            << ": итераций метода Ньютона " << polish.iterations << (warm ? "" : " (без сходимости)") << endl;
+        if (warm) initialParams = warmParams;
+    }
+    if (!warm && mle.starts > 1) {
+        // WeibullMinFunction зависит только от k (lambda профилируется внутри),
+        // поэтому мультистарт идет по одному k, а lambda - максимум
+        // правдоподобия при лучшем k. Начальные точки: k от 1/4 до 4 начальных оценок
+        auto to_point = [k_init](const double* u, double* point) {
+            point[0] = k_init * pow(4.0, 2.0 * u[0] - 1.0);
+        };
+        auto shape_objective = [lambda_init](const double* x) {
+            double point[2] = { x[0], lambda_init };
+            return WeibullMinFunction(point);
+        };
+        array<double, 1> shape = { initialParams[0] };
+        MultiStartResult search = nelder_mead_multistart(shape, mle.starts, 20240531, to_point, shape_objective, options);
+        initialParams[0] = shape[0];
+        profile_lambda(initialParams);
+        iterations = search.best.iterations;
+        cout << "Мультистарт: запусков " << search.starts << ", сошлись " << search.converged
+            << ", прекращены досрочно " << search.pruned << ", пришли в лучшую точку " << search.agreeing
+            << ", лучший запуск #" << search.best_start << ", вычислений функции " << search.evaluations << endl;
+    }
+    else if (!warm) {
+        iterations = nelder_mead(initialParams, objective, options).iterations;
+    }
+
+    // Уточнение максимума правдоподобия по обоим параметрам методом Ньютона.
+    // Начальное lambda - максимум правдоподобия при найденном k.
+    if (mle.newton && !warm) {
+        profile_lambda(initialParams);
+        NewtonResult polish = newton_maximize(initialParams, loglik);
+        cout << "Уточнение методом Ньютона: итераций " << polish.iterations
+            << (polish.converged ? "" : " (без сходимости)") << ", логарифм правдоподобия " << polish.value
+            << ", норма градиента " << polish.gradient_norm << endl;
+    }
 
     double k = initialParams[0];    // параметр формы
     double lambda = initialParams[1]; // параметр масштаба
 
-    cout << "Оптимальные параметры Вейбулла: k = " << k << ", lambda = " << lambda << endl;
-    cout << "Итераций метода Нелдера-Мида: " << iterations << endl;
-    cout << "Значение функции правдоподобия: " << WeibullMinFunction(initialParams) << endl;
-
-    // 4. Вычисление ковариационной матрицы
-    double** cov_matrix = new double* [2];
-    for (int i = 0; i < 2; i++) {
-        cov_matrix[i] = new double[2];
-        for (int j = 0; j < 2; j++) {
-            cov_matrix[i][j] = 0.0;
+    if (incremental) {
+        state.params = initialParams;
+        state.fitted = isfinite(k) && isfinite(lambda) && k > 0 && lambda > 0;
+        if (!save_fit_state(mle.state_file, state)) {
+            cout << "Не удалось записать файл состояния: " << mle.state_file << endl;
         }
     }
 
-    CovMatrixMleW(n, values, censored, lambda, k, cov_matrix);
+    cout << "Оптимальные параметры Вейбулла: k = " << k << ", lambda = " << lambda << endl;
+    cout << "Итераций метода Нелдера-Мида: " << iterations << endl;
+    cout << "Значение функции правдоподобия: " << WeibullMinFunction(initialParams.data()) << endl;
+
+    // 4. Вычисление ковариационной матрицы: нормированная матрица CovMatrixMleW
+    // во всех режимах; с --newton еще и матрица по наблюдаемой информации в
+    // единицах параметров
+    Matrix<2, 2> cov_matrix, observed_cov;
+    if (!CovMatrixMleW(n, values, censored, lambda, k, cov_matrix)) {
+        cout << "Информационная матрица вырождена: ковариационная матрица не вычислена" << endl;
+    }
+    bool observed = mle.newton && observed_covariance(jet_evaluate(initialParams, loglik), observed_cov);
+    if (observed) {
+        cout << "Ковариационная матрица по наблюдаемой информации вычислена" << endl;
+    }
 
     // 5. Запись результатов
+    STAT_PROFILE_SCOPE("write_report");
+    if (result.structured()) {
+        return writeWeibullRecord(outputFile, result, n, uncensored_count, k, lambda,
+            cov_matrix, observed, observed_cov);
+    }
     ofstream out(outputFile);
     if (!out.is_open()) {
         cout << "Не удалось создать файл: " << outputFile << endl;
-        return;
+        return false;
     }
 
-    out << "ОЦЕНКА ПАРАМЕТРОВ РАСПРЕДЕЛЕНИЯ ВЕЙБУЛЛА" << endl;
-    out << "Метод максимального правдоподобия (MLE)" << endl;
-    out << "========================================" << endl << endl;
+    out << "ОЦЕНКА ПАРАМЕТРОВ РАСПРЕДЕЛЕНИЯ ВЕЙБУЛЛА" << '\n';
+    out << "Метод максимального правдоподобия (MLE)" << '\n';
+    out << "========================================" << '\n' << '\n';
 
-    out << "ХАРАКТЕРИСТИКИ ВЫБОРКИ:" << endl;
-    out << "Размер выборки: " << n << endl;
-    out << "Нецензурированных наблюдений: " << uncensored_count << endl;
-    out << "Цензурированных наблюдений: " << n - uncensored_count << endl << endl;
+    out << "ХАРАКТЕРИСТИКИ ВЫБОРКИ:" << '\n';
+    out << "Размер выборки: " << n << '\n';
+    out << "Нецензурированных наблюдений: " << uncensored_count << '\n';
+    out << "Цензурированных наблюдений: " << n - uncensored_count << '\n' << '\n';
 
-    out << "ОЦЕНКИ ПАРАМЕТРОВ MLE:" << endl;
-    out << "Параметр формы (k): " << fixed << setprecision(6) << k << endl;
-    out << "Параметр масштаба (λ): " << fixed << setprecision(6) << lambda << endl << endl;
+    out << "ОЦЕНКИ ПАРАМЕТРОВ MLE:" << '\n';
+    out << "Параметр формы (k): " << fixed << setprecision(6) << k << '\n';
+    out << "Параметр масштаба (λ): " << fixed << setprecision(6) << lambda << '\n' << '\n';
 
     // Характеристики распределения
     double mean_weibull = lambda * tgamma(1 + 1 / k);
@@ -550,70 +485,112 @@ void estimateWeibullParameters(const string& inputFile, const string& outputFile
     double median_weibull = lambda * pow(log(2), 1 / k);
     double mode_weibull = (k > 1) ? lambda * pow((k - 1) / k, 1 / k) : 0;
 
-    out << "ХАРАКТЕРИСТИКИ РАСПРЕДЕЛЕНИЯ ВЕЙБУЛЛА:" << endl;
-    out << "Среднее: " << fixed << setprecision(6) << mean_weibull << endl;
-    out << "Медиана: " << fixed << setprecision(6) << median_weibull << endl;
+    out << "ХАРАКТЕРИСТИКИ РАСПРЕДЕЛЕНИЯ ВЕЙБУЛЛА:" << '\n';
+    out << "Среднее: " << fixed << setprecision(6) << mean_weibull << '\n';
+    out << "Медиана: " << fixed << setprecision(6) << median_weibull << '\n';
     if (k > 1) {
-        out << "Мода: " << fixed << setprecision(6) << mode_weibull << endl;
+        out << "Мода: " << fixed << setprecision(6) << mode_weibull << '\n';
     }
     else {
-        out << "Мода: 0 (распределение J-образное)" << endl;
+        out << "Мода: 0 (распределение J-образное)" << '\n';
     }
-    out << "Дисперсия: " << fixed << setprecision(6) << variance_weibull << endl;
-    out << "Стандартное отклонение: " << fixed << setprecision(6) << sqrt(variance_weibull) << endl << endl;
+    out << "Дисперсия: " << fixed << setprecision(6) << variance_weibull << '\n';
+    out << "Стандартное отклонение: " << fixed << setprecision(6) << sqrt(variance_weibull) << '\n' << '\n';
 
-    out << "КОВАРИАЦИОННАЯ МАТРИЦА ОЦЕНОК:" << endl;
-    out << "[ " << setw(15) << cov_matrix[0][0] << "  " << setw(15) << cov_matrix[0][1] << " ]" << endl;
-    out << "[ " << setw(15) << cov_matrix[1][0] << "  " << setw(15) << cov_matrix[1][1] << " ]" << endl << endl;
+    out << "КОВАРИАЦИОННАЯ МАТРИЦА ОЦЕНОК:" << '\n';
+    out << "[ " << setw(15) << cov_matrix(0, 0) << "  " << setw(15) << cov_matrix(0, 1) << " ]" << '\n';
+    out << "[ " << setw(15) << cov_matrix(1, 0) << "  " << setw(15) << cov_matrix(1, 1) << " ]" << '\n' << '\n';
 
-    out << "ДЕТАЛИ КОВАРИАЦИОННОЙ МАТРИЦЫ:" << endl;
-    out << "Var(k) = " << scientific << setprecision(6) << cov_matrix[0][0] << endl;
-    out << "Cov(k,λ) = " << scientific << setprecision(6) << cov_matrix[0][1] << endl;
-    out << "Cov(λ,k) = " << scientific << setprecision(6) << cov_matrix[1][0] << endl;
-    out << "Var(λ) = " << scientific << setprecision(6) << cov_matrix[1][1] << endl << endl;
+    out << "ДЕТАЛИ КОВАРИАЦИОННОЙ МАТРИЦЫ:" << '\n';
+    out << "Var(k) = " << scientific << setprecision(6) << cov_matrix(0, 0) << '\n';
+    out << "Cov(k,λ) = " << scientific << setprecision(6) << cov_matrix(0, 1) << '\n';
+    out << "Cov(λ,k) = " << scientific << setprecision(6) << cov_matrix(1, 0) << '\n';
+    out << "Var(λ) = " << scientific << setprecision(6) << cov_matrix(1, 1) << '\n' << '\n';
 
     // Стандартные ошибки и корреляция
-    double se_k = sqrt(cov_matrix[0][0]);
-    double se_lambda = sqrt(cov_matrix[1][1]);
-    double correlation = cov_matrix[0][1] / (se_k * se_lambda);
+    double se_k = sqrt(cov_matrix(0, 0));
+    double se_lambda = sqrt(cov_matrix(1, 1));
+    double correlation = cov_matrix(0, 1) / (se_k * se_lambda);
 
-    out << "СТАТИСТИЧЕСКИЕ ХАРАКТЕРИСТИКИ ОЦЕНОК:" << endl;
-    out << "Стандартная ошибка k: " << fixed << setprecision(6) << se_k << endl;
-    out << "Стандартная ошибка λ: " << fixed << setprecision(6) << se_lambda << endl;
-    out << "Корреляция между оценками k и λ: " << fixed << setprecision(6) << correlation << endl << endl;
+    out << "СТАТИСТИЧЕСКИЕ ХАРАКТЕРИСТИКИ ОЦЕНОК:" << '\n';
+    out << "Стандартная ошибка k: " << fixed << setprecision(6) << se_k << '\n';
+    out << "Стандартная ошибка λ: " << fixed << setprecision(6) << se_lambda << '\n';
+    out << "Корреляция между оценками k и λ: " << fixed << setprecision(6) << correlation << '\n' << '\n';
 
     // Доверительные интервалы (приближенные, 95%)
     double z_95 = norm_ppf(0.975);
-    out << "ПРИБЛИЖЕННЫЕ 95% ДОВЕРИТЕЛЬНЫЕ ИНТЕРВАЛЫ:" << endl;
-    out << "k: [" << max(0.0, k - z_95 * se_k) << ", " << k + z_95 * se_k << "]" << endl;
-    out << "λ: [" << max(0.0, lambda - z_95 * se_lambda) << ", " << lambda + z_95 * se_lambda << "]" << endl << endl;
+    out << "ПРИБЛИЖЕННЫЕ 95% ДОВЕРИТЕЛЬНЫЕ ИНТЕРВАЛЫ:" << '\n';
+    out << "k: [" << max(0.0, k - z_95 * se_k) << ", " << k + z_95 * se_k << "]" << '\n';
+    out << "λ: [" << max(0.0, lambda - z_95 * se_lambda) << ", " << lambda + z_95 * se_lambda << "]" << '\n' << '\n';
+
+    // С --newton: матрица в единицах параметров (блоки выше - нормированные,
+    // как без --newton)
+    if (observed) {
+        double se_k_obs = sqrt(observed_cov(0, 0));
+        double se_lambda_obs = sqrt(observed_cov(1, 1));
+        out << "КОВАРИАЦИОННАЯ МАТРИЦА ПО НАБЛЮДАЕМОЙ ИНФОРМАЦИИ (в единицах параметров, --newton):" << '\n';
+        out << "(матрица и интервалы выше - по нормированной матрице на одно наблюдение, как без --newton)" << '\n';
+        out << "Var(k) = " << scientific << setprecision(6) << observed_cov(0, 0) << '\n';
+        out << "Cov(k,λ) = " << scientific << setprecision(6) << observed_cov(0, 1) << '\n';
+        out << "Var(λ) = " << scientific << setprecision(6) << observed_cov(1, 1) << '\n';
+        out << "Стандартная ошибка k: " << fixed << setprecision(6) << se_k_obs << '\n';
+        out << "Стандартная ошибка λ: " << fixed << setprecision(6) << se_lambda_obs << '\n';
+        out << "k: [" << max(0.0, k - z_95 * se_k_obs) << ", " << k + z_95 * se_k_obs << "]" << '\n';
+        out << "λ: [" << max(0.0, lambda - z_95 * se_lambda_obs) << ", " << lambda + z_95 * se_lambda_obs << "]" << '\n' << '\n';
+    }
 
     // Квантили распределения
-    out << "КВАНТИЛИ РАСПРЕДЕЛЕНИЯ ВЕЙБУЛЛА:" << endl;
+    out << "КВАНТИЛИ РАСПРЕДЕЛЕНИЯ ВЕЙБУЛЛА:" << '\n';
     vector<double> probabilities = { 0.01, 0.05, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99 };
-    out << "Вероятность\tКвантиль" << endl;
+    out << "Вероятность\tКвантиль" << '\n';
     out << fixed << setprecision(6);
     for (double p : probabilities) {
         double quantile = weibull_ppf(p, lambda, k);
-        out << p << "\t\t" << quantile << endl;
+        out << p << "\t\t" << quantile << '\n';
     }
 
     out.close();
 
-    // Освобождение памяти
-    for (int i = 0; i < 2; i++) {
-        delete[] cov_matrix[i];
-    }
-    delete[] cov_matrix;
-
     cout << "Результаты MLE оценки распределения Вейбулла записаны в: " << outputFile << endl;
+    return true;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     string inputFile = "data.txt";
     string outputFile = "results_weibull.txt";
 
-    estimateWeibullParameters(inputFile, outputFile);
+    MleOptions mle;
+
+    // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+    ResultCacheOptions cacheOptions;
+    if (!take_cache_options(argc, argv, cacheOptions)) return 1;
+
+    // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+    ResultOptions resultOptions;
+    if (!take_result_options(argc, argv, resultOptions)) return 1;
+    outputFile = result_output_filename(outputFile, resultOptions);
+
+    // Другой входной файл (текстовый или двоичный): --input <файл>
+    // Мультистарт из N начальных точек: --multistart <N>
+    // Уточнение методом Ньютона: --newton
+    // Инкрементальный пересчет дописанного файла: --state <файл состояния>
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--newton") mle.newton = true;
+        else if (option == "--input" && i + 1 < argc) inputFile = argv[++i];
+        else if (option == "--multistart" && i + 1 < argc) mle.starts = max(1, atoi(argv[++i]));
+        else if (option == "--state" && i + 1 < argc) mle.state_file = argv[++i];
+    }
+
+    // Тот же файл с теми же параметрами - результат из кэша. С файлом
+    // состояния кэш не используется: каждый запуск обновляет состояние.
+    ResultCache cache(mle.state_file.empty() ? cacheOptions : ResultCacheOptions(), "weibull_mle");
+    cache.add_file(inputFile);
+    cache.add_arguments(argc, argv);
+    cache.add("format", static_cast<int>(resultOptions.format));
+    if (cache.replay()) return 0;
+
+    if (estimateWeibullParameters(inputFile, outputFile, mle, resultOptions)) cache.store({ outputFile });
 
     return 0;
 }
@@ -7,11 +7,21 @@
 #include <stdexcept>
 #include <sstream>
 
+#include "columnar.h"
+#include "fast_reader.h"
+#include "parallel_sort.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "result_writer.h"
+
 using namespace std;
 
 //Вычисляет распределение статистики Манна-Уитни U (алгоритм AS62)
 
 void udist(int M, int N, vector<double>& frequency, vector<double>& work, int& fault) {
+   STAT_PROFILE_SCOPE("udist");
+   STAT_PROFILE_COUNT("udist_frequency_size", frequency.size());
+   STAT_PROFILE_COUNT("udist_work_size", work.size());
    fault = 1;
    int minmn = min(M, N);
    if (minmn < 1) return;
@@ -115,96 +125,86 @@ double exact_p_value_from_udist(double U, int m, int n) {
    return 2.0 * p_tail;
 }
 
-// U-статистику Манна-Уитни для двух выборок
+// U-статистику Манна-Уитни для двух выборок: U = R1 - m(m+1)/2, где R1 -
+// сумма средних рангов первой выборки в объединенной (то же, что число пар
+// x1 > x2 плюс половина равных, но за одну сортировку вместо m*n сравнений)
 double compute_u_statistic(const vector<double>& sample1, const vector<double>& sample2) {
-   double U = 0.0;
-
-   for (size_t i = 0; i < sample1.size(); i++) {
-       for (size_t j = 0; j < sample2.size(); j++) {
-           if (sample1[i] > sample2[j]) {
-               U += 1.0;
-           }
-           else if (sample1[i] == sample2[j]) {
-               U += 0.5;
-           }
+   STAT_PROFILE_SCOPE("compute_u_statistic");
+   size_t m = sample1.size();
+   size_t total = m + sample2.size();
+   STAT_PROFILE_COUNT("sort_size", total);
+
+   vector<double> combined(sample1);
+   combined.insert(combined.end(), sample2.begin(), sample2.end());
+   vector<size_t> order(total);
+   parallel_sort_indices(combined.data(), total, order.data());
+
+   double rank_sum = 0.0;
+   size_t i = 0;
+   while (i < total) {
+       size_t j = i;
+       size_t first_sample = 0;
+       while (j < total && combined[order[j]] == combined[order[i]]) {
+           if (order[j] < m) first_sample++;
+           j++;
        }
+       rank_sum += first_sample * ((i + j + 1) / 2.0);
+       i = j;
    }
 
-   return U;
+   return rank_sum - m * (m + 1) / 2.0;
 }
 
 bool read_data_from_file(const string& filename,
    vector<double>& sample1,
    vector<double>& sample2) {
-   ifstream infile(filename);
-   if (!infile) {
-       cerr << "Ошибка: не удалось открыть файл " << filename << endl;
-       return false;
-   }
-
-   string line;
-   int line_num = 0;
-
-   while (getline(infile, line)) {
-       line_num++;
-
-       if (line.empty()) continue;
-
-       // Удаляем начальные и конечные пробелы
-       size_t start = line.find_first_not_of(" \t");
-       if (start == string::npos) continue;
-
-       size_t end = line.find_last_not_of(" \t");
-       string trimmed_line = line.substr(start, end - start + 1);
-
-       // Ищем разделитель из 5 пробелов
-       string delimiter = "     ";  // 5 пробелов
-
-       size_t delim_pos = trimmed_line.find(delimiter);
-       if (delim_pos == string::npos) {
-           for (int spaces = 2; spaces <= 10; spaces++) {
-               delimiter = string(spaces, ' ');
-               delim_pos = trimmed_line.find(delimiter);
-               if (delim_pos != string::npos) {
-                   break;
-               }
-           }
-
-           if (delim_pos == string::npos) {
-               cerr << "Ошибка в строке " << line_num << endl;
-               cerr << "Ожидается формат: значение1" << string(5, ' ') << "значение2" << endl;
-               return false;
-           }
+   STAT_PROFILE_SCOPE("read_data");
+   // Двоичный столбцовый файл (columnar.h): выборки 0 и 1 столбца group
+   if (is_columnar_file(filename)) {
+       ColumnarFile file;
+       if (!file.open(filename)) {
+           cerr << "Ошибка: некорректный двоичный файл данных " << filename << endl;
+           return false;
        }
+       vector<vector<double>> groups = columnar_groups(file);
+       if (groups.size() < 2 || groups[0].empty() || groups[1].empty()) {
+           cerr << "Ошибка: одна или обе выборки пусты" << endl;
+           return false;
+       }
+       sample1.insert(sample1.end(), groups[0].begin(), groups[0].end());
+       sample2.insert(sample2.end(), groups[1].begin(), groups[1].end());
+       return true;
+   }
 
-       // Извлекаем значения из двух столбцов
-       string value1_str = trimmed_line.substr(0, delim_pos);
-       string value2_str = trimmed_line.substr(delim_pos + delimiter.length());
-
-       // Убираем возможные пробелы вокруг чисел
-       value1_str.erase(0, value1_str.find_first_not_of(" \t"));
-       value1_str.erase(value1_str.find_last_not_of(" \t") + 1);
-
-       value2_str.erase(0, value2_str.find_first_not_of(" \t"));
-       value2_str.erase(value2_str.find_last_not_of(" \t") + 1);
+   TextReadOptions options;
+   options.skip_comments = false;
+   options.track_lines = true;
+   TextColumns columns;
 
-       try {
-           double value1 = stod(value1_str);
-           double value2 = stod(value2_str);
+   if (!read_text_columns(filename, columns, options)) {
+       cerr << "Ошибка: не удалось открыть файл " << filename << endl;
+       return false;
+   }
 
-           sample1.push_back(value1);
-           sample2.push_back(value2);
+   // Каждая строка содержит два значения - по одному из каждой выборки
+   if (!columns.directives.empty()) {
+       const TextDirective& directive = columns.directives.front();
+       cerr << "Ошибка преобразования чисел в строке " << directive.line << ": " << directive.text << endl;
+       return false;
+   }
 
-       }
-       catch (const exception& e) {
-           cerr << "Ошибка преобразования чисел в строке " << line_num << ": " << line << endl;
-           cerr << "  value1: '" << value1_str << "', value2: '" << value2_str << "'" << endl;
+   sample1.reserve(sample1.size() + columns.rows());
+   sample2.reserve(sample2.size() + columns.rows());
+   for (size_t r = 0; r < columns.rows(); ++r) {
+       if (columns.row_size(r) < 2) {
+           cerr << "Ошибка в строке " << columns.row_line[r] << endl;
+           cerr << "Ожидается формат: значение1" << string(5, ' ') << "значение2" << endl;
            return false;
        }
+       sample1.push_back(columns.row(r)[0]);
+       sample2.push_back(columns.row(r)[1]);
    }
 
-   infile.close();
-
    if (sample1.empty() || sample2.empty()) {
        cerr << "Ошибка: одна или обе выборки пусты" << endl;
        return false;
@@ -213,8 +213,18 @@ bool read_data_from_file(const string& filename,
    return true;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
    setlocale(LC_ALL, "rus");
+
+   // Кэш результатов: --cache <каталог> [--cache-limit <МиБ>] (result_cache.h)
+   ResultCacheOptions cache_options;
+   if (!take_cache_options(argc, argv, cache_options)) return 1;
+
+   // Машиночитаемый вывод: --format jsonl|csv [--async-output] (result_writer.h)
+   ResultOptions result_options;
+   if (!take_result_options(argc, argv, result_options)) return 1;
+   string output_filename = result_output_filename("wilcoxon_output.txt", result_options);
+
    cout << "Двухвыборочный критерий Уилкоксона-Манна-Уитни (алгоритм AS62)" << endl;
    cout << "==============================================================" << endl;
 
@@ -222,6 +232,16 @@ int main() {
    vector<double> sample1, sample2;
    string filename = "wilcoxon_input.txt";
 
+   // Другой входной файл (текстовый или двоичный): --input <файл>
+   if (argc > 2 && string(argv[1]) == "--input") filename = argv[2];
+
+   // Тот же файл с теми же параметрами - результат из кэша
+   ResultCache cache(cache_options, "wilcoxon");
+   cache.add_file(filename);
+   cache.add_arguments(argc, argv);
+   cache.add("format", static_cast<int>(result_options.format));
+   if (cache.replay()) return 0;
+
    if (!read_data_from_file(filename, sample1, sample2)) {
        cerr << "\nТребуемый формат файла " << filename << ":" << endl;
        cerr << "1.0" << string(5, ' ') << "2.5" << endl;
@@ -280,43 +300,60 @@ int main() {
        }
 
        // Сохранение результатов в файл
+       STAT_PROFILE_SCOPE("write_report");
+       if (result_options.structured()) {
+           ResultWriter writer;
+           if (!writer.open(output_filename, result_options, "wilcoxon", { "input", "n1", "n2",
+               "u", "expected_u", "p_value", "alpha", "rejected" })) {
+               cerr << "Ошибка: не удалось создать файл результатов" << endl;
+               return 1;
+           }
+           writer.write(filename, m, n, U_stat, mn_product / 2.0, p_value, alpha, p_value < alpha);
+           if (!writer.close()) {
+               cerr << "Ошибка записи в файл: " << output_filename << endl;
+               return 1;
+           }
+           cout << "\nРезультаты сохранены в файл: " << output_filename << endl;
+           cache.store({ output_filename });
+           return 0;
+       }
        ofstream outfile("wilcoxon_output.txt");
        if (!outfile) {
            cerr << "Ошибка: не удалось создать файл результатов" << endl;
            return 1;
        }
 
-       outfile << "РЕЗУЛЬТАТЫ КРИТЕРИЯ УИЛКОКСОНА-МАННА-УИТНИ" << endl;
-       outfile << "Использован алгоритм AS62" << endl;
-       outfile << "===========================================" << endl << endl;
+       outfile << "РЕЗУЛЬТАТЫ КРИТЕРИЯ УИЛКОКСОНА-МАННА-УИТНИ" << '\n';
+       outfile << "Использован алгоритм AS62" << '\n';
+       outfile << "===========================================" << '\n' << '\n';
 
-       outfile << "ИСХОДНЫЕ ДАННЫЕ:" << endl;
-       outfile << "Файл: " << filename << endl;
-       outfile << "Размер выборки 1: " << m << endl;
-       outfile << "Размер выборки 2: " << n << endl;
-       outfile << "m x n = " << mn_product << endl << endl;
+       outfile << "ИСХОДНЫЕ ДАННЫЕ:" << '\n';
+       outfile << "Файл: " << filename << '\n';
+       outfile << "Размер выборки 1: " << m << '\n';
+       outfile << "Размер выборки 2: " << n << '\n';
+       outfile << "m x n = " << mn_product << '\n' << '\n';
 
-       outfile << "РАСЧЕТНЫЕ ВЕЛИЧИНЫ:" << endl;
-       outfile << "U-статистика Манна-Уитни: " << U_stat << endl;
-       outfile << "Ожидаемое значение U при H0: " << (mn_product / 2.0) << endl;
-       outfile << "Точное p-значение (двустороннее): " << p_value << endl << endl;
+       outfile << "РАСЧЕТНЫЕ ВЕЛИЧИНЫ:" << '\n';
+       outfile << "U-статистика Манна-Уитни: " << U_stat << '\n';
+       outfile << "Ожидаемое значение U при H0: " << (mn_product / 2.0) << '\n';
+       outfile << "Точное p-значение (двустороннее): " << p_value << '\n' << '\n';
 
-       outfile << "СТАТИСТИЧЕСКИЙ ВЫВОД:" << endl;
-       outfile << "Уровень значимости alpha = " << alpha << endl;
-       outfile << "Нулевая гипотеза H0: выборки из одинаковых распределений" << endl;
-       outfile << "Альтернативная гипотеза H1: выборки из разных распределений" << endl << endl;
+       outfile << "СТАТИСТИЧЕСКИЙ ВЫВОД:" << '\n';
+       outfile << "Уровень значимости alpha = " << alpha << '\n';
+       outfile << "Нулевая гипотеза H0: выборки из одинаковых распределений" << '\n';
+       outfile << "Альтернативная гипотеза H1: выборки из разных распределений" << '\n' << '\n';
 
        if (p_value < alpha) {
-           outfile << "РЕЗУЛЬТАТ: ОТКЛОНИТЬ H0" << endl;
-           outfile << "Существует статистически значимое различие между выборками." << endl;
-           outfile << "Вероятность наблюсти такие или более крайние различия" << endl;
-           outfile << "при условии истинности H0 составляет " << p_value << "." << endl;
+           outfile << "РЕЗУЛЬТАТ: ОТКЛОНИТЬ H0" << '\n';
+           outfile << "Существует статистически значимое различие между выборками." << '\n';
+           outfile << "Вероятность наблюсти такие или более крайние различия" << '\n';
+           outfile << "при условии истинности H0 составляет " << p_value << "." << '\n';
        }
        else {
-           outfile << "РЕЗУЛЬТАТ: НЕ ОТВЕРГАТЬ H0" << endl;
-           outfile << "Статистически значимого различия не обнаружено." << endl;
-           outfile << "Нет оснований утверждать, что выборки происходят" << endl;
-           outfile << "из разных распределений." << endl;
+           outfile << "РЕЗУЛЬТАТ: НЕ ОТВЕРГАТЬ H0" << '\n';
+           outfile << "Статистически значимого различия не обнаружено." << '\n';
+           outfile << "Нет оснований утверждать, что выборки происходят" << '\n';
+           outfile << "из разных распределений." << '\n';
        }
 
        outfile.close();
@@ -329,5 +366,6 @@ int main() {
        return 1;
    }
 
+   cache.store({ "wilcoxon_output.txt" });
    return 0;
 }
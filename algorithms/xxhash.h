@@ -0,0 +1,113 @@
+#pragma once
+// Потоковая 64-битная хэш-функция XXH64: ключи кэша результатов
+// (result_cache.h) и контрольная сумма прочитанной части файла данных в
+// состоянии инкрементального пересчета (fit_state.h).
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Потоковый XXH64 (Yann Collet): 4 независимые полосы по 8 байт,
+// скорость порядка скорости чтения памяти
+class Xxh64 {
+public:
+   explicit Xxh64(std::uint64_t seed = 0)
+      : lanes_{ seed + prime1 + prime2, seed + prime2, seed, seed - prime1 }, seed_(seed) {}
+
+   void update(const void* bytes, size_t size) {
+      const unsigned char* p = static_cast<const unsigned char*>(bytes);
+      total_ += size;
+      if (buffered_ + size < 32) {
+         std::memcpy(buffer_ + buffered_, p, size);
+         buffered_ += size;
+         return;
+      }
+      if (buffered_ > 0) {
+         size_t fill = 32 - buffered_;
+         std::memcpy(buffer_ + buffered_, p, fill);
+         consume_stripe(buffer_);
+         p += fill;
+         size -= fill;
+         buffered_ = 0;
+      }
+      for (; size >= 32; p += 32, size -= 32) consume_stripe(p);
+      std::memcpy(buffer_, p, size);
+      buffered_ = size;
+   }
+
+   void update(const std::string& text) {
+      update(text.data(), text.size());
+      update("\0", 1); // граница поля
+   }
+
+   std::uint64_t digest() const {
+      std::uint64_t h;
+      if (total_ >= 32) {
+         h = rotl(lanes_[0], 1) + rotl(lanes_[1], 7) + rotl(lanes_[2], 12) + rotl(lanes_[3], 18);
+         for (std::uint64_t lane : lanes_) {
+            h ^= round(0, lane);
+            h = h * prime1 + prime4;
+         }
+      }
+      else {
+         h = seed_ + prime5;
+      }
+      h += total_;
+
+      const unsigned char* p = buffer_;
+      size_t size = buffered_;
+      for (; size >= 8; p += 8, size -= 8) {
+         h ^= round(0, read64(p));
+         h = rotl(h, 27) * prime1 + prime4;
+      }
+      if (size >= 4) {
+         h ^= static_cast<std::uint64_t>(read32(p)) * prime1;
+         h = rotl(h, 23) * prime2 + prime3;
+         p += 4;
+         size -= 4;
+      }
+      for (; size > 0; p++, size--) {
+         h ^= *p * prime5;
+         h = rotl(h, 11) * prime1;
+      }
+
+      h ^= h >> 33;
+      h *= prime2;
+      h ^= h >> 29;
+      h *= prime3;
+      h ^= h >> 32;
+      return h;
+   }
+
+private:
+   static constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ull;
+   static constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+   static constexpr std::uint64_t prime3 = 0x165667B19E3779F9ull;
+   static constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+   static constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+   static std::uint64_t rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+   static std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+      return rotl(acc + input * prime2, 31) * prime1;
+   }
+   static std::uint64_t read64(const unsigned char* p) {
+      std::uint64_t v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+   }
+   static std::uint32_t read32(const unsigned char* p) {
+      std::uint32_t v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+   }
+
+   void consume_stripe(const unsigned char* p) {
+      for (int i = 0; i < 4; i++) lanes_[i] = round(lanes_[i], read64(p + 8 * i));
+   }
+
+   std::uint64_t lanes_[4];
+   std::uint64_t seed_;
+   std::uint64_t total_ = 0;
+   unsigned char buffer_[32] = {};
+   size_t buffered_ = 0;
+};